@@ -35,11 +35,35 @@ SOURCES += \
     $${SOURCE_ROOT}/ApplicationSettings.cpp \
     $${SOURCE_ROOT}/ApplicationSettingsLoader.cpp \
     $${SOURCE_ROOT}/MainWindow.cpp \
+    $${SOURCE_ROOT}/PortSessionsWindow.cpp \
+    $${SOURCE_ROOT}/DeviceMonitor.cpp \
     $${SOURCE_ROOT}/ApplicationIcons.cpp \
     $${SOURCE_ROOT}/QSerialTerminalLineEdit.cpp \
+    $${SOURCE_ROOT}/TerminalRenderer.cpp \
+    $${SOURCE_ROOT}/TerminalView.cpp \
+    $${SOURCE_ROOT}/LineStore.cpp \
+    $${SOURCE_ROOT}/MappedFile.cpp \
+    $${SOURCE_ROOT}/ScriptRunner.cpp \
+    $${SOURCE_ROOT}/SessionReplayer.cpp \
+    $${SOURCE_ROOT}/CaptureIndex.cpp \
+    $${SOURCE_ROOT}/CaptureViewer.cpp \
+    $${SOURCE_ROOT}/TextSearch.cpp \
+    $${SOURCE_ROOT}/SearchBar.cpp \
+    $${SOURCE_ROOT}/FileTransferSession.cpp \
     $${SOURCE_ROOT}/ApplicationUtilities.cpp \
     $${SOURCE_ROOT}/SerialPort.cpp \
     $${SOURCE_ROOT}/IByteStream.cpp \
+    $${SOURCE_ROOT}/RingBuffer.cpp \
+    $${SOURCE_ROOT}/ByteSearch.cpp \
+    $${SOURCE_ROOT}/ByteFormatter.cpp \
+    $${SOURCE_ROOT}/SessionRecorder.cpp \
+    $${SOURCE_ROOT}/Crc.cpp \
+    $${SOURCE_ROOT}/FileTransfer.cpp \
+    $${SOURCE_ROOT}/XModemTransfer.cpp \
+    $${SOURCE_ROOT}/ZModemTransfer.cpp \
+    $${SOURCE_ROOT}/SerialPortReader.cpp \
+    $${SOURCE_ROOT}/SerialPortWriter.cpp \
+    $${SOURCE_ROOT}/SerialReactor.cpp \
     $${SOURCE_ROOT}/SingleInstanceGuard.cpp \
     $${SOURCE_ROOT}/AboutApplicationWidget.cpp \
     src/win32_getopt.cpp
@@ -49,11 +73,37 @@ HEADERS += \
     $${SOURCE_ROOT}/ApplicationSettings.h\ \
     $${SOURCE_ROOT}/ApplicationSettingsLoader.h \
     $${SOURCE_ROOT}/MainWindow.h \
+    $${SOURCE_ROOT}/PortSessionsWindow.h \
+    $${SOURCE_ROOT}/DeviceMonitor.h \
     $${SOURCE_ROOT}/ApplicationIcons.h \
     $${SOURCE_ROOT}/QSerialTerminalLineEdit.h \
+    $${SOURCE_ROOT}/TerminalRenderer.h \
+    $${SOURCE_ROOT}/TerminalView.h \
+    $${SOURCE_ROOT}/LineStore.h \
+    $${SOURCE_ROOT}/MappedFile.h \
+    $${SOURCE_ROOT}/ScriptRunner.h \
+    $${SOURCE_ROOT}/SessionReplayer.h \
+    $${SOURCE_ROOT}/CaptureIndex.h \
+    $${SOURCE_ROOT}/CaptureViewer.h \
+    $${SOURCE_ROOT}/TextSearch.h \
+    $${SOURCE_ROOT}/SearchBar.h \
+    $${SOURCE_ROOT}/FileTransferSession.h \
     $${SOURCE_ROOT}/ApplicationUtilities.h \
     $${SOURCE_ROOT}/SerialPort.h \
     $${SOURCE_ROOT}/IByteStream.h \
+    $${SOURCE_ROOT}/RingBuffer.h \
+    $${SOURCE_ROOT}/ByteSearch.h \
+    $${SOURCE_ROOT}/ByteFormatter.h \
+    $${SOURCE_ROOT}/SessionRecorder.h \
+    $${SOURCE_ROOT}/Crc.h \
+    $${SOURCE_ROOT}/FileTransfer.h \
+    $${SOURCE_ROOT}/XModemTransfer.h \
+    $${SOURCE_ROOT}/ZModemTransfer.h \
+    $${SOURCE_ROOT}/SerialPortReader.h \
+    $${SOURCE_ROOT}/SerialPortWriter.h \
+    $${SOURCE_ROOT}/SerialReactor.h \
+    $${SOURCE_ROOT}/SpscQueue.h \
+    $${SOURCE_ROOT}/EventNotifier.h \
     $${SOURCE_ROOT}/AboutApplicationWidget.h \
     $${SOURCE_ROOT}/SingleInstanceGuard.h \
     $${SOURCE_ROOT}/QActionSetDefs.h \
@@ -68,4 +118,7 @@ FORMS += \
 RESOURCES += \
     $${RESOURCES_ROOT}/icons.qrc
 
-
+unix {
+    SOURCES += $${SOURCE_ROOT}/HeadlessTerminal.cpp
+    HEADERS += $${SOURCE_ROOT}/HeadlessTerminal.h
+}
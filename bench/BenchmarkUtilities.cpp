@@ -0,0 +1,41 @@
+#include "BenchmarkUtilities.h"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace BenchmarkUtilities
+{
+
+double percentile(const std::vector<double> &sortedValues, double fraction)
+{
+    if (sortedValues.empty()) {
+        return 0.0;
+    }
+    size_t rank{static_cast<size_t>(fraction * static_cast<double>(sortedValues.size()) + 0.5)};
+    rank = std::max<size_t>(rank, 1);
+    return sortedValues[std::min(rank, sortedValues.size()) - 1];
+}
+
+std::string escapeJson(const std::string &str)
+{
+    std::ostringstream escaped{};
+    for (unsigned char c : str) {
+        if (c == '"') {
+            escaped << R"(\")";
+        } else if (c == '\\') {
+            escaped << R"(\\)";
+        } else if (c == '\n') {
+            escaped << R"(\n)";
+        } else if (c == '\r') {
+            escaped << R"(\r)";
+        } else if (c < 0x20) {
+            escaped << R"(\u)" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            escaped << c;
+        }
+    }
+    return escaped.str();
+}
+
+} //namespace BenchmarkUtilities
@@ -0,0 +1,18 @@
+#ifndef QSERIALTERMINAL_BENCHMARKUTILITIES_H
+#define QSERIALTERMINAL_BENCHMARKUTILITIES_H
+
+#include <string>
+#include <vector>
+
+/*
+ * Helpers shared by the benchmark executables for summarising samples
+ * and writing the results out as JSON
+ */
+namespace BenchmarkUtilities
+{
+    //Nearest rank, so the reported value is always one that was actually measured
+    double percentile(const std::vector<double> &sortedValues, double fraction);
+    std::string escapeJson(const std::string &str);
+}
+
+#endif //QSERIALTERMINAL_BENCHMARKUTILITIES_H
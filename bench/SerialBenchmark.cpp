@@ -0,0 +1,521 @@
+#include "SerialBenchmark.h"
+#include "BenchmarkUtilities.h"
+#include "SerialPort.h"
+#include "ApplicationSettings.h"
+#include "ByteSearch.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <memory>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+
+#include <pty.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+using namespace CppSerialPort;
+
+static struct option benchmarkLongOptions[]{
+    { "quick",           no_argument,       nullptr, 'q' },
+    { "operation",       required_argument, nullptr, 'o' },
+    { "latency-samples", required_argument, nullptr, 'n' },
+    { "record",          required_argument, nullptr, 'r' },
+    { "help",            no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+};
+
+static const size_t KIBIBYTE{1024};
+static const size_t MEBIBYTE{1024 * 1024};
+
+const int SerialBenchmark::READ_TIMEOUT{1000};
+
+PseudoTerminalPair::PseudoTerminalPair() :
+    m_masterFileDescriptor{-1},
+    m_slaveFileDescriptor{-1},
+    m_slaveName{""}
+{
+    if (openpty(&this->m_masterFileDescriptor, &this->m_slaveFileDescriptor, nullptr, nullptr, nullptr) != 0) {
+        throw std::runtime_error("PseudoTerminalPair::PseudoTerminalPair(): openpty failed (" + std::string{strerror(errno)} + ")");
+    }
+    //The master is polled, so a full or empty pty never blocks the benchmark for good
+    fcntl(this->m_masterFileDescriptor, F_SETFL, fcntl(this->m_masterFileDescriptor, F_GETFL) | O_NONBLOCK);
+    const char *slaveName{ttyname(this->m_slaveFileDescriptor)};
+    if (!slaveName) {
+        close(this->m_slaveFileDescriptor);
+        close(this->m_masterFileDescriptor);
+        throw std::runtime_error("PseudoTerminalPair::PseudoTerminalPair(): ttyname failed (" + std::string{strerror(errno)} + ")");
+    }
+    this->m_slaveName = slaveName;
+}
+
+PseudoTerminalPair::~PseudoTerminalPair()
+{
+    close(this->m_slaveFileDescriptor);
+    close(this->m_masterFileDescriptor);
+}
+
+int PseudoTerminalPair::masterFileDescriptor() const
+{
+    return this->m_masterFileDescriptor;
+}
+
+std::string PseudoTerminalPair::slaveName() const
+{
+    return this->m_slaveName;
+}
+
+bool PseudoTerminalPair::writeToMaster(const char *data, size_t size, const std::atomic<bool> &cancelled)
+{
+    pollfd pollDescriptor{this->m_masterFileDescriptor, POLLOUT, 0};
+    while (size > 0) {
+        if (cancelled.load()) {
+            return false;
+        }
+        auto writtenBytes = ::write(this->m_masterFileDescriptor, data, size);
+        if (writtenBytes < 0) {
+            if ( (errno == EAGAIN) || (errno == EINTR) ) {
+                poll(&pollDescriptor, 1, POLL_INTERVAL);
+                continue;
+            }
+            return false;
+        }
+        data += writtenBytes;
+        size -= static_cast<size_t>(writtenBytes);
+    }
+    return true;
+}
+
+bool PseudoTerminalPair::readFromMaster(std::string &out, size_t size, const std::atomic<bool> &cancelled)
+{
+    pollfd pollDescriptor{this->m_masterFileDescriptor, POLLIN, 0};
+    char buffer[4096];
+    while (size > 0) {
+        if (cancelled.load()) {
+            return false;
+        }
+        auto bytesRead = ::read(this->m_masterFileDescriptor, buffer, std::min(size, sizeof(buffer)));
+        if (bytesRead < 0) {
+            if ( (errno == EAGAIN) || (errno == EINTR) ) {
+                poll(&pollDescriptor, 1, POLL_INTERVAL);
+                continue;
+            }
+            return false;
+        }
+        out.append(buffer, static_cast<size_t>(bytesRead));
+        size -= static_cast<size_t>(bytesRead);
+    }
+    return true;
+}
+
+SerialBenchmark::SerialBenchmark(const SerialBenchmarkOptions &options) :
+    m_options{options},
+    m_recorder{nullptr}
+{
+
+}
+
+std::string SerialBenchmark::operationName(BenchmarkOperation operation)
+{
+    switch (operation) {
+        case BenchmarkOperation::Read:
+            return "read";
+        case BenchmarkOperation::ReadLine:
+            return "readLine";
+        case BenchmarkOperation::ReadUntil:
+            return "readUntil";
+        case BenchmarkOperation::WriteLine:
+            return "writeLine";
+        case BenchmarkOperation::WriteLines:
+            return "writeLines";
+    }
+    return "unknown";
+}
+
+std::string SerialBenchmark::payloadKindName(PayloadKind payloadKind)
+{
+    return (payloadKind == PayloadKind::Text ? "text" : "binary");
+}
+
+std::vector<BenchmarkCase> SerialBenchmark::defaultCases(bool quick)
+{
+    const size_t bytePayload{quick ? 64 * KIBIBYTE : MEBIBYTE};
+    const size_t linePayload{quick ? 256 * KIBIBYTE : 4 * MEBIBYTE};
+    std::vector<BenchmarkCase> cases{};
+    for (auto payloadKind : {PayloadKind::Text, PayloadKind::Binary}) {
+        cases.push_back(BenchmarkCase{BenchmarkOperation::Read, payloadKind, bytePayload, 0, ""});
+        for (size_t lineLength : {16, 80, 1024}) {
+            cases.push_back(BenchmarkCase{BenchmarkOperation::ReadLine, payloadKind, linePayload, lineLength, "\n"});
+        }
+    }
+    //ETX framing stands in for the binary protocols that use readUntil()
+    for (size_t lineLength : {80, 1024}) {
+        cases.push_back(BenchmarkCase{BenchmarkOperation::ReadUntil, PayloadKind::Binary, linePayload, lineLength, "\x03"});
+    }
+    //Two byte terminators take the vectorized first/last byte path instead of memchr
+    for (auto payloadKind : {PayloadKind::Text, PayloadKind::Binary}) {
+        for (size_t lineLength : {80, 1024}) {
+            cases.push_back(BenchmarkCase{BenchmarkOperation::ReadUntil, payloadKind, linePayload, lineLength, "\r\n"});
+        }
+    }
+    for (size_t lineLength : {16, 80, 1024}) {
+        cases.push_back(BenchmarkCase{BenchmarkOperation::WriteLine, PayloadKind::Text, linePayload, lineLength, "\n"});
+    }
+    for (size_t lineLength : {16, 80, 1024}) {
+        cases.push_back(BenchmarkCase{BenchmarkOperation::WriteLines, PayloadKind::Text, linePayload, lineLength, "\n"});
+    }
+    return cases;
+}
+
+std::string SerialBenchmark::makeLinePayload(PayloadKind payloadKind, size_t lineLength, const std::string &terminator, size_t lineNumber)
+{
+    size_t contentLength{lineLength > terminator.length() ? lineLength - terminator.length() : 0};
+    std::string line(contentLength, '\0');
+    for (size_t i = 0; i < contentLength; i++) {
+        if (payloadKind == PayloadKind::Text) {
+            line[i] = static_cast<char>(' ' + ((lineNumber + i) % 95));
+        } else {
+            char c{static_cast<char>((lineNumber * 31 + i * 7) & 0xFF)};
+            //Terminator bytes inside the payload would split the line early
+            while (terminator.find(c) != std::string::npos) {
+                c = static_cast<char>(c + 1);
+            }
+            line[i] = c;
+        }
+    }
+    return line;
+}
+
+double SerialBenchmark::threadCpuSeconds()
+{
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+double SerialBenchmark::elapsedSeconds(const std::chrono::steady_clock::time_point &startTime)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+BenchmarkResult SerialBenchmark::runCase(const BenchmarkCase &benchmarkCase)
+{
+    switch (benchmarkCase.operation) {
+        case BenchmarkOperation::Read:
+            return this->benchmarkRead(benchmarkCase);
+        case BenchmarkOperation::ReadLine:
+        case BenchmarkOperation::ReadUntil:
+            return this->benchmarkReadUntil(benchmarkCase);
+        case BenchmarkOperation::WriteLine:
+        case BenchmarkOperation::WriteLines:
+            return this->benchmarkWriteLine(benchmarkCase);
+    }
+    throw std::runtime_error("SerialBenchmark::runCase(const BenchmarkCase &): unknown operation");
+}
+
+BenchmarkResult SerialBenchmark::benchmarkRead(const BenchmarkCase &benchmarkCase)
+{
+    PseudoTerminalPair pseudoTerminal{};
+    SerialPort serialPort{pseudoTerminal.slaveName()};
+    serialPort.openPort();
+    serialPort.setReadTimeout(READ_TIMEOUT);
+    serialPort.setRecorder(this->m_recorder);
+
+    BenchmarkResult result{benchmarkCase, 0, 0.0, 0.0, std::vector<double>{}, false, false};
+    const std::string payload{makeLinePayload(benchmarkCase.payloadKind, benchmarkCase.payloadBytes, "", 0)};
+    std::string received{};
+    received.reserve(payload.length());
+
+    std::atomic<bool> cancelled{false};
+    auto startTime = std::chrono::steady_clock::now();
+    double startCpu{threadCpuSeconds()};
+    std::thread feeder{[&]() { pseudoTerminal.writeToMaster(payload.data(), payload.length(), cancelled); }};
+    while (received.length() < payload.length()) {
+        ReadResult readResult{serialPort.read()};
+        if (readResult.status != ReadStatus::Byte) {
+            result.timedOut = true;
+            break;
+        }
+        received.push_back(readResult.value);
+    }
+    result.cpuSeconds = threadCpuSeconds() - startCpu;
+    result.seconds = elapsedSeconds(startTime);
+    cancelled.store(true);
+    feeder.join();
+
+    result.bytesTransferred = received.length();
+    result.verified = (received == payload);
+    serialPort.closePort();
+    return result;
+}
+
+BenchmarkResult SerialBenchmark::benchmarkReadUntil(const BenchmarkCase &benchmarkCase)
+{
+    PseudoTerminalPair pseudoTerminal{};
+    SerialPort serialPort{pseudoTerminal.slaveName()};
+    serialPort.openPort();
+    serialPort.setReadTimeout(READ_TIMEOUT);
+    serialPort.setRecorder(this->m_recorder);
+    serialPort.setLineEnding(benchmarkCase.terminator);
+    const bool useReadLine{benchmarkCase.operation == BenchmarkOperation::ReadLine};
+
+    BenchmarkResult result{benchmarkCase, 0, 0.0, 0.0, std::vector<double>{}, true, false};
+    const size_t lineCount{std::max<size_t>(benchmarkCase.payloadBytes / benchmarkCase.lineLength, 1)};
+    std::string payload{};
+    payload.reserve(lineCount * benchmarkCase.lineLength);
+    for (size_t i = 0; i < lineCount; i++) {
+        payload += makeLinePayload(benchmarkCase.payloadKind, benchmarkCase.lineLength, benchmarkCase.terminator, i);
+        payload += benchmarkCase.terminator;
+    }
+
+    std::atomic<bool> cancelled{false};
+    auto startTime = std::chrono::steady_clock::now();
+    double startCpu{threadCpuSeconds()};
+    std::thread feeder{[&]() { pseudoTerminal.writeToMaster(payload.data(), payload.length(), cancelled); }};
+    size_t payloadOffset{0};
+    ReadTimestamp previousTimestamp{0, 0};
+    for (size_t i = 0; i < lineCount; i++) {
+        bool timeout{false};
+        ReadTimestamp firstByteTimestamp{0, 0};
+        std::string line{useReadLine ? serialPort.readLine(&timeout) : serialPort.readUntil(benchmarkCase.terminator, &timeout, &firstByteTimestamp)};
+        if (timeout) {
+            result.timedOut = true;
+            break;
+        }
+        if (payload.compare(payloadOffset, line.length(), line) != 0) {
+            result.verified = false;
+        }
+        //Lines that start in bytes put back after a terminator must keep the time of the read that brought them in
+        if (!useReadLine) {
+            if ( (firstByteTimestamp.monotonic == 0) || (firstByteTimestamp.monotonic < previousTimestamp.monotonic) ) {
+                result.verified = false;
+            }
+            previousTimestamp = firstByteTimestamp;
+        }
+        payloadOffset += line.length() + benchmarkCase.terminator.length();
+    }
+    result.cpuSeconds = threadCpuSeconds() - startCpu;
+    result.seconds = elapsedSeconds(startTime);
+    cancelled.store(true);
+    feeder.join();
+    result.bytesTransferred = payloadOffset;
+    result.verified = result.verified && (payloadOffset == payload.length());
+
+    //Round trips on an idle port: one line in through the master, one call to get it back out
+    std::atomic<bool> neverCancelled{false};
+    for (size_t i = 0; (i < this->m_options.latencySamples) && (!result.timedOut); i++) {
+        std::string line{makeLinePayload(benchmarkCase.payloadKind, benchmarkCase.lineLength, benchmarkCase.terminator, i) + benchmarkCase.terminator};
+        bool timeout{false};
+        auto sampleStart = std::chrono::steady_clock::now();
+        pseudoTerminal.writeToMaster(line.data(), line.length(), neverCancelled);
+        std::string echoed{useReadLine ? serialPort.readLine(&timeout) : serialPort.readUntil(benchmarkCase.terminator, &timeout)};
+        result.latencies.push_back(elapsedSeconds(sampleStart) * 1000000.0);
+        if (timeout) {
+            result.timedOut = true;
+        } else if (echoed.length() + benchmarkCase.terminator.length() != line.length()) {
+            result.verified = false;
+        }
+    }
+    serialPort.closePort();
+    return result;
+}
+
+BenchmarkResult SerialBenchmark::benchmarkWriteLine(const BenchmarkCase &benchmarkCase)
+{
+    PseudoTerminalPair pseudoTerminal{};
+    SerialPort serialPort{pseudoTerminal.slaveName()};
+    serialPort.openPort();
+    serialPort.setReadTimeout(READ_TIMEOUT);
+    serialPort.setRecorder(this->m_recorder);
+    serialPort.setLineEnding(benchmarkCase.terminator);
+
+    BenchmarkResult result{benchmarkCase, 0, 0.0, 0.0, std::vector<double>{}, false, false};
+    const size_t lineCount{std::max<size_t>(benchmarkCase.payloadBytes / benchmarkCase.lineLength, 1)};
+    std::vector<std::string> lines{};
+    std::string expected{};
+    lines.reserve(lineCount);
+    expected.reserve(lineCount * benchmarkCase.lineLength);
+    for (size_t i = 0; i < lineCount; i++) {
+        lines.push_back(makeLinePayload(benchmarkCase.payloadKind, benchmarkCase.lineLength, benchmarkCase.terminator, i));
+        expected += lines.back();
+        expected += benchmarkCase.terminator;
+    }
+
+    std::string drained{};
+    drained.reserve(expected.length());
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> drainFinished{false};
+    auto startTime = std::chrono::steady_clock::now();
+    double startCpu{threadCpuSeconds()};
+    std::thread drainer{[&]() {
+        pseudoTerminal.readFromMaster(drained, expected.length(), cancelled);
+        drainFinished.store(true);
+    }};
+    if (benchmarkCase.operation == BenchmarkOperation::WriteLines) {
+        serialPort.writeLines(lines);
+    } else {
+        for (const auto &line : lines) {
+            if (serialPort.writeLine(line) < 0) {
+                break;
+            }
+        }
+    }
+    result.cpuSeconds = threadCpuSeconds() - startCpu;
+    //Throughput counts until the far end has everything, not until the kernel accepted it
+    auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{READ_TIMEOUT};
+    while ( (!drainFinished.load()) && (std::chrono::steady_clock::now() < drainDeadline) ) {
+        std::this_thread::sleep_for(std::chrono::microseconds{50});
+    }
+    cancelled.store(true);
+    drainer.join();
+    result.seconds = elapsedSeconds(startTime);
+    result.bytesTransferred = drained.length();
+    result.verified = (drained == expected);
+    result.timedOut = (drained.length() != expected.length());
+
+    std::atomic<bool> neverCancelled{false};
+    for (size_t i = 0; (i < this->m_options.latencySamples) && (!result.timedOut); i++) {
+        std::string echoed{};
+        auto sampleStart = std::chrono::steady_clock::now();
+        serialPort.writeLine(lines[i % lines.size()]);
+        pseudoTerminal.readFromMaster(echoed, lines[i % lines.size()].length() + benchmarkCase.terminator.length(), neverCancelled);
+        result.latencies.push_back(elapsedSeconds(sampleStart) * 1000000.0);
+    }
+    serialPort.closePort();
+    return result;
+}
+
+std::string SerialBenchmark::resultToJson(const BenchmarkResult &result)
+{
+    const double mebibytes{static_cast<double>(result.bytesTransferred) / static_cast<double>(MEBIBYTE)};
+    std::ostringstream json{};
+    json << std::fixed << std::setprecision(3);
+    json << R"({"operation": ")" << operationName(result.benchmarkCase.operation) << R"(")";
+    json << R"(, "payload": ")" << payloadKindName(result.benchmarkCase.payloadKind) << R"(")";
+    json << R"(, "payloadBytes": )" << result.benchmarkCase.payloadBytes;
+    json << R"(, "lineLength": )" << result.benchmarkCase.lineLength;
+    json << R"(, "terminator": ")" << BenchmarkUtilities::escapeJson(result.benchmarkCase.terminator) << R"(")";
+    json << R"(, "bytesTransferred": )" << result.bytesTransferred;
+    json << R"(, "seconds": )" << std::setprecision(6) << result.seconds;
+    json << R"(, "bytesPerSecond": )" << std::setprecision(0) << (result.seconds > 0.0 ? static_cast<double>(result.bytesTransferred) / result.seconds : 0.0);
+    json << R"(, "cpuSecondsPerMiB": )" << std::setprecision(6) << (mebibytes > 0.0 ? result.cpuSeconds / mebibytes : 0.0);
+    if (result.latencies.empty()) {
+        json << R"(, "latencyMicroseconds": null)";
+    } else {
+        std::vector<double> sortedLatencies{result.latencies};
+        std::sort(sortedLatencies.begin(), sortedLatencies.end());
+        json << std::setprecision(1);
+        json << R"(, "latencyMicroseconds": {"samples": )" << sortedLatencies.size();
+        json << R"(, "p50": )" << BenchmarkUtilities::percentile(sortedLatencies, 0.50);
+        json << R"(, "p90": )" << BenchmarkUtilities::percentile(sortedLatencies, 0.90);
+        json << R"(, "p99": )" << BenchmarkUtilities::percentile(sortedLatencies, 0.99);
+        json << R"(, "max": )" << sortedLatencies.back() << "}";
+    }
+    json << R"(, "verified": )" << (result.verified ? "true" : "false");
+    json << R"(, "timedOut": )" << (result.timedOut ? "true" : "false") << "}";
+    return json.str();
+}
+
+std::string SerialBenchmark::resultsToJson(const std::vector<BenchmarkResult> &results, bool isRecording)
+{
+    std::ostringstream json{};
+    json << "{" << std::endl;
+    json << R"(  "benchmark": "serial-pty-loopback",)" << std::endl;
+    json << R"(  "version": ")" << GlobalSettings::SOFTWARE_MAJOR_VERSION << "." << GlobalSettings::SOFTWARE_MINOR_VERSION << "." << GlobalSettings::SOFTWARE_PATCH_VERSION << R"(",)" << std::endl;
+    json << R"(  "byteSearch": ")" << ByteSearch::implementationName() << R"(",)" << std::endl;
+    json << R"(  "recording": )" << (isRecording ? "true" : "false") << "," << std::endl;
+    json << R"(  "results": [)" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        json << "    " << resultToJson(results[i]) << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    json << "  ]" << std::endl;
+    json << "}" << std::endl;
+    return json.str();
+}
+
+int SerialBenchmark::run()
+{
+    std::vector<BenchmarkResult> results{};
+    bool allPassed{true};
+    if (!this->m_options.recordPath.empty()) {
+        this->m_recorder = std::make_shared<SessionRecorder>();
+        this->m_recorder->start(this->m_options.recordPath);
+    }
+    for (const auto &benchmarkCase : defaultCases(this->m_options.quick)) {
+        if ( (!this->m_options.operationFilter.empty()) && (operationName(benchmarkCase.operation) != this->m_options.operationFilter) ) {
+            continue;
+        }
+        results.push_back(this->runCase(benchmarkCase));
+        allPassed = allPassed && results.back().verified && !results.back().timedOut;
+    }
+    if (this->m_recorder) {
+        this->m_recorder->stop();
+        allPassed = allPassed && !this->m_recorder->hasError() && (this->m_recorder->droppedRecords() == 0);
+    }
+    std::cout << resultsToJson(results, static_cast<bool>(this->m_recorder));
+    return (allPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void SerialBenchmark::displayHelp(const char *programName)
+{
+    std::cout << "Usage: " << programName << " [Option [=value]]" << std::endl;
+    std::cout << "Options: " << std::endl;
+    std::cout << "    -q, --quick: Use small payloads, for a smoke run" << std::endl;
+    std::cout << "    -o, --operation: Only run read, readLine, readUntil, writeLine or writeLines" << std::endl;
+    std::cout << "    -n, --latency-samples: Round trips measured per line case (default " << DEFAULT_LATENCY_SAMPLES << ")" << std::endl;
+    std::cout << "    -r, --record: Capture every case's traffic to this session file while measuring" << std::endl;
+    std::cout << "    -h, --help: Display this help text" << std::endl;
+}
+
+SerialBenchmarkOptions SerialBenchmark::parseOptions(int argc, char *argv[])
+{
+    SerialBenchmarkOptions options{false, "", DEFAULT_LATENCY_SAMPLES, ""};
+    int optionIndex{0};
+    int currentOption{0};
+    opterr = 0;
+    while ( (currentOption = getopt_long(argc, argv, "qo:n:r:h", benchmarkLongOptions, &optionIndex)) != -1) {
+        switch (currentOption) {
+            case 'q':
+                options.quick = true;
+                break;
+            case 'o':
+                options.operationFilter = optarg;
+                break;
+            case 'n':
+                options.latencySamples = static_cast<size_t>(std::stoul(optarg));
+                break;
+            case 'r':
+                options.recordPath = optarg;
+                break;
+            case 'h':
+                displayHelp(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                throw std::runtime_error("SerialBenchmark::parseOptions(int, char **): invalid switch \"" + std::string{argv[optind - 1]} + "\"");
+        }
+    }
+    return options;
+}
+
+int SerialBenchmark::main(int argc, char *argv[])
+{
+    try {
+        signal(SIGPIPE, SIG_IGN);
+        SerialBenchmark serialBenchmark{parseOptions(argc, argv)};
+        return serialBenchmark.run();
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
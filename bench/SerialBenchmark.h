@@ -0,0 +1,124 @@
+#ifndef QSERIALTERMINAL_SERIALBENCHMARK_H
+#define QSERIALTERMINAL_SERIALBENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "SessionRecorder.h"
+
+/*
+ * Loopback benchmark for the CppSerialPort I/O stack. Each case opens a
+ * fresh pseudo terminal pair, drives the slave through SerialPort and the
+ * master directly, and the results are printed to stdout as JSON. With
+ * --record every case also captures its traffic through a SessionRecorder,
+ * so cpuSecondsPerMiB shows what recording costs the reading thread
+ */
+class PseudoTerminalPair
+{
+public:
+    PseudoTerminalPair();
+    ~PseudoTerminalPair();
+
+    PseudoTerminalPair(const PseudoTerminalPair &other) = delete;
+    PseudoTerminalPair(PseudoTerminalPair &&other) = delete;
+    PseudoTerminalPair &operator=(const PseudoTerminalPair &rhs) = delete;
+    PseudoTerminalPair &operator=(PseudoTerminalPair &&rhs) = delete;
+
+    int masterFileDescriptor() const;
+    std::string slaveName() const;
+
+    bool writeToMaster(const char *data, size_t size, const std::atomic<bool> &cancelled);
+    bool readFromMaster(std::string &out, size_t size, const std::atomic<bool> &cancelled);
+
+private:
+    int m_masterFileDescriptor;
+    int m_slaveFileDescriptor;
+    std::string m_slaveName;
+
+    static const int constexpr POLL_INTERVAL{100};
+};
+
+enum class BenchmarkOperation {
+    Read,
+    ReadLine,
+    ReadUntil,
+    WriteLine,
+    WriteLines
+};
+
+enum class PayloadKind {
+    Text,
+    Binary
+};
+
+struct BenchmarkCase
+{
+    BenchmarkOperation operation;
+    PayloadKind payloadKind;
+    size_t payloadBytes;
+    size_t lineLength;
+    std::string terminator;
+};
+
+struct BenchmarkResult
+{
+    BenchmarkCase benchmarkCase;
+    size_t bytesTransferred;
+    double seconds;
+    double cpuSeconds;
+    std::vector<double> latencies;
+    bool verified;
+    bool timedOut;
+};
+
+struct SerialBenchmarkOptions
+{
+    bool quick;
+    std::string operationFilter;
+    size_t latencySamples;
+    std::string recordPath;
+};
+
+class SerialBenchmark
+{
+public:
+    explicit SerialBenchmark(const SerialBenchmarkOptions &options);
+
+    SerialBenchmark(const SerialBenchmark &other) = delete;
+    SerialBenchmark(SerialBenchmark &&other) = delete;
+    SerialBenchmark &operator=(const SerialBenchmark &rhs) = delete;
+    SerialBenchmark &operator=(SerialBenchmark &&rhs) = delete;
+
+    int run();
+
+    static int main(int argc, char *argv[]);
+    static SerialBenchmarkOptions parseOptions(int argc, char *argv[]);
+    static void displayHelp(const char *programName);
+    static std::vector<BenchmarkCase> defaultCases(bool quick);
+
+    static std::string operationName(BenchmarkOperation operation);
+    static std::string payloadKindName(PayloadKind payloadKind);
+    static std::string makeLinePayload(PayloadKind payloadKind, size_t lineLength, const std::string &terminator, size_t lineNumber);
+
+private:
+    SerialBenchmarkOptions m_options;
+    std::shared_ptr<CppSerialPort::SessionRecorder> m_recorder;
+
+    BenchmarkResult runCase(const BenchmarkCase &benchmarkCase);
+    BenchmarkResult benchmarkRead(const BenchmarkCase &benchmarkCase);
+    BenchmarkResult benchmarkReadUntil(const BenchmarkCase &benchmarkCase);
+    BenchmarkResult benchmarkWriteLine(const BenchmarkCase &benchmarkCase);
+
+    static std::string resultsToJson(const std::vector<BenchmarkResult> &results, bool isRecording);
+    static std::string resultToJson(const BenchmarkResult &result);
+    static double threadCpuSeconds();
+    static double elapsedSeconds(const std::chrono::steady_clock::time_point &startTime);
+
+    static const size_t constexpr DEFAULT_LATENCY_SAMPLES{1000};
+    static const int READ_TIMEOUT;
+};
+
+#endif //QSERIALTERMINAL_SERIALBENCHMARK_H
@@ -0,0 +1,6 @@
+#include "SerialBenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    return SerialBenchmark::main(argc, argv);
+}
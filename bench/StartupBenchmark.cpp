@@ -0,0 +1,251 @@
+#include "StartupBenchmark.h"
+#include "BenchmarkUtilities.h"
+#include "ApplicationSettings.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <csignal>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static struct option startupLongOptions[]{
+    { "runs", required_argument, nullptr, 'n' },
+    { "cli",  required_argument, nullptr, 'c' },
+    { "gui",  required_argument, nullptr, 'g' },
+    { "case", required_argument, nullptr, 'o' },
+    { "help", no_argument,       nullptr, 'h' },
+    { nullptr, 0, nullptr, 0 }
+};
+
+static const char *CLI_EXECUTABLE_NAME{"qserialterminal-cli"};
+static const char *GUI_EXECUTABLE_NAME{"QSerialTerminal"};
+
+const std::chrono::seconds StartupBenchmark::RUN_TIMEOUT{10};
+
+StartupBenchmark::StartupBenchmark(const StartupBenchmarkOptions &options) :
+    m_options{options}
+{
+
+}
+
+std::vector<StartupCase> StartupBenchmark::defaultCases(const std::string &cliPath, const std::string &guiPath)
+{
+    return std::vector<StartupCase>{
+        StartupCase{"cli-version", cliPath, {"--version"}},
+        StartupCase{"cli-help", cliPath, {"--help"}},
+        StartupCase{"gui-version", guiPath, {"--version"}},
+        StartupCase{"gui-first-window", guiPath, {"--exit-after-first-frame"}}
+    };
+}
+
+int StartupBenchmark::run()
+{
+    std::vector<StartupResult> results{};
+    for (const auto &it : defaultCases(this->m_options.cliPath, this->m_options.guiPath)) {
+        if ( (!this->m_options.caseFilter.empty()) && (it.name != this->m_options.caseFilter) ) {
+            continue;
+        }
+        std::cerr << "Running " << it.name << "..." << std::endl;
+        results.push_back(this->runCase(it));
+    }
+    std::cout << resultsToJson(results);
+    for (const auto &it : results) {
+        if ( (it.failures > 0) || (it.timeouts > 0) ) {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+StartupResult StartupBenchmark::runCase(const StartupCase &startupCase)
+{
+    StartupResult result{startupCase, false, 0, 0, {}, {}, 0};
+    //A build without the graphical target still gets its command line numbers
+    if (access(startupCase.program.c_str(), X_OK) != 0) {
+        result.skipped = true;
+        return result;
+    }
+    std::vector<char *> arguments{};
+    arguments.push_back(const_cast<char *>(startupCase.program.c_str()));
+    for (const auto &it : startupCase.arguments) {
+        arguments.push_back(const_cast<char *>(it.c_str()));
+    }
+    arguments.push_back(nullptr);
+
+    //SIGCHLD stays blocked so the exit can be waited for with a timeout, without a watchdog thread competing for the CPU
+    sigset_t childSignal{};
+    sigset_t oldSignalMask{};
+    sigemptyset(&childSignal);
+    sigaddset(&childSignal, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childSignal, &oldSignalMask);
+    for (size_t i = 0; i < this->m_options.runs; i++) {
+        auto startTime = std::chrono::steady_clock::now();
+        pid_t childPid{fork()};
+        if (childPid == -1) {
+            sigprocmask(SIG_SETMASK, &oldSignalMask, nullptr);
+            throw std::runtime_error("StartupBenchmark::runCase(const StartupCase &): fork failed (" + std::string{strerror(errno)} + ")");
+        }
+        if (childPid == 0) {
+            sigprocmask(SIG_SETMASK, &oldSignalMask, nullptr);
+            int nullFileDescriptor{open("/dev/null", O_RDWR)};
+            if (nullFileDescriptor != -1) {
+                dup2(nullFileDescriptor, STDIN_FILENO);
+                dup2(nullFileDescriptor, STDOUT_FILENO);
+                dup2(nullFileDescriptor, STDERR_FILENO);
+            }
+            execv(arguments[0], arguments.data());
+            _exit(127);
+        }
+        timespec timeout{static_cast<time_t>(RUN_TIMEOUT.count()), 0};
+        int signalNumber{-1};
+        do {
+            signalNumber = sigtimedwait(&childSignal, nullptr, &timeout);
+        } while ( (signalNumber == -1) && (errno == EINTR) );
+        bool timedOut{signalNumber == -1};
+        if (timedOut) {
+            kill(childPid, SIGKILL);
+        }
+        int exitStatus{0};
+        rusage childUsage{};
+        wait4(childPid, &exitStatus, 0, &childUsage);
+        double wallSeconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()};
+        if (timedOut) {
+            result.timeouts++;
+            continue;
+        }
+        if ( (!WIFEXITED(exitStatus)) || (WEXITSTATUS(exitStatus) != EXIT_SUCCESS) ) {
+            result.failures++;
+            continue;
+        }
+        double cpuSeconds{static_cast<double>(childUsage.ru_utime.tv_sec + childUsage.ru_stime.tv_sec) +
+                          static_cast<double>(childUsage.ru_utime.tv_usec + childUsage.ru_stime.tv_usec) / 1000000.0};
+        result.wallMilliseconds.push_back(wallSeconds * 1000.0);
+        result.cpuMilliseconds.push_back(cpuSeconds * 1000.0);
+        result.maxResidentKibibytes = std::max(result.maxResidentKibibytes, childUsage.ru_maxrss);
+    }
+    sigprocmask(SIG_SETMASK, &oldSignalMask, nullptr);
+    return result;
+}
+
+std::string StartupBenchmark::resultToJson(const StartupResult &result)
+{
+    std::ostringstream json{};
+    json << std::fixed << std::setprecision(3);
+    json << R"({"case": ")" << BenchmarkUtilities::escapeJson(result.startupCase.name) << R"(")";
+    json << R"(, "program": ")" << BenchmarkUtilities::escapeJson(result.startupCase.program) << R"(")";
+    if (result.skipped) {
+        json << R"(, "skipped": true})";
+        return json.str();
+    }
+    std::vector<double> sortedWall{result.wallMilliseconds};
+    std::vector<double> sortedCpu{result.cpuMilliseconds};
+    std::sort(sortedWall.begin(), sortedWall.end());
+    std::sort(sortedCpu.begin(), sortedCpu.end());
+    json << R"(, "runs": )" << sortedWall.size();
+    json << R"(, "failures": )" << result.failures;
+    json << R"(, "timeouts": )" << result.timeouts;
+    if (sortedWall.empty()) {
+        json << R"(, "wallMilliseconds": null, "cpuMilliseconds": null)";
+    } else {
+        json << R"(, "wallMilliseconds": {"min": )" << sortedWall.front();
+        json << R"(, "p50": )" << BenchmarkUtilities::percentile(sortedWall, 0.50);
+        json << R"(, "p90": )" << BenchmarkUtilities::percentile(sortedWall, 0.90);
+        json << R"(, "max": )" << sortedWall.back() << "}";
+        json << R"(, "cpuMilliseconds": {"p50": )" << BenchmarkUtilities::percentile(sortedCpu, 0.50);
+        json << R"(, "p90": )" << BenchmarkUtilities::percentile(sortedCpu, 0.90) << "}";
+    }
+    json << R"(, "maxResidentKiB": )" << result.maxResidentKibibytes << "}";
+    return json.str();
+}
+
+std::string StartupBenchmark::resultsToJson(const std::vector<StartupResult> &results)
+{
+    std::ostringstream json{};
+    json << "{" << std::endl;
+    json << R"(  "benchmark": "startup",)" << std::endl;
+    json << R"(  "version": ")" << GlobalSettings::SOFTWARE_MAJOR_VERSION << "." << GlobalSettings::SOFTWARE_MINOR_VERSION << "." << GlobalSettings::SOFTWARE_PATCH_VERSION << R"(",)" << std::endl;
+    json << R"(  "results": [)" << std::endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        json << "    " << resultToJson(results[i]) << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    json << "  ]" << std::endl;
+    json << "}" << std::endl;
+    return json.str();
+}
+
+std::string StartupBenchmark::executableDirectory()
+{
+    char executablePath[PATH_MAX];
+    ssize_t pathLength{readlink("/proc/self/exe", executablePath, sizeof(executablePath) - 1)};
+    if (pathLength <= 0) {
+        return ".";
+    }
+    std::string returnString{executablePath, static_cast<size_t>(pathLength)};
+    return returnString.substr(0, returnString.rfind('/'));
+}
+
+void StartupBenchmark::displayHelp(const char *programName)
+{
+    std::cout << "Usage: " << programName << " [Option [=value]]" << std::endl;
+    std::cout << "Options: " << std::endl;
+    std::cout << "    -n, --runs: Times each case is started (default " << DEFAULT_RUNS << ")" << std::endl;
+    std::cout << "    -c, --cli: Command line executable to time (default " << CLI_EXECUTABLE_NAME << " next to this program)" << std::endl;
+    std::cout << "    -g, --gui: Graphical executable to time (default " << GUI_EXECUTABLE_NAME << " next to this program, skipped if missing)" << std::endl;
+    std::cout << "    -o, --case: Only run cli-version, cli-help, gui-version or gui-first-window" << std::endl;
+    std::cout << "    -h, --help: Display this help text" << std::endl;
+}
+
+StartupBenchmarkOptions StartupBenchmark::parseOptions(int argc, char *argv[])
+{
+    std::string executableDirectory{StartupBenchmark::executableDirectory()};
+    StartupBenchmarkOptions options{DEFAULT_RUNS, executableDirectory + "/" + CLI_EXECUTABLE_NAME, executableDirectory + "/" + GUI_EXECUTABLE_NAME, ""};
+    int optionIndex{0};
+    int currentOption{0};
+    opterr = 0;
+    while ( (currentOption = getopt_long(argc, argv, "n:c:g:o:h", startupLongOptions, &optionIndex)) != -1) {
+        switch (currentOption) {
+            case 'n':
+                options.runs = static_cast<size_t>(std::stoul(optarg));
+                break;
+            case 'c':
+                options.cliPath = optarg;
+                break;
+            case 'g':
+                options.guiPath = optarg;
+                break;
+            case 'o':
+                options.caseFilter = optarg;
+                break;
+            case 'h':
+                displayHelp(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                throw std::runtime_error("StartupBenchmark::parseOptions(int, char **): invalid switch \"" + std::string{argv[optind - 1]} + "\"");
+        }
+    }
+    return options;
+}
+
+int StartupBenchmark::main(int argc, char *argv[])
+{
+    try {
+        StartupBenchmark startupBenchmark{parseOptions(argc, argv)};
+        return startupBenchmark.run();
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
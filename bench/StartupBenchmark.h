@@ -0,0 +1,73 @@
+#ifndef QSERIALTERMINAL_STARTUPBENCHMARK_H
+#define QSERIALTERMINAL_STARTUPBENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+/*
+ * Startup benchmark for the terminal executables. Each case runs a program
+ * to completion a number of times, with its output thrown away, and the
+ * wall clock time from fork to exit is printed to stdout as JSON. The cases
+ * cover time to --version and --help for the command line and graphical
+ * builds, and time to the first painted window, which the graphical build
+ * reports by quitting when started with --exit-after-first-frame (it needs
+ * a display, or QT_QPA_PLATFORM=offscreen)
+ */
+struct StartupCase
+{
+    std::string name;
+    std::string program;
+    std::vector<std::string> arguments;
+};
+
+struct StartupResult
+{
+    StartupCase startupCase;
+    bool skipped;
+    size_t failures;
+    size_t timeouts;
+    std::vector<double> wallMilliseconds;
+    std::vector<double> cpuMilliseconds;
+    long maxResidentKibibytes;
+};
+
+struct StartupBenchmarkOptions
+{
+    size_t runs;
+    std::string cliPath;
+    std::string guiPath;
+    std::string caseFilter;
+};
+
+class StartupBenchmark
+{
+public:
+    explicit StartupBenchmark(const StartupBenchmarkOptions &options);
+
+    StartupBenchmark(const StartupBenchmark &other) = delete;
+    StartupBenchmark(StartupBenchmark &&other) = delete;
+    StartupBenchmark &operator=(const StartupBenchmark &rhs) = delete;
+    StartupBenchmark &operator=(StartupBenchmark &&rhs) = delete;
+
+    int run();
+
+    static int main(int argc, char *argv[]);
+    static StartupBenchmarkOptions parseOptions(int argc, char *argv[]);
+    static void displayHelp(const char *programName);
+    static std::vector<StartupCase> defaultCases(const std::string &cliPath, const std::string &guiPath);
+
+private:
+    StartupBenchmarkOptions m_options;
+
+    StartupResult runCase(const StartupCase &startupCase);
+
+    static std::string resultsToJson(const std::vector<StartupResult> &results);
+    static std::string resultToJson(const StartupResult &result);
+    static std::string executableDirectory();
+
+    static const size_t constexpr DEFAULT_RUNS{20};
+    static const std::chrono::seconds RUN_TIMEOUT;
+};
+
+#endif //QSERIALTERMINAL_STARTUPBENCHMARK_H
@@ -0,0 +1,6 @@
+#include "StartupBenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    return StartupBenchmark::main(argc, argv);
+}
@@ -16,6 +16,9 @@ const char * const DATA_BITS_ACTION_KEY{"DataBits"};
 const char * const FLOW_CONTROL_ACTION_KEY{"FlowControl"};
 const char * const LINE_ENDING_ACTION_KEY{"LineEnding"};
 const char * const PORT_NAME_ACTION_KEY{"PortName"};
+const char * const PORT_NAME_DESCRIPTION_STRING{"%1 - %2"};
+const char * const DISPLAY_MODE_ACTION_KEY{"DisplayMode"};
+const char * const TIMESTAMP_MODE_ACTION_KEY{"TimestampMode"};
 const char * const QUIT_PROMPT_STRING{"Are you sure you want to quit?"};
 const char * const QUIT_PROMPT_WINDOW_TITLE_STRING{"Quit QSerialTerminal?"};
 const char * const INVALID_SETTINGS_DETECTED_STRING{"Invalid settings detected, please reselect serial port settings: "};
@@ -31,6 +34,77 @@ const char * const LICENSE_PATH_KEY{"LicensePath"};
 
 const char * const TERMINAL_RECEIVE_BASE_STRING{"Rx << "};
 const char * const TERMINAL_TRANSMIT_BASE_STRING{"Tx >> "};
+//U+2400 SYMBOL FOR NULL, spelled out in UTF-8 so it can be spliced straight into a received line
+const char * const NUL_DISPLAY_UTF8_STRING{"\xE2\x90\x80"};
+const char * const LINES_PER_FLUSH_STRING{"Lines per flush: %1 (peak %2)"};
+const char * const TRANSMIT_QUEUED_STRING{"Tx queued: %1 bytes"};
+const char * const TRANSMIT_STALLED_STRING{"Tx stalled, %1 bytes waiting for flow control"};
+const char * const TRANSMIT_QUEUE_FULL_STRING{"Transmit queue is full (%1 bytes waiting), line was not sent"};
+const char * const TRANSMIT_PORT_NOT_OPEN_STRING{"%1 is not open, line was not sent"};
+const char * const LOAD_SCRIPT_STRING{"Load Script"};
+const char * const STOP_SCRIPT_STRING{"Stop Script"};
+const char * const LOAD_SCRIPT_DIALOG_TITLE_STRING{"Load Script"};
+const char * const SCRIPT_STARTED_STRING{"Running script %1"};
+const char * const SCRIPT_PROGRESS_STRING{"Script %1: %2% sent (%3 lines, %4 kB/s)"};
+const char * const SCRIPT_FINISHED_STRING{"Script %1 finished: %2 lines in %3 s (%4 kB/s)"};
+const char * const SCRIPT_CANCELLED_STRING{"Script %1 stopped after %2 lines"};
+const char * const SCRIPT_FAILED_STRING{"Script failed: %1"};
+const char * const SEND_FILE_STRING{"Send File..."};
+const char * const RECEIVE_FILE_STRING{"Receive File..."};
+const char * const CANCEL_TRANSFER_STRING{"Cancel Transfer"};
+const char * const SEND_FILE_DIALOG_TITLE_STRING{"Send File"};
+const char * const RECEIVE_FILE_DIALOG_TITLE_STRING{"Receive File"};
+const char * const RECEIVE_DIRECTORY_DIALOG_TITLE_STRING{"Receive Files Into"};
+const char * const TRANSFER_PROTOCOL_DIALOG_TITLE_STRING{"File Transfer"};
+const char * const TRANSFER_PROTOCOL_LABEL_STRING{"Protocol:"};
+const char * const TRANSFER_WAITING_STRING{"%1: waiting for the other end"};
+const char * const TRANSFER_PROGRESS_STRING{"%1 %2: %3 of %4 bytes (%5 kB/s, %6 errors)"};
+const char * const TRANSFER_FINISHED_STRING{"%1 transfer finished: %2 files, %3 bytes in %4 s (%5 kB/s)"};
+const char * const TRANSFER_CANCELLED_STRING{"%1 transfer cancelled"};
+const char * const TRANSFER_FAILED_STRING{"%1 transfer failed: %2"};
+const char * const RECORD_SESSION_STRING{"Record Session..."};
+const char * const STOP_RECORDING_STRING{"Stop Recording"};
+const char * const RECORD_SESSION_DIALOG_TITLE_STRING{"Record Session To"};
+const char * const RECORDING_STARTED_STRING{"Recording session to %1"};
+const char * const RECORDING_STOPPED_STRING{"Recorded %1 bytes to %2"};
+const char * const RECORDING_DROPPED_STRING{"Recorded %1 bytes to %2 (%3 chunks dropped, the disk fell behind)"};
+const char * const RECORDING_FAILED_STRING{"Recording to %1 failed: %2"};
+const char * const REPLAY_SESSION_STRING{"Replay Session..."};
+const char * const STOP_REPLAY_STRING{"Stop Replay"};
+const char * const REPLAY_SESSION_DIALOG_TITLE_STRING{"Replay Session"};
+const char * const REPLAY_MODE_DIALOG_TITLE_STRING{"Replay Session"};
+const char * const REPLAY_MODE_LABEL_STRING{"Timing:"};
+const char * const REPLAY_MODE_TIMED_STRING{"Original timing"};
+const char * const REPLAY_MODE_MAXIMUM_SPEED_STRING{"Maximum speed"};
+const char * const DISCONNECT_TO_REPLAY_STRING{"Disconnect from the serial port before replaying a session"};
+const char * const REPLAY_PROGRESS_STRING{"Replaying %1: %2 of %3 bytes"};
+const char * const REPLAY_FINISHED_STRING{"Replayed %1 bytes in %2 s (%3 MB/s)"};
+const char * const REPLAY_CANCELLED_STRING{"Replay of %1 stopped"};
+const char * const REPLAY_FAILED_STRING{"Replay of %1 failed: %2"};
+const char * const OPEN_CAPTURE_DIALOG_TITLE_STRING{"Open Capture"};
+const char * const OPEN_CAPTURE_FAILED_STRING{"Unable to open %1: %2"};
+const char * const CAPTURE_VIEWER_TITLE_STRING{"%1 - %2 lines"};
+const char * const CAPTURE_VIEWER_INDEXING_TITLE_STRING{"%1 - indexing, %2% (%3 lines so far)"};
+const char * const CAPTURE_GO_TO_DIALOG_TITLE_STRING{"Go To"};
+const char * const CAPTURE_GO_TO_LABEL_STRING{"Byte offset, or @seconds into the recording:"};
+const char * const SEARCH_PLACEHOLDER_STRING{"Find"};
+const char * const SEARCH_REGEX_STRING{"Regex"};
+const char * const SEARCH_MATCH_CASE_STRING{"Match case"};
+const char * const SEARCH_PREVIOUS_STRING{"Previous"};
+const char * const SEARCH_NEXT_STRING{"Next"};
+const char * const SEARCH_RUNNING_STRING{"Searching, %1% (%2 matches so far)"};
+const char * const SEARCH_RESULT_STRING{"%1 of %2"};
+const char * const SEARCH_TRUNCATED_RESULT_STRING{"%1 of %2 (stopped at the match limit)"};
+const char * const SEARCH_NO_MATCHES_STRING{"No matches"};
+const char * const SEARCH_LINE_GONE_STRING{"%1 of %2 (line has left the scrollback)"};
+const char * const INTERPOLATE_TIMESTAMPS_STRING{"Interpolate Timestamps By Baud Rate"};
+const char * const MONITOR_PORTS_DIALOG_TITLE_STRING{"Monitor Ports"};
+const char * const NO_PORTS_TO_MONITOR_STRING{"No other serial ports are available to monitor"};
+const char * const MONITOR_PORT_FAILED_STRING{"Unable to monitor %1: %2"};
+const char * const PORT_SESSIONS_TITLE_STRING{"Port Monitor - %1 ports"};
+const char * const PORT_SESSION_DISCONNECTED_TAB_STRING{"%1 (disconnected)"};
+const char * const REACTOR_LOAD_STRING{"%1 ports %2%"};
+const char * const REACTOR_STATISTICS_STRING{"Reactor %1: %2 ports, %3 wakeups, %4 chunks, %5 bytes"};
 const char * const NO_SERIAL_PORTS_CONNECTED_STRING{"No serial ports connected"};
 const char * const CONNECT_TO_SERIAL_PORT_TO_BEGIN_STRING{"Select a serial port and press connect"};
 
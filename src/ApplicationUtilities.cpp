@@ -478,7 +478,8 @@ std::string buildShortOptions(option *longOptions, size_t numberOfLongOptions)
     std::string returnString{""};
     for (size_t i = 0; i < numberOfLongOptions; i++) {
         option *currentOption{longOptions + i};
-        if (currentOption->val == 0) {
+        //Options that only set a flag have no short form
+        if ( (currentOption->val == 0) || (currentOption->flag != nullptr) ) {
             continue;
         }
         returnString += static_cast<char>(currentOption->val);
@@ -557,6 +558,24 @@ std::string flowControlToString(CppSerialPort::FlowControl flowControl) {
 
 }
 
+std::string displayModeToString(CppSerialPort::DisplayMode displayMode) {
+    switch (displayMode) {
+        case CppSerialPort::DisplayMode::Text:    return "Text";
+        case CppSerialPort::DisplayMode::Escaped: return "Escaped";
+        case CppSerialPort::DisplayMode::Hex:     return "Hex";
+    }
+    Q_UNREACHABLE();
+}
+
+std::string timestampModeToString(CppSerialPort::TimestampMode timestampMode) {
+    switch (timestampMode) {
+        case CppSerialPort::TimestampMode::None:      return "No Timestamps";
+        case CppSerialPort::TimestampMode::Monotonic: return "Monotonic Timestamps";
+        case CppSerialPort::TimestampMode::Realtime:  return "Wall Clock Timestamps";
+    }
+    Q_UNREACHABLE();
+}
+
 std::string baudRateToString(CppSerialPort::BaudRate baudRate) {
 #if defined(_WIN32)
     switch (baudRate) {
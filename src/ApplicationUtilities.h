@@ -22,6 +22,7 @@
 #endif //!defined(_MSC_VER)
 
 #include "SerialPort.h"
+#include "ByteFormatter.h"
 
 class QFile;
 class QByteArray;
@@ -218,10 +219,15 @@ std::string stopBitsToString(CppSerialPort::StopBits stopBits);
 std::string parityToString(CppSerialPort::Parity parity);
 std::string flowControlToString(CppSerialPort::FlowControl flowControl);
 std::string baudRateToString(CppSerialPort::BaudRate baudRate);
+std::string displayModeToString(CppSerialPort::DisplayMode displayMode);
+std::string timestampModeToString(CppSerialPort::TimestampMode timestampMode);
 
 
 template <typename T> inline std::string toStdString(const T &t) {
-    return dynamic_cast<std::ostringstream &>(std::ostringstream{} << t).str();
+    //Streaming into a temporary gives back an rvalue reference from GCC 11 on, which cannot be cast to an lvalue one
+    std::ostringstream stream{};
+    stream << t;
+    return stream.str();
 }
 
 template<> inline std::string toStdString(const CppSerialPort::BaudRate &baudRate) { return baudRateToString(baudRate); }
@@ -229,6 +235,8 @@ template<> inline std::string toStdString(const CppSerialPort::StopBits &stopBit
 template<> inline std::string toStdString(const CppSerialPort::Parity &parity) { return parityToString(parity); }
 template<> inline std::string toStdString(const CppSerialPort::FlowControl &flowControl) { return flowControlToString(flowControl); }
 template<> inline std::string toStdString(const CppSerialPort::DataBits &dataBits) { return dataBitsToString(dataBits); }
+template<> inline std::string toStdString(const CppSerialPort::DisplayMode &displayMode) { return displayModeToString(displayMode); }
+template<> inline std::string toStdString(const CppSerialPort::TimestampMode &timestampMode) { return timestampModeToString(timestampMode); }
 
 
 }
@@ -0,0 +1,274 @@
+/***********************************************************************
+*    ByteFormatter.cpp:                                                *
+*    ByteFormatter, escaped and hex dump views of received bytes       *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a ByteFormatter class       *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "ByteFormatter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#    define CPPSERIALPORT_HAVE_SSE2
+#    define CPPSERIALPORT_TARGET_SSE2 __attribute__((target("sse2")))
+#    include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#    define CPPSERIALPORT_HAVE_SSE2
+#    define CPPSERIALPORT_TARGET_SSE2
+#    include <emmintrin.h>
+#    include <intrin.h>
+#endif
+
+namespace CppSerialPort {
+
+const size_t ByteFormatter::HEX_DUMP_BYTES_PER_LINE{16};
+
+static const char HEX_DIGITS[]{"0123456789abcdef"};
+static const size_t ESCAPE_BUFFER_SIZE{256};
+
+namespace {
+
+struct FormatTables
+{
+    //Every escape fits in four characters (\xHH), so the longest one is a single fixed size copy
+    char escapes[256][4];
+    unsigned char escapeLengths[256];
+    bool isPlain[256];
+    char hexPairs[256][2];
+    char asciiGutter[256];
+
+    FormatTables()
+    {
+        for (unsigned value = 0; value < 256; value++) {
+            bool isPrintable{(value >= 0x20) && (value < 0x7F)};
+            this->isPlain[value] = (isPrintable && (value != '\\'));
+            this->hexPairs[value][0] = HEX_DIGITS[value >> 4];
+            this->hexPairs[value][1] = HEX_DIGITS[value & 0x0F];
+            this->asciiGutter[value] = (isPrintable ? static_cast<char>(value) : '.');
+            const char *escape{nullptr};
+            switch (value) {
+                case '\r': escape = "\\r"; break;
+                case '\n': escape = "\\n"; break;
+                case '\t': escape = "\\t"; break;
+                case '\0': escape = "\\0"; break;
+                case '\\': escape = "\\\\"; break;
+                default: break;
+            }
+            if (escape) {
+                memcpy(this->escapes[value], escape, 2);
+                this->escapeLengths[value] = 2;
+            } else if (this->isPlain[value]) {
+                this->escapes[value][0] = static_cast<char>(value);
+                this->escapeLengths[value] = 1;
+            } else {
+                this->escapes[value][0] = '\\';
+                this->escapes[value][1] = 'x';
+                this->escapes[value][2] = this->hexPairs[value][0];
+                this->escapes[value][3] = this->hexPairs[value][1];
+                this->escapeLengths[value] = 4;
+            }
+        }
+    }
+};
+
+const FormatTables &formatTables()
+{
+    static const FormatTables tables{};
+    return tables;
+}
+
+} //namespace
+
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+static inline unsigned countTrailingZeros(unsigned value)
+{
+#if defined(_MSC_VER)
+    unsigned long index{0};
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+#endif //defined(CPPSERIALPORT_HAVE_SSE2)
+
+void ByteFormatter::appendEscaped(const char *data, size_t size, std::string *output, bool breakAfterLineFeed)
+{
+    const FormatTables &tables{formatTables()};
+    const RunLengthFunction runLength{implementation()};
+    const char *position{data};
+    const char *end{data + size};
+    while (position < end) {
+        size_t plainBytes{runLength(position, end)};
+        output->append(position, plainBytes);
+        position += plainBytes;
+        //Escapes come in clusters (a line ending, a binary payload), so stay on the table until the next printable byte,
+        //copying every entry at its full four characters into a local buffer and only advancing by its real length
+        char escaped[ESCAPE_BUFFER_SIZE];
+        size_t escapedLength{0};
+        while ( (position < end) && (!tables.isPlain[static_cast<unsigned char>(*position)]) ) {
+            auto value = static_cast<unsigned char>(*position);
+            memcpy(escaped + escapedLength, tables.escapes[value], 4);
+            escapedLength += tables.escapeLengths[value];
+            if ( (breakAfterLineFeed) && (value == '\n') ) {
+                escaped[escapedLength++] = '\n';
+            }
+            if (escapedLength > ESCAPE_BUFFER_SIZE - 5) {
+                output->append(escaped, escapedLength);
+                escapedLength = 0;
+            }
+            position++;
+        }
+        output->append(escaped, escapedLength);
+    }
+}
+
+void ByteFormatter::appendHexDumpLine(uint64_t offset, const char *data, size_t size, std::string *output)
+{
+    const FormatTables &tables{formatTables()};
+    size = std::min(size, HEX_DUMP_BYTES_PER_LINE);
+    //Offsets past 4GB would otherwise push every column after them out of line
+    const unsigned offsetDigits{offset > 0xFFFFFFFFull ? 16u : 8u};
+    //Offset, two spaces, 16 three character cells with an extra space in the middle, a space, then |ASCII|
+    const size_t lineLength{offsetDigits + 2 + (HEX_DUMP_BYTES_PER_LINE * 3) + 2 + size + 2};
+    const size_t lineStart{output->size()};
+    //Sized up front with every gap already a space, so only the filled positions are written
+    output->resize(lineStart + lineLength, ' ');
+    char *position{&(*output)[lineStart]};
+    for (unsigned digit = offsetDigits; digit > 0; digit--) {
+        *position++ = HEX_DIGITS[(offset >> ((digit - 1) * 4)) & 0x0F];
+    }
+    position += 2;
+    for (size_t i = 0; i < HEX_DUMP_BYTES_PER_LINE; i++) {
+        if (i < size) {
+            memcpy(position, tables.hexPairs[static_cast<unsigned char>(data[i])], 2);
+        }
+        position += (i == (HEX_DUMP_BYTES_PER_LINE / 2) - 1 ? 4 : 3);
+    }
+    position++;
+    *position++ = '|';
+    for (size_t i = 0; i < size; i++) {
+        *position++ = tables.asciiGutter[static_cast<unsigned char>(data[i])];
+    }
+    *position = '|';
+}
+
+void ByteFormatter::appendTimestamp(const ReadTimestamp &timestamp, TimestampMode timestampMode, std::string *output)
+{
+    char formatted[64];
+    int formattedLength{0};
+    if (timestampMode == TimestampMode::Monotonic) {
+        formattedLength = snprintf(formatted, sizeof(formatted), "[%5llu.%06llu] ", static_cast<unsigned long long>(timestamp.monotonic / 1000000000ull),
+                                   static_cast<unsigned long long>((timestamp.monotonic % 1000000000ull) / 1000ull));
+    } else if (timestampMode == TimestampMode::Realtime) {
+        //Lines come many to a second, so the calendar part is only worked out again once the second changes
+        static thread_local time_t cachedSeconds{-1};
+        static thread_local char cachedCalendar[32]{};
+        auto seconds = static_cast<time_t>(timestamp.realtime / 1000000000ull);
+        if (seconds != cachedSeconds) {
+            tm localTime{};
+#if defined(_WIN32)
+            localtime_s(&localTime, &seconds);
+#else
+            localtime_r(&seconds, &localTime);
+#endif //defined(_WIN32)
+            strftime(cachedCalendar, sizeof(cachedCalendar), "%Y-%m-%d %H:%M:%S", &localTime);
+            cachedSeconds = seconds;
+        }
+        formattedLength = snprintf(formatted, sizeof(formatted), "[%s.%06llu] ", cachedCalendar, static_cast<unsigned long long>((timestamp.realtime % 1000000000ull) / 1000ull));
+    }
+    if (formattedLength > 0) {
+        output->append(formatted, std::min(static_cast<size_t>(formattedLength), sizeof(formatted) - 1));
+    }
+}
+
+size_t ByteFormatter::printableRunLength(const char *begin, const char *end)
+{
+    return implementation()(begin, end);
+}
+
+size_t ByteFormatter::printableRunLengthScalar(const char *begin, const char *end)
+{
+    const FormatTables &tables{formatTables()};
+    const char *position{begin};
+    while ( (position < end) && (tables.isPlain[static_cast<unsigned char>(*position)]) ) {
+        position++;
+    }
+    return static_cast<size_t>(position - begin);
+}
+
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+CPPSERIALPORT_TARGET_SSE2 size_t ByteFormatter::printableRunLengthSse2(const char *begin, const char *end)
+{
+    if (end <= begin) {
+        return 0;
+    }
+    const size_t size{static_cast<size_t>(end - begin)};
+    //Signed compares, so bytes from 0x80 up are negative and fall below the lower bound with the control characters
+    const __m128i belowPrintable{_mm_set1_epi8(0x1F)};
+    const __m128i abovePrintable{_mm_set1_epi8(0x7F)};
+    const __m128i backslash{_mm_set1_epi8('\\')};
+    size_t offset{0};
+    for (; offset + sizeof(__m128i) <= size; offset += sizeof(__m128i)) {
+        __m128i block{_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + offset))};
+        __m128i isPlain{_mm_and_si128(_mm_cmpgt_epi8(block, belowPrintable), _mm_cmplt_epi8(block, abovePrintable))};
+        isPlain = _mm_andnot_si128(_mm_cmpeq_epi8(block, backslash), isPlain);
+        auto plainMask = static_cast<unsigned>(_mm_movemask_epi8(isPlain));
+        if (plainMask != 0xFFFFu) {
+            return offset + countTrailingZeros(~plainMask);
+        }
+    }
+    return offset + printableRunLengthScalar(begin + offset, end);
+}
+#else
+size_t ByteFormatter::printableRunLengthSse2(const char *begin, const char *end)
+{
+    return printableRunLengthScalar(begin, end);
+}
+#endif //defined(CPPSERIALPORT_HAVE_SSE2)
+
+ByteFormatter::RunLengthFunction ByteFormatter::selectImplementation()
+{
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+#    if !defined(_MSC_VER)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        return &ByteFormatter::printableRunLengthSse2;
+    }
+#    else
+    return &ByteFormatter::printableRunLengthSse2;
+#    endif
+#endif
+    return &ByteFormatter::printableRunLengthScalar;
+}
+
+ByteFormatter::RunLengthFunction ByteFormatter::implementation()
+{
+    //Picked once, the first time anything is formatted
+    static const RunLengthFunction selectedImplementation{selectImplementation()};
+    return selectedImplementation;
+}
+
+const char *ByteFormatter::implementationName()
+{
+    if (implementation() == &ByteFormatter::printableRunLengthSse2) {
+        return "sse2";
+    }
+    return "scalar";
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,78 @@
+/***********************************************************************
+*    ByteFormatter.h:                                                  *
+*    ByteFormatter, escaped and hex dump views of received bytes       *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a ByteFormatter class         *
+*    Both views are driven by 256 entry tables built once, and write   *
+*    straight into the end of the caller's std::string. The escaped    *
+*    view copies runs of printable bytes in bulk, finding the end of   *
+*    each run 16 bytes at a time with SSE2 where it is available       *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_BYTEFORMATTER_H
+#define CPPSERIALPORT_BYTEFORMATTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "IByteStream.h"
+
+namespace CppSerialPort {
+
+enum class DisplayMode
+{
+    Text,
+    Escaped,
+    Hex
+};
+
+enum class TimestampMode
+{
+    None,
+    Monotonic,
+    Realtime
+};
+
+class ByteFormatter
+{
+public:
+    ByteFormatter() = delete;
+
+    //Printable ASCII is copied as is, everything else (and the backslash itself) becomes \r, \n, \t, \0, \\ or \xHH.
+    //With breakAfterLineFeed a real line feed follows each \n, so a stream still reads line by line
+    static void appendEscaped(const char *data, size_t size, std::string *output, bool breakAfterLineFeed = false);
+    //One row in the layout of hexdump -C: the offset, up to HEX_DUMP_BYTES_PER_LINE bytes in hex, then the same bytes as ASCII
+    static void appendHexDumpLine(uint64_t offset, const char *data, size_t size, std::string *output);
+    //"[SECONDS.MICROSECONDS] " on the monotonic clock, or "[YYYY-MM-DD HH:MM:SS.MICROSECONDS] " in local time for Realtime
+    static void appendTimestamp(const ReadTimestamp &timestamp, TimestampMode timestampMode, std::string *output);
+
+    //Length of the run of bytes at the start of [begin, end) that appendEscaped copies unchanged
+    static size_t printableRunLength(const char *begin, const char *end);
+    static size_t printableRunLengthScalar(const char *begin, const char *end);
+    static size_t printableRunLengthSse2(const char *begin, const char *end);
+
+    static const char *implementationName();
+
+    static const size_t HEX_DUMP_BYTES_PER_LINE;
+
+private:
+    using RunLengthFunction = size_t (*)(const char *, const char *);
+
+    static RunLengthFunction selectImplementation();
+    static RunLengthFunction implementation();
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_BYTEFORMATTER_H
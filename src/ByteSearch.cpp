@@ -0,0 +1,191 @@
+/***********************************************************************
+*    ByteSearch.cpp:                                                   *
+*    ByteSearch, delimiter search over received blocks                 *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a ByteSearch class          *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "ByteSearch.h"
+
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#    define CPPSERIALPORT_HAVE_SSE2
+#    define CPPSERIALPORT_HAVE_AVX2
+#    define CPPSERIALPORT_TARGET_SSE2 __attribute__((target("sse2")))
+#    define CPPSERIALPORT_TARGET_AVX2 __attribute__((target("avx2")))
+#    include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#    define CPPSERIALPORT_HAVE_SSE2
+#    define CPPSERIALPORT_TARGET_SSE2
+#    include <emmintrin.h>
+#    include <intrin.h>
+#endif
+
+namespace CppSerialPort {
+
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+static inline unsigned countTrailingZeros(unsigned value)
+{
+#if defined(_MSC_VER)
+    unsigned long index{0};
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+#endif //defined(CPPSERIALPORT_HAVE_SSE2)
+
+const char *ByteSearch::findScalar(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    if (needleLength == 0) {
+        return begin;
+    }
+    if ( (end < begin) || (static_cast<size_t>(end - begin) < needleLength) ) {
+        return nullptr;
+    }
+    //A match can only start before this point
+    const char *lastStart{end - needleLength + 1};
+    const char *position{begin};
+    while (position < lastStart) {
+        position = static_cast<const char *>(memchr(position, needle[0], static_cast<size_t>(lastStart - position)));
+        if (!position) {
+            return nullptr;
+        }
+        if (memcmp(position + 1, needle + 1, needleLength - 1) == 0) {
+            return position;
+        }
+        position++;
+    }
+    return nullptr;
+}
+
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+CPPSERIALPORT_TARGET_SSE2 const char *ByteSearch::findSse2(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    //memchr is already vectorized by the C library, and is hard to beat for a single byte
+    if ( (needleLength < 2) || (end < begin) || (static_cast<size_t>(end - begin) < needleLength) ) {
+        return findScalar(begin, end, needle, needleLength);
+    }
+    const size_t size{static_cast<size_t>(end - begin)};
+    const __m128i firstByte{_mm_set1_epi8(needle[0])};
+    const __m128i lastByte{_mm_set1_epi8(needle[needleLength - 1])};
+    size_t offset{0};
+    for (; offset + needleLength - 1 + sizeof(__m128i) <= size; offset += sizeof(__m128i)) {
+        __m128i firstBlock{_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + offset))};
+        __m128i lastBlock{_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + offset + needleLength - 1))};
+        auto candidates = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstByte), _mm_cmpeq_epi8(lastBlock, lastByte))));
+        while (candidates != 0) {
+            unsigned bit{countTrailingZeros(candidates)};
+            //First and last byte already matched, so only the middle is left to verify
+            if (memcmp(begin + offset + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return begin + offset + bit;
+            }
+            candidates &= (candidates - 1);
+        }
+    }
+    return findScalar(begin + offset, end, needle, needleLength);
+}
+#else
+const char *ByteSearch::findSse2(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    return findScalar(begin, end, needle, needleLength);
+}
+#endif //defined(CPPSERIALPORT_HAVE_SSE2)
+
+#if defined(CPPSERIALPORT_HAVE_AVX2)
+CPPSERIALPORT_TARGET_AVX2 const char *ByteSearch::findAvx2(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    if ( (needleLength < 2) || (end < begin) || (static_cast<size_t>(end - begin) < needleLength) ) {
+        return findScalar(begin, end, needle, needleLength);
+    }
+    const size_t size{static_cast<size_t>(end - begin)};
+    const __m256i firstByte{_mm256_set1_epi8(needle[0])};
+    const __m256i lastByte{_mm256_set1_epi8(needle[needleLength - 1])};
+    size_t offset{0};
+    for (; offset + needleLength - 1 + sizeof(__m256i) <= size; offset += sizeof(__m256i)) {
+        __m256i firstBlock{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin + offset))};
+        __m256i lastBlock{_mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin + offset + needleLength - 1))};
+        auto candidates = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, firstByte), _mm256_cmpeq_epi8(lastBlock, lastByte))));
+        while (candidates != 0) {
+            unsigned bit{countTrailingZeros(candidates)};
+            if (memcmp(begin + offset + bit + 1, needle + 1, needleLength - 2) == 0) {
+                return begin + offset + bit;
+            }
+            candidates &= (candidates - 1);
+        }
+    }
+    return findSse2(begin + offset, end, needle, needleLength);
+}
+#else
+const char *ByteSearch::findAvx2(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    return findSse2(begin, end, needle, needleLength);
+}
+#endif //defined(CPPSERIALPORT_HAVE_AVX2)
+
+ByteSearch::FindFunction ByteSearch::selectImplementation()
+{
+#if defined(CPPSERIALPORT_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &ByteSearch::findAvx2;
+    }
+#endif
+#if defined(CPPSERIALPORT_HAVE_SSE2)
+#    if !defined(_MSC_VER)
+    if (__builtin_cpu_supports("sse2")) {
+        return &ByteSearch::findSse2;
+    }
+#    else
+    return &ByteSearch::findSse2;
+#    endif
+#endif
+    return &ByteSearch::findScalar;
+}
+
+ByteSearch::FindFunction ByteSearch::implementation()
+{
+    //Picked once, the first time anything searches
+    static const FindFunction selectedImplementation{selectImplementation()};
+    return selectedImplementation;
+}
+
+const char *ByteSearch::implementationName()
+{
+    FindFunction selectedImplementation{implementation()};
+    if (selectedImplementation == &ByteSearch::findAvx2) {
+        return "avx2";
+    } else if (selectedImplementation == &ByteSearch::findSse2) {
+        return "sse2";
+    }
+    return "scalar";
+}
+
+const char *ByteSearch::find(const char *begin, const char *end, const char *needle, size_t needleLength)
+{
+    return implementation()(begin, end, needle, needleLength);
+}
+
+size_t ByteSearch::find(const std::string &haystack, const std::string &needle, size_t startPosition)
+{
+    if (startPosition > haystack.length()) {
+        return std::string::npos;
+    }
+    const char *begin{haystack.data()};
+    const char *match{find(begin + startPosition, begin + haystack.length(), needle.data(), needle.length())};
+    return (match ? static_cast<size_t>(match - begin) : std::string::npos);
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,55 @@
+/***********************************************************************
+*    ByteSearch.h:                                                     *
+*    ByteSearch, delimiter search over received blocks                 *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a ByteSearch class            *
+*    Single byte terminators go straight to memchr, longer ones are    *
+*    found by matching their first and last byte 16 or 32 positions    *
+*    at a time (SSE2/AVX2, picked once at runtime) and then verifying  *
+*    the candidates, with a portable memchr/memcmp fallback            *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_BYTESEARCH_H
+#define CPPSERIALPORT_BYTESEARCH_H
+
+#include <cstddef>
+#include <string>
+
+namespace CppSerialPort {
+
+class ByteSearch
+{
+public:
+    ByteSearch() = delete;
+
+    //Returns a pointer to the first match in [begin, end), or nullptr
+    static const char *find(const char *begin, const char *end, const char *needle, size_t needleLength);
+    //Same contract as std::string::find, returning std::string::npos when there is no match
+    static size_t find(const std::string &haystack, const std::string &needle, size_t startPosition = 0);
+
+    static const char *implementationName();
+
+    static const char *findScalar(const char *begin, const char *end, const char *needle, size_t needleLength);
+    static const char *findSse2(const char *begin, const char *end, const char *needle, size_t needleLength);
+    static const char *findAvx2(const char *begin, const char *end, const char *needle, size_t needleLength);
+
+private:
+    using FindFunction = const char *(*)(const char *, const char *, const char *, size_t);
+
+    static FindFunction selectImplementation();
+    static FindFunction implementation();
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_BYTESEARCH_H
@@ -0,0 +1,414 @@
+#include "CaptureIndex.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+using namespace CppSerialPort;
+
+const char CaptureIndex::INDEX_MAGIC[8]{'Q', 'S', 'T', 'I', 'D', 'X', '0', '1'};
+const size_t CaptureIndex::CHECKPOINT_LINE_INTERVAL{256};
+const size_t CaptureIndex::CHECKPOINT_BYTE_INTERVAL{64 * 1024};
+const size_t CaptureIndex::MAXIMUM_LINE_LENGTH{4096};
+const size_t CaptureIndex::LINE_BLOCK_CHECKPOINTS{16};
+const std::chrono::milliseconds CaptureIndex::PROGRESS_INTERVAL{100};
+
+CaptureIndex::CaptureIndex(std::function<void()> indexEventCallback) :
+    m_indexEventNotifier{indexEventCallback},
+    m_captureFile{},
+    m_startTime{0},
+    m_indexThread{},
+    m_cancelRequested{false},
+    m_mutex{},
+    m_checkpoints{},
+    m_progress{false, false, 0, 0, 0},
+    m_lastNotification{}
+{
+
+}
+
+std::string CaptureIndex::indexFilePathFor(const std::string &filePath)
+{
+    return filePath + ".idx";
+}
+
+void CaptureIndex::open(const std::string &filePath)
+{
+    this->close();
+    this->m_captureFile.open(filePath);
+    if (!SessionRecorder::decodeFileHeader(this->m_captureFile.data(), this->m_captureFile.size(), &this->m_startTime)) {
+        this->m_captureFile.close();
+        throw std::runtime_error("CaptureIndex::open(const std::string &): " + filePath + " is not a session capture");
+    }
+    this->m_cancelRequested = false;
+    this->m_indexEventNotifier.acknowledge();
+    if (this->loadIndex()) {
+        return;
+    }
+    Position firstLine{0, SessionRecorder::FILE_HEADER_SIZE, 0, 0};
+    this->skipConsumedRecords(&firstLine);
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_checkpoints.push_back(firstLine);
+        this->m_progress = CaptureIndexProgress{false, false, 0, fileOffsetOf(firstLine), this->m_captureFile.size()};
+    }
+    this->m_lastNotification = std::chrono::steady_clock::now();
+    this->m_indexThread = std::thread{&CaptureIndex::run, this};
+}
+
+void CaptureIndex::close()
+{
+    this->m_cancelRequested = true;
+    if (this->m_indexThread.joinable()) {
+        this->m_indexThread.join();
+    }
+    this->m_captureFile.close();
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    this->m_checkpoints.clear();
+    this->m_progress = CaptureIndexProgress{false, false, 0, 0, 0};
+}
+
+bool CaptureIndex::isOpen() const
+{
+    return this->m_captureFile.isOpen();
+}
+
+std::string CaptureIndex::filePath() const
+{
+    return this->m_captureFile.filePath();
+}
+
+uint64_t CaptureIndex::startTime() const
+{
+    return this->m_startTime;
+}
+
+CaptureIndexProgress CaptureIndex::progress() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_progress;
+}
+
+uint64_t CaptureIndex::lineCount() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_progress.lineCount;
+}
+
+void CaptureIndex::acknowledgeNotification()
+{
+    this->m_indexEventNotifier.acknowledge();
+}
+
+uint64_t CaptureIndex::fileOffsetOf(const Position &position)
+{
+    return position.recordOffset + SessionRecorder::RECORD_HEADER_SIZE + position.payloadOffset;
+}
+
+bool CaptureIndex::recordAt(uint64_t recordOffset, CaptureRecordHeader *header) const
+{
+    const uint64_t captureSize{this->m_captureFile.size()};
+    if (recordOffset >= captureSize) {
+        return false;
+    }
+    //A record cut short by a crash ends the capture, the same as for replay
+    return (SessionRecorder::decodeRecordHeader(this->m_captureFile.data() + recordOffset, captureSize - recordOffset, header)) &&
+           (header->size <= captureSize - recordOffset - SessionRecorder::RECORD_HEADER_SIZE);
+}
+
+void CaptureIndex::skipConsumedRecords(Position *position) const
+{
+    CaptureRecordHeader header{};
+    while (this->recordAt(position->recordOffset, &header)) {
+        position->timestamp = header.timestamp;
+        if (position->payloadOffset < header.size) {
+            return;
+        }
+        position->recordOffset += SessionRecorder::RECORD_HEADER_SIZE + header.size;
+        position->payloadOffset = 0;
+    }
+}
+
+bool CaptureIndex::readLine(Position *position, CaptureLine *line, bool copyText) const
+{
+    size_t lineLength{0};
+    bool hasStarted{false};
+    line->text.clear();
+    CaptureRecordHeader header{};
+    while (this->recordAt(position->recordOffset, &header)) {
+        if (position->payloadOffset >= header.size) {
+            position->recordOffset += SessionRecorder::RECORD_HEADER_SIZE + header.size;
+            position->payloadOffset = 0;
+            continue;
+        }
+        if (!hasStarted) {
+            line->lineNumber = position->lineNumber;
+            line->fileOffset = fileOffsetOf(*position);
+            line->timestamp = header.timestamp;
+            line->direction = header.direction;
+            hasStarted = true;
+        } else if (header.direction != line->direction) {
+            break;
+        }
+        const char *start{this->m_captureFile.data() + fileOffsetOf(*position)};
+        size_t available{std::min(static_cast<size_t>(header.size - position->payloadOffset), MAXIMUM_LINE_LENGTH - lineLength)};
+        const char *newline{static_cast<const char *>(memchr(start, '\n', available))};
+        size_t taken{newline ? static_cast<size_t>(newline - start) : available};
+        if (copyText) {
+            line->text.append(start, taken);
+        }
+        lineLength += taken;
+        position->payloadOffset += static_cast<uint32_t>(taken + (newline ? 1 : 0));
+        if (newline) {
+            if ( (!line->text.empty()) && (line->text.back() == '\r') ) {
+                line->text.pop_back();
+            }
+            break;
+        }
+        if (lineLength >= MAXIMUM_LINE_LENGTH) {
+            break;
+        }
+    }
+    if (!hasStarted) {
+        return false;
+    }
+    this->skipConsumedRecords(position);
+    position->lineNumber++;
+    return true;
+}
+
+void CaptureIndex::run()
+{
+    Position position{this->m_checkpoints.front()};
+    uint64_t lastCheckpointOffset{fileOffsetOf(position)};
+    size_t linesSinceCheckpoint{0};
+    CaptureLine line{0, 0, 0, RecordDirection::Received, ""};
+    while ( (!this->m_cancelRequested) && (this->readLine(&position, &line, false)) ) {
+        linesSinceCheckpoint++;
+        if ( (linesSinceCheckpoint < CHECKPOINT_LINE_INTERVAL) && (fileOffsetOf(position) - lastCheckpointOffset < CHECKPOINT_BYTE_INTERVAL) ) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock{this->m_mutex};
+            this->m_checkpoints.push_back(position);
+            this->m_progress.lineCount = position.lineNumber;
+            this->m_progress.bytesIndexed = std::min(fileOffsetOf(position), this->m_progress.totalBytes);
+        }
+        lastCheckpointOffset = fileOffsetOf(position);
+        linesSinceCheckpoint = 0;
+        auto now = std::chrono::steady_clock::now();
+        if (now - this->m_lastNotification >= PROGRESS_INTERVAL) {
+            this->m_lastNotification = now;
+            this->m_indexEventNotifier.notify();
+        }
+    }
+    if (this->m_cancelRequested) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress.isComplete = true;
+        this->m_progress.lineCount = position.lineNumber;
+        this->m_progress.bytesIndexed = this->m_progress.totalBytes;
+    }
+    this->saveIndex();
+    this->m_indexEventNotifier.notifyAlways();
+}
+
+CaptureIndex::Position CaptureIndex::checkpointBefore(std::function<bool(const Position &)> isAfterTarget) const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    auto found = std::partition_point(this->m_checkpoints.begin(), this->m_checkpoints.end(), [&isAfterTarget](const Position &checkpoint) {
+        return !isAfterTarget(checkpoint);
+    });
+    return (found == this->m_checkpoints.begin() ? *found : *(found - 1));
+}
+
+std::vector<CaptureLine> CaptureIndex::lines(uint64_t firstLine, size_t count) const
+{
+    std::vector<CaptureLine> result{};
+    const uint64_t indexedLines{this->lineCount()};
+    if (firstLine >= indexedLines) {
+        return result;
+    }
+    count = static_cast<size_t>(std::min(static_cast<uint64_t>(count), indexedLines - firstLine));
+    Position position{this->checkpointBefore([firstLine](const Position &checkpoint) { return checkpoint.lineNumber > firstLine; })};
+    CaptureLine line{0, 0, 0, RecordDirection::Received, ""};
+    while ( (position.lineNumber < firstLine) && (this->readLine(&position, &line, false)) ) { }
+    result.reserve(count);
+    while ( (result.size() < count) && (this->readLine(&position, &line, true)) ) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+uint64_t CaptureIndex::lineAtOffset(uint64_t fileOffset) const
+{
+    const uint64_t indexedLines{this->lineCount()};
+    if (indexedLines == 0) {
+        return 0;
+    }
+    Position position{this->checkpointBefore([fileOffset](const Position &checkpoint) { return fileOffsetOf(checkpoint) > fileOffset; })};
+    CaptureLine line{0, 0, 0, RecordDirection::Received, ""};
+    while ( (position.lineNumber < indexedLines) && (this->readLine(&position, &line, false)) ) {
+        //position is now the start of the next line, so fileOffset is inside this one (or in the headers in between)
+        if (fileOffsetOf(position) > fileOffset) {
+            return line.lineNumber;
+        }
+    }
+    return indexedLines - 1;
+}
+
+uint64_t CaptureIndex::lineAtTimestamp(uint64_t timestamp) const
+{
+    const uint64_t indexedLines{this->lineCount()};
+    if (indexedLines == 0) {
+        return 0;
+    }
+    //Several lines can share a timestamp, so start from the last checkpoint strictly before it
+    Position position{this->checkpointBefore([timestamp](const Position &checkpoint) { return checkpoint.timestamp >= timestamp; })};
+    CaptureLine line{0, 0, 0, RecordDirection::Received, ""};
+    while ( (position.lineNumber < indexedLines) && (this->readLine(&position, &line, false)) ) {
+        if (line.timestamp >= timestamp) {
+            return line.lineNumber;
+        }
+    }
+    return indexedLines - 1;
+}
+
+uint64_t CaptureIndex::lineAtPosition(const std::string &position) const
+{
+    std::string value{position};
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t") + 1);
+    bool isTimestamp{(!value.empty()) && (value.front() == '@')};
+    if (isTimestamp) {
+        value.erase(0, 1);
+    }
+    size_t parsedLength{0};
+    double seconds{0.0};
+    uint64_t fileOffset{0};
+    try {
+        if ( (!value.empty()) && (isdigit(static_cast<unsigned char>(value.front()))) ) {
+            if (isTimestamp) {
+                seconds = std::stod(value, &parsedLength);
+            } else {
+                fileOffset = std::stoull(value, &parsedLength, 0);
+            }
+        }
+    } catch (std::exception &e) {
+        parsedLength = 0;
+    }
+    if ( (parsedLength == 0) || (parsedLength != value.length()) ) {
+        throw std::runtime_error("CaptureIndex::lineAtPosition(const std::string &): invalid position \"" + position + "\" (expected a byte offset or @SECONDS)");
+    }
+    if (isTimestamp) {
+        return this->lineAtTimestamp(static_cast<uint64_t>(seconds * 1000000000.0));
+    }
+    return this->lineAtOffset(fileOffset);
+}
+
+size_t CaptureIndex::lineBlockCount() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return (this->m_checkpoints.size() + LINE_BLOCK_CHECKPOINTS - 1) / LINE_BLOCK_CHECKPOINTS;
+}
+
+uint64_t CaptureIndex::readLineBlock(size_t blockIndex, std::string *bytes, std::vector<uint32_t> *lineEnds) const
+{
+    Position position{0, 0, 0, 0};
+    uint64_t endLineNumber{0};
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        size_t firstCheckpoint{blockIndex * LINE_BLOCK_CHECKPOINTS};
+        if (firstCheckpoint >= this->m_checkpoints.size()) {
+            throw std::out_of_range("CaptureIndex::readLineBlock(size_t, std::string *, std::vector<uint32_t> *): block " + std::to_string(blockIndex) + " is out of range");
+        }
+        position = this->m_checkpoints[firstCheckpoint];
+        size_t endCheckpoint{firstCheckpoint + LINE_BLOCK_CHECKPOINTS};
+        endLineNumber = (endCheckpoint < this->m_checkpoints.size() ? this->m_checkpoints[endCheckpoint].lineNumber : this->m_progress.lineCount);
+    }
+    const uint64_t firstLineNumber{position.lineNumber};
+    bytes->clear();
+    lineEnds->clear();
+    CaptureLine line{0, 0, 0, RecordDirection::Received, ""};
+    while ( (position.lineNumber < endLineNumber) && (this->readLine(&position, &line, true)) ) {
+        bytes->append(line.text);
+        lineEnds->push_back(static_cast<uint32_t>(bytes->size()));
+    }
+    return firstLineNumber;
+}
+
+bool CaptureIndex::loadIndex()
+{
+    MappedFile indexFile{};
+    try {
+        indexFile.open(indexFilePathFor(this->m_captureFile.filePath()));
+    } catch (std::exception &e) {
+        return false;
+    }
+    const char *data{indexFile.data()};
+    if ( (indexFile.size() < INDEX_HEADER_SIZE) || (memcmp(data, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) ) {
+        return false;
+    }
+    //Captures are only ever appended to, so the same start time and size means the same contents
+    uint64_t captureSize{SessionRecorder::decodeLittleEndian(data + 8, 8)};
+    uint64_t startTime{SessionRecorder::decodeLittleEndian(data + 16, 8)};
+    uint64_t lineCount{SessionRecorder::decodeLittleEndian(data + 24, 8)};
+    uint64_t entryCount{SessionRecorder::decodeLittleEndian(data + 32, 8)};
+    if ( (captureSize != this->m_captureFile.size()) || (startTime != this->m_startTime) || (entryCount == 0) ||
+         (entryCount != (indexFile.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE) || ((indexFile.size() - INDEX_HEADER_SIZE) % INDEX_ENTRY_SIZE != 0) ) {
+        return false;
+    }
+    std::vector<Position> checkpoints{};
+    checkpoints.reserve(static_cast<size_t>(entryCount));
+    for (const char *entry = data + INDEX_HEADER_SIZE; entry < data + indexFile.size(); entry += INDEX_ENTRY_SIZE) {
+        checkpoints.push_back(Position{SessionRecorder::decodeLittleEndian(entry, 8),
+                                       SessionRecorder::decodeLittleEndian(entry + 8, 8),
+                                       static_cast<uint32_t>(SessionRecorder::decodeLittleEndian(entry + 16, 4)),
+                                       SessionRecorder::decodeLittleEndian(entry + 20, 8)});
+    }
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    this->m_checkpoints = std::move(checkpoints);
+    this->m_progress = CaptureIndexProgress{true, true, lineCount, captureSize, captureSize};
+    return true;
+}
+
+void CaptureIndex::saveIndex() const
+{
+    std::vector<char> buffer{};
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        buffer.resize(INDEX_HEADER_SIZE + (this->m_checkpoints.size() * INDEX_ENTRY_SIZE));
+        memcpy(buffer.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        SessionRecorder::encodeLittleEndian(buffer.data() + 8, this->m_progress.totalBytes, 8);
+        SessionRecorder::encodeLittleEndian(buffer.data() + 16, this->m_startTime, 8);
+        SessionRecorder::encodeLittleEndian(buffer.data() + 24, this->m_progress.lineCount, 8);
+        SessionRecorder::encodeLittleEndian(buffer.data() + 32, this->m_checkpoints.size(), 8);
+        char *entry{buffer.data() + INDEX_HEADER_SIZE};
+        for (const auto &it : this->m_checkpoints) {
+            SessionRecorder::encodeLittleEndian(entry, it.lineNumber, 8);
+            SessionRecorder::encodeLittleEndian(entry + 8, it.recordOffset, 8);
+            SessionRecorder::encodeLittleEndian(entry + 16, it.payloadOffset, 4);
+            SessionRecorder::encodeLittleEndian(entry + 20, it.timestamp, 8);
+            entry += INDEX_ENTRY_SIZE;
+        }
+    }
+    //The index is only a cache; a capture in a read-only directory is simply indexed again next time
+    std::string indexFilePath{indexFilePathFor(this->m_captureFile.filePath())};
+    std::FILE *indexFile{std::fopen(indexFilePath.c_str(), "wb")};
+    if (!indexFile) {
+        return;
+    }
+    bool isWritten{std::fwrite(buffer.data(), 1, buffer.size(), indexFile) == buffer.size()};
+    if ( (std::fclose(indexFile) != 0) || (!isWritten) ) {
+        std::remove(indexFilePath.c_str());
+    }
+}
+
+CaptureIndex::~CaptureIndex()
+{
+    this->close();
+}
@@ -0,0 +1,130 @@
+#ifndef QSERIALTERMINAL_CAPTUREINDEX_H
+#define QSERIALTERMINAL_CAPTUREINDEX_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "SessionRecorder.h"
+#include "EventNotifier.h"
+
+struct CaptureLine
+{
+    uint64_t lineNumber;
+    //Where the first byte of the line sits in the capture file
+    uint64_t fileOffset;
+    //Nanoseconds since the start of the recording, of the record the line starts in
+    uint64_t timestamp;
+    CppSerialPort::RecordDirection direction;
+    std::string text;
+};
+
+struct CaptureIndexProgress
+{
+    bool isComplete;
+    //True when the index was read back from indexFilePath() instead of being built
+    bool wasLoaded;
+    uint64_t lineCount;
+    uint64_t bytesIndexed;
+    uint64_t totalBytes;
+};
+
+/*
+ * Line index over a memory mapped SessionRecorder capture, so a capture of
+ * any size can be viewed without reading it in. A line ends at a newline,
+ * at a change of direction, or after MAXIMUM_LINE_LENGTH bytes. A
+ * background thread walks the capture once and keeps a checkpoint (line
+ * number, position, timestamp) every CHECKPOINT_LINE_INTERVAL lines or
+ * CHECKPOINT_BYTE_INTERVAL bytes; any line, offset or timestamp is then a
+ * binary search over the checkpoints plus a short bounded walk. Lines are
+ * available as soon as the walk has passed them, so the first screen does
+ * not wait for the whole file. A finished index is saved next to the
+ * capture and reused while the capture's size and start time still match
+ */
+class CaptureIndex
+{
+public:
+    explicit CaptureIndex(std::function<void()> indexEventCallback);
+    ~CaptureIndex();
+
+    CaptureIndex(const CaptureIndex &other) = delete;
+    CaptureIndex(CaptureIndex &&other) = delete;
+    CaptureIndex &operator=(const CaptureIndex &rhs) = delete;
+    CaptureIndex &operator=(CaptureIndex &&rhs) = delete;
+
+    void open(const std::string &filePath);
+    void close();
+    bool isOpen() const;
+
+    std::string filePath() const;
+    //Wall clock nanoseconds since the Unix epoch at which the recording started
+    uint64_t startTime() const;
+    CaptureIndexProgress progress() const;
+    void acknowledgeNotification();
+
+    //Lines indexed so far; grows until progress().isComplete
+    uint64_t lineCount() const;
+    //Up to count lines starting at firstLine, fewer past the end of what has been indexed
+    std::vector<CaptureLine> lines(uint64_t firstLine, size_t count) const;
+    //The line holding fileOffset, or the last indexed line if the index has not got that far
+    uint64_t lineAtOffset(uint64_t fileOffset) const;
+    //The first line starting at or after timestamp (nanoseconds since the start of the recording)
+    uint64_t lineAtTimestamp(uint64_t timestamp) const;
+    //Accepts a byte offset (decimal or 0x hex) or @SECONDS since the start of the recording
+    uint64_t lineAtPosition(const std::string &position) const;
+
+    //The indexed lines split into blocks of LINE_BLOCK_CHECKPOINTS checkpoints, so they can be scanned in parallel
+    size_t lineBlockCount() const;
+    //Packs the lines of a block back to back into bytes, with line i ending at lineEnds[i]; returns the first line number
+    uint64_t readLineBlock(size_t blockIndex, std::string *bytes, std::vector<uint32_t> *lineEnds) const;
+
+    static std::string indexFilePathFor(const std::string &filePath);
+
+    static const char INDEX_MAGIC[8];
+    static const size_t constexpr INDEX_HEADER_SIZE{40};
+    static const size_t constexpr INDEX_ENTRY_SIZE{28};
+    static const size_t CHECKPOINT_LINE_INTERVAL;
+    static const size_t CHECKPOINT_BYTE_INTERVAL;
+    static const size_t MAXIMUM_LINE_LENGTH;
+    static const size_t LINE_BLOCK_CHECKPOINTS;
+    static const std::chrono::milliseconds PROGRESS_INTERVAL;
+
+private:
+    //A line start: the record it is in and how far into that record's payload
+    struct Position
+    {
+        uint64_t lineNumber;
+        uint64_t recordOffset;
+        uint32_t payloadOffset;
+        uint64_t timestamp;
+    };
+
+    CppSerialPort::EventNotifier m_indexEventNotifier;
+    MappedFile m_captureFile;
+    uint64_t m_startTime;
+    std::thread m_indexThread;
+    std::atomic<bool> m_cancelRequested;
+    mutable std::mutex m_mutex;
+    std::vector<Position> m_checkpoints;
+    CaptureIndexProgress m_progress;
+    std::chrono::steady_clock::time_point m_lastNotification;
+
+    void run();
+    bool recordAt(uint64_t recordOffset, CppSerialPort::CaptureRecordHeader *header) const;
+    void skipConsumedRecords(Position *position) const;
+    //Reads the line starting at position and moves position to the start of the next one
+    bool readLine(Position *position, CaptureLine *line, bool copyText) const;
+    Position checkpointBefore(std::function<bool(const Position &)> isAfterTarget) const;
+    bool loadIndex();
+    void saveIndex() const;
+
+    static uint64_t fileOffsetOf(const Position &position);
+};
+
+#endif //QSERIALTERMINAL_CAPTUREINDEX_H
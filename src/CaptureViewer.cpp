@@ -0,0 +1,239 @@
+#include "CaptureViewer.h"
+#include "ApplicationStrings.h"
+
+#include <QScrollBar>
+#include <QRect>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QKeyEvent>
+#include <QFontMetrics>
+#include <QFontDatabase>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QMessageBox>
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+using namespace CppSerialPort;
+
+static const int TEXT_MARGIN{4};
+
+CaptureViewer::CaptureViewer(QWidget *parent) :
+    QAbstractScrollArea{parent},
+    m_captureIndex{[this]() { emit this->indexEvent(); }},
+    m_receivedColor{Qt::red},
+    m_transmittedColor{Qt::blue},
+    m_longestLineWidth{0},
+    m_hasHighlightedLine{false},
+    m_highlightedLine{0},
+    m_searchBar{new SearchBar{this}}
+{
+    this->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    this->setFocusPolicy(Qt::StrongFocus);
+    this->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    //The index thread raises the event, so it has to be queued over to the GUI thread
+    connect(this, &CaptureViewer::indexEvent, this, &CaptureViewer::onIndexEvent, Qt::QueuedConnection);
+
+    const CaptureIndex *captureIndex{&this->m_captureIndex};
+    this->m_searchBar->setSource([captureIndex](TextSearch::BlockFunction *blockFunction) -> size_t {
+        *blockFunction = [captureIndex](size_t blockIndex, std::string *scratchBytes, std::vector<uint32_t> *scratchLineEnds, SearchBlock *block) {
+            block->firstLineNumber = captureIndex->readLineBlock(blockIndex, scratchBytes, scratchLineEnds);
+            block->data = scratchBytes->data();
+            block->lineEnds = scratchLineEnds->data();
+            block->lineCount = scratchLineEnds->size();
+        };
+        return captureIndex->lineBlockCount();
+    }, [this](uint64_t lineNumber) -> bool {
+        return this->showLine(lineNumber);
+    });
+    this->m_searchBar->hide();
+    connect(this->m_searchBar.get(), &SearchBar::dismissed, this, &CaptureViewer::onSearchBarDismissed);
+    this->updateScrollBars();
+}
+
+void CaptureViewer::openCapture(const QString &filePath)
+{
+    //The search workers read straight out of the index being replaced
+    this->m_searchBar->stopSearch();
+    this->m_captureIndex.open(filePath.toStdString());
+    this->m_longestLineWidth = 0;
+    this->m_hasHighlightedLine = false;
+    this->verticalScrollBar()->setValue(0);
+    this->horizontalScrollBar()->setValue(0);
+    //A saved index is loaded synchronously and raises no event
+    this->onIndexEvent();
+}
+
+void CaptureViewer::setLineColor(RecordDirection direction, const QColor &color)
+{
+    if (direction == RecordDirection::Received) {
+        this->m_receivedColor = color;
+    } else {
+        this->m_transmittedColor = color;
+    }
+    this->viewport()->update();
+}
+
+void CaptureViewer::onIndexEvent()
+{
+    this->m_captureIndex.acknowledgeNotification();
+    this->updateScrollBars();
+    this->updateWindowTitle();
+    this->viewport()->update();
+}
+
+void CaptureViewer::updateWindowTitle()
+{
+    using namespace ApplicationStrings;
+    CaptureIndexProgress progress{this->m_captureIndex.progress()};
+    QString fileName{QFileInfo{QString::fromStdString(this->m_captureIndex.filePath())}.fileName()};
+    if (progress.isComplete) {
+        this->setWindowTitle(QString{CAPTURE_VIEWER_TITLE_STRING}.arg(fileName, QString::number(progress.lineCount)));
+    } else {
+        int percentage{progress.totalBytes > 0 ? static_cast<int>((progress.bytesIndexed * 100) / progress.totalBytes) : 0};
+        this->setWindowTitle(QString{CAPTURE_VIEWER_INDEXING_TITLE_STRING}.arg(fileName, QString::number(percentage), QString::number(progress.lineCount)));
+    }
+}
+
+void CaptureViewer::goToPosition()
+{
+    using namespace ApplicationStrings;
+    bool isAccepted{false};
+    QString position{QInputDialog::getText(this, CAPTURE_GO_TO_DIALOG_TITLE_STRING, CAPTURE_GO_TO_LABEL_STRING, QLineEdit::Normal, "", &isAccepted)};
+    if ( (!isAccepted) || (position.isEmpty()) ) {
+        return;
+    }
+    try {
+        uint64_t lineNumber{this->m_captureIndex.lineAtPosition(position.toStdString())};
+        this->verticalScrollBar()->setValue(static_cast<int>(std::min(lineNumber, static_cast<uint64_t>(INT_MAX))));
+    } catch (std::exception &e) {
+        QMessageBox::warning(this, CAPTURE_GO_TO_DIALOG_TITLE_STRING, e.what());
+    }
+}
+
+void CaptureViewer::showSearchBar()
+{
+    //The bar sits in a margin below the viewport, so the scroll range still covers every line
+    this->setViewportMargins(0, 0, 0, this->m_searchBar->sizeHint().height());
+    this->layoutSearchBar();
+    this->m_searchBar->activate();
+}
+
+void CaptureViewer::onSearchBarDismissed()
+{
+    this->setViewportMargins(0, 0, 0, 0);
+    this->m_hasHighlightedLine = false;
+    this->updateScrollBars();
+    this->viewport()->update();
+    this->setFocus();
+}
+
+void CaptureViewer::layoutSearchBar()
+{
+    QRect viewportGeometry{this->viewport()->geometry()};
+    this->m_searchBar->setGeometry(viewportGeometry.left(), viewportGeometry.bottom() + 1, viewportGeometry.width(), this->m_searchBar->sizeHint().height());
+}
+
+bool CaptureViewer::showLine(uint64_t lineNumber)
+{
+    if (lineNumber >= this->m_captureIndex.lineCount()) {
+        return false;
+    }
+    this->m_hasHighlightedLine = true;
+    this->m_highlightedLine = lineNumber;
+    int index{static_cast<int>(std::min(lineNumber, static_cast<uint64_t>(INT_MAX)))};
+    this->verticalScrollBar()->setValue(std::max(0, index - (this->visibleRowCount() / 2)));
+    this->viewport()->update();
+    return true;
+}
+
+int CaptureViewer::lineHeight() const
+{
+    return std::max(1, this->fontMetrics().lineSpacing());
+}
+
+int CaptureViewer::visibleRowCount() const
+{
+    return std::max(1, this->viewport()->height() / this->lineHeight());
+}
+
+void CaptureViewer::updateScrollBars()
+{
+    int rows{this->visibleRowCount()};
+    int lineCount{static_cast<int>(std::min(this->m_captureIndex.lineCount(), static_cast<uint64_t>(INT_MAX)))};
+    this->verticalScrollBar()->setPageStep(rows);
+    this->verticalScrollBar()->setRange(0, std::max(0, lineCount - rows));
+    this->horizontalScrollBar()->setPageStep(this->viewport()->width());
+    this->horizontalScrollBar()->setRange(0, std::max(0, this->m_longestLineWidth + (2 * TEXT_MARGIN) - this->viewport()->width()));
+}
+
+void CaptureViewer::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter{this->viewport()};
+    painter.setFont(this->font());
+    QFontMetrics metrics{this->font()};
+
+    const int height{this->lineHeight()};
+    const int ascent{metrics.ascent()};
+    const int xOffset{TEXT_MARGIN - this->horizontalScrollBar()->value()};
+    const size_t rowsToPaint{static_cast<size_t>(this->viewport()->height() / height) + 1};
+    std::vector<CaptureLine> lines{this->m_captureIndex.lines(static_cast<uint64_t>(this->verticalScrollBar()->value()), rowsToPaint)};
+
+    int longestLineWidth{this->m_longestLineWidth};
+    int y{0};
+    for (const auto &it : lines) {
+        bool isReceived{it.direction == RecordDirection::Received};
+        if ( (this->m_hasHighlightedLine) && (it.lineNumber == this->m_highlightedLine) ) {
+            painter.fillRect(0, y, this->viewport()->width(), height, this->palette().highlight());
+        }
+        QString text{QString::number(static_cast<double>(it.timestamp) / 1000000000.0, 'f', 6).rightJustified(14) + (isReceived ? " Rx " : " Tx ") +
+                     QString::fromUtf8(it.text.data(), static_cast<int>(it.text.size()))};
+        painter.setPen(isReceived ? this->m_receivedColor : this->m_transmittedColor);
+        painter.drawText(xOffset, y + ascent, text);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+        longestLineWidth = std::max(longestLineWidth, metrics.horizontalAdvance(text));
+#else
+        longestLineWidth = std::max(longestLineWidth, metrics.width(text));
+#endif
+        y += height;
+    }
+    //Only lines that have been on screen are measured, so the horizontal range grows as the capture is scrolled through
+    if (longestLineWidth != this->m_longestLineWidth) {
+        this->m_longestLineWidth = longestLineWidth;
+        this->updateScrollBars();
+    }
+}
+
+void CaptureViewer::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    this->updateScrollBars();
+    this->layoutSearchBar();
+}
+
+void CaptureViewer::keyPressEvent(QKeyEvent *event)
+{
+    if ( (event->key() == Qt::Key_G) && (event->modifiers() & Qt::ControlModifier) ) {
+        this->goToPosition();
+    } else if ( (event->key() == Qt::Key_F) && (event->modifiers() & Qt::ControlModifier) ) {
+        this->showSearchBar();
+    } else if ( (event->key() == Qt::Key_Home) && (event->modifiers() & Qt::ControlModifier) ) {
+        this->verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMinimum);
+    } else if ( (event->key() == Qt::Key_End) && (event->modifiers() & Qt::ControlModifier) ) {
+        this->verticalScrollBar()->triggerAction(QAbstractSlider::SliderToMaximum);
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+CaptureViewer::~CaptureViewer()
+{
+    //Stops the search workers before the index they read, then the index thread before the signal it emits goes away
+    this->m_searchBar->stopSearch();
+    this->m_captureIndex.close();
+}
@@ -0,0 +1,76 @@
+#ifndef QSERIALTERMINAL_CAPTUREVIEWER_H
+#define QSERIALTERMINAL_CAPTUREVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QString>
+#include <QColor>
+
+#include <memory>
+#include <cstdint>
+
+#include "CaptureIndex.h"
+#include "SearchBar.h"
+
+class QPaintEvent;
+class QResizeEvent;
+class QKeyEvent;
+
+/*
+ * Window that shows a session capture as timestamped lines straight out of
+ * its CaptureIndex. Like TerminalView only the rows inside the viewport are
+ * decoded and painted, so opening a multi gigabyte capture costs one screen
+ * of lines and the scroll range grows while the index is being built.
+ * Ctrl+G jumps to a byte offset or a time into the recording, and Ctrl+F
+ * searches every line indexed so far
+ */
+class CaptureViewer : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureViewer(QWidget *parent = nullptr);
+    ~CaptureViewer() override;
+
+    CaptureViewer(const CaptureViewer &other) = delete;
+    CaptureViewer(CaptureViewer &&other) = delete;
+    CaptureViewer &operator=(const CaptureViewer &rhs) = delete;
+    CaptureViewer &operator=(CaptureViewer &&rhs) = delete;
+
+    void openCapture(const QString &filePath);
+    void setLineColor(CppSerialPort::RecordDirection direction, const QColor &color);
+
+signals:
+    void indexEvent();
+
+public slots:
+    void goToPosition();
+    void showSearchBar();
+
+private slots:
+    void onIndexEvent();
+    void onSearchBarDismissed();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    CaptureIndex m_captureIndex;
+    QColor m_receivedColor;
+    QColor m_transmittedColor;
+    int m_longestLineWidth;
+    bool m_hasHighlightedLine;
+    uint64_t m_highlightedLine;
+    //Declared after the index its workers read, so the search is gone before the index is
+    std::unique_ptr<SearchBar> m_searchBar;
+
+    int visibleRowCount() const;
+    int lineHeight() const;
+    void updateScrollBars();
+    void updateWindowTitle();
+    void layoutSearchBar();
+    bool showLine(uint64_t lineNumber);
+};
+
+#endif //QSERIALTERMINAL_CAPTUREVIEWER_H
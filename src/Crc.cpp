@@ -0,0 +1,131 @@
+/***********************************************************************
+*    Crc.cpp:                                                          *
+*    Crc16, Crc32, checksums for the file transfer protocols           *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of the Crc16 and Crc32 classes *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "Crc.h"
+
+namespace CppSerialPort {
+
+namespace {
+
+struct Crc16Table
+{
+    uint16_t entries[256];
+
+    Crc16Table() :
+        entries{}
+    {
+        for (unsigned i = 0; i < 256; i++) {
+            auto crc = static_cast<uint16_t>(i << 8);
+            for (int bit = 0; bit < 8; bit++) {
+                crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1));
+            }
+            this->entries[i] = crc;
+        }
+    }
+};
+
+struct Crc32Table
+{
+    //entries[k][i] is the CRC of byte i followed by k zero bytes, which is what lets eight bytes be folded in at once
+    uint32_t entries[8][256];
+
+    Crc32Table() :
+        entries{}
+    {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc{i};
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320u) : (crc >> 1);
+            }
+            this->entries[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++) {
+            for (int slice = 1; slice < 8; slice++) {
+                uint32_t previous{this->entries[slice - 1][i]};
+                this->entries[slice][i] = (previous >> 8) ^ this->entries[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc16Table &crc16Table()
+{
+    static const Crc16Table table{};
+    return table;
+}
+
+const Crc32Table &crc32Table()
+{
+    static const Crc32Table table{};
+    return table;
+}
+
+inline uint32_t loadLittleEndian32(const uint8_t *bytes)
+{
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+} //namespace
+
+uint16_t Crc16::update(uint16_t crc, uint8_t byte)
+{
+    return static_cast<uint16_t>((crc << 8) ^ crc16Table().entries[((crc >> 8) ^ byte) & 0xFF]);
+}
+
+uint16_t Crc16::update(uint16_t crc, const void *data, size_t size)
+{
+    const uint16_t *table{crc16Table().entries};
+    auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ bytes[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+uint16_t Crc16::compute(const void *data, size_t size)
+{
+    return update(0, data, size);
+}
+
+uint32_t Crc32::update(uint32_t crc, const void *data, size_t size)
+{
+    const Crc32Table &table{crc32Table()};
+    auto bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    while (size >= 8) {
+        uint32_t low{loadLittleEndian32(bytes) ^ crc};
+        uint32_t high{loadLittleEndian32(bytes + 4)};
+        crc = table.entries[7][low & 0xFF] ^ table.entries[6][(low >> 8) & 0xFF] ^
+              table.entries[5][(low >> 16) & 0xFF] ^ table.entries[4][low >> 24] ^
+              table.entries[3][high & 0xFF] ^ table.entries[2][(high >> 8) & 0xFF] ^
+              table.entries[1][(high >> 16) & 0xFF] ^ table.entries[0][high >> 24];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ table.entries[0][(crc ^ *bytes++) & 0xFF];
+    }
+    return ~crc;
+}
+
+uint32_t Crc32::compute(const void *data, size_t size)
+{
+    return update(0, data, size);
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,53 @@
+/***********************************************************************
+*    Crc.h:                                                            *
+*    Crc16, Crc32, checksums for the file transfer protocols           *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of the Crc16 and Crc32 classes   *
+*    Crc16 is CRC-16/XMODEM (polynomial 0x1021, MSB first), computed  *
+*    one byte per table lookup. Crc32 is the IEEE 802.3 CRC used by    *
+*    ZMODEM and zlib, computed eight bytes at a time (slicing-by-8).   *
+*    Both can be fed a stream piece by piece                           *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_CRC_H
+#define CPPSERIALPORT_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CppSerialPort {
+
+class Crc16
+{
+public:
+    Crc16() = delete;
+
+    //Start with crc = 0; feeding the data in pieces gives the same result as feeding it all at once
+    static uint16_t update(uint16_t crc, const void *data, size_t size);
+    static uint16_t update(uint16_t crc, uint8_t byte);
+    static uint16_t compute(const void *data, size_t size);
+};
+
+class Crc32
+{
+public:
+    Crc32() = delete;
+
+    //Start with crc = 0; the pre and post inversion is done internally, as in zlib's crc32()
+    static uint32_t update(uint32_t crc, const void *data, size_t size);
+    static uint32_t compute(const void *data, size_t size);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_CRC_H
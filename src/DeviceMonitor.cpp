@@ -0,0 +1,165 @@
+#include "DeviceMonitor.h"
+#include "SerialPort.h"
+
+#include <QSocketNotifier>
+
+#include <vector>
+
+#if defined(__linux__)
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#    include <cerrno>
+#endif //defined(__linux__)
+
+using namespace CppSerialPort;
+
+const char *DeviceMonitor::DEVICE_DIRECTORY{"/dev"};
+
+DeviceMonitor::DeviceMonitor(int fallbackInterval, QObject *parent) :
+    QObject{parent},
+    m_serialPorts{},
+    m_rescanTimer{},
+    m_inotifyFileDescriptor{-1},
+    m_deviceNotifier{nullptr}
+{
+    this->m_rescanTimer.setInterval(fallbackInterval);
+    connect(&this->m_rescanTimer, &QTimer::timeout, this, &DeviceMonitor::rescan);
+    //Watching starts before the first scan, so a port that appears in between is not missed
+    bool isWatching{this->startWatching()};
+    this->m_serialPorts = SerialPort::availableSerialPorts();
+    if (!isWatching) {
+        this->m_rescanTimer.start();
+    }
+}
+
+const std::unordered_set<std::string> &DeviceMonitor::serialPorts() const
+{
+    return this->m_serialPorts;
+}
+
+bool DeviceMonitor::isEventDriven() const
+{
+    return (this->m_deviceNotifier != nullptr);
+}
+
+void DeviceMonitor::rescan()
+{
+    std::unordered_set<std::string> serialPorts{SerialPort::availableSerialPorts()};
+    std::vector<std::string> removedPorts{};
+    for (const auto &it : this->m_serialPorts) {
+        if (serialPorts.find(it) == serialPorts.end()) {
+            removedPorts.push_back(it);
+        }
+    }
+    for (const auto &it : removedPorts) {
+        this->removeSerialPort(it);
+    }
+    for (const auto &it : serialPorts) {
+        this->addSerialPort(it);
+    }
+}
+
+void DeviceMonitor::addSerialPort(const std::string &portName)
+{
+    if (this->m_serialPorts.insert(portName).second) {
+        emit this->serialPortAdded(QString::fromStdString(portName));
+    }
+}
+
+void DeviceMonitor::removeSerialPort(const std::string &portName)
+{
+    if (this->m_serialPorts.erase(portName) > 0) {
+        emit this->serialPortRemoved(QString::fromStdString(portName));
+    }
+}
+
+#if defined(__linux__)
+bool DeviceMonitor::startWatching()
+{
+    this->m_inotifyFileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (this->m_inotifyFileDescriptor == -1) {
+        return false;
+    }
+    //Renames are watched too, since udev may create a node under a temporary name and move it into place
+    if (inotify_add_watch(this->m_inotifyFileDescriptor, DEVICE_DIRECTORY, IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM) == -1) {
+        this->stopWatching();
+        return false;
+    }
+    this->m_deviceNotifier.reset(new QSocketNotifier{this->m_inotifyFileDescriptor, QSocketNotifier::Read});
+    connect(this->m_deviceNotifier.get(), &QSocketNotifier::activated, this, &DeviceMonitor::onDeviceEvent);
+    return true;
+}
+
+void DeviceMonitor::stopWatching()
+{
+    this->m_deviceNotifier.reset();
+    if (this->m_inotifyFileDescriptor != -1) {
+        close(this->m_inotifyFileDescriptor);
+        this->m_inotifyFileDescriptor = -1;
+    }
+}
+
+void DeviceMonitor::onDeviceEvent()
+{
+    alignas(inotify_event) char buffer[4096];
+    bool needsRescan{false};
+    while (true) {
+        ssize_t bytesRead{read(this->m_inotifyFileDescriptor, buffer, sizeof(buffer))};
+        if (bytesRead <= 0) {
+            if ( (bytesRead == -1) && (errno == EINTR) ) {
+                continue;
+            }
+            break;
+        }
+        for (char *position = buffer; position < buffer + bytesRead; ) {
+            auto event = reinterpret_cast<inotify_event *>(position);
+            position += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                //Events were lost, so only a full scan can say what is there now
+                needsRescan = true;
+                continue;
+            }
+            if ( (event->len == 0) || (event->mask & IN_ISDIR) ) {
+                continue;
+            }
+            //Only the one node that changed is checked, rather than every possible port name
+            std::string portName{std::string{DEVICE_DIRECTORY} + "/" + event->name};
+            if (!SerialPort::isValidSerialPortName(portName)) {
+                continue;
+            }
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                //A node with no device behind it is left out, the same as in a full scan
+                SerialPortInfo info{};
+                if (SerialPort::findSerialPortInfo(portName, &info)) {
+                    this->addSerialPort(portName);
+                }
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                this->removeSerialPort(portName);
+            }
+        }
+    }
+    if (needsRescan) {
+        this->rescan();
+    }
+}
+#else
+bool DeviceMonitor::startWatching()
+{
+    return false;
+}
+
+void DeviceMonitor::stopWatching()
+{
+
+}
+
+void DeviceMonitor::onDeviceEvent()
+{
+
+}
+#endif //defined(__linux__)
+
+DeviceMonitor::~DeviceMonitor()
+{
+    this->stopWatching();
+}
@@ -0,0 +1,61 @@
+#ifndef QSERIALTERMINAL_DEVICEMONITOR_H
+#define QSERIALTERMINAL_DEVICEMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <string>
+#include <memory>
+#include <unordered_set>
+
+class QSocketNotifier;
+
+/*
+ * Keeps the set of serial ports on the machine up to date and reports
+ * each one that appears or goes away. On Linux it watches /dev through
+ * inotify, so nothing runs until a device node is created or removed and
+ * only that node is looked at. Where inotify is not available (or cannot
+ * be set up) it falls back to rescanning every port on a timer
+ */
+class DeviceMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DeviceMonitor(int fallbackInterval, QObject *parent = nullptr);
+    ~DeviceMonitor() override;
+
+    DeviceMonitor(const DeviceMonitor &other) = delete;
+    DeviceMonitor(DeviceMonitor &&other) = delete;
+    DeviceMonitor &operator=(const DeviceMonitor &rhs) = delete;
+    DeviceMonitor &operator=(DeviceMonitor &&rhs) = delete;
+
+    const std::unordered_set<std::string> &serialPorts() const;
+    bool isEventDriven() const;
+
+signals:
+    void serialPortAdded(const QString &portName);
+    void serialPortRemoved(const QString &portName);
+
+public slots:
+    void rescan();
+
+private slots:
+    void onDeviceEvent();
+
+private:
+    std::unordered_set<std::string> m_serialPorts;
+    QTimer m_rescanTimer;
+    int m_inotifyFileDescriptor;
+    std::unique_ptr<QSocketNotifier> m_deviceNotifier;
+
+    bool startWatching();
+    void stopWatching();
+    void addSerialPort(const std::string &portName);
+    void removeSerialPort(const std::string &portName);
+
+    static const char *DEVICE_DIRECTORY;
+};
+
+#endif //QSERIALTERMINAL_DEVICEMONITOR_H
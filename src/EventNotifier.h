@@ -0,0 +1,71 @@
+/***********************************************************************
+*    EventNotifier.h:                                                  *
+*    EventNotifier, coalescing wake-up for a background worker         *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of an EventNotifier class        *
+*    A worker thread calls notify() as often as it likes, but the      *
+*    callback only runs again once the consumer has acknowledged the  *
+*    last one, so a fast producer cannot flood the consumer's thread   *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_EVENTNOTIFIER_H
+#define CPPSERIALPORT_EVENTNOTIFIER_H
+
+#include <atomic>
+#include <functional>
+
+namespace CppSerialPort {
+
+class EventNotifier
+{
+public:
+    explicit EventNotifier(std::function<void()> callback) :
+        m_callback{callback},
+        m_isPending{false}
+    {
+
+    }
+
+    EventNotifier(const EventNotifier &other) = delete;
+    EventNotifier(EventNotifier &&other) = delete;
+    EventNotifier &operator=(const EventNotifier &rhs) = delete;
+    EventNotifier &operator=(EventNotifier &&rhs) = delete;
+
+    void notify()
+    {
+        if ( (!this->m_isPending.exchange(true)) && (this->m_callback) ) {
+            this->m_callback();
+        }
+    }
+
+    //For the last event of a run, which has to arrive even if the previous one was never acknowledged
+    void notifyAlways()
+    {
+        this->m_isPending = false;
+        this->notify();
+    }
+
+    //Must be called before draining, so that anything reported after the drain starts raises a fresh notification
+    void acknowledge()
+    {
+        this->m_isPending = false;
+    }
+
+private:
+    const std::function<void()> m_callback;
+    std::atomic<bool> m_isPending;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_EVENTNOTIFIER_H
@@ -0,0 +1,307 @@
+/***********************************************************************
+*    FileTransfer.cpp:                                                 *
+*    FileTransfer, base class for the XMODEM/YMODEM/ZMODEM transfers   *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a FileTransfer class        *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "FileTransfer.h"
+#include "XModemTransfer.h"
+#include "ZModemTransfer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <cctype>
+
+namespace CppSerialPort {
+
+const std::chrono::milliseconds FileTransfer::PROGRESS_INTERVAL{100};
+const std::chrono::milliseconds FileTransfer::WRITE_STALL_TIMEOUT{10000};
+const int FileTransfer::READ_TIMED_OUT{-1};
+const char FileTransfer::CANCEL_CHARACTER{0x18};
+
+FileTransfer::FileTransfer(std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback) :
+    m_byteStream{byteStream},
+    m_progressCallback{progressCallback},
+    m_isCancelled{false},
+    m_progressMutex{},
+    m_progress{"", 0, 0, 0, 0, 0, 0.0},
+    m_startTime{std::chrono::steady_clock::now()},
+    m_lastPublished{},
+    m_readBuffer{},
+    m_readPosition{0},
+    m_readLength{0}
+{
+    if (!this->m_byteStream) {
+        throw std::runtime_error("FileTransfer::FileTransfer(std::shared_ptr<IByteStream>, std::function<void()>): invariant failure (byteStream cannot be null)");
+    }
+}
+
+std::unique_ptr<FileTransfer> FileTransfer::create(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback)
+{
+    if (protocol == TransferProtocol::ZModem) {
+        return std::unique_ptr<FileTransfer>{new ZModemTransfer{byteStream, progressCallback}};
+    }
+    return std::unique_ptr<FileTransfer>{new XModemTransfer{protocol, byteStream, progressCallback}};
+}
+
+std::string FileTransfer::protocolName(TransferProtocol protocol)
+{
+    switch (protocol) {
+        case TransferProtocol::XModem:
+            return "XMODEM";
+        case TransferProtocol::XModem1K:
+            return "XMODEM-1K";
+        case TransferProtocol::YModem:
+            return "YMODEM";
+        case TransferProtocol::ZModem:
+            return "ZMODEM";
+    }
+    return "unknown";
+}
+
+TransferProtocol FileTransfer::parseProtocol(const std::string &str)
+{
+    std::string name{str};
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (name == "xmodem") {
+        return TransferProtocol::XModem;
+    } else if ( (name == "xmodem-1k") || (name == "xmodem1k") ) {
+        return TransferProtocol::XModem1K;
+    } else if (name == "ymodem") {
+        return TransferProtocol::YModem;
+    } else if (name == "zmodem") {
+        return TransferProtocol::ZModem;
+    }
+    throw std::runtime_error("FileTransfer::parseProtocol(const std::string &): invalid protocol \"" + str + "\"");
+}
+
+void FileTransfer::cancel()
+{
+    this->m_isCancelled = true;
+}
+
+bool FileTransfer::isCancelled() const
+{
+    return this->m_isCancelled;
+}
+
+TransferProgress FileTransfer::progress() const
+{
+    std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+    return this->m_progress;
+}
+
+void FileTransfer::throwIfCancelled(const std::string &context)
+{
+    if (this->m_isCancelled) {
+        this->sendCancelSequence();
+        throw std::runtime_error(context + ": transfer cancelled");
+    }
+}
+
+void FileTransfer::sendCancelSequence()
+{
+    //Enough CANs for any receiver to notice, then backspaces to erase them if they land on a shell instead
+    const char cancelSequence[]{"\x18\x18\x18\x18\x18\x18\x18\x18\x18\x18\b\b\b\b\b\b\b\b\b\b"};
+    try {
+        this->m_byteStream->write(cancelSequence, sizeof(cancelSequence) - 1);
+    } catch (std::exception &) {
+        //Best effort; the port may be the reason the transfer is being abandoned
+    }
+}
+
+int FileTransfer::readByte(std::chrono::milliseconds timeout)
+{
+    if (this->m_readPosition < this->m_readLength) {
+        return static_cast<unsigned char>(this->m_readBuffer[this->m_readPosition++]);
+    }
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    do {
+        //Wait in short slices so a cancel() is noticed well before a protocol timeout runs out
+        auto remainingTime = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        remainingTime = std::max(std::chrono::microseconds{0}, std::min(remainingTime, std::chrono::microseconds{100000}));
+        ssize_t bytesRead{this->m_byteStream->readSome(this->m_readBuffer, READ_BUFFER_SIZE, remainingTime)};
+        if (bytesRead < 0) {
+            throw std::runtime_error("FileTransfer::readByte(std::chrono::milliseconds): read from " + this->m_byteStream->portName() + " failed");
+        }
+        if (bytesRead > 0) {
+            this->m_readPosition = 1;
+            this->m_readLength = static_cast<size_t>(bytesRead);
+            return static_cast<unsigned char>(this->m_readBuffer[0]);
+        }
+        if (this->m_isCancelled) {
+            break;
+        }
+    } while (std::chrono::steady_clock::now() < deadline);
+    return READ_TIMED_OUT;
+}
+
+int FileTransfer::peekByte(std::chrono::milliseconds timeout)
+{
+    int c{this->readByte(timeout)};
+    if (c != READ_TIMED_OUT) {
+        //readByte() always leaves the byte it returned in the buffer, so stepping back is enough
+        this->m_readPosition--;
+    }
+    return c;
+}
+
+bool FileTransfer::hasPendingInput()
+{
+    if (this->m_readPosition < this->m_readLength) {
+        return true;
+    }
+    ssize_t bytesRead{this->m_byteStream->readSome(this->m_readBuffer, READ_BUFFER_SIZE, std::chrono::microseconds{0})};
+    if (bytesRead < 0) {
+        throw std::runtime_error("FileTransfer::hasPendingInput(): read from " + this->m_byteStream->portName() + " failed");
+    }
+    this->m_readPosition = 0;
+    this->m_readLength = static_cast<size_t>(std::max<ssize_t>(bytesRead, 0));
+    return bytesRead > 0;
+}
+
+void FileTransfer::discardInput(std::chrono::milliseconds quietTime)
+{
+    this->m_readPosition = 0;
+    this->m_readLength = 0;
+    while (this->m_byteStream->readSome(this->m_readBuffer, READ_BUFFER_SIZE, quietTime) > 0) { }
+}
+
+void FileTransfer::writeBytes(const char *data, size_t size)
+{
+    auto lastProgress = std::chrono::steady_clock::now();
+    while (size > 0) {
+        ssize_t bytesWritten{this->m_byteStream->write(data, size)};
+        if (bytesWritten < 0) {
+            throw std::runtime_error("FileTransfer::writeBytes(const char *, size_t): write to " + this->m_byteStream->portName() + " failed");
+        }
+        auto currentTime = std::chrono::steady_clock::now();
+        if (bytesWritten > 0) {
+            data += bytesWritten;
+            size -= static_cast<size_t>(bytesWritten);
+            lastProgress = currentTime;
+        } else if ( (this->m_isCancelled) || (currentTime - lastProgress > WRITE_STALL_TIMEOUT) ) {
+            throw std::runtime_error("FileTransfer::writeBytes(const char *, size_t): transmitter stalled on " + this->m_byteStream->portName());
+        }
+    }
+}
+
+void FileTransfer::writeByte(char c)
+{
+    this->writeBytes(&c, 1);
+}
+
+void FileTransfer::beginTransfer()
+{
+    std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+    this->m_startTime = std::chrono::steady_clock::now();
+    this->m_lastPublished = this->m_startTime;
+    this->m_progress = TransferProgress{"", 0, 0, 0, 0, 0, 0.0};
+    this->m_readPosition = 0;
+    this->m_readLength = 0;
+}
+
+void FileTransfer::beginFile(const std::string &fileName, uint64_t fileSize)
+{
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        this->m_progress.fileName = fileName;
+        this->m_progress.fileSize = fileSize;
+        this->m_progress.fileBytesTransferred = 0;
+    }
+    this->publishProgress(true);
+}
+
+void FileTransfer::setFilePosition(uint64_t position)
+{
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        //A restart from an earlier position does not undo the bytes already counted towards the throughput
+        this->m_progress.fileBytesTransferred = position;
+    }
+    this->publishProgress(false);
+}
+
+void FileTransfer::addFileBytes(uint64_t byteCount)
+{
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        this->m_progress.fileBytesTransferred += byteCount;
+        this->m_progress.totalBytesTransferred += byteCount;
+    }
+    this->publishProgress(false);
+}
+
+void FileTransfer::finishFile()
+{
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        this->m_progress.filesCompleted++;
+    }
+    this->publishProgress(true);
+}
+
+void FileTransfer::countError()
+{
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        this->m_progress.errorCount++;
+    }
+    this->publishProgress(false);
+}
+
+void FileTransfer::publishProgress(bool force)
+{
+    auto currentTime = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> progressLock{this->m_progressMutex};
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(currentTime - this->m_startTime).count();
+        if ( (!force) && (currentTime - this->m_lastPublished < PROGRESS_INTERVAL) ) {
+            return;
+        }
+        this->m_lastPublished = currentTime;
+    }
+    if (this->m_progressCallback) {
+        this->m_progressCallback();
+    }
+}
+
+std::string FileTransfer::baseName(const std::string &filePath)
+{
+    auto separatorPosition = filePath.find_last_of("/\\");
+    return (separatorPosition == std::string::npos ? filePath : filePath.substr(separatorPosition + 1));
+}
+
+bool FileTransfer::receivedFilePath(const std::string &offeredName, const std::string &destination, std::string *safeName, std::string *filePath)
+{
+    //Never trust a path from the other end; only the last component is used
+    *safeName = baseName(offeredName);
+    if ( (safeName->empty()) || (*safeName == ".") || (*safeName == "..") ) {
+        return false;
+    }
+    *filePath = (destination.empty() ? *safeName : destination + "/" + *safeName);
+    return true;
+}
+
+uint64_t FileTransfer::fileSize(const std::string &filePath)
+{
+    std::ifstream inputFile{filePath, std::ios::binary | std::ios::ate};
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("FileTransfer::fileSize(const std::string &): could not open \"" + filePath + "\"");
+    }
+    return static_cast<uint64_t>(inputFile.tellg());
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,133 @@
+/***********************************************************************
+*    FileTransfer.h:                                                   *
+*    FileTransfer, base class for the XMODEM/YMODEM/ZMODEM transfers   *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a FileTransfer class          *
+*    A transfer owns the byte stream for its whole duration; nothing   *
+*    else may read from or write to the port while it runs. Transfers  *
+*    are synchronous and throw std::runtime_error when they fail or    *
+*    are cancelled. Files are streamed from and to disk in blocks,     *
+*    and progress is published at most every PROGRESS_INTERVAL         *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_FILETRANSFER_H
+#define CPPSERIALPORT_FILETRANSFER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+#include "IByteStream.h"
+
+namespace CppSerialPort {
+
+enum class TransferProtocol
+{
+    XModem,
+    XModem1K,
+    YModem,
+    ZModem
+};
+
+struct TransferProgress
+{
+    std::string fileName;
+    uint64_t fileBytesTransferred;
+    uint64_t fileSize;
+    uint64_t totalBytesTransferred;
+    unsigned filesCompleted;
+    unsigned errorCount;
+    double elapsedSeconds;
+};
+
+class FileTransfer
+{
+public:
+    FileTransfer(std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback);
+    virtual ~FileTransfer() = default;
+
+    FileTransfer(const FileTransfer &other) = delete;
+    FileTransfer(FileTransfer &&other) = delete;
+    FileTransfer &operator=(const FileTransfer &rhs) = delete;
+    FileTransfer &operator=(FileTransfer &&rhs) = delete;
+
+    virtual void sendFiles(const std::vector<std::string> &filePaths) = 0;
+    //Batch protocols write into the destination directory under the names the sender used;
+    //plain XMODEM carries no name, so there the destination is the file itself
+    virtual std::vector<std::string> receiveFiles(const std::string &destination) = 0;
+    virtual TransferProtocol protocol() const = 0;
+
+    //Safe to call from any thread; the transfer notices at its next block boundary or timeout
+    void cancel();
+    bool isCancelled() const;
+    TransferProgress progress() const;
+
+    static std::unique_ptr<FileTransfer> create(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback = nullptr);
+    static std::string protocolName(TransferProtocol protocol);
+    static TransferProtocol parseProtocol(const std::string &str);
+
+    static const std::chrono::milliseconds PROGRESS_INTERVAL;
+
+protected:
+    std::shared_ptr<IByteStream> m_byteStream;
+
+    static const int READ_TIMED_OUT;
+
+    //Returns the next byte (0 - 255), or READ_TIMED_OUT
+    int readByte(std::chrono::milliseconds timeout);
+    //Like readByte(), but the byte stays buffered for the next read
+    int peekByte(std::chrono::milliseconds timeout);
+    bool hasPendingInput();
+    void discardInput(std::chrono::milliseconds quietTime);
+    void writeBytes(const char *data, size_t size);
+    void writeByte(char c);
+    void sendCancelSequence();
+    void throwIfCancelled(const std::string &context);
+
+    void beginTransfer();
+    void beginFile(const std::string &fileName, uint64_t fileSize);
+    void setFilePosition(uint64_t position);
+    void addFileBytes(uint64_t byteCount);
+    void finishFile();
+    void countError();
+    void publishProgress(bool force);
+
+    static std::string baseName(const std::string &filePath);
+    //False if the name offered by the sender has nothing usable left once its directories are dropped
+    static bool receivedFilePath(const std::string &offeredName, const std::string &destination, std::string *safeName, std::string *filePath);
+    static uint64_t fileSize(const std::string &filePath);
+
+    static const char CANCEL_CHARACTER;
+    static const size_t constexpr READ_BUFFER_SIZE{4096};
+    static const std::chrono::milliseconds WRITE_STALL_TIMEOUT;
+
+private:
+    std::function<void()> m_progressCallback;
+    std::atomic<bool> m_isCancelled;
+    mutable std::mutex m_progressMutex;
+    TransferProgress m_progress;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastPublished;
+    char m_readBuffer[READ_BUFFER_SIZE];
+    size_t m_readPosition;
+    size_t m_readLength;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_FILETRANSFER_H
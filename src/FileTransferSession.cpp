@@ -0,0 +1,151 @@
+#include "FileTransferSession.h"
+
+#include <stdexcept>
+
+using namespace CppSerialPort;
+
+FileTransferSession::FileTransferSession(std::function<void()> transferEventCallback) :
+    m_transferEventNotifier{transferEventCallback},
+    m_fileTransfer{nullptr},
+    m_transferThread{},
+    m_isRunning{false},
+    m_isSending{false},
+    m_protocol{TransferProtocol::ZModem},
+    m_mutex{},
+    m_state{TransferState::Idle},
+    m_receivedFiles{},
+    m_errorString{""}
+{
+
+}
+
+FileTransferSession::~FileTransferSession()
+{
+    this->stop();
+}
+
+void FileTransferSession::startSending(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, const std::vector<std::string> &filePaths)
+{
+    if (filePaths.empty()) {
+        throw std::runtime_error("FileTransferSession::startSending(TransferProtocol, std::shared_ptr<IByteStream>, const std::vector<std::string> &): no files to send");
+    }
+    if ( (filePaths.size() > 1) && ( (protocol == TransferProtocol::XModem) || (protocol == TransferProtocol::XModem1K) ) ) {
+        throw std::runtime_error("FileTransferSession::startSending(TransferProtocol, std::shared_ptr<IByteStream>, const std::vector<std::string> &): " + FileTransfer::protocolName(protocol) + " can only send one file");
+    }
+    this->start(protocol, byteStream, true, [this, filePaths]() {
+        this->m_fileTransfer->sendFiles(filePaths);
+    });
+}
+
+void FileTransferSession::startReceiving(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, const std::string &destination)
+{
+    this->start(protocol, byteStream, false, [this, destination]() {
+        std::vector<std::string> receivedFiles{this->m_fileTransfer->receiveFiles(destination)};
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_receivedFiles = std::move(receivedFiles);
+    });
+}
+
+void FileTransferSession::start(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, bool isSending, std::function<void()> transferFunction)
+{
+    if (this->m_isRunning) {
+        throw std::runtime_error("FileTransferSession::start(TransferProtocol, std::shared_ptr<IByteStream>, bool, std::function<void()>): a transfer is already running");
+    }
+    if (this->m_transferThread.joinable()) {
+        this->m_transferThread.join();
+    }
+    this->m_fileTransfer = FileTransfer::create(protocol, byteStream, [this]() {
+        this->m_transferEventNotifier.notify();
+    });
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_state = TransferState::Running;
+        this->m_receivedFiles.clear();
+        this->m_errorString = "";
+    }
+    this->m_isSending = isSending;
+    this->m_protocol = protocol;
+    this->m_transferEventNotifier.acknowledge();
+    this->m_isRunning = true;
+    this->m_transferThread = std::thread{&FileTransferSession::run, this, transferFunction};
+}
+
+void FileTransferSession::cancel()
+{
+    if (this->m_fileTransfer) {
+        this->m_fileTransfer->cancel();
+    }
+}
+
+void FileTransferSession::stop()
+{
+    this->cancel();
+    if (this->m_transferThread.joinable()) {
+        this->m_transferThread.join();
+    }
+}
+
+bool FileTransferSession::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+bool FileTransferSession::isSending() const
+{
+    return this->m_isSending;
+}
+
+TransferProtocol FileTransferSession::protocol() const
+{
+    return this->m_protocol;
+}
+
+TransferState FileTransferSession::state() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_state;
+}
+
+TransferProgress FileTransferSession::progress() const
+{
+    if (!this->m_fileTransfer) {
+        return TransferProgress{"", 0, 0, 0, 0, 0, 0.0};
+    }
+    return this->m_fileTransfer->progress();
+}
+
+std::vector<std::string> FileTransferSession::receivedFiles() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_receivedFiles;
+}
+
+std::string FileTransferSession::errorString() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_errorString;
+}
+
+void FileTransferSession::acknowledgeNotification()
+{
+    this->m_transferEventNotifier.acknowledge();
+}
+
+void FileTransferSession::run(std::function<void()> transferFunction)
+{
+    TransferState finalState{TransferState::Finished};
+    std::string errorString{""};
+    try {
+        transferFunction();
+    } catch (std::exception &e) {
+        finalState = (this->m_fileTransfer->isCancelled() ? TransferState::Cancelled : TransferState::Failed);
+        errorString = e.what();
+    }
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_state = finalState;
+        this->m_errorString = errorString;
+    }
+    this->m_isRunning = false;
+    this->m_transferEventNotifier.notifyAlways();
+}
@@ -0,0 +1,76 @@
+#ifndef QSERIALTERMINAL_FILETRANSFERSESSION_H
+#define QSERIALTERMINAL_FILETRANSFERSESSION_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+#include "FileTransfer.h"
+#include "EventNotifier.h"
+
+enum class TransferState
+{
+    Idle,
+    Running,
+    Finished,
+    Cancelled,
+    Failed
+};
+
+/*
+ * Runs one XMODEM/YMODEM/ZMODEM transfer on its own thread so the GUI
+ * stays responsive. The transfer needs the port to itself, so the caller
+ * stops its reader and writer before starting one and restarts them once
+ * the session reports that it is no longer running. Progress events are
+ * coalesced the same way as ScriptRunner's: at most one is outstanding
+ * until acknowledgeNotification() is called, and the final one is always
+ * delivered
+ */
+class FileTransferSession
+{
+public:
+    explicit FileTransferSession(std::function<void()> transferEventCallback);
+    ~FileTransferSession();
+
+    FileTransferSession(const FileTransferSession &other) = delete;
+    FileTransferSession(FileTransferSession &&other) = delete;
+    FileTransferSession &operator=(const FileTransferSession &rhs) = delete;
+    FileTransferSession &operator=(FileTransferSession &&rhs) = delete;
+
+    void startSending(CppSerialPort::TransferProtocol protocol, std::shared_ptr<CppSerialPort::IByteStream> byteStream, const std::vector<std::string> &filePaths);
+    void startReceiving(CppSerialPort::TransferProtocol protocol, std::shared_ptr<CppSerialPort::IByteStream> byteStream, const std::string &destination);
+    //Returns straight away; the final event arrives once the transfer thread has wound down
+    void cancel();
+    //Cancels and waits for the transfer thread
+    void stop();
+    bool isRunning() const;
+    bool isSending() const;
+    CppSerialPort::TransferProtocol protocol() const;
+
+    TransferState state() const;
+    CppSerialPort::TransferProgress progress() const;
+    std::vector<std::string> receivedFiles() const;
+    std::string errorString() const;
+    void acknowledgeNotification();
+
+private:
+    CppSerialPort::EventNotifier m_transferEventNotifier;
+    std::unique_ptr<CppSerialPort::FileTransfer> m_fileTransfer;
+    std::thread m_transferThread;
+    std::atomic<bool> m_isRunning;
+    bool m_isSending;
+    CppSerialPort::TransferProtocol m_protocol;
+    mutable std::mutex m_mutex;
+    TransferState m_state;
+    std::vector<std::string> m_receivedFiles;
+    std::string m_errorString;
+
+    void start(CppSerialPort::TransferProtocol protocol, std::shared_ptr<CppSerialPort::IByteStream> byteStream, bool isSending, std::function<void()> transferFunction);
+    void run(std::function<void()> transferFunction);
+};
+
+#endif //QSERIALTERMINAL_FILETRANSFERSESSION_H
@@ -0,0 +1,6 @@
+#include "HeadlessTerminal.h"
+
+int main(int argc, char *argv[])
+{
+    return HeadlessTerminal::main(argc, argv);
+}
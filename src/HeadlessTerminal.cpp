@@ -0,0 +1,1132 @@
+#include "HeadlessTerminal.h"
+#include "ApplicationSettings.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <csignal>
+
+#include <poll.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/eventfd.h>
+
+using namespace CppSerialPort;
+
+const char *HeadlessTerminal::HEADLESS_SWITCH{"--headless"};
+
+static volatile sig_atomic_t stopRequested{0};
+
+static void headlessSignalHandler(int signalNumber)
+{
+    (void)signalNumber;
+    stopRequested = 1;
+}
+
+static std::string toLowercase(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return str;
+}
+
+static const std::vector<std::pair<const char *, BaudRate>> BAUD_RATE_NAMES{
+    {"50", BaudRate::Baud50}, {"75", BaudRate::Baud75}, {"110", BaudRate::Baud110}, {"134", BaudRate::Baud134},
+    {"150", BaudRate::Baud150}, {"200", BaudRate::Baud200}, {"300", BaudRate::Baud300}, {"600", BaudRate::Baud600},
+    {"1200", BaudRate::Baud1200}, {"1800", BaudRate::Baud1800}, {"2400", BaudRate::Baud2400}, {"4800", BaudRate::Baud4800},
+    {"9600", BaudRate::Baud9600}, {"19200", BaudRate::Baud19200}, {"38400", BaudRate::Baud38400}, {"57600", BaudRate::Baud57600},
+    {"115200", BaudRate::Baud115200}, {"230400", BaudRate::Baud230400}, {"460800", BaudRate::Baud460800}, {"500000", BaudRate::Baud500000},
+    {"576000", BaudRate::Baud576000}, {"921600", BaudRate::Baud921600}, {"1000000", BaudRate::Baud1000000}, {"1152000", BaudRate::Baud1152000},
+    {"1500000", BaudRate::Baud1500000}, {"2000000", BaudRate::Baud2000000}, {"2500000", BaudRate::Baud2500000}, {"3000000", BaudRate::Baud3000000},
+    {"3500000", BaudRate::Baud3500000}, {"4000000", BaudRate::Baud4000000}
+};
+
+static struct option headlessLongOptions[]{
+    { "port",         required_argument, nullptr, 'p' },
+    { "baud",         required_argument, nullptr, 'b' },
+    { "data-bits",    required_argument, nullptr, 'd' },
+    { "stop-bits",    required_argument, nullptr, 's' },
+    { "parity",       required_argument, nullptr, 'a' },
+    { "flow-control", required_argument, nullptr, 'f' },
+    { "line-ending",  required_argument, nullptr, 'l' },
+    { "verbose",      no_argument,       nullptr, 'e' },
+    { "help",         no_argument,       nullptr, 'h' },
+    { "version",      no_argument,       nullptr, 'v' },
+    { "headless",     no_argument,       nullptr, 'H' },
+    { "send",         required_argument, nullptr, 'S' },
+    { "receive",      required_argument, nullptr, 'R' },
+    { "protocol",     required_argument, nullptr, 'P' },
+    { "record",       required_argument, nullptr, 'r' },
+    { "replay",       required_argument, nullptr, 'y' },
+    { "replay-speed", required_argument, nullptr, 'x' },
+    { "view",         required_argument, nullptr, 'V' },
+    { "goto",         required_argument, nullptr, 'g' },
+    { "search",       required_argument, nullptr, 'F' },
+    { "regex",        no_argument,       nullptr, 'E' },
+    { "ignore-case",  no_argument,       nullptr, 'i' },
+    { "display",      required_argument, nullptr, 'D' },
+    { "timestamps",   required_argument, nullptr, 'T' },
+    { "interpolate",  no_argument,       nullptr, 'I' },
+    { "reactor-threads", required_argument, nullptr, 'N' },
+    { "pin-reactors", no_argument,       nullptr, 'C' },
+    { nullptr, 0, nullptr, 0 }
+};
+
+HeadlessTerminal::HeadlessTerminal(const HeadlessOptions &options) :
+    m_options{options},
+    m_serialPort{nullptr},
+    m_pendingInput{""},
+    m_recorder{nullptr},
+    m_displayBuffer{""},
+    m_pendingHexRow{""},
+    m_pendingHexRowTimestamp{0, 0},
+    m_displayOffset{0},
+    m_atLineStart{true},
+    m_characterDuration{options.interpolateTimestamps ? SerialPort::characterDuration(baudRateValue(options.baudRate), options.dataBits, options.parity, options.stopBits) : 0},
+    m_monitoredPorts{}
+{
+
+}
+
+BaudRate HeadlessTerminal::parseBaudRate(const std::string &str)
+{
+    for (const auto &it : BAUD_RATE_NAMES) {
+        if (str == it.first) {
+            return it.second;
+        }
+    }
+    throw std::runtime_error("HeadlessTerminal::parseBaudRate(const std::string &): invalid baud rate \"" + str + "\"");
+}
+
+unsigned HeadlessTerminal::baudRateValue(BaudRate baudRate)
+{
+    for (const auto &it : BAUD_RATE_NAMES) {
+        if (baudRate == it.second) {
+            return static_cast<unsigned>(std::stoul(it.first));
+        }
+    }
+    throw std::runtime_error("HeadlessTerminal::baudRateValue(BaudRate): unknown baud rate");
+}
+
+DataBits HeadlessTerminal::parseDataBits(const std::string &str)
+{
+    if (str == "5") {
+        return DataBits::DataFive;
+    } else if (str == "6") {
+        return DataBits::DataSix;
+    } else if (str == "7") {
+        return DataBits::DataSeven;
+    } else if (str == "8") {
+        return DataBits::DataEight;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseDataBits(const std::string &): invalid data bits \"" + str + "\"");
+}
+
+StopBits HeadlessTerminal::parseStopBits(const std::string &str)
+{
+    if (str == "1") {
+        return StopBits::StopOne;
+    } else if (str == "2") {
+        return StopBits::StopTwo;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseStopBits(const std::string &): invalid stop bits \"" + str + "\"");
+}
+
+Parity HeadlessTerminal::parseParity(const std::string &str)
+{
+    std::string parity{toLowercase(str)};
+    if (parity == "none") {
+        return Parity::ParityNone;
+    } else if (parity == "even") {
+        return Parity::ParityEven;
+    } else if (parity == "odd") {
+        return Parity::ParityOdd;
+    } else if (parity == "space") {
+        return Parity::ParitySpace;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseParity(const std::string &): invalid parity \"" + str + "\"");
+}
+
+FlowControl HeadlessTerminal::parseFlowControl(const std::string &str)
+{
+    std::string flowControl{toLowercase(str)};
+    if (flowControl == "off") {
+        return FlowControl::FlowOff;
+    } else if (flowControl == "hardware") {
+        return FlowControl::FlowHardware;
+    } else if (flowControl == "xonxoff") {
+        return FlowControl::FlowXonXoff;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseFlowControl(const std::string &): invalid flow control \"" + str + "\"");
+}
+
+std::string HeadlessTerminal::parseLineEnding(const std::string &str)
+{
+    //Accept both the escaped spelling used in the GUI menu and the usual names
+    std::string lineEnding{toLowercase(str)};
+    if ( (lineEnding == R"(\n)") || (lineEnding == "lf") ) {
+        return "\n";
+    } else if ( (lineEnding == R"(\r)") || (lineEnding == "cr") ) {
+        return "\r";
+    } else if ( (lineEnding == R"(\r\n)") || (lineEnding == "crlf") ) {
+        return "\r\n";
+    }
+    throw std::runtime_error("HeadlessTerminal::parseLineEnding(const std::string &): invalid line ending \"" + str + "\"");
+}
+
+ReplayOptions HeadlessTerminal::parseReplaySpeed(const std::string &str)
+{
+    if (toLowercase(str) == "max") {
+        return ReplayOptions{ReplayMode::MaximumSpeed, 1.0};
+    }
+    size_t parsedLength{0};
+    double speedFactor{0.0};
+    try {
+        speedFactor = std::stod(str, &parsedLength);
+    } catch (std::exception &e) {
+        parsedLength = 0;
+    }
+    if ( (parsedLength != str.length()) || (!(speedFactor > 0.0)) ) {
+        throw std::runtime_error("HeadlessTerminal::parseReplaySpeed(const std::string &): invalid replay speed \"" + str + "\"");
+    }
+    return ReplayOptions{ReplayMode::Timed, speedFactor};
+}
+
+DisplayMode HeadlessTerminal::parseDisplayMode(const std::string &str)
+{
+    std::string displayMode{toLowercase(str)};
+    if (displayMode == "text") {
+        return DisplayMode::Text;
+    } else if (displayMode == "escaped") {
+        return DisplayMode::Escaped;
+    } else if (displayMode == "hex") {
+        return DisplayMode::Hex;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseDisplayMode(const std::string &): invalid display mode \"" + str + "\"");
+}
+
+TimestampMode HeadlessTerminal::parseTimestampMode(const std::string &str)
+{
+    std::string timestampMode{toLowercase(str)};
+    if (timestampMode == "none") {
+        return TimestampMode::None;
+    } else if (timestampMode == "monotonic") {
+        return TimestampMode::Monotonic;
+    } else if (timestampMode == "realtime") {
+        return TimestampMode::Realtime;
+    }
+    throw std::runtime_error("HeadlessTerminal::parseTimestampMode(const std::string &): invalid timestamp mode \"" + str + "\"");
+}
+
+unsigned HeadlessTerminal::parseReactorThreads(const std::string &str)
+{
+    size_t parsedLength{0};
+    unsigned long reactorThreads{0};
+    try {
+        reactorThreads = std::stoul(str, &parsedLength);
+    } catch (std::exception &e) {
+        parsedLength = 0;
+    }
+    if ( (parsedLength != str.length()) || (reactorThreads == 0) || (reactorThreads > MAX_REACTOR_THREADS) ) {
+        throw std::runtime_error("HeadlessTerminal::parseReactorThreads(const std::string &): invalid reactor thread count \"" + str + "\"");
+    }
+    return static_cast<unsigned>(reactorThreads);
+}
+
+bool HeadlessTerminal::isHeadlessRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], HEADLESS_SWITCH) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HeadlessTerminal::displayHelp(const char *programName)
+{
+    std::cout << "Usage: " << programName << " --port=PORT [Option [=value]]" << std::endl;
+    std::cout << "       " << programName << " --port=PORT --port=PORT... [Option [=value]]" << std::endl;
+    std::cout << "       " << programName << " --replay=FILE [--port=PORT] [Option [=value]]" << std::endl;
+    std::cout << "       " << programName << " --view=FILE [--goto=POSITION | --search=PATTERN]" << std::endl;
+    std::cout << "Options: " << std::endl;
+    std::cout << "    -p, --port: Serial port to open (required unless replaying); repeat it to monitor several ports at once" << std::endl;
+    std::cout << "    -b, --baud: Baud rate (default 9600)" << std::endl;
+    std::cout << "    -d, --data-bits: 5, 6, 7 or 8 (default 8)" << std::endl;
+    std::cout << "    -s, --stop-bits: 1 or 2 (default 1)" << std::endl;
+    std::cout << "    -a, --parity: None, Even, Odd or Space (default None)" << std::endl;
+    std::cout << "    -f, --flow-control: Off, Hardware or XonXoff (default Off)" << std::endl;
+    std::cout << "    -l, --line-ending: \\n, \\r or \\r\\n (or lf, cr, crlf) appended to each stdin line (default \\n)" << std::endl;
+    std::cout << "    -D, --display: Text, Escaped (non-printable bytes as \\xHH) or Hex (hexdump -C rows) for received data (default Text)" << std::endl;
+    std::cout << "    -T, --timestamps: None, Monotonic (seconds since boot) or Realtime (local time), to the microsecond, before each received line (default None)" << std::endl;
+    std::cout << "    -I, --interpolate: Work each line's timestamp back from the end of its read by the character time at the port settings" << std::endl;
+    std::cout << "    -N, --reactor-threads: Threads to share several ports between (default one per " << SerialReactor::PORTS_PER_THREAD << " ports, up to one per core)" << std::endl;
+    std::cout << "    -C, --pin-reactors: Pin each reactor thread to its own core" << std::endl;
+    std::cout << "    -S, --send: Send a file instead of starting the terminal (may be repeated)" << std::endl;
+    std::cout << "    -R, --receive: Receive into a directory (a file for XMODEM) instead of starting the terminal" << std::endl;
+    std::cout << "    -P, --protocol: XMODEM, XMODEM-1K, YMODEM or ZMODEM, for --send and --receive (default ZMODEM)" << std::endl;
+    std::cout << "    -r, --record: Capture everything sent and received to a binary session file" << std::endl;
+    std::cout << "    -y, --replay: Play back what a session file received, to stdout or out of --port" << std::endl;
+    std::cout << "    -x, --replay-speed: Multiple of the recorded timing, or max to replay as fast as possible (default 1)" << std::endl;
+    std::cout << "    -V, --view: Print a session file as timestamped Rx/Tx lines" << std::endl;
+    std::cout << "    -g, --goto: Start --view at a byte offset in the file, or at @SECONDS into the recording" << std::endl;
+    std::cout << "    -F, --search: With --view, print only the lines containing PATTERN" << std::endl;
+    std::cout << "    -E, --regex: Treat the --search pattern as an ECMAScript regular expression" << std::endl;
+    std::cout << "    -i, --ignore-case: Match the --search pattern regardless of case" << std::endl;
+    std::cout << "    -e, --verbose: Enable verbose logging on stderr" << std::endl;
+    std::cout << "    -h, --help: Display this help text" << std::endl;
+    std::cout << "    -v, --version: Display the version" << std::endl;
+}
+
+HeadlessOptions HeadlessTerminal::parseOptions(int argc, char *argv[])
+{
+    HeadlessOptions options{"", BaudRate::Baud9600, DataBits::DataEight, StopBits::StopOne, Parity::ParityNone, FlowControl::FlowOff, "\n", false, {}, "", TransferProtocol::ZModem, "", "", SessionReplayer::defaultOptions(), "", "", SearchOptions{"", false, true}, DisplayMode::Text, TimestampMode::None, false, {}, 0, false};
+    int optionIndex{0};
+    int currentOption{0};
+    opterr = 0;
+    optind = 1;
+    while ( (currentOption = getopt_long(argc, argv, "p:b:d:s:a:f:l:ehvHS:R:P:r:y:x:V:g:F:EiD:T:IN:C", headlessLongOptions, &optionIndex)) != -1) {
+        switch (currentOption) {
+            case 'p':
+                options.monitorPorts.push_back(optarg);
+                break;
+            case 'b':
+                options.baudRate = parseBaudRate(optarg);
+                break;
+            case 'd':
+                options.dataBits = parseDataBits(optarg);
+                break;
+            case 's':
+                options.stopBits = parseStopBits(optarg);
+                break;
+            case 'a':
+                options.parity = parseParity(optarg);
+                break;
+            case 'f':
+                options.flowControl = parseFlowControl(optarg);
+                break;
+            case 'l':
+                options.lineEnding = parseLineEnding(optarg);
+                break;
+            case 'e':
+                options.verbose = true;
+                break;
+            case 'h':
+                displayHelp(argv[0]);
+                exit(EXIT_SUCCESS);
+            case 'v':
+                std::cout << GlobalSettings::PROGRAM_NAME << ", v" << GlobalSettings::SOFTWARE_MAJOR_VERSION << "." << GlobalSettings::SOFTWARE_MINOR_VERSION << "." << GlobalSettings::SOFTWARE_PATCH_VERSION << std::endl;
+                exit(EXIT_SUCCESS);
+            case 'H':
+                break;
+            case 'S':
+                options.sendFiles.push_back(optarg);
+                break;
+            case 'R':
+                options.receivePath = optarg;
+                break;
+            case 'P':
+                options.transferProtocol = FileTransfer::parseProtocol(optarg);
+                break;
+            case 'r':
+                options.recordPath = optarg;
+                break;
+            case 'y':
+                options.replayPath = optarg;
+                break;
+            case 'x':
+                options.replayOptions = parseReplaySpeed(optarg);
+                break;
+            case 'D':
+                options.displayMode = parseDisplayMode(optarg);
+                break;
+            case 'T':
+                options.timestampMode = parseTimestampMode(optarg);
+                break;
+            case 'I':
+                options.interpolateTimestamps = true;
+                break;
+            case 'N':
+                options.reactorThreads = parseReactorThreads(optarg);
+                break;
+            case 'C':
+                options.pinReactors = true;
+                break;
+            case 'V':
+                options.viewPath = optarg;
+                break;
+            case 'g':
+                options.viewPosition = optarg;
+                break;
+            case 'F':
+                options.searchOptions.pattern = optarg;
+                break;
+            case 'E':
+                options.searchOptions.isRegex = true;
+                break;
+            case 'i':
+                options.searchOptions.isCaseSensitive = false;
+                break;
+            default:
+                throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): invalid switch \"" + std::string{argv[optind - 1]} + "\"");
+        }
+    }
+    //A single port is the ordinary terminal; only a second one turns it into a monitor
+    if (!options.monitorPorts.empty()) {
+        options.portName = options.monitorPorts.front();
+    }
+    if (options.monitorPorts.size() == 1) {
+        options.monitorPorts.clear();
+    }
+    if ( (options.monitorPorts.empty()) && ( (options.reactorThreads != 0) || (options.pinReactors) ) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --reactor-threads and --pin-reactors need more than one --port");
+    }
+    if (!options.viewPath.empty()) {
+        if ( (!options.portName.empty()) || (!options.replayPath.empty()) || (!options.recordPath.empty()) || (!options.sendFiles.empty()) || (!options.receivePath.empty()) ) {
+            throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --view cannot be used with a serial port, --record, --replay, --send or --receive");
+        }
+        if ( (!options.viewPosition.empty()) && (!options.searchOptions.pattern.empty()) ) {
+            throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --goto and --search cannot be used together");
+        }
+        return options;
+    }
+    if ( (!options.viewPosition.empty()) || (!options.searchOptions.pattern.empty()) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --goto and --search need --view");
+    }
+    if ( (options.interpolateTimestamps) && (options.timestampMode == TimestampMode::None) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --interpolate needs --timestamps");
+    }
+    if ( (options.portName.empty()) && (options.replayPath.empty()) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): no serial port specified (use --port)");
+    }
+    if (!options.monitorPorts.empty()) {
+        if ( (!options.replayPath.empty()) || (!options.recordPath.empty()) || (!options.sendFiles.empty()) || (!options.receivePath.empty()) ) {
+            throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): more than one --port cannot be used with --record, --replay, --send or --receive");
+        }
+        if (options.displayMode == DisplayMode::Hex) {
+            throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): more than one --port cannot be used with --display hex");
+        }
+    }
+    if ( (!options.replayPath.empty()) && ( (!options.sendFiles.empty()) || (!options.receivePath.empty()) ) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --replay cannot be used with --send or --receive");
+    }
+    if ( (!options.replayPath.empty()) && (options.portName.empty()) && (!options.recordPath.empty()) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --record needs --port");
+    }
+    if ( (!options.sendFiles.empty()) && (!options.receivePath.empty()) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): --send and --receive cannot be used together");
+    }
+    if ( (options.sendFiles.size() > 1) && ( (options.transferProtocol == TransferProtocol::XModem) || (options.transferProtocol == TransferProtocol::XModem1K) ) ) {
+        throw std::runtime_error("HeadlessTerminal::parseOptions(int, char **): " + FileTransfer::protocolName(options.transferProtocol) + " can only send one file");
+    }
+    return options;
+}
+
+int HeadlessTerminal::main(int argc, char *argv[])
+{
+    try {
+        HeadlessTerminal headlessTerminal{parseOptions(argc, argv)};
+        return headlessTerminal.run();
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+void HeadlessTerminal::installSignalHandlers()
+{
+    struct sigaction stopHandler{};
+    stopHandler.sa_handler = headlessSignalHandler;
+    sigemptyset(&stopHandler.sa_mask);
+    //No SA_RESTART, so poll() returns EINTR and the loop notices the request straight away
+    stopHandler.sa_flags = 0;
+    sigaction(SIGINT, &stopHandler, nullptr);
+    sigaction(SIGTERM, &stopHandler, nullptr);
+    sigaction(SIGHUP, &stopHandler, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+void HeadlessTerminal::logVerbose(const std::string &str) const
+{
+    if (this->m_options.verbose) {
+        std::cerr << str << std::endl;
+    }
+}
+
+bool HeadlessTerminal::writeAll(int fileDescriptor, const char *data, size_t size)
+{
+    while (size > 0) {
+        auto writtenBytes = ::write(fileDescriptor, data, size);
+        if (writtenBytes < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += writtenBytes;
+        size -= static_cast<size_t>(writtenBytes);
+    }
+    return true;
+}
+
+ssize_t HeadlessTerminal::forwardPortToStdout()
+{
+    char buffer[IO_BUFFER_SIZE];
+    ssize_t bytesRead{this->m_serialPort->readSome(buffer, sizeof(buffer))};
+    if (bytesRead < 0) {
+        std::cerr << "Unable to read from " << this->m_serialPort->portName() << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    if (!this->writeReceived(buffer, static_cast<size_t>(bytesRead), this->m_serialPort->lastReadTimestamp())) {
+        return -1;
+    }
+    return bytesRead;
+}
+
+bool HeadlessTerminal::writeReceived(const char *data, size_t size, const ReadTimestamp &timestamp)
+{
+    if (this->m_options.displayMode == DisplayMode::Hex) {
+        return this->writeHexRows(data, size, timestamp);
+    }
+    if ( (this->m_options.displayMode == DisplayMode::Text) && (this->m_options.timestampMode == TimestampMode::None) ) {
+        return writeAll(STDOUT_FILENO, data, size);
+    }
+    this->m_displayBuffer.clear();
+    if (this->m_options.timestampMode == TimestampMode::None) {
+        ByteFormatter::appendEscaped(data, size, &this->m_displayBuffer, true);
+        return writeAll(STDOUT_FILENO, this->m_displayBuffer.data(), this->m_displayBuffer.size());
+    }
+    //A line is stamped when its first byte shows up, which may be several reads before its line feed does
+    size_t position{0};
+    while (position < size) {
+        if (this->m_atLineStart) {
+            ByteFormatter::appendTimestamp(this->byteTimestamp(timestamp, size, position), this->m_options.timestampMode, &this->m_displayBuffer);
+        }
+        auto lineFeed = static_cast<const char *>(memchr(data + position, '\n', size - position));
+        size_t segmentEnd{lineFeed ? static_cast<size_t>(lineFeed - data) + 1 : size};
+        if (this->m_options.displayMode == DisplayMode::Escaped) {
+            ByteFormatter::appendEscaped(data + position, segmentEnd - position, &this->m_displayBuffer, true);
+        } else {
+            this->m_displayBuffer.append(data + position, segmentEnd - position);
+        }
+        this->m_atLineStart = (lineFeed != nullptr);
+        position = segmentEnd;
+    }
+    return writeAll(STDOUT_FILENO, this->m_displayBuffer.data(), this->m_displayBuffer.size());
+}
+
+bool HeadlessTerminal::writeHexRows(const char *data, size_t size, const ReadTimestamp &timestamp)
+{
+    //Rows are only printed once they are full, unless the port goes quiet (see flushHexRow)
+    const size_t rowSize{ByteFormatter::HEX_DUMP_BYTES_PER_LINE};
+    this->m_displayBuffer.clear();
+    size_t position{0};
+    if (!this->m_pendingHexRow.empty()) {
+        size_t fill{std::min(rowSize - this->m_pendingHexRow.size(), size)};
+        this->m_pendingHexRow.append(data, fill);
+        position = fill;
+        if (this->m_pendingHexRow.size() < rowSize) {
+            return true;
+        }
+        this->appendHexRow(this->m_pendingHexRow.data(), rowSize, this->m_pendingHexRowTimestamp);
+        this->m_pendingHexRow.clear();
+    }
+    for (; position + rowSize <= size; position += rowSize) {
+        this->appendHexRow(data + position, rowSize, this->byteTimestamp(timestamp, size, position));
+    }
+    if (position < size) {
+        this->m_pendingHexRowTimestamp = this->byteTimestamp(timestamp, size, position);
+        this->m_pendingHexRow.append(data + position, size - position);
+    }
+    return writeAll(STDOUT_FILENO, this->m_displayBuffer.data(), this->m_displayBuffer.size());
+}
+
+void HeadlessTerminal::appendHexRow(const char *data, size_t size, const ReadTimestamp &timestamp)
+{
+    ByteFormatter::appendTimestamp(timestamp, this->m_options.timestampMode, &this->m_displayBuffer);
+    ByteFormatter::appendHexDumpLine(this->m_displayOffset, data, size, &this->m_displayBuffer);
+    this->m_displayBuffer.push_back('\n');
+    this->m_displayOffset += size;
+}
+
+bool HeadlessTerminal::flushHexRow()
+{
+    if (this->m_pendingHexRow.empty()) {
+        return true;
+    }
+    this->m_displayBuffer.clear();
+    this->appendHexRow(this->m_pendingHexRow.data(), this->m_pendingHexRow.size(), this->m_pendingHexRowTimestamp);
+    this->m_pendingHexRow.clear();
+    return writeAll(STDOUT_FILENO, this->m_displayBuffer.data(), this->m_displayBuffer.size());
+}
+
+ReadTimestamp HeadlessTerminal::byteTimestamp(const ReadTimestamp &readTimestamp, size_t readSize, size_t byteIndex) const
+{
+    //Without --interpolate every byte of a read shares the moment the read returned
+    if (this->m_characterDuration == 0) {
+        return readTimestamp;
+    }
+    return IByteStream::interpolateTimestamp(readTimestamp, readSize - 1 - byteIndex, this->m_characterDuration);
+}
+
+void HeadlessTerminal::sendPendingLines(bool flushPartialLine)
+{
+    std::vector<std::string> lines{};
+    size_t lineStart{0};
+    size_t foundPosition{this->m_pendingInput.find('\n')};
+    while (foundPosition != std::string::npos) {
+        std::string line{this->m_pendingInput.substr(lineStart, foundPosition - lineStart)};
+        if ( (!line.empty()) && (line.back() == '\r') ) {
+            line.pop_back();
+        }
+        lines.push_back(std::move(line));
+        lineStart = foundPosition + 1;
+        foundPosition = this->m_pendingInput.find('\n', lineStart);
+    }
+    this->m_pendingInput.erase(0, lineStart);
+    if ( (flushPartialLine) && (!this->m_pendingInput.empty()) ) {
+        lines.push_back(this->m_pendingInput);
+        this->m_pendingInput.clear();
+    }
+    if (lines.empty()) {
+        return;
+    }
+    //A pasted block goes out in as few writev() calls as possible
+    this->m_serialPort->writeLines(lines);
+    for (const auto &line : lines) {
+        this->logVerbose("Tx >> " + line);
+    }
+}
+
+bool HeadlessTerminal::forwardStdinToPort(bool *endOfInput)
+{
+    char buffer[IO_BUFFER_SIZE];
+    auto bytesRead = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (bytesRead < 0) {
+        return (errno == EINTR) || (errno == EAGAIN);
+    }
+    if (bytesRead == 0) {
+        *endOfInput = true;
+        this->sendPendingLines(true);
+        return true;
+    }
+    this->m_pendingInput.append(buffer, static_cast<size_t>(bytesRead));
+    this->sendPendingLines(false);
+    return true;
+}
+
+void HeadlessTerminal::printTransferProgress(const TransferProgress &progress, bool isFinished)
+{
+    double bytesPerSecond{progress.elapsedSeconds > 0.0 ? static_cast<double>(progress.totalBytesTransferred) / progress.elapsedSeconds : 0.0};
+    std::cerr << "\r" << progress.fileName << ": " << progress.fileBytesTransferred;
+    if (progress.fileSize != 0) {
+        std::cerr << "/" << progress.fileSize;
+    }
+    std::cerr << " bytes, " << std::fixed << std::setprecision(1) << bytesPerSecond / 1024.0 << " KB/s, "
+              << progress.errorCount << " errors    " << (isFinished ? "\n" : "") << std::flush;
+}
+
+int HeadlessTerminal::runFileTransfer()
+{
+    std::unique_ptr<FileTransfer> fileTransfer{nullptr};
+    fileTransfer = FileTransfer::create(this->m_options.transferProtocol, this->m_serialPort, [&fileTransfer]() {
+        printTransferProgress(fileTransfer->progress(), false);
+    });
+    this->logVerbose("Starting " + FileTransfer::protocolName(this->m_options.transferProtocol) + " transfer on " + this->m_serialPort->portName());
+
+    //The transfer blocks this thread, so a second one turns SIGINT/SIGTERM into a cancel()
+    std::atomic<bool> isFinished{false};
+    std::thread cancelWatcher{[&fileTransfer, &isFinished]() {
+        while (!isFinished) {
+            if (stopRequested) {
+                fileTransfer->cancel();
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        }
+    }};
+    int exitCode{EXIT_SUCCESS};
+    try {
+        if (!this->m_options.sendFiles.empty()) {
+            fileTransfer->sendFiles(this->m_options.sendFiles);
+        } else {
+            for (const auto &filePath : fileTransfer->receiveFiles(this->m_options.receivePath)) {
+                std::cout << filePath << std::endl;
+            }
+        }
+    } catch (std::exception &e) {
+        std::cerr << std::endl << e.what() << std::endl;
+        exitCode = EXIT_FAILURE;
+    }
+    isFinished = true;
+    cancelWatcher.join();
+    TransferProgress progress{fileTransfer->progress()};
+    if (exitCode == EXIT_SUCCESS) {
+        printTransferProgress(progress, true);
+    }
+    this->logVerbose(std::to_string(progress.filesCompleted) + " files, " + std::to_string(progress.totalBytesTransferred) + " bytes in " + std::to_string(progress.elapsedSeconds) + " seconds");
+    return exitCode;
+}
+
+void HeadlessTerminal::startRecording()
+{
+    if (this->m_options.recordPath.empty()) {
+        return;
+    }
+    this->m_recorder = std::make_shared<SessionRecorder>();
+    this->m_recorder->start(this->m_options.recordPath);
+    this->m_serialPort->setRecorder(this->m_recorder);
+    this->logVerbose("Recording session to " + this->m_options.recordPath);
+}
+
+void HeadlessTerminal::stopRecording()
+{
+    if (!this->m_recorder) {
+        return;
+    }
+    this->m_serialPort->setRecorder(nullptr);
+    this->m_recorder->stop();
+    if (this->m_recorder->hasError()) {
+        std::cerr << this->m_recorder->errorString() << std::endl;
+    }
+    if (this->m_recorder->droppedRecords() > 0) {
+        std::cerr << "Recording fell behind and dropped " << this->m_recorder->droppedRecords() << " chunks" << std::endl;
+    }
+    this->logVerbose("Recorded " + std::to_string(this->m_recorder->recordedBytes()) + " bytes to " + this->m_recorder->filePath());
+    this->m_recorder.reset();
+}
+
+bool HeadlessTerminal::writeToPort(const char *data, size_t size)
+{
+    //A short write means flow control held the port off for the whole write timeout; keep offering the rest
+    while ( (size > 0) && (!stopRequested) ) {
+        ssize_t writtenBytes{this->m_serialPort->write(data, size)};
+        if (writtenBytes < 0) {
+            return false;
+        }
+        data += writtenBytes;
+        size -= static_cast<size_t>(writtenBytes);
+    }
+    return true;
+}
+
+int HeadlessTerminal::runReplay()
+{
+    SessionReplayer sessionReplayer{[this](const char *data, size_t size) -> bool {
+        if (this->m_serialPort) {
+            if (!this->writeToPort(data, size)) {
+                throw std::runtime_error("Unable to write to " + this->m_serialPort->portName() + ": " + strerror(errno));
+            }
+        } else if (!this->writeReceived(data, size, IByteStream::currentTimestamp(this->m_options.timestampMode == TimestampMode::Realtime))) {
+            throw std::runtime_error(std::string{"Unable to write to stdout: "} + strerror(errno));
+        }
+        return true;
+    }, nullptr};
+    sessionReplayer.start(this->m_options.replayPath, this->m_options.replayOptions);
+    this->logVerbose("Replaying " + this->m_options.replayPath + (this->m_serialPort ? " to " + this->m_serialPort->portName() : ""));
+    while ( (sessionReplayer.isRunning()) && (!stopRequested) ) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    }
+    sessionReplayer.stop();
+    this->flushHexRow();
+
+    ReplayProgress progress{sessionReplayer.progress()};
+    double megabytesPerSecond{progress.elapsedSeconds > 0.0 ? static_cast<double>(progress.bytesReplayed) / progress.elapsedSeconds / 1000000.0 : 0.0};
+    std::cerr << "Replayed " << progress.bytesReplayed << " bytes (" << progress.recordsReplayed << " chunks) in " << std::fixed << std::setprecision(3)
+              << progress.elapsedSeconds << " s, " << std::setprecision(1) << megabytesPerSecond << " MB/s" << std::endl;
+    if (progress.state == ReplayState::Failed) {
+        std::cerr << sessionReplayer.errorString() << std::endl;
+    }
+    return (progress.state == ReplayState::Finished ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+void HeadlessTerminal::appendCaptureLine(const CaptureLine &line, std::string *output)
+{
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%14.6f %s ", static_cast<double>(line.timestamp) / 1000000000.0, (line.direction == RecordDirection::Received ? "Rx" : "Tx"));
+    output->append(prefix);
+    output->append(line.text);
+    output->push_back('\n');
+}
+
+int HeadlessTerminal::runViewer()
+{
+    auto openTime = std::chrono::steady_clock::now();
+    CaptureIndex captureIndex{nullptr};
+    captureIndex.open(this->m_options.viewPath);
+    this->logVerbose((captureIndex.progress().wasLoaded ? "Using saved index " : "Indexing into ") + CaptureIndex::indexFilePathFor(this->m_options.viewPath));
+    if (!this->m_options.searchOptions.pattern.empty()) {
+        //Searches cover what has been indexed, so let the index finish first
+        while ( (!captureIndex.progress().isComplete) && (!stopRequested) ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        this->logVerbose("Indexed " + std::to_string(captureIndex.lineCount()) + " lines in " +
+                         std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - openTime).count()) + " seconds");
+        return this->searchCapture(captureIndex);
+    }
+    uint64_t lineNumber{0};
+    if (!this->m_options.viewPosition.empty()) {
+        //Only a position the index has already passed can be found
+        while ( (!captureIndex.progress().isComplete) && (!stopRequested) ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        auto lookupStart = std::chrono::steady_clock::now();
+        lineNumber = captureIndex.lineAtPosition(this->m_options.viewPosition);
+        this->logVerbose(this->m_options.viewPosition + " is line " + std::to_string(lineNumber) + ", found in " +
+                         std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - lookupStart).count()) + " us");
+    }
+    std::string output{};
+    bool isFirstBatch{true};
+    while (!stopRequested) {
+        //Checked before fetching, so lines indexed in between are never mistaken for the end
+        bool isComplete{captureIndex.progress().isComplete};
+        std::vector<CaptureLine> lines{captureIndex.lines(lineNumber, VIEW_BATCH_LINES)};
+        if (lines.empty()) {
+            if (isComplete) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            continue;
+        }
+        if (isFirstBatch) {
+            this->logVerbose("First " + std::to_string(lines.size()) + " lines after " +
+                             std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - openTime).count()) + " us");
+            isFirstBatch = false;
+        }
+        output.clear();
+        for (const auto &it : lines) {
+            appendCaptureLine(it, &output);
+        }
+        //A closed pipe (e.g. piped into head) just ends the listing
+        if (!writeAll(STDOUT_FILENO, output.data(), output.size())) {
+            break;
+        }
+        lineNumber += lines.size();
+    }
+    CaptureIndexProgress progress{captureIndex.progress()};
+    this->logVerbose(std::to_string(progress.lineCount) + " lines indexed" + (progress.isComplete ? "" : " so far") + ", " +
+                     std::to_string(std::chrono::duration<double>(std::chrono::steady_clock::now() - openTime).count()) + " seconds");
+    return EXIT_SUCCESS;
+}
+
+int HeadlessTerminal::searchCapture(const CaptureIndex &captureIndex)
+{
+    TextSearch textSearch{nullptr};
+    textSearch.start(this->m_options.searchOptions, captureIndex.lineBlockCount(), [&captureIndex](size_t blockIndex, std::string *scratchBytes, std::vector<uint32_t> *scratchLineEnds, SearchBlock *block) {
+        block->firstLineNumber = captureIndex.readLineBlock(blockIndex, scratchBytes, scratchLineEnds);
+        block->data = scratchBytes->data();
+        block->lineEnds = scratchLineEnds->data();
+        block->lineCount = scratchLineEnds->size();
+    });
+    this->logVerbose("Searching with " + std::to_string(TextSearch::workerCount(captureIndex.lineBlockCount())) + " threads, prefiltering on \"" +
+                     (this->m_options.searchOptions.isRegex ? TextSearch::requiredLiteral(this->m_options.searchOptions.pattern) : this->m_options.searchOptions.pattern) + "\"");
+    std::vector<SearchHit> hits{};
+    while (textSearch.isRunning()) {
+        if (stopRequested) {
+            textSearch.stop();
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    textSearch.stop();
+    hits = textSearch.takeHits();
+    SearchProgress progress{textSearch.progress()};
+    if (progress.state == SearchState::Failed) {
+        std::cerr << textSearch.errorString() << std::endl;
+        return EXIT_FAILURE;
+    }
+    this->logVerbose(std::to_string(progress.hitCount) + " matching lines in " + std::to_string(progress.bytesSearched) + " bytes, " + std::to_string(progress.elapsedSeconds) + " seconds" +
+                     (progress.isTruncated ? " (stopped at the hit limit)" : ""));
+
+    //Blocks finish in any order, so put the hits back in file order before printing them
+    std::sort(hits.begin(), hits.end(), [](const SearchHit &lhs, const SearchHit &rhs) { return lhs.lineNumber < rhs.lineNumber; });
+    std::string output{};
+    for (const auto &it : hits) {
+        if (stopRequested) {
+            break;
+        }
+        for (const auto &line : captureIndex.lines(it.lineNumber, 1)) {
+            output += std::to_string(line.lineNumber) + ":";
+            appendCaptureLine(line, &output);
+        }
+        if (output.length() >= IO_BUFFER_SIZE) {
+            if (!writeAll(STDOUT_FILENO, output.data(), output.size())) {
+                return EXIT_SUCCESS;
+            }
+            output.clear();
+        }
+    }
+    writeAll(STDOUT_FILENO, output.data(), output.size());
+    return (progress.state == SearchState::Cancelled ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+void HeadlessTerminal::appendMonitoredChunk(MonitoredPort &monitoredPort, const ReceivedChunk &chunk, std::string *output) const
+{
+    const char *data{chunk.data.data()};
+    const size_t size{chunk.data.size()};
+    size_t position{0};
+    while (position < size) {
+        if (monitoredPort.pendingLine.empty()) {
+            monitoredPort.pendingLineTimestamp = this->byteTimestamp(chunk.timestamp, size, position);
+        }
+        auto lineFeed = static_cast<const char *>(memchr(data + position, '\n', size - position));
+        size_t segmentEnd{lineFeed ? static_cast<size_t>(lineFeed - data) + 1 : size};
+        monitoredPort.pendingLine.append(data + position, segmentEnd - position);
+        if (lineFeed) {
+            this->appendMonitoredLine(monitoredPort, output);
+        }
+        position = segmentEnd;
+    }
+    monitoredPort.lastReceiveTime = std::chrono::steady_clock::now();
+}
+
+void HeadlessTerminal::appendMonitoredLine(MonitoredPort &monitoredPort, std::string *output) const
+{
+    //Lines from different ports interleave, so each one is printed whole behind the name of its port
+    output->push_back('[');
+    output->append(monitoredPort.serialPort->portName());
+    output->append("] ");
+    ByteFormatter::appendTimestamp(monitoredPort.pendingLineTimestamp, this->m_options.timestampMode, output);
+    if (this->m_options.displayMode == DisplayMode::Escaped) {
+        ByteFormatter::appendEscaped(monitoredPort.pendingLine.data(), monitoredPort.pendingLine.size(), output, true);
+    } else {
+        output->append(monitoredPort.pendingLine);
+    }
+    if (output->back() != '\n') {
+        output->push_back('\n');
+    }
+    monitoredPort.pendingLine.clear();
+}
+
+bool HeadlessTerminal::flushStaleMonitoredLines(std::string *output)
+{
+    //A prompt or a port that went quiet mid line still shows up, just not before MONITOR_LINE_TIMEOUT
+    auto staleBefore = std::chrono::steady_clock::now() - std::chrono::milliseconds{int{MONITOR_LINE_TIMEOUT}};
+    bool isAnyLinePending{false};
+    for (auto &it : this->m_monitoredPorts) {
+        if (it.second.pendingLine.empty()) {
+            continue;
+        }
+        if (it.second.lastReceiveTime <= staleBefore) {
+            this->appendMonitoredLine(it.second, output);
+        } else {
+            isAnyLinePending = true;
+        }
+    }
+    return isAnyLinePending;
+}
+
+void HeadlessTerminal::closeMonitoredPorts()
+{
+    for (auto &it : this->m_monitoredPorts) {
+        it.second.serialPort->closePort();
+        this->logVerbose("Successfully closed serial port " + it.second.serialPort->portName());
+    }
+    this->m_monitoredPorts.clear();
+}
+
+void HeadlessTerminal::printReactorStatistics(const SerialReactor &serialReactor) const
+{
+    if (!this->m_options.verbose) {
+        return;
+    }
+    //Ports go to whichever thread has fewest, so uneven busy times point at a few ports doing most of the talking
+    for (const auto &it : serialReactor.statistics()) {
+        std::cerr << "Reactor " << it.threadIndex << " (" << (it.cpu < 0 ? std::string{"unpinned"} : "cpu " + std::to_string(it.cpu)) << "): "
+                  << it.portCount << " ports, " << it.wakeups << " wakeups, " << it.chunksRead << " chunks, " << it.bytesRead << " bytes, "
+                  << std::fixed << std::setprecision(3) << it.busySeconds << " s busy" << std::endl;
+    }
+}
+
+int HeadlessTerminal::runMonitor()
+{
+    //The reactor callback only has to wake poll() below, which an eventfd does without a lock
+    int wakeDescriptor{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+    if (wakeDescriptor == -1) {
+        const auto errorCode = errno;
+        throw std::runtime_error("eventfd(unsigned int, int): Unable to create wake event: " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    unsigned reactorThreads{this->m_options.reactorThreads != 0 ? this->m_options.reactorThreads : SerialReactor::defaultThreadCount(this->m_options.monitorPorts.size())};
+    SerialReactor serialReactor{[wakeDescriptor]() {
+        uint64_t wakeValue{1};
+        if (::write(wakeDescriptor, &wakeValue, sizeof(wakeValue)) == -1) {
+            //Only fails once the counter is already non-zero, in which case poll() wakes anyway
+        }
+    }, reactorThreads};
+    serialReactor.setPinnedToCores(this->m_options.pinReactors);
+    try {
+        for (const auto &portName : this->m_options.monitorPorts) {
+            auto serialPort = std::make_shared<SerialPort>(portName, this->m_options.baudRate, this->m_options.dataBits, this->m_options.stopBits, this->m_options.parity, this->m_options.flowControl);
+            serialPort->openPort();
+            serialPort->setRealtimeTimestamps(this->m_options.timestampMode == TimestampMode::Realtime);
+            this->m_monitoredPorts.emplace(serialReactor.addPort(serialPort), MonitoredPort{serialPort, "", ReadTimestamp{0, 0}, std::chrono::steady_clock::time_point{}});
+            this->logVerbose("Successfully opened serial port " + serialPort->portName());
+        }
+        serialReactor.start();
+    } catch (std::exception &e) {
+        serialReactor.stop();
+        this->closeMonitoredPorts();
+        close(wakeDescriptor);
+        throw;
+    }
+    this->logVerbose("Monitoring " + std::to_string(this->m_monitoredPorts.size()) + " ports from " + std::to_string(serialReactor.threadCount()) + " reactor threads");
+
+    int exitCode{EXIT_SUCCESS};
+    bool isAnyLinePending{false};
+    std::string output{};
+    pollfd pollDescriptor{wakeDescriptor, POLLIN, 0};
+    while ( (!stopRequested) && (!this->m_monitoredPorts.empty()) ) {
+        int pollResult{poll(&pollDescriptor, 1, isAnyLinePending ? MONITOR_LINE_TIMEOUT : -1)};
+        if (pollResult < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "poll(pollfd *, nfds_t, int): " << strerror(errno) << std::endl;
+            exitCode = EXIT_FAILURE;
+            break;
+        }
+        output.clear();
+        if (pollResult > 0) {
+            uint64_t wakeValue{0};
+            if (::read(wakeDescriptor, &wakeValue, sizeof(wakeValue)) == -1) {
+                //Already reset by an earlier read; there is still a queue to drain
+            }
+            serialReactor.acknowledgeNotification();
+            ReactorEvent event{};
+            while (serialReactor.tryPop(event)) {
+                auto foundPort = this->m_monitoredPorts.find(event.portId);
+                if (foundPort == this->m_monitoredPorts.end()) {
+                    continue;
+                }
+                if (event.errorString.empty()) {
+                    this->appendMonitoredChunk(foundPort->second, event.chunk, &output);
+                    continue;
+                }
+                //The reactor has already let go of a failed port, so only its last partial line is left to print
+                if (!foundPort->second.pendingLine.empty()) {
+                    this->appendMonitoredLine(foundPort->second, &output);
+                }
+                std::cerr << event.errorString << std::endl;
+                foundPort->second.serialPort->closePort();
+                this->m_monitoredPorts.erase(foundPort);
+                exitCode = EXIT_FAILURE;
+            }
+            if (serialReactor.hasError()) {
+                std::cerr << serialReactor.errorString() << std::endl;
+                exitCode = EXIT_FAILURE;
+                writeAll(STDOUT_FILENO, output.data(), output.size());
+                break;
+            }
+        }
+        isAnyLinePending = this->flushStaleMonitoredLines(&output);
+        if (!writeAll(STDOUT_FILENO, output.data(), output.size())) {
+            exitCode = EXIT_FAILURE;
+            break;
+        }
+    }
+    serialReactor.stop();
+    this->printReactorStatistics(serialReactor);
+    output.clear();
+    for (auto &it : this->m_monitoredPorts) {
+        if (!it.second.pendingLine.empty()) {
+            this->appendMonitoredLine(it.second, &output);
+        }
+    }
+    writeAll(STDOUT_FILENO, output.data(), output.size());
+    this->closeMonitoredPorts();
+    close(wakeDescriptor);
+    return exitCode;
+}
+
+int HeadlessTerminal::run()
+{
+    installSignalHandlers();
+    if (!this->m_options.viewPath.empty()) {
+        return this->runViewer();
+    }
+    if (!this->m_options.monitorPorts.empty()) {
+        return this->runMonitor();
+    }
+    if (this->m_options.portName.empty()) {
+        return this->runReplay();
+    }
+    this->m_serialPort = std::make_shared<SerialPort>(this->m_options.portName, this->m_options.baudRate, this->m_options.dataBits, this->m_options.stopBits, this->m_options.parity, this->m_options.flowControl);
+    this->m_serialPort->openPort();
+    this->m_serialPort->setLineEnding(this->m_options.lineEnding);
+    this->m_serialPort->setRealtimeTimestamps(this->m_options.timestampMode == TimestampMode::Realtime);
+    //poll() already said the port is readable, so readSome() must never wait
+    this->m_serialPort->setReadTimeout(0);
+    this->logVerbose("Successfully opened serial port " + this->m_serialPort->portName());
+    this->startRecording();
+    if ( (!this->m_options.sendFiles.empty()) || (!this->m_options.receivePath.empty()) ) {
+        int exitCode{this->runFileTransfer()};
+        this->stopRecording();
+        this->m_serialPort->closePort();
+        return exitCode;
+    }
+    if (!this->m_options.replayPath.empty()) {
+        int exitCode{this->runReplay()};
+        this->stopRecording();
+        this->m_serialPort->closePort();
+        return exitCode;
+    }
+
+    bool endOfInput{false};
+    pollfd pollDescriptors[2];
+    pollDescriptors[0] = pollfd{this->m_serialPort->getFileDescriptor(), POLLIN, 0};
+    pollDescriptors[1] = pollfd{STDIN_FILENO, POLLIN, 0};
+    int exitCode{EXIT_SUCCESS};
+    while (!stopRequested) {
+        nfds_t descriptorCount{endOfInput ? 1u : 2u};
+        //A partial hex row waits for the rest of its bytes, but not for longer than HEX_ROW_TIMEOUT
+        int pollResult{poll(pollDescriptors, descriptorCount, this->m_pendingHexRow.empty() ? -1 : HEX_ROW_TIMEOUT)};
+        if (pollResult == 0) {
+            if (!this->flushHexRow()) {
+                exitCode = EXIT_FAILURE;
+                break;
+            }
+            continue;
+        }
+        if (pollResult < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "poll(pollfd *, nfds_t, int): " << strerror(errno) << std::endl;
+            exitCode = EXIT_FAILURE;
+            break;
+        }
+        ssize_t bytesForwarded{0};
+        if (pollDescriptors[0].revents & POLLIN) {
+            bytesForwarded = this->forwardPortToStdout();
+            if (bytesForwarded < 0) {
+                exitCode = EXIT_FAILURE;
+                break;
+            }
+        }
+        //A hung up tty stays readable but only ever returns end of file
+        if ( (bytesForwarded == 0) && (pollDescriptors[0].revents & (POLLHUP | POLLERR | POLLNVAL)) ) {
+            std::cerr << "Serial port disconnected: " << this->m_serialPort->portName() << std::endl;
+            exitCode = EXIT_FAILURE;
+            break;
+        }
+        if ( (!endOfInput) && (pollDescriptors[1].revents & (POLLIN | POLLHUP)) ) {
+            if (!this->forwardStdinToPort(&endOfInput)) {
+                exitCode = EXIT_FAILURE;
+                break;
+            }
+        }
+    }
+    this->flushHexRow();
+    this->stopRecording();
+    this->m_serialPort->closePort();
+    this->logVerbose("Successfully closed serial port " + this->m_serialPort->portName());
+    return exitCode;
+}
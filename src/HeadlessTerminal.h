@@ -0,0 +1,155 @@
+#ifndef QSERIALTERMINAL_HEADLESSTERMINAL_H
+#define QSERIALTERMINAL_HEADLESSTERMINAL_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+
+#include "SerialPort.h"
+#include "FileTransfer.h"
+#include "SessionRecorder.h"
+#include "SessionReplayer.h"
+#include "CaptureIndex.h"
+#include "TextSearch.h"
+#include "ByteFormatter.h"
+#include "SerialReactor.h"
+
+/*
+ * Streams a serial port to stdout and sends stdin to it line by line,
+ * without pulling in Qt. Used by the qserialterminal-cli target and by
+ * the GUI executable when it is started with --headless. With --send or
+ * --receive it runs a single XMODEM/YMODEM/ZMODEM transfer instead and
+ * reports its progress on stderr. With --record everything sent and
+ * received is also captured to a binary session file, and --replay plays
+ * the received side of such a file back to stdout, or out of the port
+ * when one is given. --view prints a session file as timestamped lines,
+ * optionally from the line at --goto, without reading the file in, and
+ * with --search prints only the lines that match. --display shows what
+ * the port (or a replay) receives escaped or as a hex dump instead of raw,
+ * and --timestamps puts the arrival time of its first byte in front of
+ * every received line (or hex row). Given --port more than once it only
+ * monitors: the ports are shared out between SerialReactor threads
+ * (--reactor-threads, optionally pinned to cores with --pin-reactors) and
+ * each line is printed with the name of the port it came from in front of
+ * it. With --verbose each reactor's load is printed when monitoring ends
+ */
+struct HeadlessOptions
+{
+    std::string portName;
+    CppSerialPort::BaudRate baudRate;
+    CppSerialPort::DataBits dataBits;
+    CppSerialPort::StopBits stopBits;
+    CppSerialPort::Parity parity;
+    CppSerialPort::FlowControl flowControl;
+    std::string lineEnding;
+    bool verbose;
+    std::vector<std::string> sendFiles;
+    std::string receivePath;
+    CppSerialPort::TransferProtocol transferProtocol;
+    std::string recordPath;
+    std::string replayPath;
+    ReplayOptions replayOptions;
+    std::string viewPath;
+    std::string viewPosition;
+    SearchOptions searchOptions;
+    CppSerialPort::DisplayMode displayMode;
+    CppSerialPort::TimestampMode timestampMode;
+    bool interpolateTimestamps;
+    //Only filled when --port was given more than once
+    std::vector<std::string> monitorPorts;
+    //0 for one thread per SerialReactor::PORTS_PER_THREAD ports
+    unsigned reactorThreads;
+    bool pinReactors;
+};
+
+struct MonitoredPort
+{
+    std::shared_ptr<CppSerialPort::SerialPort> serialPort;
+    std::string pendingLine;
+    CppSerialPort::ReadTimestamp pendingLineTimestamp;
+    std::chrono::steady_clock::time_point lastReceiveTime;
+};
+
+class HeadlessTerminal
+{
+public:
+    explicit HeadlessTerminal(const HeadlessOptions &options);
+
+    HeadlessTerminal(const HeadlessTerminal &other) = delete;
+    HeadlessTerminal(HeadlessTerminal &&other) = delete;
+    HeadlessTerminal &operator=(const HeadlessTerminal &rhs) = delete;
+    HeadlessTerminal &operator=(HeadlessTerminal &&rhs) = delete;
+
+    int run();
+
+    static int main(int argc, char *argv[]);
+    static bool isHeadlessRequested(int argc, char *argv[]);
+    static HeadlessOptions parseOptions(int argc, char *argv[]);
+    static void displayHelp(const char *programName);
+
+    static CppSerialPort::BaudRate parseBaudRate(const std::string &str);
+    static CppSerialPort::DataBits parseDataBits(const std::string &str);
+    static CppSerialPort::StopBits parseStopBits(const std::string &str);
+    static CppSerialPort::Parity parseParity(const std::string &str);
+    static CppSerialPort::FlowControl parseFlowControl(const std::string &str);
+    static std::string parseLineEnding(const std::string &str);
+    static ReplayOptions parseReplaySpeed(const std::string &str);
+    static CppSerialPort::DisplayMode parseDisplayMode(const std::string &str);
+    static CppSerialPort::TimestampMode parseTimestampMode(const std::string &str);
+    static unsigned parseReactorThreads(const std::string &str);
+    static unsigned baudRateValue(CppSerialPort::BaudRate baudRate);
+
+    static const char *HEADLESS_SWITCH;
+
+private:
+    HeadlessOptions m_options;
+    std::shared_ptr<CppSerialPort::SerialPort> m_serialPort;
+    std::string m_pendingInput;
+    std::shared_ptr<CppSerialPort::SessionRecorder> m_recorder;
+    std::string m_displayBuffer;
+    std::string m_pendingHexRow;
+    CppSerialPort::ReadTimestamp m_pendingHexRowTimestamp;
+    uint64_t m_displayOffset;
+    bool m_atLineStart;
+    uint64_t m_characterDuration;
+    std::unordered_map<unsigned, MonitoredPort> m_monitoredPorts;
+
+    ssize_t forwardPortToStdout();
+    bool forwardStdinToPort(bool *endOfInput);
+    void sendPendingLines(bool flushPartialLine);
+    void logVerbose(const std::string &str) const;
+    int runFileTransfer();
+    void startRecording();
+    void stopRecording();
+    int runReplay();
+    bool writeToPort(const char *data, size_t size);
+    bool writeReceived(const char *data, size_t size, const CppSerialPort::ReadTimestamp &timestamp);
+    bool writeHexRows(const char *data, size_t size, const CppSerialPort::ReadTimestamp &timestamp);
+    void appendHexRow(const char *data, size_t size, const CppSerialPort::ReadTimestamp &timestamp);
+    bool flushHexRow();
+    CppSerialPort::ReadTimestamp byteTimestamp(const CppSerialPort::ReadTimestamp &readTimestamp, size_t readSize, size_t byteIndex) const;
+    int runViewer();
+    int searchCapture(const CaptureIndex &captureIndex);
+    int runMonitor();
+    void appendMonitoredChunk(MonitoredPort &monitoredPort, const CppSerialPort::ReceivedChunk &chunk, std::string *output) const;
+    void appendMonitoredLine(MonitoredPort &monitoredPort, std::string *output) const;
+    bool flushStaleMonitoredLines(std::string *output);
+    void closeMonitoredPorts();
+    void printReactorStatistics(const CppSerialPort::SerialReactor &serialReactor) const;
+
+    static void printTransferProgress(const CppSerialPort::TransferProgress &progress, bool isFinished);
+    static void appendCaptureLine(const CaptureLine &line, std::string *output);
+
+    static bool writeAll(int fileDescriptor, const char *data, size_t size);
+    static void installSignalHandlers();
+
+    static const size_t constexpr IO_BUFFER_SIZE{4096};
+    static const size_t constexpr VIEW_BATCH_LINES{1024};
+    static const int constexpr HEX_ROW_TIMEOUT{100};
+    static const int constexpr MONITOR_LINE_TIMEOUT{100};
+    static const unsigned constexpr MAX_REACTOR_THREADS{256};
+};
+
+#endif //QSERIALTERMINAL_HEADLESSTERMINAL_H
@@ -17,7 +17,9 @@
 
 #include <sstream>
 #include "IByteStream.h"
+#include "ByteSearch.h"
 #include <fstream>
+#include <algorithm>
 
 namespace CppSerialPort {
 
@@ -32,12 +34,15 @@ const char *IByteStream::DEFAULT_LINE_ENDING{"\n"};
 
 const int IByteStream::DEFAULT_READ_TIMEOUT{1000};
 const int IByteStream::DEFAULT_WRITE_TIMEOUT{1000};
+const size_t IByteStream::WRITE_LINES_BATCH;
 
 IByteStream::IByteStream() :
-        m_readTimeout{DEFAULT_READ_TIMEOUT},
+        m_readTimeout{std::chrono::milliseconds{DEFAULT_READ_TIMEOUT}},
         m_writeTimeout{DEFAULT_WRITE_TIMEOUT},
         m_lineEnding{DEFAULT_LINE_ENDING},
-        m_writeMutex{}
+        m_writeMutex{},
+        m_lastReadTimestamp{0, 0},
+        m_realtimeTimestamps{false}
 {
 
 }
@@ -47,13 +52,31 @@ void IByteStream::setReadTimeout(int timeout)
     if (timeout < 0) {
         throw std::runtime_error("IByteStream::setReadTimeout(int): invariant failure (read timeout cannot be less than 0, " + toStdString(timeout) + " < 0)");
     }
+    this->setReadTimeout(std::chrono::microseconds{std::chrono::milliseconds{timeout}});
+}
+
+void IByteStream::setReadTimeout(std::chrono::microseconds timeout)
+{
+    if (timeout.count() < 0) {
+        throw std::runtime_error("IByteStream::setReadTimeout(std::chrono::microseconds): invariant failure (read timeout cannot be less than 0, " + toStdString(timeout.count()) + "us < 0)");
+    }
     this->m_readTimeout = timeout;
 }
 
 int IByteStream::readTimeout() const
+{
+    //Rounded up, so a sub millisecond timeout is never reported as "do not wait"
+    return static_cast<int>((this->m_readTimeout.count() + 999) / 1000);
+}
+
+std::chrono::microseconds IByteStream::readTimeoutDuration() const
 {
     return this->m_readTimeout;
+}
 
+ssize_t IByteStream::readSome(char *buffer, size_t maxBytes)
+{
+    return this->readSome(buffer, maxBytes, this->m_readTimeout);
 }
 void IByteStream::setWriteTimeout(int timeout)
 {
@@ -92,14 +115,30 @@ void IByteStream::setLineEnding(char chr)
 ssize_t IByteStream::writeLine(const std::string &str)
 {
     std::lock_guard<std::mutex> writeLock{this->m_writeMutex};
-	std::string toWrite{ str + this->lineEnding() };
-	return this->write(toWrite.c_str(), toWrite.length());
+    ByteSpan spans[2]{ByteSpan{str.data(), str.length()}, ByteSpan{this->m_lineEnding.data(), this->m_lineEnding.length()}};
+    return this->write(spans, 2);
 }
 
-ssize_t IByteStream::write(const std::string &str)
+ssize_t IByteStream::writeLines(const std::vector<std::string> &lines)
 {
-    std::lock_guard<std::mutex> writeLock{this->m_writeMutex};
-	return this->write(str.c_str(), str.length());
+    return this->writeLines(lines.begin(), lines.end());
+}
+
+ssize_t IByteStream::write(const ByteSpan *spans, size_t spanCount)
+{
+    //Streams without a gather write send the spans one after the other
+    ssize_t totalWritten{0};
+    for (size_t i = 0; i < spanCount; i++) {
+        ssize_t writtenBytes{this->write(spans[i].data, spans[i].size)};
+        if (writtenBytes < 0) {
+            return (totalWritten > 0 ? totalWritten : writtenBytes);
+        }
+        totalWritten += writtenBytes;
+        if (static_cast<size_t>(writtenBytes) < spans[i].size) {
+            break;
+        }
+    }
+    return totalWritten;
 }
 
 std::string IByteStream::readLine(bool *timeout)
@@ -109,21 +148,44 @@ std::string IByteStream::readLine(bool *timeout)
 
 std::string IByteStream::readUntil(const std::string &until, bool *timeout)
 {
-    uint64_t startTime{IByteStream::getEpoch()};
+    return this->readUntil(until, timeout, nullptr);
+}
+
+std::string IByteStream::readUntil(const std::string &until, bool *timeout, ReadTimestamp *firstByteTimestamp)
+{
+    //One deadline for the whole call; each wait only gets what is left of it
+    const auto deadline = std::chrono::steady_clock::now() + this->m_readTimeout;
     std::string returnString{""};
+    char readBuffer[READ_CHUNK_SIZE];
     if (timeout) {
         *timeout = false;
     }
+    auto currentTime = std::chrono::steady_clock::now();
     do {
-        int maybeChar{this->read()};
-        if (maybeChar == 0) {
+        auto remainingTime = std::max(std::chrono::duration_cast<std::chrono::microseconds>(deadline - currentTime), std::chrono::microseconds::zero());
+        ssize_t bytesRead{this->readSome(readBuffer, sizeof(readBuffer), remainingTime)};
+        currentTime = std::chrono::steady_clock::now();
+        if (bytesRead <= 0) {
             continue;
         }
-        returnString += static_cast<char>(maybeChar);
-        if (endsWith(returnString, until)) {
-            return returnString.substr(0, returnString.length() - until.length());
+        if ( (firstByteTimestamp) && (returnString.empty()) ) {
+            //The first read that contributes anything carries the first byte of the result
+            *firstByteTimestamp = this->m_lastReadTimestamp;
         }
-    } while ((IByteStream::getEpoch() - startTime) <= static_cast<unsigned long>(this->m_readTimeout));
+        /* The terminator may straddle the previous chunk and this one,
+         * so start the search far enough back to catch a split match */
+        size_t searchStart{returnString.length() + 1 > until.length() ? returnString.length() + 1 - until.length() : 0};
+        returnString.append(readBuffer, static_cast<size_t>(bytesRead));
+        auto foundPosition = ByteSearch::find(returnString, until, searchStart);
+        if (foundPosition != std::string::npos) {
+            size_t matchEnd{foundPosition + until.length()};
+            if (matchEnd < returnString.length()) {
+                this->putBack(returnString.data() + matchEnd, returnString.length() - matchEnd);
+            }
+            returnString.resize(foundPosition);
+            return returnString;
+        }
+    } while (currentTime < deadline);
     if (timeout) {
         *timeout = true;
     }
@@ -135,17 +197,96 @@ std::string IByteStream::readUntil(char until, bool *timeout)
     return this->readUntil(std::string(1, until), timeout);
 }
 
-int IByteStream::peek()
+ReadTimestamp IByteStream::lastReadTimestamp() const
+{
+    return this->m_lastReadTimestamp;
+}
+
+void IByteStream::setRealtimeTimestamps(bool realtimeTimestamps)
+{
+    //Picked up by the reading thread on its next read
+    this->m_realtimeTimestamps = realtimeTimestamps;
+}
+
+bool IByteStream::realtimeTimestamps() const
+{
+    return this->m_realtimeTimestamps;
+}
+
+void IByteStream::stampRead()
+{
+    this->m_lastReadTimestamp = currentTimestamp(this->m_realtimeTimestamps.load(std::memory_order_relaxed));
+}
+
+void IByteStream::setLastReadTimestamp(const ReadTimestamp &timestamp)
+{
+    this->m_lastReadTimestamp = timestamp;
+}
+
+ReadTimestamp IByteStream::currentTimestamp(bool includeRealtime)
 {
-    int readChar{this->read()};
-    this->putBack(readChar);
-    return readChar;
+    //Both clocks are read through the vDSO on Linux, so neither costs a system call of its own
+    ReadTimestamp timestamp{static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()), 0};
+    if (includeRealtime) {
+        timestamp.realtime = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+    return timestamp;
 }
 
+ReadTimestamp IByteStream::interpolateTimestamp(const ReadTimestamp &readTimestamp, size_t bytesAfter, uint64_t characterDuration)
+{
+    uint64_t offset{static_cast<uint64_t>(bytesAfter) * characterDuration};
+    ReadTimestamp timestamp{readTimestamp.monotonic > offset ? readTimestamp.monotonic - offset : 0, 0};
+    if (readTimestamp.realtime > offset) {
+        timestamp.realtime = readTimestamp.realtime - offset;
+    }
+    return timestamp;
+}
+
+std::string IByteStream::readAvailable()
+{
+    std::string returnString{""};
+    char readBuffer[READ_CHUNK_SIZE];
+    ssize_t bytesRead{0};
+    do {
+        bytesRead = this->readSome(readBuffer, sizeof(readBuffer));
+        if (bytesRead > 0) {
+            returnString.append(readBuffer, static_cast<size_t>(bytesRead));
+        }
+    } while (bytesRead == static_cast<ssize_t>(sizeof(readBuffer)));
+    return returnString;
+}
+
+ReadResult IByteStream::read()
+{
+    char readChar{0};
+    ssize_t bytesRead{this->readSome(&readChar, 1)};
+    if (bytesRead > 0) {
+        return ReadResult{ReadStatus::Byte, readChar};
+    } else if (bytesRead < 0) {
+        return ReadResult{ReadStatus::Error, 0};
+    }
+    //A zero timeout means the caller asked not to wait, so an empty read is not a timeout
+    return ReadResult{(this->m_readTimeout.count() == 0 ? ReadStatus::NoData : ReadStatus::Timeout), 0};
+}
+
+ReadResult IByteStream::peek()
+{
+    ReadResult result{this->read()};
+    if (result.status == ReadStatus::Byte) {
+        this->putBack(result.value);
+    }
+    return result;
+}
+
+void IByteStream::putBack(char c)
+{
+    this->putBack(&c, 1);
+}
 
 bool IByteStream::available()
 {
-    return (this->peek() != '\0');
+    return (this->peek().status == ReadStatus::Byte);
 }
 
 bool IByteStream::fileExists(const std::string &fileToCheck)
@@ -159,31 +300,4 @@ bool IByteStream::fileExists(const std::string &fileToCheck)
 #endif //defined(_WIN32)
 }
 
-
-#if defined(_MSC_VER)
-#include <Windows.h>
-uint64_t IByteStream::getEpoch()
-{
-    /*
-     * Are you fucking kidding me Windows?
-     * https://stackoverflow.com/a/1695332/4791654
-     */
-    FILETIME ft_now{};
-    LONGLONG ll_now{(LONGLONG)ft_now.dwLowDateTime + ((LONGLONG)(ft_now.dwHighDateTime) << 32LL)};
-    LONGLONG win32Epoch{ll_now/10000};
-    LONGLONG unixEpoch{win32Epoch - 116444736000000000LL};
-    return static_cast<uint64_t>(unixEpoch);
-}
-#else
-#include <sys/time.h>
-uint64_t IByteStream::getEpoch()
-{
-    struct timeval tv{};
-    gettimeofday(&tv, NULL);
-    return (static_cast<unsigned long long>(tv.tv_sec) * 1000) +
-           (static_cast<unsigned long long>(tv.tv_usec) / 1000);
-}
-
-#endif //defined(_WIN32)
-
 } //namespace CppSerialPort
@@ -33,6 +33,12 @@
 #include <string>
 #include <sstream>
 #include <mutex>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+#include "RingBuffer.h"
 
 #if defined(_WIN32)
 #    ifndef PATH_MAX
@@ -45,15 +51,41 @@
 
 namespace CppSerialPort {
 
+enum class ReadStatus {
+    Byte,
+    NoData,
+    Timeout,
+    Error
+};
+
+struct ReadResult
+{
+    ReadStatus status;
+    char value;
+};
+
+//Taken once per read system call, straight after it returns, so it marks the arrival of the last byte of that read
+struct ReadTimestamp
+{
+    //Nanoseconds on the monotonic clock (CLOCK_MONOTONIC on Linux)
+    uint64_t monotonic;
+    //Nanoseconds since the Unix epoch, or 0 unless wall clock timestamps were asked for
+    uint64_t realtime;
+};
+
 class IByteStream
 {
 public:
     IByteStream();
     virtual ~IByteStream() = default;
 
-	virtual char read() = 0;
+	virtual ReadResult read();
+	ssize_t readSome(char *buffer, size_t maxBytes);
+	virtual ssize_t readSome(char *buffer, size_t maxBytes, std::chrono::microseconds timeout) = 0;
+	std::string readAvailable();
 	virtual ssize_t write(char) = 0;
 	virtual ssize_t write(const char *, size_t) = 0;
+	virtual ssize_t write(const ByteSpan *spans, size_t spanCount);
 
 	virtual std::string portName() const = 0;
 	virtual bool isOpen() const = 0;
@@ -63,9 +95,11 @@ public:
 	virtual void flushTx() = 0;
 
 	bool available();
-	int peek();
-	virtual void setReadTimeout(int timeout);
+	ReadResult peek();
+	void setReadTimeout(int timeout);
+	virtual void setReadTimeout(std::chrono::microseconds timeout);
 	int readTimeout() const;
+	std::chrono::microseconds readTimeoutDuration() const;
 
 	virtual void setWriteTimeout(int timeout);
 	int writeTimeout() const;
@@ -75,37 +109,81 @@ public:
 	void setLineEnding(char chr);
 
 	virtual ssize_t writeLine(const std::string &str);
+	ssize_t writeLines(const std::vector<std::string> &lines);
+
+	//Payload and line ending go out as separate spans, so no line is copied, and a whole batch of lines shares one write
+	template <typename InputIterator> ssize_t writeLines(InputIterator first, InputIterator last)
+	{
+		std::lock_guard<std::mutex> writeLock{this->m_writeMutex};
+		ByteSpan spans[WRITE_LINES_BATCH * 2];
+		ssize_t totalWritten{0};
+		while (first != last) {
+			size_t spanCount{0};
+			size_t batchBytes{0};
+			for (; (first != last) && (spanCount < WRITE_LINES_BATCH * 2); ++first) {
+				spans[spanCount++] = ByteSpan{first->data(), first->length()};
+				spans[spanCount++] = ByteSpan{this->m_lineEnding.data(), this->m_lineEnding.length()};
+				batchBytes += first->length() + this->m_lineEnding.length();
+			}
+			ssize_t writtenBytes{this->write(spans, spanCount)};
+			if (writtenBytes < 0) {
+				return (totalWritten > 0 ? totalWritten : writtenBytes);
+			}
+			totalWritten += writtenBytes;
+			if (static_cast<size_t>(writtenBytes) < batchBytes) {
+				break;
+			}
+		}
+		return totalWritten;
+	}
 
 	std::string readLine(bool *timeout = nullptr);
 	std::string readUntil(const std::string &until, bool *timeout = nullptr);
 	std::string readUntil(char until, bool *timeout = nullptr);
+	//firstByteTimestamp gets the timestamp of the read that delivered the first byte of the returned string
+	std::string readUntil(const std::string &until, bool *timeout, ReadTimestamp *firstByteTimestamp);
+
+	//Timestamp of the read behind the bytes the last readSome() returned; only meaningful on the reading thread
+	ReadTimestamp lastReadTimestamp() const;
+	void setRealtimeTimestamps(bool realtimeTimestamps);
+	bool realtimeTimestamps() const;
+
+	static ReadTimestamp currentTimestamp(bool includeRealtime);
+	//Backs a read timestamp off by bytesAfter characters, for a byte that arrived that many characters before the end of its read
+	static ReadTimestamp interpolateTimestamp(const ReadTimestamp &readTimestamp, size_t bytesAfter, uint64_t characterDuration);
 
 protected:
-	virtual void putBack(char c) = 0;
+	virtual void putBack(const char *bytes, size_t numberOfBytes) = 0;
+	void putBack(char c);
+	//Called by implementations right after each read system call that returned data
+	void stampRead();
+	void setLastReadTimestamp(const ReadTimestamp &timestamp);
 
 	static bool fileExists(const std::string &filePath);
 	static inline bool endsWith (const std::string &fullString, const std::string &ending) {
         return ( (fullString.length() < ending.length()) ? false : std::equal(ending.rbegin(), ending.rend(), fullString.rbegin()) );
     }
 	template<typename T> static inline std::string toStdString(const T &t) {
-        return dynamic_cast<std::ostringstream &>(std::ostringstream{""} << t).str();
+        std::ostringstream outputStream{};
+        outputStream << t;
+        return outputStream.str();
     }
 
 	static const int DEFAULT_READ_TIMEOUT;
 	static const int DEFAULT_WRITE_TIMEOUT;
-	static uint64_t getEpoch();
+	static const size_t constexpr READ_CHUNK_SIZE{4096};
+	static const size_t constexpr WRITE_LINES_BATCH{256};
 
 
 private:
-    int m_readTimeout;
+    std::chrono::microseconds m_readTimeout;
     int m_writeTimeout;
     std::string m_lineEnding;
     std::mutex m_writeMutex;
-
+    ReadTimestamp m_lastReadTimestamp;
+    std::atomic<bool> m_realtimeTimestamps;
 
     static const char *DEFAULT_LINE_ENDING;
-
-    ssize_t write(const std::string &str);
 };
 
 } //namespace CppSerialPort
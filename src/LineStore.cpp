@@ -0,0 +1,169 @@
+#include "LineStore.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const size_t LineStore::SEGMENT_LINE_CAPACITY{4096};
+const size_t LineStore::SEGMENT_BYTE_CAPACITY{256 * 1024};
+
+LineStore::LineStore(size_t maxLines, size_t maxBytes) :
+    m_segments{},
+    m_nextLineNumber{0},
+    m_lineCount{0},
+    m_byteCount{0},
+    m_maxLines{maxLines},
+    m_maxBytes{maxBytes},
+    m_spillFilePath{""},
+    m_spillStream{}
+{
+
+}
+
+LineSegment &LineStore::writableSegment(size_t size)
+{
+    if (!this->m_segments.empty()) {
+        LineSegment &lastSegment = *this->m_segments.back();
+        if ( (lastSegment.lineEnds.size() < SEGMENT_LINE_CAPACITY) &&
+             (lastSegment.bytes.size() + size <= SEGMENT_BYTE_CAPACITY) ) {
+            return lastSegment;
+        }
+    }
+    //An oversized line still gets a segment of its own rather than being split
+    this->m_segments.push_back(std::make_shared<LineSegment>(LineSegment{this->m_nextLineNumber, std::string{}, std::vector<uint32_t>{}, std::vector<LineKind>{}}));
+    LineSegment &newSegment = *this->m_segments.back();
+    newSegment.bytes.reserve(std::max(size, SEGMENT_BYTE_CAPACITY));
+    newSegment.lineEnds.reserve(SEGMENT_LINE_CAPACITY);
+    newSegment.kinds.reserve(SEGMENT_LINE_CAPACITY);
+    return newSegment;
+}
+
+void LineStore::append(const char *data, size_t size, LineKind kind)
+{
+    LineSegment &segment = this->writableSegment(size);
+    segment.bytes.append(data, size);
+    segment.lineEnds.push_back(static_cast<uint32_t>(segment.bytes.size()));
+    segment.kinds.push_back(kind);
+    this->m_nextLineNumber++;
+    this->m_lineCount++;
+    this->m_byteCount += size;
+    this->enforceScrollbackLimit();
+}
+
+void LineStore::clear()
+{
+    this->m_segments.clear();
+    this->m_lineCount = 0;
+    this->m_byteCount = 0;
+}
+
+size_t LineStore::lineCount() const
+{
+    return this->m_lineCount;
+}
+
+size_t LineStore::byteCount() const
+{
+    return this->m_byteCount;
+}
+
+uint64_t LineStore::firstLineNumber() const
+{
+    return this->m_nextLineNumber - this->m_lineCount;
+}
+
+LineReference LineStore::line(size_t index) const
+{
+    if (index >= this->m_lineCount) {
+        throw std::out_of_range("LineStore::line(size_t): index " + std::to_string(index) + " is out of range (lineCount = " + std::to_string(this->m_lineCount) + ")");
+    }
+    uint64_t lineNumber{this->firstLineNumber() + index};
+    auto foundSegment = std::upper_bound(this->m_segments.begin(), this->m_segments.end(), lineNumber, [](uint64_t number, const std::shared_ptr<LineSegment> &segment) {
+        return number < segment->firstLineNumber;
+    });
+    const LineSegment &segment = **(foundSegment - 1);
+    size_t lineIndex{static_cast<size_t>(lineNumber - segment.firstLineNumber)};
+    size_t lineStart{lineIndex == 0 ? 0 : segment.lineEnds[lineIndex - 1]};
+    return LineReference{segment.bytes.data() + lineStart, segment.lineEnds[lineIndex] - lineStart, segment.kinds[lineIndex]};
+}
+
+LineSegmentList LineStore::snapshot() const
+{
+    LineSegmentList segments{};
+    segments.reserve(this->m_segments.size());
+    for (size_t i = 0; i < this->m_segments.size(); i++) {
+        if (i + 1 < this->m_segments.size()) {
+            segments.push_back(this->m_segments[i]);
+        } else {
+            segments.push_back(std::make_shared<LineSegment>(*this->m_segments[i]));
+        }
+    }
+    return segments;
+}
+
+void LineStore::setScrollbackLimit(size_t maxLines, size_t maxBytes)
+{
+    this->m_maxLines = maxLines;
+    this->m_maxBytes = maxBytes;
+    this->enforceScrollbackLimit();
+}
+
+size_t LineStore::maxLines() const
+{
+    return this->m_maxLines;
+}
+
+size_t LineStore::maxBytes() const
+{
+    return this->m_maxBytes;
+}
+
+void LineStore::setSpillFile(const std::string &filePath)
+{
+    if (this->m_spillStream.is_open()) {
+        this->m_spillStream.close();
+    }
+    this->m_spillFilePath = filePath;
+    if (filePath.empty()) {
+        return;
+    }
+    this->m_spillStream.open(filePath, std::ios::out | std::ios::binary | std::ios::app);
+    if (!this->m_spillStream.is_open()) {
+        this->m_spillFilePath.clear();
+        throw std::runtime_error("LineStore::setSpillFile(const std::string &): Unable to open spill file " + filePath);
+    }
+}
+
+std::string LineStore::spillFile() const
+{
+    return this->m_spillFilePath;
+}
+
+void LineStore::enforceScrollbackLimit()
+{
+    //Only whole, closed segments are dropped, so the limit may be exceeded by up to one segment
+    while (this->m_segments.size() > 1) {
+        bool overLineLimit{(this->m_maxLines != 0) && (this->m_lineCount - this->m_segments.front()->lineEnds.size() >= this->m_maxLines)};
+        bool overByteLimit{(this->m_maxBytes != 0) && (this->m_byteCount - this->m_segments.front()->bytes.size() >= this->m_maxBytes)};
+        if ( (!overLineLimit) && (!overByteLimit) ) {
+            return;
+        }
+        const LineSegment &oldestSegment = *this->m_segments.front();
+        if (this->m_spillStream.is_open()) {
+            this->spillSegment(oldestSegment);
+        }
+        this->m_lineCount -= oldestSegment.lineEnds.size();
+        this->m_byteCount -= oldestSegment.bytes.size();
+        this->m_segments.pop_front();
+    }
+}
+
+void LineStore::spillSegment(const LineSegment &segment)
+{
+    size_t lineStart{0};
+    for (const auto &it : segment.lineEnds) {
+        this->m_spillStream.write(segment.bytes.data() + lineStart, static_cast<std::streamsize>(it - lineStart));
+        this->m_spillStream.put('\n');
+        lineStart = it;
+    }
+    this->m_spillStream.flush();
+}
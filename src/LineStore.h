@@ -0,0 +1,90 @@
+#ifndef QSERIALTERMINAL_LINESTORE_H
+#define QSERIALTERMINAL_LINESTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <memory>
+
+enum class LineKind : unsigned char
+{
+    Received,
+    Transmitted
+};
+
+struct LineReference
+{
+    const char *data;
+    size_t size;
+    LineKind kind;
+};
+
+//Lines packed back to back, without separators; line i ends at lineEnds[i]
+struct LineSegment
+{
+    uint64_t firstLineNumber;
+    std::string bytes;
+    std::vector<uint32_t> lineEnds;
+    std::vector<LineKind> kinds;
+};
+
+using LineSegmentList = std::vector<std::shared_ptr<const LineSegment>>;
+
+/*
+ * Append-only scrollback storage. Lines are packed into segments of
+ * contiguous bytes with an end-offset index, so looking up any line is a
+ * binary search over segments plus one array access. The scrollback limit
+ * is enforced by dropping whole segments from the front, optionally
+ * writing them to a spill file first, so trimming never moves retained data.
+ * Only the last segment is ever appended to, so snapshot() can share the
+ * others with a search running on another thread
+ */
+class LineStore
+{
+public:
+    explicit LineStore(size_t maxLines = 0, size_t maxBytes = 0);
+
+    LineStore(const LineStore &other) = delete;
+    LineStore(LineStore &&other) = delete;
+    LineStore &operator=(const LineStore &rhs) = delete;
+    LineStore &operator=(LineStore &&rhs) = delete;
+
+    void append(const char *data, size_t size, LineKind kind);
+    void clear();
+
+    size_t lineCount() const;
+    size_t byteCount() const;
+    uint64_t firstLineNumber() const;
+    LineReference line(size_t index) const;
+    //The closed segments are shared rather than copied; only the one still being filled is copied
+    LineSegmentList snapshot() const;
+
+    void setScrollbackLimit(size_t maxLines, size_t maxBytes);
+    size_t maxLines() const;
+    size_t maxBytes() const;
+
+    void setSpillFile(const std::string &filePath);
+    std::string spillFile() const;
+
+    static const size_t SEGMENT_LINE_CAPACITY;
+    static const size_t SEGMENT_BYTE_CAPACITY;
+
+private:
+    std::deque<std::shared_ptr<LineSegment>> m_segments;
+    uint64_t m_nextLineNumber;
+    size_t m_lineCount;
+    size_t m_byteCount;
+    size_t m_maxLines;
+    size_t m_maxBytes;
+    std::string m_spillFilePath;
+    std::ofstream m_spillStream;
+
+    LineSegment &writableSegment(size_t size);
+    void enforceScrollbackLimit();
+    void spillSegment(const LineSegment &segment);
+};
+
+#endif //QSERIALTERMINAL_LINESTORE_H
@@ -4,6 +4,7 @@
 #include <QtCore/QDateTime>
 #include <QLabel>
 #include <QTimer>
+#include <QEvent>
 
 #if defined(_WIN32)
 #    include <Windows.h>
@@ -16,8 +17,12 @@
 #include "ApplicationUtilities.h"
 #include "ApplicationSettings.h"
 #include "SingleInstanceGuard.h"
+#include "HeadlessTerminal.h"
 
 
+//Not in --help: quits once the first frame is painted, so bench/StartupBenchmark can time startup from outside
+static int exitAfterFirstFrame{0};
+
 #if !defined(_MSC_VER)
 #   include <csignal>
 #   include <unistd.h>
@@ -27,6 +32,10 @@ static struct option longOptions[]{
 	{ "verbose",        no_argument,       nullptr, 'e' },
 { "help",           no_argument,       nullptr, 'h' },
 { "version",        no_argument,       nullptr, 'v' },
+{ "scrollback-lines", required_argument, nullptr, 'l' },
+{ "scrollback-bytes", required_argument, nullptr, 'b' },
+{ "scrollback-file",  required_argument, nullptr, 'f' },
+{ "exit-after-first-frame", no_argument, &exitAfterFirstFrame, 1 },
 { nullptr, 0, nullptr, 0 }
 };
 #endif //!defined(_MSC_VER)
@@ -35,12 +44,26 @@ static struct option longOptions[]{
 
 #define ARRAY_SIZE(x) sizeof(x)/sizeof(x[0])
 
+class FirstFrameProbe : public QObject
+{
+public:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            //Queued, so the paint that triggered it still finishes
+            QTimer::singleShot(0, QCoreApplication::instance(), &QCoreApplication::quit);
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
 void displayHelp();
 void displayVersion();
 void interruptHandler(int signalNumber);
 void installSignalHandlers(void (*signalHandler)(int));
 void globalLogHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 void exitApplication(const std::string &why);
+size_t parseScrollbackLimit(const char *optionName, const std::string &value);
 
 using namespace ApplicationStrings;
 using namespace GlobalSettings;
@@ -49,6 +72,12 @@ using namespace ApplicationUtilities;
 
 int main(int argc, char *argv[])
 {
+#if !defined(_WIN32)
+    //Decide before anything Qt related is touched, so headless startup stays in the millisecond range
+    if (HeadlessTerminal::isHeadlessRequested(argc, argv)) {
+        return HeadlessTerminal::main(argc, argv);
+    }
+#endif //!defined(_WIN32)
     //https://stackoverflow.com/a/28172162/4791654
     SingleInstanceGuard singleInstanceGuard{PROGRAM_LONG_NAME};
     if (!singleInstanceGuard.tryLockProcess()) {
@@ -64,6 +93,9 @@ int main(int argc, char *argv[])
 
     ApplicationUtilities::checkOrCreateProgramSettingsDirectory();
 
+    size_t scrollbackLines{MainWindow::SCROLLBACK_LINE_LIMIT};
+    size_t scrollbackBytes{MainWindow::SCROLLBACK_BYTE_LIMIT};
+    std::string scrollbackFile{""};
 #if defined(_MSC_VER)
     for (int i = 0; i < argc; i++) {
         auto it = argv[i];
@@ -74,7 +106,18 @@ int main(int argc, char *argv[])
         bool shortOption{(it[0] == '-')};
         if (longOption) {
             auto newIt = std::string{it + 2};
-            if (newIt == "verbose") {
+            auto equalsPosition = newIt.find('=');
+            auto optionValue = (equalsPosition == std::string::npos ? std::string{""} : newIt.substr(equalsPosition + 1));
+            if (equalsPosition != std::string::npos) {
+                newIt = newIt.substr(0, equalsPosition);
+            }
+            if (newIt == "scrollback-lines") {
+                scrollbackLines = parseScrollbackLimit("scrollback-lines", optionValue);
+            } else if (newIt == "scrollback-bytes") {
+                scrollbackBytes = parseScrollbackLimit("scrollback-bytes", optionValue);
+            } else if (newIt == "scrollback-file") {
+                scrollbackFile = optionValue;
+            } else if (newIt == "verbose") {
                 ApplicationUtilities::verboseLogging = true;
                 LOG_INFO() << "Setting LogLevel to verbose due to command line option";
             } else if (newIt == "version") {
@@ -83,6 +126,8 @@ int main(int argc, char *argv[])
             } else if (newIt == "help") {
                 displayHelp();
                 exit(EXIT_SUCCESS);
+            } else if (newIt == "exit-after-first-frame") {
+                exitAfterFirstFrame = 1;
             } else {
                 LOG_WARN() << QString{"Invalid switch \"%1\" detected"}.arg(QString{it});
             }
@@ -121,6 +166,17 @@ int main(int argc, char *argv[])
                 ApplicationUtilities::verboseLogging = true;
                 LOG_INFO() << "Setting LogLevel to verbose due to command line option";
                 break;
+            case 'l':
+                scrollbackLines = parseScrollbackLimit("scrollback-lines", optarg);
+                break;
+            case 'b':
+                scrollbackBytes = parseScrollbackLimit("scrollback-bytes", optarg);
+                break;
+            case 'f':
+                scrollbackFile = optarg;
+                break;
+            case 0:
+                break;
             default:
                 LOG_WARN() << QString{"Invalid switch \"%1\" detected"}.arg(QString{optarg});
                 break;
@@ -136,12 +192,24 @@ int main(int argc, char *argv[])
     ApplicationIcons::initializeInstance();
     std::shared_ptr<MainWindow> mainWindow{std::make_shared<MainWindow>()};
     mainWindow->setWindowIcon(applicationIcons->MAIN_WINDOW_ICON);
+    mainWindow->setScrollbackLimit(scrollbackLines, scrollbackBytes);
+    if (!scrollbackFile.empty()) {
+        try {
+            mainWindow->setScrollbackSpillFile(scrollbackFile);
+        } catch (std::exception &e) {
+            LOG_WARN() << e.what();
+        }
+    }
     mainWindow->setWindowTitle(MAIN_WINDOW_TITLE);
     mainWindow->setStyleSheet(MAIN_WINDOW_STYLESHEET);
     QRect screenGeometry{QApplication::desktop()->screenGeometry()};
     int x{(screenGeometry.width() - mainWindow->width()) / 2};
     int y{(screenGeometry.height() - mainWindow->height()) / 2};
     mainWindow->move(x, y);
+    FirstFrameProbe firstFrameProbe{};
+    if (exitAfterFirstFrame) {
+        qApplication.installEventFilter(&firstFrameProbe);
+    }
     mainWindow->show();
 
     return qApplication.exec();
@@ -213,6 +281,23 @@ void displayHelp()
     std::cout << "    -h, --help: Display this help text" << std::endl;
     std::cout << "    -v, --version: Display the version" << std::endl;
     std::cout << "    -e, --verbose: Enable verbose logging" << std::endl;
+    std::cout << "    -l, --scrollback-lines=N: Keep at most N lines of scrollback (0 for no limit)" << std::endl;
+    std::cout << "    -b, --scrollback-bytes=N: Keep at most N bytes of scrollback (0 for no limit)" << std::endl;
+    std::cout << "    -f, --scrollback-file=PATH: Append lines dropped from the scrollback to PATH" << std::endl;
+#if !defined(_WIN32)
+    std::cout << "    --headless: Run without a window, see --headless --help for the options" << std::endl;
+#endif //!defined(_WIN32)
+}
+
+size_t parseScrollbackLimit(const char *optionName, const std::string &value)
+{
+    try {
+        return static_cast<size_t>(std::stoull(value));
+    } catch (std::exception &e) {
+        (void)e;
+        LOG_WARN() << QString{"Invalid value \"%1\" for %2, using the default"}.arg(value.c_str(), optionName);
+        return (std::string{optionName} == "scrollback-lines" ? MainWindow::SCROLLBACK_LINE_LIMIT : MainWindow::SCROLLBACK_BYTE_LIMIT);
+    }
 }
 
 void logToFile(const std::string &str, const std::string &filePath)
@@ -10,18 +10,22 @@
 #include <QDesktopWidget>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QStringList>
 #include <QTimer>
 #include <QtCore/QTimer>
 #include <QtWidgets/QStatusBar>
 #include <QLabel>
 
+#include <algorithm>
+
 #include "SerialPort.h"
 
 
 using namespace CppSerialPort;
 
 const int MainWindow::CHECK_PORT_DISCONNECT_TIMEOUT{750};
-const int MainWindow::CHECK_PORT_RECEIVE_TIMEOUT{1};
 const int MainWindow::NO_SERIAL_PORTS_CONNECTED_MESSAGE_TIMEOUT{5000};
 const int MainWindow::SERIAL_READ_TIMEOUT{500};
 const CppSerialPort::BaudRate MainWindow::DEFAULT_BAUD_RATE{CppSerialPort::BaudRate::Baud9600};
@@ -29,7 +33,12 @@ const CppSerialPort::Parity MainWindow::DEFAULT_PARITY{CppSerialPort::Parity::Pa
 const CppSerialPort::StopBits MainWindow::DEFAULT_STOP_BITS{CppSerialPort::StopBits::StopOne};
 const CppSerialPort::DataBits MainWindow::DEFAULT_DATA_BITS{CppSerialPort::DataBits::DataEight};
 const CppSerialPort::FlowControl MainWindow::DEFAULT_FLOW_CONTROL{CppSerialPort::FlowControl::FlowOff};
+const CppSerialPort::DisplayMode MainWindow::DEFAULT_DISPLAY_MODE{CppSerialPort::DisplayMode::Text};
+const CppSerialPort::TimestampMode MainWindow::DEFAULT_TIMESTAMP_MODE{CppSerialPort::TimestampMode::None};
 const int MainWindow::STATUS_BAR_FONT_POINT_SIZE{12};
+const int MainWindow::TERMINAL_FLUSH_INTERVAL{TerminalRenderer::DEFAULT_FLUSH_INTERVAL};
+const size_t MainWindow::SCROLLBACK_LINE_LIMIT{100000};
+const size_t MainWindow::SCROLLBACK_BYTE_LIMIT{64 * 1024 * 1024};
 const char *MainWindow::CARRIAGE_RETURN_LINE_ENDING{R"(\r)"};
 const char *MainWindow::NEW_LINE_LINE_ENDING{R"(\n)"};
 const char *MainWindow::CARRIAGE_RETURN_NEW_LINE_LINE_ENDING{R"(\r\n)"};
@@ -43,9 +52,29 @@ MainWindow::MainWindow(QWidget *parent) :
     m_ui{new Ui::MainWindow{}},
     m_aboutApplicationWidget{std::make_shared<AboutApplicationWidget>()},
     m_statusBarLabel{new QLabel{""}},
-    m_checkPortDisconnectTimer{new QTimer{}},
-    m_checkSerialPortReceiveTimer{new QTimer{}},
-    m_serialPortNames{CppSerialPort::SerialPort::availableSerialPorts()},
+    m_renderStatisticsLabel{new QLabel{""}},
+    m_transmitStatusLabel{new QLabel{""}},
+    m_terminalRenderer{nullptr},
+    m_peakLinesCoalesced{0},
+    m_deviceMonitor{new DeviceMonitor{CHECK_PORT_DISCONNECT_TIMEOUT}},
+    m_partialLineTimer{new QTimer{}},
+    m_serialPortReader{nullptr},
+    m_serialPortWriter{nullptr},
+    m_scriptRunner{nullptr},
+    m_fileTransferSession{nullptr},
+    m_sessionRecorder{nullptr},
+    m_replayQueue{SerialPortReader::DEFAULT_QUEUE_CAPACITY},
+    m_replayNotificationPending{false},
+    m_replayStartTime{},
+    m_sessionReplayer{nullptr},
+    m_captureViewer{nullptr},
+    m_pendingReceive{""},
+    m_pendingReadEnds{},
+    m_displayMode{DEFAULT_DISPLAY_MODE},
+    m_timestampMode{DEFAULT_TIMESTAMP_MODE},
+    m_interpolateTimestamps{false},
+    m_characterDuration{0},
+    m_receivedOffset{0},
     m_currentLinePushedIntoCommandHistory{false},
     m_currentHistoryIndex{0}
 {
@@ -56,6 +85,30 @@ MainWindow::MainWindow(QWidget *parent) :
     tempFont.setPointSize(MainWindow::STATUS_BAR_FONT_POINT_SIZE);
     this->m_statusBarLabel->setFont(tempFont);
     this->m_ui->statusBar->addWidget(this->m_statusBarLabel.get());
+    this->m_renderStatisticsLabel->setFont(tempFont);
+    this->m_ui->statusBar->addPermanentWidget(this->m_renderStatisticsLabel.get());
+    this->m_transmitStatusLabel->setFont(tempFont);
+    this->m_ui->statusBar->addPermanentWidget(this->m_transmitStatusLabel.get());
+    this->m_ui->terminal->setLineColor(LineKind::Received, QColor{RED_COLOR_STRING});
+    this->m_ui->terminal->setLineColor(LineKind::Transmitted, QColor{BLUE_COLOR_STRING});
+    this->m_ui->terminal->setScrollbackLimit(MainWindow::SCROLLBACK_LINE_LIMIT, MainWindow::SCROLLBACK_BYTE_LIMIT);
+    this->m_terminalRenderer.reset(new TerminalRenderer{this->m_ui->terminal, MainWindow::TERMINAL_FLUSH_INTERVAL});
+    //Each search works on a snapshot, so the scrollback can keep growing and trimming while the workers read it
+    this->m_ui->searchBar->setSource([this](TextSearch::BlockFunction *blockFunction) -> size_t {
+        std::shared_ptr<LineSegmentList> segments{std::make_shared<LineSegmentList>(this->m_ui->terminal->lineStore().snapshot())};
+        *blockFunction = [segments](size_t blockIndex, std::string *, std::vector<uint32_t> *, SearchBlock *block) {
+            const LineSegment &segment{*(*segments)[blockIndex]};
+            block->firstLineNumber = segment.firstLineNumber;
+            block->data = segment.bytes.data();
+            block->lineEnds = segment.lineEnds.data();
+            block->lineCount = segment.lineEnds.size();
+        };
+        return segments->size();
+    }, [this](uint64_t lineNumber) -> bool {
+        return this->m_ui->terminal->scrollToLine(lineNumber);
+    });
+    this->m_ui->searchBar->hide();
+    connect(this->m_ui->searchBar, &SearchBar::dismissed, this->m_ui->sendBox, static_cast<void (QWidget::*)()>(&QWidget::setFocus));
     qApp->installEventFilter(this);
 
     setupAdditionalUiComponents();
@@ -78,15 +131,39 @@ MainWindow::MainWindow(QWidget *parent) :
     this->connect(this->m_ui->actionAboutQSerialTerminal, &QAction::triggered, this, &MainWindow::onAboutQSerialTerminalActionTriggered);
     this->connect(this->m_aboutApplicationWidget.get(), &AboutApplicationWidget::aboutToClose, this, &MainWindow::onAboutApplicationWidgetWindowClosed);
 
-    this->m_checkPortDisconnectTimer->setInterval(MainWindow::CHECK_PORT_DISCONNECT_TIMEOUT);
-    this->m_checkSerialPortReceiveTimer->setInterval(MainWindow::CHECK_PORT_RECEIVE_TIMEOUT);
-
-    connect(this->m_checkPortDisconnectTimer.get(), &QTimer::timeout, this, &MainWindow::checkDisconnectedSerialPorts);
-    connect(this->m_checkSerialPortReceiveTimer.get(), &QTimer::timeout, this, &MainWindow::launchSerialReceiveAsync);
+    this->m_partialLineTimer->setInterval(MainWindow::SERIAL_READ_TIMEOUT);
+    this->m_partialLineTimer->setSingleShot(true);
+
+    connect(this->m_deviceMonitor.get(), &DeviceMonitor::serialPortAdded, this, &MainWindow::onSerialPortAdded);
+    connect(this->m_deviceMonitor.get(), &DeviceMonitor::serialPortRemoved, this, &MainWindow::onSerialPortRemoved);
+    connect(this->m_partialLineTimer.get(), &QTimer::timeout, this, &MainWindow::onPartialLineTimeout);
+    connect(this->m_terminalRenderer.get(), &TerminalRenderer::flushed, this, &MainWindow::onTerminalFlushed);
+    //Emitted from the reader thread, so always hop onto the GUI thread before touching the terminal
+    connect(this, &MainWindow::serialDataAvailable, this, &MainWindow::onSerialDataAvailable, Qt::QueuedConnection);
+    connect(this, &MainWindow::serialTransmitEvent, this, &MainWindow::onSerialTransmitEvent, Qt::QueuedConnection);
+    connect(this, &MainWindow::scriptEvent, this, &MainWindow::onScriptEvent, Qt::QueuedConnection);
+    connect(this->m_ui->actionLoadScript, &QAction::triggered, this, &MainWindow::onActionLoadScriptTriggered);
+    connect(this, &MainWindow::fileTransferEvent, this, &MainWindow::onFileTransferEvent, Qt::QueuedConnection);
+    connect(this->m_ui->actionSendFile, &QAction::triggered, this, &MainWindow::onActionSendFileTriggered);
+    connect(this->m_ui->actionReceiveFile, &QAction::triggered, this, &MainWindow::onActionReceiveFileTriggered);
+    connect(this->m_ui->actionRecordSession, &QAction::triggered, this, &MainWindow::onActionRecordSessionTriggered);
+    connect(this, &MainWindow::replayEvent, this, &MainWindow::onReplayEvent, Qt::QueuedConnection);
+    connect(this, &MainWindow::replayDataAvailable, this, &MainWindow::onReplayDataAvailable, Qt::QueuedConnection);
+    connect(this->m_ui->actionReplaySession, &QAction::triggered, this, &MainWindow::onActionReplaySessionTriggered);
+    connect(this->m_ui->actionOpenCapture, &QAction::triggered, this, &MainWindow::onActionOpenCaptureTriggered);
+    connect(this->m_ui->actionMonitorPorts, &QAction::triggered, this, &MainWindow::onActionMonitorPortsTriggered);
 
     this->show();
-    this->m_checkPortDisconnectTimer->start();
-    this->m_checkSerialPortReceiveTimer->start();
+}
+
+void MainWindow::setScrollbackLimit(size_t maxLines, size_t maxBytes)
+{
+    this->m_ui->terminal->setScrollbackLimit(maxLines, maxBytes);
+}
+
+void MainWindow::setScrollbackSpillFile(const std::string &filePath)
+{
+    this->m_ui->terminal->setSpillFile(filePath);
 }
 
 void MainWindow::onAboutApplicationWidgetWindowClosed()
@@ -130,17 +207,17 @@ void MainWindow::autoSetLineEnding()
         if (it->isChecked()) {
             this->setLineEnding(it->text().toStdString());
             if (this->m_byteStream) {
-                this->m_byteStream->setLineEnding(this->m_lineEnding);
+                this->m_byteStream->setLineEnding(this->unescapeLineEnding(this->m_lineEnding));
             }
         }
     }
 }
 
-void MainWindow::appendReceivedString(const std::string &str)
+void MainWindow::appendReceivedString(const std::string &str, const CppSerialPort::ReadTimestamp &timestamp)
 {
     using namespace ApplicationStrings;
     if (str.length() > 0) {
-        this->printRxResult(str);
+        this->printRxResult(str, timestamp);
     }
 }
 
@@ -151,42 +228,48 @@ void MainWindow::appendTransmittedString(const QString &str)
         if (!this->m_byteStream->isOpen()) {
             this->openSerialPort();
         }
+        //There is no writer when the port could not be opened
+        if (!this->m_serialPortWriter) {
+            this->setStatusBarLabelText(QString{TRANSMIT_PORT_NOT_OPEN_STRING}.arg(QString::fromStdString(this->m_byteStream->portName())));
+            return;
+        }
+        //Refuse the line rather than drop bytes when flow control has backed the queue up; it stays in the send box to retry
+        if (this->m_serialPortWriter->enqueue(str.toStdString() + this->m_byteStream->lineEnding()) == 0) {
+            this->setStatusBarLabelText(QString{TRANSMIT_QUEUE_FULL_STRING}.arg(QString::number(this->m_serialPortWriter->queuedBytes())));
+            return;
+        }
+        //Only once it is queued, so a refused line that is retried is not remembered twice
         if (str.toStdString() != "") {
             this->m_commandHistory.insert(this->m_commandHistory.begin(), this->m_ui->sendBox->text());
             resetCommandHistory();
         }
-        this->m_byteStream->writeLine(str.toStdString());
+        this->updateTransmitStatus();
         this->printTxResult(str.toStdString());
         this->m_ui->sendBox->clear();
     }
 }
 
 
-void MainWindow::checkDisconnectedSerialPorts()
+void MainWindow::onSerialPortAdded(const QString &portName)
 {
-    /*
-    auto names = CppSerialPort::SerialPort::availableSerialPorts();
-    auto maybeUpdate = std::vector<std::string>{};
-    auto currents = QActionSet{};
-
-    for (auto &it : names) {
-        maybeUpdate.push_back(it);
-    }
-    for (auto &it : this->m_availablePortNamesActions) {
-        currents.insert(it);
-    }
-    for (auto &it : maybeUpdate) {
-        QAction temp{it.c_str()};
-        if (currents.find(&temp) == currents.end()) {
-            this->addNewSerialPortInfoItem(SerialPortItemType::PortName, it);
+    this->addNewPortNameItem(portName.toStdString());
+    //With nothing plugged in at startup there is no port selected yet, so the new one becomes it
+    auto foundChecked = std::find_if(this->m_availablePortNamesActions.begin(), this->m_availablePortNamesActions.end(), [](QAction *action) { return action->isChecked(); });
+    if (foundChecked == this->m_availablePortNamesActions.end()) {
+        auto foundPosition = this->findPortNameAction(portName);
+        if (foundPosition != this->m_availablePortNamesActions.end()) {
+            this->setPortName(*foundPosition);
         }
     }
-    for (auto &it : currents) {
-        if (std::find(maybeUpdate.begin(), maybeUpdate.end(), it) == maybeUpdate.end()) {
-            this->removeOldSerialPortInfoItem(SerialPortItemType::PortName, it);
-        }
+    if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) ) {
+        this->m_ui->connectButton->setEnabled(true);
+        this->m_ui->actionConnect->setEnabled(true);
     }
-     */
+}
+
+void MainWindow::onSerialPortRemoved(const QString &portName)
+{
+    this->removeOldPortNameItem(portName.toStdString());
 }
 
 std::string MainWindow::escapeLineEnding(const std::string &lineEnding) {
@@ -210,6 +293,25 @@ std::string MainWindow::escapeLineEnding(const std::string &lineEnding) {
     return returnString;
 }
 
+std::string MainWindow::unescapeLineEnding(const std::string &lineEnding) {
+    std::string returnString{""};
+    for (size_t i = 0; i < lineEnding.length(); i++) {
+        if ( (lineEnding[i] == '\\') && (i + 1 < lineEnding.length()) ) {
+            if (lineEnding[i + 1] == 'r') {
+                returnString += '\r';
+                i++;
+                continue;
+            } else if (lineEnding[i + 1] == 'n') {
+                returnString += '\n';
+                i++;
+                continue;
+            }
+        }
+        returnString += lineEnding[i];
+    }
+    return returnString;
+}
+
 void MainWindow::addNewLineEndingItem(const std::string &lineEnding) {
     using namespace ApplicationUtilities;
     QAction *tempAction{new QAction{lineEnding.c_str(), this}};
@@ -226,7 +328,17 @@ void MainWindow::addNewLineEndingItem(const std::string &lineEnding) {
 
 void MainWindow::addNewPortNameItem(const std::string &str) {
     using namespace ApplicationUtilities;
-    QAction *tempAction{new QAction{str.c_str(), this}};
+    using namespace ApplicationStrings;
+    //The menu shows what is plugged in where the system knows it, but the port name stays the key for the action
+    QString actionText{QString::fromStdString(str)};
+    CppSerialPort::SerialPortInfo portInfo{};
+    if (CppSerialPort::SerialPort::findSerialPortInfo(str, &portInfo) && (!portInfo.description().empty())) {
+        actionText = QString{PORT_NAME_DESCRIPTION_STRING}.arg(actionText, QString::fromStdString(portInfo.description()));
+    }
+    QAction *tempAction{new QAction{actionText, this}};
+    if (!portInfo.byIdPath.empty()) {
+        tempAction->setToolTip(QString::fromStdString(portInfo.byIdPath));
+    }
     tempAction->setProperty(ApplicationStrings::ACTION_INDEX_PROPERTY_TAG, QVariant{0});
     tempAction->setProperty(ApplicationStrings::PORT_NAME_ACTION_KEY, QVariant{str.c_str()});
     tempAction->setCheckable(true);
@@ -305,14 +417,41 @@ void MainWindow::addNewFlowControlItem(CppSerialPort::FlowControl flowControl) {
     }
 }
 
+void MainWindow::addNewDisplayModeItem(CppSerialPort::DisplayMode displayMode) {
+    using namespace ApplicationUtilities;
+    QAction *tempAction{new QAction{toStdString(displayMode).c_str(), this}};
+    tempAction->setProperty(ApplicationStrings::ACTION_INDEX_PROPERTY_TAG, QVariant{0});
+    tempAction->setProperty(ApplicationStrings::DISPLAY_MODE_ACTION_KEY, QVariant{static_cast<int>(displayMode)});
+    tempAction->setCheckable(true);
+    connect(tempAction, &QAction::triggered, this, &MainWindow::onActionDisplayModeChecked);
+    this->m_availableDisplayModeActions.insert(tempAction);
+    this->m_ui->menuDisplay->addAction(tempAction);
+    if (displayMode == DEFAULT_DISPLAY_MODE) {
+        this->setDisplayMode(tempAction);
+    }
+}
+
+void MainWindow::addNewTimestampModeItem(CppSerialPort::TimestampMode timestampMode) {
+    using namespace ApplicationUtilities;
+    QAction *tempAction{new QAction{toStdString(timestampMode).c_str(), this}};
+    tempAction->setProperty(ApplicationStrings::ACTION_INDEX_PROPERTY_TAG, QVariant{0});
+    tempAction->setProperty(ApplicationStrings::TIMESTAMP_MODE_ACTION_KEY, QVariant{static_cast<int>(timestampMode)});
+    tempAction->setCheckable(true);
+    connect(tempAction, &QAction::triggered, this, &MainWindow::onActionTimestampModeChecked);
+    this->m_availableTimestampModeActions.insert(tempAction);
+    this->m_ui->menuDisplay->addAction(tempAction);
+    if (timestampMode == DEFAULT_TIMESTAMP_MODE) {
+        this->setTimestampMode(tempAction);
+    }
+}
+
 template <typename T>
 class TD;
 
 void MainWindow::removeOldPortNameItem(const std::string &str) {
     using namespace ApplicationUtilities;
     using namespace ApplicationStrings;
-    auto actionName = QString::fromStdString(str);
-    auto foundPosition = findInQActionSet(&this->m_availablePortNamesActions, actionName);
+    auto foundPosition = this->findPortNameAction(QString::fromStdString(str));
     if (foundPosition != this->m_availablePortNamesActions.end()) {
         auto foundAction = *foundPosition;
         this->setStatusBarLabelText(QString{SERIAL_PORT_DISCONNECTED_STRING + foundAction->text()});
@@ -322,6 +461,9 @@ void MainWindow::removeOldPortNameItem(const std::string &str) {
             this->m_ui->actionConnect->setEnabled(false);
             this->m_ui->connectButton->setEnabled(false);
             this->m_ui->actionLoadScript->setEnabled(false);
+            this->m_ui->actionSendFile->setEnabled(false);
+            this->m_ui->actionReceiveFile->setEnabled(false);
+            this->m_ui->actionRecordSession->setEnabled(false);
             this->m_ui->sendBox->setEnabled(false);
             this->m_ui->sendButton->setEnabled(false);
         }
@@ -337,6 +479,13 @@ std::unordered_set<QAction *>::iterator MainWindow::findInQActionSet(QActionSet
     return qActionSet->find(&tempAction);
 }
 
+std::unordered_set<QAction *>::iterator MainWindow::findPortNameAction(const QString &portName) {
+    //Port actions may carry a device description in their text, so they are matched on the port name they were made for
+    return std::find_if(this->m_availablePortNamesActions.begin(), this->m_availablePortNamesActions.end(), [&portName](QAction *action) {
+        return action->property(ApplicationStrings::PORT_NAME_ACTION_KEY).toString() == portName;
+    });
+}
+
 void MainWindow::removeOldBaudRateItem(CppSerialPort::BaudRate baudRate) {
     using namespace ApplicationUtilities;
     auto actionName = QString::fromStdString(toStdString(baudRate));
@@ -407,38 +556,713 @@ void MainWindow::removeOldFlowControlItem(CppSerialPort::FlowControl flowControl
     }
 }
 
-void MainWindow::launchSerialReceiveAsync()
+void MainWindow::onSerialDataAvailable()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_serialPortReader) {
+        return;
+    }
+    //Acknowledge before draining so a chunk pushed mid-drain raises a fresh notification instead of being stranded
+    this->m_serialPortReader->acknowledgeNotification();
+    ReceivedChunk chunk{};
+    while (this->m_serialPortReader->tryPop(chunk)) {
+        if ( (this->m_scriptRunner) && (this->m_scriptRunner->isRunning()) ) {
+            this->m_scriptRunner->receive(chunk.data.data(), chunk.data.length());
+        }
+        this->appendPendingChunk(chunk);
+    }
+    this->printPendingLines();
+    if (this->m_serialPortReader->hasError()) {
+        QString errorString{this->m_serialPortReader->errorString().c_str()};
+        try {
+            closeSerialPort();
+        } catch (std::exception &e) {
+            LOG_DEBUG() << e.what();
+        }
+        this->setStatusBarLabelText(QString{SERIAL_PORT_DISCONNECTED_STRING} + errorString);
+        return;
+    }
+    this->updatePartialLineTimer();
+}
+
+void MainWindow::updatePartialLineTimer()
+{
+    if (this->m_pendingReceive.empty()) {
+        this->m_partialLineTimer->stop();
+    } else if (!this->m_partialLineTimer->isActive()) {
+        this->m_partialLineTimer->start();
+    }
+}
+
+void MainWindow::onSerialTransmitEvent()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_serialPortWriter) {
+        return;
+    }
+    this->m_serialPortWriter->acknowledgeNotification();
+    CppSerialPort::TransmitCompletion completion{};
+    while (this->m_serialPortWriter->tryPopCompletion(completion)) {
+        LOG_DEBUG() << "Transmitted message" << completion.sequenceNumber << "(" << completion.bytesWritten << "bytes)";
+    }
+    if (this->m_serialPortWriter->hasError()) {
+        QString errorString{this->m_serialPortWriter->errorString().c_str()};
+        try {
+            closeSerialPort();
+        } catch (std::exception &e) {
+            LOG_DEBUG() << e.what();
+        }
+        this->setStatusBarLabelText(QString{SERIAL_PORT_DISCONNECTED_STRING} + errorString);
+        return;
+    }
+    this->updateTransmitStatus();
+}
+
+void MainWindow::updateTransmitStatus()
+{
+    using namespace ApplicationStrings;
+    size_t queuedBytes{this->m_serialPortWriter ? this->m_serialPortWriter->queuedBytes() : 0};
+    if (queuedBytes == 0) {
+        this->m_transmitStatusLabel->clear();
+    } else if (this->m_serialPortWriter->isStalled()) {
+        this->m_transmitStatusLabel->setText(QString{TRANSMIT_STALLED_STRING}.arg(QString::number(queuedBytes)));
+    } else {
+        this->m_transmitStatusLabel->setText(QString{TRANSMIT_QUEUED_STRING}.arg(QString::number(queuedBytes)));
+    }
+}
+
+void MainWindow::onActionLoadScriptTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    //The same action stops a running script; the runner reports the cancellation through onScriptEvent()
+    if ( (this->m_scriptRunner) && (this->m_scriptRunner->isRunning()) ) {
+        this->m_scriptRunner->stop();
+        return;
+    }
+    if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) || (!this->m_serialPortWriter) ) {
+        this->setStatusBarLabelText(CONNECT_TO_SERIAL_PORT_TO_BEGIN_STRING);
+        return;
+    }
+    QString filePath{QFileDialog::getOpenFileName(this, LOAD_SCRIPT_DIALOG_TITLE_STRING)};
+    if (filePath.isEmpty()) {
+        return;
+    }
+    if (!this->m_scriptRunner) {
+        //Lines go through the same transmit queue as the send box, so a full queue just holds the script back
+        this->m_scriptRunner.reset(new ScriptRunner{[this](const std::string &data) {
+            return this->m_serialPortWriter->enqueue(data) != 0;
+        }, [this]() {
+            emit this->scriptEvent();
+        }});
+    }
+    ScriptOptions scriptOptions{ScriptRunner::defaultOptions()};
+    scriptOptions.lineEnding = this->m_byteStream->lineEnding();
+    try {
+        this->m_scriptRunner->start(filePath.toStdString(), scriptOptions);
+    } catch (std::exception &e) {
+        this->setStatusBarLabelText(QString{SCRIPT_FAILED_STRING}.arg(e.what()));
+        return;
+    }
+    this->m_ui->actionLoadScript->setText(STOP_SCRIPT_STRING);
+    this->setStatusBarLabelText(QString{SCRIPT_STARTED_STRING}.arg(QFileInfo{filePath}.fileName()));
+}
+
+void MainWindow::onScriptEvent()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_scriptRunner) {
+        return;
+    }
+    this->m_scriptRunner->acknowledgeNotification();
+    ScriptProgress progress{this->m_scriptRunner->progress()};
+    QString fileName{QFileInfo{QString::fromStdString(this->m_scriptRunner->filePath())}.fileName()};
+    double kilobytesPerSecond{progress.elapsedSeconds > 0.0 ? static_cast<double>(progress.bytesSent) / progress.elapsedSeconds / 1000.0 : 0.0};
+    uint64_t percentComplete{progress.totalBytes > 0 ? (progress.bytesProcessed * 100) / progress.totalBytes : 100};
+    switch (progress.state) {
+        case ScriptState::Idle:
+            return;
+        case ScriptState::Running:
+            this->setStatusBarLabelText(QString{SCRIPT_PROGRESS_STRING}.arg(fileName, QString::number(percentComplete), QString::number(progress.linesSent), QString::number(kilobytesPerSecond, 'f', 1)));
+            return;
+        case ScriptState::Finished:
+            this->setStatusBarLabelText(QString{SCRIPT_FINISHED_STRING}.arg(fileName, QString::number(progress.linesSent), QString::number(progress.elapsedSeconds, 'f', 1), QString::number(kilobytesPerSecond, 'f', 1)));
+            break;
+        case ScriptState::Cancelled:
+            this->setStatusBarLabelText(QString{SCRIPT_CANCELLED_STRING}.arg(fileName, QString::number(progress.linesSent)));
+            break;
+        case ScriptState::Failed:
+            this->setStatusBarLabelText(QString{SCRIPT_FAILED_STRING}.arg(QString::fromStdString(this->m_scriptRunner->errorString())));
+            break;
+    }
+    this->m_ui->actionLoadScript->setText(LOAD_SCRIPT_STRING);
+}
+
+void MainWindow::stopScriptRunner()
+{
+    if (!this->m_scriptRunner) {
+        return;
+    }
+    //Must happen before the writer goes away, the script thread enqueues into it
+    this->m_scriptRunner->stop();
+    this->m_scriptRunner.reset();
+    this->m_ui->actionLoadScript->setText(ApplicationStrings::LOAD_SCRIPT_STRING);
+}
+
+bool MainWindow::selectTransferProtocol(TransferProtocol *protocol)
+{
+    using namespace ApplicationStrings;
+    QStringList protocolNames{};
+    for (auto availableProtocol : {TransferProtocol::ZModem, TransferProtocol::YModem, TransferProtocol::XModem1K, TransferProtocol::XModem}) {
+        protocolNames.append(QString::fromStdString(FileTransfer::protocolName(availableProtocol)));
+    }
+    bool isAccepted{false};
+    QString protocolName{QInputDialog::getItem(this, TRANSFER_PROTOCOL_DIALOG_TITLE_STRING, TRANSFER_PROTOCOL_LABEL_STRING, protocolNames, 0, false, &isAccepted)};
+    if (!isAccepted) {
+        return false;
+    }
+    *protocol = FileTransfer::parseProtocol(protocolName.toStdString());
+    return true;
+}
+
+void MainWindow::beginFileTransfer(bool isSending)
 {
+    using namespace ApplicationStrings;
+    //The transfer reads and writes the port directly, so nothing else may touch it until it is over
+    this->stopScriptRunner();
+    this->stopSerialPortWriter();
+    this->stopSerialPortReader();
+    if (!this->m_fileTransferSession) {
+        this->m_fileTransferSession.reset(new FileTransferSession{[this]() {
+            emit this->fileTransferEvent();
+        }});
+    }
+    this->m_ui->sendBox->setEnabled(false);
+    this->m_ui->sendButton->setEnabled(false);
+    this->m_ui->actionLoadScript->setEnabled(false);
+    //Whichever action started the transfer is the one that cancels it
+    if (isSending) {
+        this->m_ui->actionSendFile->setText(CANCEL_TRANSFER_STRING);
+        this->m_ui->actionReceiveFile->setEnabled(false);
+    } else {
+        this->m_ui->actionReceiveFile->setText(CANCEL_TRANSFER_STRING);
+        this->m_ui->actionSendFile->setEnabled(false);
+    }
+}
+
+void MainWindow::endFileTransfer()
+{
+    using namespace ApplicationStrings;
+    this->m_ui->actionSendFile->setText(SEND_FILE_STRING);
+    this->m_ui->actionReceiveFile->setText(RECEIVE_FILE_STRING);
     if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) ) {
         return;
     }
+    this->m_ui->sendBox->setEnabled(true);
+    this->m_ui->sendButton->setEnabled(true);
+    this->m_ui->actionLoadScript->setEnabled(true);
+    this->m_ui->actionSendFile->setEnabled(true);
+    this->m_ui->actionReceiveFile->setEnabled(true);
+    this->startSerialPortReader();
+    this->startSerialPortWriter();
+}
+
+void MainWindow::stopFileTransfer()
+{
+    if (!this->m_fileTransferSession) {
+        return;
+    }
+    //Must happen before the port closes, the transfer thread is reading and writing it
+    this->m_fileTransferSession->stop();
+    this->m_fileTransferSession.reset();
+    this->m_ui->actionSendFile->setText(ApplicationStrings::SEND_FILE_STRING);
+    this->m_ui->actionReceiveFile->setText(ApplicationStrings::RECEIVE_FILE_STRING);
+}
+
+void MainWindow::onActionSendFileTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    if ( (this->m_fileTransferSession) && (this->m_fileTransferSession->isRunning()) ) {
+        this->m_fileTransferSession->cancel();
+        return;
+    }
+    if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) ) {
+        this->setStatusBarLabelText(CONNECT_TO_SERIAL_PORT_TO_BEGIN_STRING);
+        return;
+    }
+    QStringList filePaths{QFileDialog::getOpenFileNames(this, SEND_FILE_DIALOG_TITLE_STRING)};
+    TransferProtocol protocol{TransferProtocol::ZModem};
+    if ( (filePaths.isEmpty()) || (!this->selectTransferProtocol(&protocol)) ) {
+        return;
+    }
+    std::vector<std::string> sendFiles{};
+    for (const auto &filePath : filePaths) {
+        sendFiles.push_back(filePath.toStdString());
+    }
+    QString protocolName{QString::fromStdString(FileTransfer::protocolName(protocol))};
+    this->beginFileTransfer(true);
     try {
-        if (!this->m_serialReceiveAsyncHandle) {
-           this->m_serialReceiveAsyncHandle = std::unique_ptr< std::future<std::string> >{new std::future<std::string>{std::async(std::launch::async,
-                                                                                        &MainWindow::checkSerialReceive,
-                                                                                        this)}};
-        }
-        if (this->m_serialReceiveAsyncHandle->wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-            appendReceivedString(this->m_serialReceiveAsyncHandle->get());
-            this->m_serialReceiveAsyncHandle = std::unique_ptr<std::future<std::string>>{new std::future<std::string>{std::async(std::launch::async,
-                                                                                          &MainWindow::checkSerialReceive,
-                                                                                          this)}};
+        this->m_fileTransferSession->startSending(protocol, this->m_byteStream, sendFiles);
+    } catch (std::exception &e) {
+        this->endFileTransfer();
+        this->setStatusBarLabelText(QString{TRANSFER_FAILED_STRING}.arg(protocolName, e.what()));
+        return;
+    }
+    this->setStatusBarLabelText(QString{TRANSFER_WAITING_STRING}.arg(protocolName));
+}
+
+void MainWindow::onActionReceiveFileTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    if ( (this->m_fileTransferSession) && (this->m_fileTransferSession->isRunning()) ) {
+        this->m_fileTransferSession->cancel();
+        return;
+    }
+    if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) ) {
+        this->setStatusBarLabelText(CONNECT_TO_SERIAL_PORT_TO_BEGIN_STRING);
+        return;
+    }
+    TransferProtocol protocol{TransferProtocol::ZModem};
+    if (!this->selectTransferProtocol(&protocol)) {
+        return;
+    }
+    //Plain XMODEM carries no file name, so it needs a file; the batch protocols need a directory
+    bool isSingleFile{(protocol == TransferProtocol::XModem) || (protocol == TransferProtocol::XModem1K)};
+    QString destination{isSingleFile ? QFileDialog::getSaveFileName(this, RECEIVE_FILE_DIALOG_TITLE_STRING) : QFileDialog::getExistingDirectory(this, RECEIVE_DIRECTORY_DIALOG_TITLE_STRING)};
+    if (destination.isEmpty()) {
+        return;
+    }
+    QString protocolName{QString::fromStdString(FileTransfer::protocolName(protocol))};
+    this->beginFileTransfer(false);
+    try {
+        this->m_fileTransferSession->startReceiving(protocol, this->m_byteStream, destination.toStdString());
+    } catch (std::exception &e) {
+        this->endFileTransfer();
+        this->setStatusBarLabelText(QString{TRANSFER_FAILED_STRING}.arg(protocolName, e.what()));
+        return;
+    }
+    this->setStatusBarLabelText(QString{TRANSFER_WAITING_STRING}.arg(protocolName));
+}
+
+void MainWindow::onActionRecordSessionTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    if (this->m_sessionRecorder) {
+        this->stopSessionRecording();
+        return;
+    }
+    if ( (!this->m_byteStream) || (!this->m_byteStream->isOpen()) ) {
+        this->setStatusBarLabelText(CONNECT_TO_SERIAL_PORT_TO_BEGIN_STRING);
+        return;
+    }
+    QString filePath{QFileDialog::getSaveFileName(this, RECORD_SESSION_DIALOG_TITLE_STRING)};
+    if (filePath.isEmpty()) {
+        return;
+    }
+    std::shared_ptr<SessionRecorder> sessionRecorder{std::make_shared<SessionRecorder>()};
+    try {
+        sessionRecorder->start(filePath.toStdString());
+    } catch (std::exception &e) {
+        this->setStatusBarLabelText(QString{RECORDING_FAILED_STRING}.arg(filePath, e.what()));
+        return;
+    }
+    //Recorded from the port itself, so scripts and file transfers are captured along with the terminal traffic
+    this->m_byteStream->setRecorder(sessionRecorder);
+    this->m_sessionRecorder = sessionRecorder;
+    this->m_ui->actionRecordSession->setText(STOP_RECORDING_STRING);
+    this->setStatusBarLabelText(QString{RECORDING_STARTED_STRING}.arg(filePath));
+}
+
+void MainWindow::stopSessionRecording()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_sessionRecorder) {
+        return;
+    }
+    this->m_byteStream->setRecorder(nullptr);
+    this->m_sessionRecorder->stop();
+    QString filePath{QString::fromStdString(this->m_sessionRecorder->filePath())};
+    QString recordedBytes{QString::number(this->m_sessionRecorder->recordedBytes())};
+    if (this->m_sessionRecorder->hasError()) {
+        this->setStatusBarLabelText(QString{RECORDING_FAILED_STRING}.arg(filePath, QString::fromStdString(this->m_sessionRecorder->errorString())));
+    } else if (this->m_sessionRecorder->droppedRecords() > 0) {
+        this->setStatusBarLabelText(QString{RECORDING_DROPPED_STRING}.arg(recordedBytes, filePath, QString::number(this->m_sessionRecorder->droppedRecords())));
+    } else {
+        this->setStatusBarLabelText(QString{RECORDING_STOPPED_STRING}.arg(recordedBytes, filePath));
+    }
+    this->m_sessionRecorder.reset();
+    this->m_ui->actionRecordSession->setText(RECORD_SESSION_STRING);
+}
+
+void MainWindow::onActionReplaySessionTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    if ( (this->m_sessionReplayer) && (this->m_sessionReplayer->isRunning()) ) {
+        this->m_sessionReplayer->stop();
+        return;
+    }
+    //Live traffic would interleave with the replay in the same terminal
+    if ( (this->m_byteStream) && (this->m_byteStream->isOpen()) ) {
+        this->setStatusBarLabelText(DISCONNECT_TO_REPLAY_STRING);
+        return;
+    }
+    QString filePath{QFileDialog::getOpenFileName(this, REPLAY_SESSION_DIALOG_TITLE_STRING)};
+    if (filePath.isEmpty()) {
+        return;
+    }
+    bool isAccepted{false};
+    QString modeName{QInputDialog::getItem(this, REPLAY_MODE_DIALOG_TITLE_STRING, REPLAY_MODE_LABEL_STRING, QStringList{REPLAY_MODE_TIMED_STRING, REPLAY_MODE_MAXIMUM_SPEED_STRING}, 0, false, &isAccepted)};
+    if (!isAccepted) {
+        return;
+    }
+    ReplayOptions replayOptions{SessionReplayer::defaultOptions()};
+    if (modeName == REPLAY_MODE_MAXIMUM_SPEED_STRING) {
+        replayOptions.mode = ReplayMode::MaximumSpeed;
+    }
+    if (!this->m_sessionReplayer) {
+        //Runs on the replay thread; the chunks then take the same path through printPendingLines() as live traffic
+        this->m_sessionReplayer.reset(new SessionReplayer{[this](const char *data, size_t size) -> bool {
+            //Stamped as it is played back; with the original timing that keeps the gaps between lines
+            if (!this->m_replayQueue.tryPush(ReceivedChunk{std::string{data, size}, IByteStream::currentTimestamp(true)})) {
+                return false;
+            }
+            if (!this->m_replayNotificationPending.exchange(true)) {
+                emit this->replayDataAvailable();
+            }
+            return true;
+        }, [this]() {
+            emit this->replayEvent();
+        }});
+    }
+    this->m_terminalRenderer->clear();
+    this->m_peakLinesCoalesced = 0;
+    this->m_renderStatisticsLabel->clear();
+    this->clearPending();
+    this->m_receivedOffset = 0;
+    this->updateCharacterDuration();
+    this->m_replayNotificationPending = false;
+    try {
+        this->m_sessionReplayer->start(filePath.toStdString(), replayOptions);
+    } catch (std::exception &e) {
+        this->setStatusBarLabelText(QString{REPLAY_FAILED_STRING}.arg(QFileInfo{filePath}.fileName(), e.what()));
+        return;
+    }
+    this->m_replayStartTime = std::chrono::steady_clock::now();
+    this->m_ui->actionReplaySession->setText(STOP_REPLAY_STRING);
+}
+
+void MainWindow::onReplayDataAvailable()
+{
+    //Cleared before draining so a chunk pushed mid-drain raises a fresh notification
+    this->m_replayNotificationPending = false;
+    ReceivedChunk chunk{};
+    while (this->m_replayQueue.tryPop(chunk)) {
+        this->appendPendingChunk(chunk);
+    }
+    this->printPendingLines();
+    this->updatePartialLineTimer();
+}
+
+void MainWindow::onReplayEvent()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_sessionReplayer) {
+        return;
+    }
+    this->m_sessionReplayer->acknowledgeNotification();
+    ReplayProgress progress{this->m_sessionReplayer->progress()};
+    QString fileName{QFileInfo{QString::fromStdString(this->m_sessionReplayer->filePath())}.fileName()};
+    switch (progress.state) {
+        case ReplayState::Idle:
+            return;
+        case ReplayState::Running:
+            this->setStatusBarLabelText(QString{REPLAY_PROGRESS_STRING}.arg(fileName, QString::number(progress.bytesProcessed), QString::number(progress.totalBytes)));
+            return;
+        case ReplayState::Finished: {
+            //The rate covers the terminal as well, so only stop the clock once everything queued has been displayed
+            this->onReplayDataAvailable();
+            double elapsedSeconds{std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_replayStartTime).count()};
+            double megabytesPerSecond{elapsedSeconds > 0.0 ? static_cast<double>(progress.bytesReplayed) / elapsedSeconds / 1000000.0 : 0.0};
+            this->setStatusBarLabelText(QString{REPLAY_FINISHED_STRING}.arg(QString::number(progress.bytesReplayed), QString::number(elapsedSeconds, 'f', 3), QString::number(megabytesPerSecond, 'f', 1)));
+            break;
         }
+        case ReplayState::Cancelled:
+            this->onReplayDataAvailable();
+            this->setStatusBarLabelText(QString{REPLAY_CANCELLED_STRING}.arg(fileName));
+            break;
+        case ReplayState::Failed:
+            this->onReplayDataAvailable();
+            this->setStatusBarLabelText(QString{REPLAY_FAILED_STRING}.arg(fileName, QString::fromStdString(this->m_sessionReplayer->errorString())));
+            break;
+    }
+    this->m_ui->actionReplaySession->setText(REPLAY_SESSION_STRING);
+}
+
+void MainWindow::onActionOpenCaptureTriggered(bool checked)
+{
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    QString filePath{QFileDialog::getOpenFileName(this, OPEN_CAPTURE_DIALOG_TITLE_STRING)};
+    if (filePath.isEmpty()) {
+        return;
+    }
+    if (!this->m_captureViewer) {
+        this->m_captureViewer.reset(new CaptureViewer{});
+        this->m_captureViewer->setWindowIcon(applicationIcons->MAIN_WINDOW_ICON);
+        this->m_captureViewer->resize(this->size());
+    }
+    try {
+        this->m_captureViewer->openCapture(filePath);
     } catch (std::exception &e) {
-        std::cout << e.what() << std::endl;
+        this->setStatusBarLabelText(QString{OPEN_CAPTURE_FAILED_STRING}.arg(QFileInfo{filePath}.fileName(), e.what()));
+        return;
     }
+    this->m_captureViewer->show();
+    this->m_captureViewer->raise();
+    this->m_captureViewer->activateWindow();
 }
 
-std::string MainWindow::checkSerialReceive()
+void MainWindow::onActionMonitorPortsTriggered(bool checked)
 {
-    if (this->m_byteStream) {
-        bool timeout{false};
-        std::string returnString{this->m_byteStream->readLine(&timeout)};
-        if (!returnString.empty()) {
-            return returnString;
+    using namespace ApplicationStrings;
+    Q_UNUSED(checked);
+    //The port this window is connected to, and any already being monitored, cannot be opened a second time
+    QStringList portNames{};
+    for (const auto &it : this->m_deviceMonitor->serialPorts()) {
+        bool isConnected{(this->m_byteStream) && (this->m_byteStream->isOpen()) && (this->m_byteStream->portName() == it)};
+        bool isMonitored{(this->m_portSessionsWindow) && (this->m_portSessionsWindow->isMonitoring(it))};
+        if ( (!isConnected) && (!isMonitored) ) {
+            portNames.append(QString::fromStdString(it));
         }
     }
-    return "";
+    if (portNames.isEmpty()) {
+        this->setStatusBarLabelText(NO_PORTS_TO_MONITOR_STRING);
+        return;
+    }
+    portNames.sort();
+    QStringList selectedPorts{PortSessionsWindow::selectPorts(this, portNames)};
+    if (selectedPorts.isEmpty()) {
+        return;
+    }
+    if (!this->m_portSessionsWindow) {
+        this->m_portSessionsWindow.reset(new PortSessionsWindow{});
+        this->m_portSessionsWindow->setWindowIcon(applicationIcons->MAIN_WINDOW_ICON);
+        this->m_portSessionsWindow->resize(this->size());
+    }
+    //Every monitored port is opened with the settings currently checked in the menus
+    this->m_portSessionsWindow->setDisplayMode(this->m_displayMode, this->m_timestampMode);
+    for (const auto &it : selectedPorts) {
+        try {
+            this->m_portSessionsWindow->openPort(it.toStdString(), this->getSelectedBaudRate(), this->getSelectedDataBits(), this->getSelectedStopBits(), this->getSelectedParity(), this->getSelectedFlowControl());
+        } catch (std::exception &e) {
+            this->setStatusBarLabelText(QString{MONITOR_PORT_FAILED_STRING}.arg(it, e.what()));
+        }
+    }
+    this->m_portSessionsWindow->show();
+    this->m_portSessionsWindow->raise();
+    this->m_portSessionsWindow->activateWindow();
+}
+
+void MainWindow::stopSessionReplay()
+{
+    if (!this->m_sessionReplayer) {
+        return;
+    }
+    this->m_sessionReplayer->stop();
+    this->m_sessionReplayer.reset();
+    ReceivedChunk chunk{};
+    while (this->m_replayQueue.tryPop(chunk)) {
+    }
+    this->m_replayNotificationPending = false;
+    this->clearPending();
+    this->m_ui->actionReplaySession->setText(ApplicationStrings::REPLAY_SESSION_STRING);
+}
+
+void MainWindow::onFileTransferEvent()
+{
+    using namespace ApplicationStrings;
+    if (!this->m_fileTransferSession) {
+        return;
+    }
+    this->m_fileTransferSession->acknowledgeNotification();
+    TransferProgress progress{this->m_fileTransferSession->progress()};
+    QString protocolName{QString::fromStdString(FileTransfer::protocolName(this->m_fileTransferSession->protocol()))};
+    double kilobytesPerSecond{progress.elapsedSeconds > 0.0 ? static_cast<double>(progress.totalBytesTransferred) / progress.elapsedSeconds / 1000.0 : 0.0};
+    switch (this->m_fileTransferSession->state()) {
+        case TransferState::Idle:
+            return;
+        case TransferState::Running:
+            if (progress.fileName.empty()) {
+                this->setStatusBarLabelText(QString{TRANSFER_WAITING_STRING}.arg(protocolName));
+            } else {
+                this->setStatusBarLabelText(QString{TRANSFER_PROGRESS_STRING}.arg(protocolName, QString::fromStdString(progress.fileName), QString::number(progress.fileBytesTransferred),
+                                                                                   QString::number(progress.fileSize), QString::number(kilobytesPerSecond, 'f', 1), QString::number(progress.errorCount)));
+            }
+            return;
+        case TransferState::Finished:
+            this->setStatusBarLabelText(QString{TRANSFER_FINISHED_STRING}.arg(protocolName, QString::number(progress.filesCompleted), QString::number(progress.totalBytesTransferred),
+                                                                               QString::number(progress.elapsedSeconds, 'f', 1), QString::number(kilobytesPerSecond, 'f', 1)));
+            break;
+        case TransferState::Cancelled:
+            this->setStatusBarLabelText(QString{TRANSFER_CANCELLED_STRING}.arg(protocolName));
+            break;
+        case TransferState::Failed:
+            this->setStatusBarLabelText(QString{TRANSFER_FAILED_STRING}.arg(protocolName, QString::fromStdString(this->m_fileTransferSession->errorString())));
+            break;
+    }
+    this->endFileTransfer();
+}
+
+void MainWindow::onPartialLineTimeout()
+{
+    //Nothing has completed the current line within the read timeout, so show what has arrived so far
+    if (this->m_displayMode == CppSerialPort::DisplayMode::Hex) {
+        this->printHexRows(true);
+        return;
+    }
+    this->appendReceivedString(this->m_pendingReceive, this->pendingTimestamp(0));
+    this->clearPending();
+}
+
+void MainWindow::onTerminalFlushed(int linesCoalesced)
+{
+    using namespace ApplicationStrings;
+    this->m_peakLinesCoalesced = std::max(this->m_peakLinesCoalesced, linesCoalesced);
+    this->m_renderStatisticsLabel->setText(QString{LINES_PER_FLUSH_STRING}.arg(QString::number(linesCoalesced), QString::number(this->m_peakLinesCoalesced)));
+}
+
+void MainWindow::printPendingLines()
+{
+    if (this->m_displayMode == CppSerialPort::DisplayMode::Hex) {
+        this->printHexRows(false);
+        return;
+    }
+    std::string lineEnding{this->unescapeLineEnding(this->m_lineEnding)};
+    size_t lineStart{0};
+    size_t foundPosition{this->m_pendingReceive.find(lineEnding)};
+    while (foundPosition != std::string::npos) {
+        size_t lineEnd{foundPosition + lineEnding.length()};
+        this->appendReceivedString(this->m_pendingReceive.substr(lineStart, lineEnd - lineStart), this->pendingTimestamp(lineStart));
+        lineStart = lineEnd;
+        foundPosition = this->m_pendingReceive.find(lineEnding, lineStart);
+    }
+    this->consumePending(lineStart);
+}
+
+void MainWindow::printHexRows(bool includePartialRow)
+{
+    using namespace ApplicationStrings;
+    //Rows ignore line endings and follow the byte count instead, so the offset column lines up across reads
+    const size_t rowSize{ByteFormatter::HEX_DUMP_BYTES_PER_LINE};
+    size_t rowStart{0};
+    while ( (rowStart < this->m_pendingReceive.size()) && ((includePartialRow) || (this->m_pendingReceive.size() - rowStart >= rowSize)) ) {
+        size_t rowLength{std::min(rowSize, this->m_pendingReceive.size() - rowStart)};
+        std::string line{TERMINAL_RECEIVE_BASE_STRING};
+        ByteFormatter::appendTimestamp(this->pendingTimestamp(rowStart), this->m_timestampMode, &line);
+        ByteFormatter::appendHexDumpLine(this->m_receivedOffset, this->m_pendingReceive.data() + rowStart, rowLength, &line);
+        this->m_terminalRenderer->appendLine(std::move(line), LineKind::Received);
+        this->m_receivedOffset += rowLength;
+        rowStart += rowLength;
+    }
+    this->consumePending(rowStart);
+}
+
+void MainWindow::appendPendingChunk(const CppSerialPort::ReceivedChunk &chunk)
+{
+    this->m_pendingReceive += chunk.data;
+    this->m_pendingReadEnds.emplace_back(this->m_pendingReceive.size(), chunk.timestamp);
+}
+
+void MainWindow::consumePending(size_t byteCount)
+{
+    this->m_pendingReceive.erase(0, byteCount);
+    while ( (!this->m_pendingReadEnds.empty()) && (this->m_pendingReadEnds.front().first <= byteCount) ) {
+        this->m_pendingReadEnds.pop_front();
+    }
+    for (auto &it : this->m_pendingReadEnds) {
+        it.first -= byteCount;
+    }
+}
+
+void MainWindow::clearPending()
+{
+    this->m_pendingReceive.clear();
+    this->m_pendingReadEnds.clear();
+}
+
+CppSerialPort::ReadTimestamp MainWindow::pendingTimestamp(size_t offset) const
+{
+    //A flood queues up many reads at once, so the one holding offset is found by bisection rather than a walk per line
+    auto readEnd = std::upper_bound(this->m_pendingReadEnds.begin(), this->m_pendingReadEnds.end(), offset, [](size_t value, const std::pair<size_t, ReadTimestamp> &entry) {
+        return value < entry.first;
+    });
+    if (readEnd == this->m_pendingReadEnds.end()) {
+        return ReadTimestamp{0, 0};
+    }
+    if (!this->m_interpolateTimestamps) {
+        return readEnd->second;
+    }
+    return IByteStream::interpolateTimestamp(readEnd->second, readEnd->first - 1 - offset, this->m_characterDuration);
+}
+
+void MainWindow::updateCharacterDuration()
+{
+    using namespace ApplicationUtilities;
+    //A replay has no port of its own, so it is timed at whatever the menus are set to
+    CppSerialPort::BaudRate baudRate{this->m_byteStream ? this->m_byteStream->baudRate() : this->getSelectedBaudRate()};
+    CppSerialPort::DataBits dataBits{this->m_byteStream ? this->m_byteStream->dataBits() : this->getSelectedDataBits()};
+    CppSerialPort::Parity parity{this->m_byteStream ? this->m_byteStream->parity() : this->getSelectedParity()};
+    CppSerialPort::StopBits stopBits{this->m_byteStream ? this->m_byteStream->stopBits() : this->getSelectedStopBits()};
+    this->m_characterDuration = SerialPort::characterDuration(static_cast<unsigned>(std::stoul(baudRateToString(baudRate))), dataBits, parity, stopBits);
+}
+
+void MainWindow::startSerialPortReader()
+{
+    this->stopSerialPortReader();
+    this->m_serialPortReader.reset(new SerialPortReader{this->m_byteStream, [this]() {
+        emit this->serialDataAvailable();
+    }});
+    this->m_serialPortReader->start();
+}
+
+void MainWindow::stopSerialPortReader()
+{
+    if (!this->m_serialPortReader) {
+        return;
+    }
+    this->m_serialPortReader->stop();
+    ReceivedChunk chunk{};
+    while (this->m_serialPortReader->tryPop(chunk)) {
+        this->appendPendingChunk(chunk);
+    }
+    this->m_serialPortReader.reset();
+    this->printPendingLines();
+    this->m_partialLineTimer->stop();
+    this->onPartialLineTimeout();
+}
+
+void MainWindow::startSerialPortWriter()
+{
+    this->stopSerialPortWriter();
+    this->m_serialPortWriter.reset(new SerialPortWriter{this->m_byteStream, [this]() {
+        emit this->serialTransmitEvent();
+    }});
+    this->m_serialPortWriter->start();
+}
+
+void MainWindow::stopSerialPortWriter()
+{
+    if (!this->m_serialPortWriter) {
+        return;
+    }
+    //Anything still queued is discarded; the port is about to close underneath it
+    this->m_serialPortWriter->stop();
+    this->m_serialPortWriter.reset();
+    this->m_transmitStatusLabel->clear();
 }
 
 void MainWindow::resetCommandHistory()
@@ -481,6 +1305,15 @@ void MainWindow::onSendButtonClicked()
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     Q_UNUSED(event);
+    //A capture viewer or port sessions window left open would otherwise keep the application running
+    if (this->m_captureViewer) {
+        this->m_captureViewer->close();
+    }
+    if (this->m_portSessionsWindow) {
+        this->m_portSessionsWindow->close();
+        //Destroying it joins the reactor threads and closes the monitored ports
+        this->m_portSessionsWindow.reset();
+    }
     event->accept();
     /*
     using namespace ApplicationStrings;
@@ -533,6 +1366,18 @@ void MainWindow::setupAdditionalUiComponents()
         this->addNewLineEndingItem(it);
     }
 
+    this->addNewDisplayModeItem(CppSerialPort::DisplayMode::Text);
+    this->addNewDisplayModeItem(CppSerialPort::DisplayMode::Escaped);
+    this->addNewDisplayModeItem(CppSerialPort::DisplayMode::Hex);
+    this->m_ui->menuDisplay->addSeparator();
+    this->addNewTimestampModeItem(CppSerialPort::TimestampMode::None);
+    this->addNewTimestampModeItem(CppSerialPort::TimestampMode::Monotonic);
+    this->addNewTimestampModeItem(CppSerialPort::TimestampMode::Realtime);
+    QAction *interpolateTimestampsAction{new QAction{INTERPOLATE_TIMESTAMPS_STRING, this}};
+    interpolateTimestampsAction->setCheckable(true);
+    connect(interpolateTimestampsAction, &QAction::toggled, this, &MainWindow::onActionInterpolateTimestampsToggled);
+    this->m_ui->menuDisplay->addAction(interpolateTimestampsAction);
+
     this->addNewDataBitsItem(CppSerialPort::DataBits::DataFive);
     this->addNewDataBitsItem(CppSerialPort::DataBits::DataSix);
     this->addNewDataBitsItem(CppSerialPort::DataBits::DataSeven);
@@ -603,16 +1448,18 @@ void MainWindow::setupAdditionalUiComponents()
     this->addNewFlowControlItem(CppSerialPort::FlowControl::FlowHardware);
     this->addNewFlowControlItem(CppSerialPort::FlowControl::FlowXonXoff);
 
-    for (auto &it : CppSerialPort::SerialPort::availableSerialPorts()) {
+    //Port entries carry their /dev/serial/by-id path as a tooltip
+    this->m_ui->menuPortNames->setToolTipsVisible(true);
+    for (auto &it : this->m_deviceMonitor->serialPorts()) {
         this->addNewPortNameItem(it);
     }
 
     if (!this->m_availablePortNamesActions.empty()) {
 #if defined(_WIN32)
-        auto foundPosition = findInQActionSet(&this->m_availablePortNamesActions, "COM1");
+        auto foundPosition = this->findPortNameAction("COM1");
 #else
-        auto foundUSB = findInQActionSet(&this->m_availablePortNamesActions, "/dev/ttyUSB0");
-        auto foundACM = findInQActionSet(&this->m_availablePortNamesActions, "/dev/ttyACM0");
+        auto foundUSB = this->findPortNameAction("/dev/ttyUSB0");
+        auto foundACM = this->findPortNameAction("/dev/ttyACM0");
         auto foundPosition = foundACM != this->m_availablePortNamesActions.end() ? foundACM : foundUSB;
 
 #endif //defined(_WIN32)
@@ -709,7 +1556,41 @@ void MainWindow::setLineEnding(QAction *action) {
     }
     this->setLineEnding(action->text().toStdString());
     if (this->m_byteStream) {
-        this->m_byteStream->setLineEnding(this->m_lineEnding);
+        this->m_byteStream->setLineEnding(this->unescapeLineEnding(this->m_lineEnding));
+    }
+}
+
+void MainWindow::setDisplayMode(QAction *action) {
+    for (auto &it : this->m_availableDisplayModeActions) {
+        if (it == action) {
+            action->setChecked(true);
+        } else {
+            it->setChecked(false);
+        }
+    }
+    auto displayMode = static_cast<CppSerialPort::DisplayMode>(action->property(ApplicationStrings::DISPLAY_MODE_ACTION_KEY).toInt(nullptr));
+    if (displayMode == this->m_displayMode) {
+        return;
+    }
+    //Whatever is still waiting for a line ending (or a full hex row) is shown the old way before switching
+    this->onPartialLineTimeout();
+    this->m_partialLineTimer->stop();
+    this->m_displayMode = displayMode;
+    this->m_receivedOffset = 0;
+}
+
+void MainWindow::setTimestampMode(QAction *action) {
+    for (auto &it : this->m_availableTimestampModeActions) {
+        if (it == action) {
+            action->setChecked(true);
+        } else {
+            it->setChecked(false);
+        }
+    }
+    this->m_timestampMode = static_cast<CppSerialPort::TimestampMode>(action->property(ApplicationStrings::TIMESTAMP_MODE_ACTION_KEY).toInt(nullptr));
+    //The wall clock is only read alongside the monotonic one while something is going to show it
+    if (this->m_byteStream) {
+        this->m_byteStream->setRealtimeTimestamps(this->m_timestampMode == CppSerialPort::TimestampMode::Realtime);
     }
 }
 
@@ -753,6 +1634,20 @@ void MainWindow::onActionLineEndingsChecked(bool checked) {
     this->setLineEnding(dynamic_cast<QAction *>(QObject::sender()));
 }
 
+void MainWindow::onActionDisplayModeChecked(bool checked) {
+    Q_UNUSED(checked);
+    this->setDisplayMode(dynamic_cast<QAction *>(QObject::sender()));
+}
+
+void MainWindow::onActionTimestampModeChecked(bool checked) {
+    Q_UNUSED(checked);
+    this->setTimestampMode(dynamic_cast<QAction *>(QObject::sender()));
+}
+
+void MainWindow::onActionInterpolateTimestampsToggled(bool checked) {
+    this->m_interpolateTimestamps = checked;
+}
+
 void MainWindow::onActionPortNamesChecked(bool checked) {
     Q_UNUSED(checked);
     this->setPortName(dynamic_cast<QAction *>(QObject::sender()));
@@ -880,19 +1775,27 @@ void MainWindow::openSerialPort()
 {
     using namespace ApplicationStrings;
 
+    this->stopSessionReplay();
     try {
         this->m_byteStream->openPort();
-        this->m_ui->terminal->clear();
+        this->m_terminalRenderer->clear();
+        this->m_peakLinesCoalesced = 0;
+        this->m_renderStatisticsLabel->clear();
         this->m_ui->connectButton->setChecked(true);
         this->m_ui->sendButton->setEnabled(true);
         this->m_ui->actionDisconnect->setEnabled(true);
         this->m_ui->sendBox->setEnabled(true);
         this->m_ui->sendBox->setToolTip(SEND_BOX_ENABLED_TOOLTIP);
         this->m_ui->actionLoadScript->setEnabled(true);
+        this->m_ui->actionSendFile->setEnabled(true);
+        this->m_ui->actionReceiveFile->setEnabled(true);
+        this->m_ui->actionRecordSession->setEnabled(true);
         this->m_ui->sendBox->setFocus();
         this->setStatusBarLabelText(QString{SUCCESSFULLY_OPENED_SERIAL_PORT_STRING} + this->m_byteStream->portName().c_str());
         this->m_byteStream->setReadTimeout(MainWindow::SERIAL_READ_TIMEOUT);
-        this->m_byteStream->setLineEnding(this->m_lineEnding);
+        this->m_byteStream->setLineEnding(this->unescapeLineEnding(this->m_lineEnding));
+        this->m_byteStream->setRealtimeTimestamps(this->m_timestampMode == CppSerialPort::TimestampMode::Realtime);
+        this->updateCharacterDuration();
         beginCommunication();
     } catch (std::exception &e) {
         std::unique_ptr<QMessageBox> warningBox{new QMessageBox{}};
@@ -909,12 +1812,20 @@ void MainWindow::openSerialPort()
 void MainWindow::closeSerialPort()
 {
     using namespace ApplicationStrings;
+    this->stopFileTransfer();
+    this->stopScriptRunner();
+    this->stopSerialPortWriter();
+    this->stopSerialPortReader();
+    this->stopSessionRecording();
     this->m_byteStream->closePort();
     this->m_ui->connectButton->setChecked(false);
     this->m_ui->actionDisconnect->setEnabled(false);
     this->m_ui->sendBox->setEnabled(false);
     this->m_ui->sendBox->setToolTip(SEND_BOX_DISABLED_TOOLTIP);
     this->m_ui->actionLoadScript->setEnabled(false);
+    this->m_ui->actionSendFile->setEnabled(false);
+    this->m_ui->actionReceiveFile->setEnabled(false);
+    this->m_ui->actionRecordSession->setEnabled(false);
     this->setStatusBarLabelText(QString{SUCCESSFULLY_CLOSED_SERIAL_PORT_STRING} + this->m_byteStream->portName().c_str());
     this->setWindowTitle(MAIN_WINDOW_TITLE);
 }
@@ -931,7 +1842,8 @@ void MainWindow::beginCommunication()
             }
             this->setWindowTitle(this->windowTitle() + " - " + this->m_byteStream->portName().c_str());
             this->setStatusBarLabelText(QString{SUCCESSFULLY_OPENED_SERIAL_PORT_STRING} + this->m_byteStream->portName().c_str());
-            this->m_checkSerialPortReceiveTimer->start();
+            this->startSerialPortReader();
+            this->startSerialPortWriter();
         } catch (std::exception &e) {
             std::unique_ptr<QMessageBox> warningBox{new QMessageBox{}};
             warningBox->setText(QString{INVALID_SETTINGS_DETECTED_STRING} + e.what());
@@ -963,7 +1875,6 @@ void MainWindow::pauseCommunication()
 void MainWindow::stopCommunication()
 {
     using namespace ApplicationStrings;
-    this->m_checkSerialPortReceiveTimer->stop();
     if (this->m_byteStream) {
         closeSerialPort();
     }
@@ -976,33 +1887,44 @@ void MainWindow::onActionDisconnectTriggered(bool checked)
     if (this->m_byteStream) {
         closeSerialPort();
         this->m_ui->connectButton->setChecked(false);
-        LOG_DEBUG() << QString{"Waiting for async read of serial port %1 to finish..."}.arg(this->m_byteStream->portName().c_str());
-        while (this->m_serialReceiveAsyncHandle->wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
-            std::this_thread::yield();
-        }
-        LOG_DEBUG() << "Completed, resetting serial port shared_ptr";
         this->m_byteStream.reset();
     }
 }
 
-void MainWindow::printRxResult(const std::string &str)
+void MainWindow::printRxResult(const std::string &str, const CppSerialPort::ReadTimestamp &timestamp)
 {
     using namespace ApplicationStrings;
     using namespace ApplicationUtilities;
-    if (!str.empty()) {
-        std::lock_guard<std::mutex> ioLock{this->m_printToTerminalMutex};
-        this->m_ui->terminal->setTextColor(QColor(RED_COLOR_STRING));
-        this->m_ui->terminal->append(QString{"%1%2"}.arg(TERMINAL_RECEIVE_BASE_STRING, stripLineEndings(str).c_str()));
+    if (str.empty()) {
+        return;
+    }
+    //Built as UTF-8 bytes, which is what the terminal stores, so no QString is made per line
+    std::string line{TERMINAL_RECEIVE_BASE_STRING};
+    ByteFormatter::appendTimestamp(timestamp, this->m_timestampMode, &line);
+    if (this->m_displayMode == CppSerialPort::DisplayMode::Escaped) {
+        //The line ending stays in, escaped like everything else that is not printable
+        ByteFormatter::appendEscaped(str.data(), str.length(), &line);
+    } else {
+        std::string stripped{stripLineEndings(str)};
+        line.reserve(line.length() + stripped.length());
+        size_t segmentStart{0};
+        size_t nulPosition{stripped.find('\0')};
+        while (nulPosition != std::string::npos) {
+            line.append(stripped, segmentStart, nulPosition - segmentStart);
+            line.append(NUL_DISPLAY_UTF8_STRING);
+            segmentStart = nulPosition + 1;
+            nulPosition = stripped.find('\0', segmentStart);
+        }
+        line.append(stripped, segmentStart, std::string::npos);
     }
+    this->m_terminalRenderer->appendLine(std::move(line), LineKind::Received);
 }
 
 void MainWindow::printTxResult(const std::string &str)
 {
     using namespace ApplicationStrings;
     using namespace ApplicationUtilities;
-    std::lock_guard<std::mutex> ioLock{this->m_printToTerminalMutex};
-    this->m_ui->terminal->setTextColor(QColor(BLUE_COLOR_STRING));
-    this->m_ui->terminal->append(QString{"%1%2"}.arg(TERMINAL_TRANSMIT_BASE_STRING, str.c_str()));
+    this->m_terminalRenderer->appendLine(TERMINAL_TRANSMIT_BASE_STRING + str, LineKind::Transmitted);
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *qke)
@@ -1029,6 +1951,8 @@ void MainWindow::keyPressEvent(QKeyEvent *qke)
             this->onCtrlGPressed();
         } else if ((qke->key() == Qt::Key_C) && (qke->modifiers().testFlag(Qt::ControlModifier))) {
             this->onCtrlCPressed();
+        } else if ((qke->key() == Qt::Key_F) && (qke->modifiers().testFlag(Qt::ControlModifier))) {
+            this->onCtrlFPressed();
         }
         else {
             return QWidget::keyPressEvent(qke);
@@ -1066,7 +1990,9 @@ void MainWindow::onDownArrowPressed()
 
 void MainWindow::onEscapeKeyPressed()
 {
-
+    if (this->m_ui->searchBar->isVisible()) {
+        this->m_ui->searchBar->dismiss();
+    }
 }
 
 void MainWindow::onAltKeyPressed()
@@ -1091,7 +2017,8 @@ void MainWindow::onCtrlUPressed()
 
 void MainWindow::onCtrlGPressed()
 {
-    this->m_ui->terminal->clear();
+    this->m_terminalRenderer->clear();
+    this->m_receivedOffset = 0;
 }
 
 void MainWindow::onCtrlCPressed()
@@ -1099,6 +2026,11 @@ void MainWindow::onCtrlCPressed()
     using namespace ApplicationStrings;
 }
 
+void MainWindow::onCtrlFPressed()
+{
+    this->m_ui->searchBar->activate();
+}
+
 void MainWindow::onConnectButtonClicked(bool checked)
 {
     if ((this->m_ui->connectButton->isChecked()) || (checked)) {
@@ -1134,5 +2066,8 @@ bool MainWindow::eventFilter(QObject *sender, QEvent *event) {
 }
 
 MainWindow::~MainWindow() {
+    //The worker threads post events to this window, so they are stopped while it is still whole
+    this->stopSessionReplay();
+    this->stopCommunication();
     delete this->m_ui;
 }
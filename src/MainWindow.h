@@ -9,13 +9,26 @@
 #include <chrono>
 #include <functional>
 #include <list>
-#include <future>
 #include <memory>
+#include <atomic>
+#include <deque>
 #include <QLabel>
 #include <QTimer>
 
 #include "IByteStream.h"
 #include "SerialPort.h"
+#include "SerialPortReader.h"
+#include "SerialPortWriter.h"
+#include "ScriptRunner.h"
+#include "FileTransferSession.h"
+#include "SessionRecorder.h"
+#include "SessionReplayer.h"
+#include "ByteFormatter.h"
+#include "CaptureViewer.h"
+#include "PortSessionsWindow.h"
+#include "DeviceMonitor.h"
+#include "SpscQueue.h"
+#include "TerminalRenderer.h"
 #include "AboutApplicationWidget.h"
 #include "QActionSetDefs.h"
 #include <QAction>
@@ -44,11 +57,40 @@ public:
     void closeEvent(QCloseEvent *event) override;
 
     void keyPressEvent(QKeyEvent *qke) override;
+
+    void setScrollbackLimit(size_t maxLines, size_t maxBytes);
+    void setScrollbackSpillFile(const std::string &filePath);
+
+    static const size_t SCROLLBACK_LINE_LIMIT;
+    static const size_t SCROLLBACK_BYTE_LIMIT;
+signals:
+    void serialDataAvailable();
+    void serialTransmitEvent();
+    void scriptEvent();
+    void fileTransferEvent();
+    void replayEvent();
+    void replayDataAvailable();
+
 private slots:
-    void launchSerialReceiveAsync();
-    void checkDisconnectedSerialPorts();
+    void onSerialDataAvailable();
+    void onSerialTransmitEvent();
+    void onScriptEvent();
+    void onFileTransferEvent();
+    void onReplayEvent();
+    void onReplayDataAvailable();
+    void onPartialLineTimeout();
+    void onTerminalFlushed(int linesCoalesced);
+    void onSerialPortAdded(const QString &portName);
+    void onSerialPortRemoved(const QString &portName);
     void onActionConnectTriggered(bool checked);
     void onActionDisconnectTriggered(bool checked);
+    void onActionLoadScriptTriggered(bool checked);
+    void onActionSendFileTriggered(bool checked);
+    void onActionReceiveFileTriggered(bool checked);
+    void onActionRecordSessionTriggered(bool checked);
+    void onActionReplaySessionTriggered(bool checked);
+    void onActionOpenCaptureTriggered(bool checked);
+    void onActionMonitorPortsTriggered(bool checked);
     void onCommandHistoryContextMenuRequested(const QPoint &point);
     void onCommandHistoryContextMenuActionTriggered(bool checked);
 
@@ -60,6 +102,9 @@ private slots:
     void onActionPortNamesChecked(bool checked);
     void onActionLineEndingsChecked(bool checked);
     void onActionFlowControlChecked(bool checked);
+    void onActionDisplayModeChecked(bool checked);
+    void onActionTimestampModeChecked(bool checked);
+    void onActionInterpolateTimestampsToggled(bool checked);
 
     void onSendButtonClicked();
     void onReturnKeyPressed();
@@ -72,6 +117,7 @@ private slots:
     void onCtrlUPressed();
     void onCtrlGPressed();
     void onCtrlCPressed();
+    void onCtrlFPressed();
 
     void onApplicationAboutToClose();
     void onConnectButtonClicked(bool checked);
@@ -82,12 +128,35 @@ private:
     Ui::MainWindow *m_ui;
     std::shared_ptr<AboutApplicationWidget> m_aboutApplicationWidget;
     std::unique_ptr<QLabel> m_statusBarLabel;
-    std::unique_ptr<QTimer> m_checkPortDisconnectTimer;
-    std::unique_ptr<QTimer> m_checkSerialPortReceiveTimer;
+    std::unique_ptr<QLabel> m_renderStatisticsLabel;
+    std::unique_ptr<QLabel> m_transmitStatusLabel;
+    std::unique_ptr<TerminalRenderer> m_terminalRenderer;
+    int m_peakLinesCoalesced;
+    std::unique_ptr<DeviceMonitor> m_deviceMonitor;
+    std::unique_ptr<QTimer> m_partialLineTimer;
     std::shared_ptr<CppSerialPort::SerialPort> m_byteStream;
-    std::unordered_set<std::string> m_serialPortNames;
-    std::mutex m_printToTerminalMutex;
-    std::unique_ptr<std::future<std::string>> m_serialReceiveAsyncHandle;
+    std::unique_ptr<CppSerialPort::SerialPortReader> m_serialPortReader;
+    std::unique_ptr<CppSerialPort::SerialPortWriter> m_serialPortWriter;
+    std::unique_ptr<ScriptRunner> m_scriptRunner;
+    std::unique_ptr<FileTransferSession> m_fileTransferSession;
+    std::shared_ptr<CppSerialPort::SessionRecorder> m_sessionRecorder;
+    CppSerialPort::SpscQueue<CppSerialPort::ReceivedChunk> m_replayQueue;
+    std::atomic<bool> m_replayNotificationPending;
+    std::chrono::steady_clock::time_point m_replayStartTime;
+    //Declared after the queue it pushes into, so it is stopped before the queue goes away
+    std::unique_ptr<SessionReplayer> m_sessionReplayer;
+    std::unique_ptr<CaptureViewer> m_captureViewer;
+    std::unique_ptr<PortSessionsWindow> m_portSessionsWindow;
+    std::string m_pendingReceive;
+    //Where each read ends in m_pendingReceive, and when it completed, so a line can be stamped with the arrival of its first byte
+    std::deque<std::pair<size_t, CppSerialPort::ReadTimestamp>> m_pendingReadEnds;
+    CppSerialPort::DisplayMode m_displayMode;
+    CppSerialPort::TimestampMode m_timestampMode;
+    bool m_interpolateTimestamps;
+    //Nanoseconds per character at the current port settings, for working back from the end of a read
+    uint64_t m_characterDuration;
+    //Bytes shown so far in the hex view, for its offset column
+    uint64_t m_receivedOffset;
 
     bool m_currentLinePushedIntoCommandHistory;
     std::vector<QString> m_commandHistory;
@@ -101,26 +170,48 @@ private:
     QActionSet m_availableFlowControlActions;
     QActionSet m_availablePortNamesActions;
     QActionSet m_availableLineEndingActions;
+    QActionSet m_availableDisplayModeActions;
+    QActionSet m_availableTimestampModeActions;
 
     void resetCommandHistory();
     void clearEmptyStringsFromCommandHistory();
     void openSerialPort();
     void closeSerialPort();
     void beginCommunication();
+    void startSerialPortReader();
+    void stopSerialPortReader();
+    void startSerialPortWriter();
+    void stopSerialPortWriter();
+    void updateTransmitStatus();
+    void stopScriptRunner();
+    bool selectTransferProtocol(CppSerialPort::TransferProtocol *protocol);
+    void beginFileTransfer(bool isSending);
+    void endFileTransfer();
+    void stopFileTransfer();
+    void stopSessionRecording();
+    void stopSessionReplay();
+    void updatePartialLineTimer();
+    void printPendingLines();
+    void printHexRows(bool includePartialRow);
+    void appendPendingChunk(const CppSerialPort::ReceivedChunk &chunk);
+    void consumePending(size_t byteCount);
+    void clearPending();
+    CppSerialPort::ReadTimestamp pendingTimestamp(size_t offset) const;
+    void updateCharacterDuration();
     void pauseCommunication();
     void stopCommunication();
     void setupAdditionalUiComponents();
-    void appendReceivedString(const std::string &str);
+    void appendReceivedString(const std::string &str, const CppSerialPort::ReadTimestamp &timestamp);
     void appendTransmittedString(const QString &str);
 
-    void printRxResult(const std::string &str);
+    void printRxResult(const std::string &str, const CppSerialPort::ReadTimestamp &timestamp);
     void printTxResult(const std::string &str);
 
     static const int CHECK_PORT_DISCONNECT_TIMEOUT;
-    static const int CHECK_PORT_RECEIVE_TIMEOUT;
     static const int NO_SERIAL_PORTS_CONNECTED_MESSAGE_TIMEOUT;
     static const int SERIAL_READ_TIMEOUT;
     static const int STATUS_BAR_FONT_POINT_SIZE;
+    static const int TERMINAL_FLUSH_INTERVAL;
     static const char *CARRIAGE_RETURN_LINE_ENDING;
     static const char *NEW_LINE_LINE_ENDING;
     static const char *CARRIAGE_RETURN_NEW_LINE_LINE_ENDING;
@@ -133,6 +224,8 @@ private:
     void addNewDataBitsItem(CppSerialPort::DataBits dataBits);
     void addNewParityItem(CppSerialPort::Parity parity);
     void addNewFlowControlItem(CppSerialPort::FlowControl flowControl);
+    void addNewDisplayModeItem(CppSerialPort::DisplayMode displayMode);
+    void addNewTimestampModeItem(CppSerialPort::TimestampMode timestampMode);
     void removeOldPortNameItem(const std::string &str);
     void removeOldBaudRateItem(CppSerialPort::BaudRate baudRate);
     void removeOldStopBitsItem(CppSerialPort::StopBits stopBits);
@@ -141,13 +234,14 @@ private:
     void removeOldFlowControlItem(CppSerialPort::FlowControl flowControl);
     void setLineEnding(const std::string &lineEnding);
     void autoSetLineEnding();
-    std::string checkSerialReceive();
 
     static const CppSerialPort::BaudRate DEFAULT_BAUD_RATE;
     static const CppSerialPort::Parity DEFAULT_PARITY;
     static const CppSerialPort::StopBits DEFAULT_STOP_BITS;
     static const CppSerialPort::DataBits DEFAULT_DATA_BITS;
     static const CppSerialPort::FlowControl DEFAULT_FLOW_CONTROL;
+    static const CppSerialPort::DisplayMode DEFAULT_DISPLAY_MODE;
+    static const CppSerialPort::TimestampMode DEFAULT_TIMESTAMP_MODE;
 
     void setStatusBarLabelText(const QString &str);
 
@@ -170,6 +264,7 @@ private:
     CppSerialPort::Parity getSelectedParity();
 
     static std::unordered_set<QAction *>::iterator findInQActionSet(QActionSet *qActionSet, const QString &key);
+    std::unordered_set<QAction *>::iterator findPortNameAction(const QString &portName);
 
     void setBaudRate(QAction *action);
     void setParity(QAction *action);
@@ -178,8 +273,11 @@ private:
     void setFlowControl(QAction *action);
     void setPortName(QAction *action);
     void setDataBits(QAction *action);
+    void setDisplayMode(QAction *action);
+    void setTimestampMode(QAction *action);
 
     std::string escapeLineEnding(const std::string &lineEnding);
+    std::string unescapeLineEnding(const std::string &lineEnding);
 };
 
 #endif //QSERIALTERMINAL_MAINWINDOW_H
@@ -0,0 +1,166 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#    include <Windows.h>
+#else
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <fcntl.h>
+#    include <unistd.h>
+#endif //defined(_WIN32)
+
+MappedFile::MappedFile() :
+    m_filePath{""},
+    m_data{nullptr},
+    m_size{0},
+    m_isOpen{false}
+#if defined(_WIN32)
+    ,
+    m_fileHandle{INVALID_HANDLE_VALUE},
+    m_mappingHandle{nullptr}
+#endif //defined(_WIN32)
+{
+
+}
+
+MappedFile::MappedFile(const std::string &filePath) :
+    MappedFile{}
+{
+    this->open(filePath);
+}
+
+#if defined(_WIN32)
+void MappedFile::open(const std::string &filePath)
+{
+    this->close();
+    this->m_fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (this->m_fileHandle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("MappedFile::open(const std::string &): could not open \"" + filePath + "\" (error " + std::to_string(GetLastError()) + ")");
+    }
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(this->m_fileHandle, &fileSize)) {
+        auto errorCode = GetLastError();
+        this->close();
+        throw std::runtime_error("MappedFile::open(const std::string &): could not get the size of \"" + filePath + "\" (error " + std::to_string(errorCode) + ")");
+    }
+    this->m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (this->m_size > 0) {
+        this->m_mappingHandle = CreateFileMappingA(this->m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (this->m_mappingHandle) {
+            this->m_data = static_cast<const char *>(MapViewOfFile(this->m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!this->m_data) {
+            auto errorCode = GetLastError();
+            this->close();
+            throw std::runtime_error("MappedFile::open(const std::string &): could not map \"" + filePath + "\" (error " + std::to_string(errorCode) + ")");
+        }
+    }
+    this->m_filePath = filePath;
+    this->m_isOpen = true;
+}
+
+void MappedFile::close()
+{
+    if (this->m_data) {
+        UnmapViewOfFile(this->m_data);
+    }
+    if (this->m_mappingHandle) {
+        CloseHandle(this->m_mappingHandle);
+    }
+    if (this->m_fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->m_fileHandle);
+    }
+    this->m_data = nullptr;
+    this->m_mappingHandle = nullptr;
+    this->m_fileHandle = INVALID_HANDLE_VALUE;
+    this->m_size = 0;
+    this->m_isOpen = false;
+    this->m_filePath = "";
+}
+
+void MappedFile::adviseSequential()
+{
+    //FILE_FLAG_SEQUENTIAL_SCAN was already passed to CreateFile
+}
+#else
+void MappedFile::open(const std::string &filePath)
+{
+    this->close();
+    int fileDescriptor{::open(filePath.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("MappedFile::open(const std::string &): could not open \"" + filePath + "\" (" + strerror(errno) + ")");
+    }
+    struct stat fileStatus{};
+    if (fstat(fileDescriptor, &fileStatus) != 0) {
+        auto errorCode = errno;
+        ::close(fileDescriptor);
+        throw std::runtime_error("MappedFile::open(const std::string &): could not stat \"" + filePath + "\" (" + strerror(errorCode) + ")");
+    }
+    if (!S_ISREG(fileStatus.st_mode)) {
+        ::close(fileDescriptor);
+        throw std::runtime_error("MappedFile::open(const std::string &): \"" + filePath + "\" is not a regular file");
+    }
+    this->m_size = static_cast<size_t>(fileStatus.st_size);
+    if (this->m_size > 0) {
+        void *mapping{mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0)};
+        if (mapping == MAP_FAILED) {
+            auto errorCode = errno;
+            ::close(fileDescriptor);
+            this->m_size = 0;
+            throw std::runtime_error("MappedFile::open(const std::string &): could not map \"" + filePath + "\" (" + strerror(errorCode) + ")");
+        }
+        this->m_data = static_cast<const char *>(mapping);
+    }
+    //The mapping keeps its own reference to the file
+    ::close(fileDescriptor);
+    this->m_filePath = filePath;
+    this->m_isOpen = true;
+}
+
+void MappedFile::close()
+{
+    if (this->m_data) {
+        munmap(const_cast<char *>(this->m_data), this->m_size);
+    }
+    this->m_data = nullptr;
+    this->m_size = 0;
+    this->m_isOpen = false;
+    this->m_filePath = "";
+}
+
+void MappedFile::adviseSequential()
+{
+    if (this->m_data) {
+        posix_madvise(const_cast<char *>(this->m_data), this->m_size, POSIX_MADV_SEQUENTIAL);
+    }
+}
+#endif //defined(_WIN32)
+
+bool MappedFile::isOpen() const
+{
+    return this->m_isOpen;
+}
+
+const char *MappedFile::data() const
+{
+    return this->m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return this->m_size;
+}
+
+std::string MappedFile::filePath() const
+{
+    return this->m_filePath;
+}
+
+MappedFile::~MappedFile()
+{
+    this->close();
+}
@@ -0,0 +1,47 @@
+#ifndef QSERIALTERMINAL_MAPPEDFILE_H
+#define QSERIALTERMINAL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * Read-only memory mapping of a whole file. The pages are faulted in by
+ * the kernel as they are touched, so a file of any size can be walked
+ * without reading it into memory first. An empty file maps to a null
+ * range of size 0
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    explicit MappedFile(const std::string &filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile(MappedFile &&other) = delete;
+    MappedFile &operator=(const MappedFile &rhs) = delete;
+    MappedFile &operator=(MappedFile &&rhs) = delete;
+
+    void open(const std::string &filePath);
+    void close();
+    bool isOpen() const;
+
+    const char *data() const;
+    size_t size() const;
+    std::string filePath() const;
+
+    //Tells the kernel the mapping will be read front to back, so it can read ahead aggressively
+    void adviseSequential();
+
+private:
+    std::string m_filePath;
+    const char *m_data;
+    size_t m_size;
+    bool m_isOpen;
+#if defined(_WIN32)
+    void *m_fileHandle;
+    void *m_mappingHandle;
+#endif //defined(_WIN32)
+};
+
+#endif //QSERIALTERMINAL_MAPPEDFILE_H
@@ -0,0 +1,341 @@
+#include "PortSessionsWindow.h"
+#include "ApplicationStrings.h"
+#include "ApplicationUtilities.h"
+#include "TerminalRenderer.h"
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QListWidget>
+#include <QListWidgetItem>
+#include <QVBoxLayout>
+#include <QTabBar>
+#include <QColor>
+#include <QPalette>
+
+#include <cstring>
+#include <utility>
+
+using namespace CppSerialPort;
+
+const int PortSessionsWindow::FRAME_INTERVAL{TerminalRenderer::DEFAULT_FLUSH_INTERVAL};
+const int PortSessionsWindow::PARTIAL_LINE_TIMEOUT{100};
+//Kept well below the main window's, since a rack of consoles means dozens of these
+const size_t PortSessionsWindow::SCROLLBACK_LINE_LIMIT{20000};
+const size_t PortSessionsWindow::SCROLLBACK_BYTE_LIMIT{4 * 1024 * 1024};
+const int PortSessionsWindow::STATISTICS_INTERVAL{1000};
+
+PortSessionsWindow::PortSessionsWindow(QWidget *parent) :
+    QTabWidget{parent},
+    //No more ports can be monitored than the machine has, so that sets how many reactor threads could be needed
+    m_serialReactor{[this]() { emit this->reactorEvent(); }, SerialReactor::defaultThreadCount(SerialPort::availableSerialPorts().size())},
+    m_sessions{},
+    m_frameTimer{},
+    m_partialLineTimer{},
+    m_statisticsTimer{},
+    m_statisticsLabel{new QLabel{this}},
+    m_lastBusySeconds{},
+    m_lastStatisticsTime{std::chrono::steady_clock::now()},
+    m_displayMode{DisplayMode::Text},
+    m_timestampMode{TimestampMode::None}
+{
+    this->setTabsClosable(true);
+    this->setDocumentMode(true);
+    this->m_frameTimer.setSingleShot(true);
+    this->m_frameTimer.setInterval(FRAME_INTERVAL);
+    this->m_partialLineTimer.setSingleShot(true);
+    this->m_partialLineTimer.setInterval(PARTIAL_LINE_TIMEOUT);
+    //The reactor thread raises the event, so it has to be queued over to the GUI thread
+    connect(this, &PortSessionsWindow::reactorEvent, this, &PortSessionsWindow::onReactorEvent, Qt::QueuedConnection);
+    connect(&this->m_frameTimer, &QTimer::timeout, this, &PortSessionsWindow::onFrameTimeout);
+    connect(&this->m_partialLineTimer, &QTimer::timeout, this, &PortSessionsWindow::onPartialLineTimeout);
+    connect(this, &QTabWidget::tabCloseRequested, this, &PortSessionsWindow::onTabCloseRequested);
+    connect(this, &QTabWidget::currentChanged, this, &PortSessionsWindow::onCurrentChanged);
+    this->setCornerWidget(this->m_statisticsLabel, Qt::TopRightCorner);
+    this->m_statisticsTimer.setInterval(STATISTICS_INTERVAL);
+    connect(&this->m_statisticsTimer, &QTimer::timeout, this, &PortSessionsWindow::onStatisticsTimeout);
+    this->m_statisticsTimer.start();
+    this->updateWindowTitle();
+}
+
+QStringList PortSessionsWindow::selectPorts(QWidget *parent, const QStringList &portNames)
+{
+    using namespace ApplicationStrings;
+    QDialog dialog{parent};
+    dialog.setWindowTitle(MONITOR_PORTS_DIALOG_TITLE_STRING);
+    QVBoxLayout *layout{new QVBoxLayout{&dialog}};
+    QListWidget *portList{new QListWidget{&dialog}};
+    for (const auto &it : portNames) {
+        QListWidgetItem *item{new QListWidgetItem{it, portList}};
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+    }
+    QDialogButtonBox *buttonBox{new QDialogButtonBox{QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog}};
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(portList);
+    layout->addWidget(buttonBox);
+    QStringList selectedPorts{};
+    if (dialog.exec() != QDialog::Accepted) {
+        return selectedPorts;
+    }
+    for (int i = 0; i < portList->count(); i++) {
+        if (portList->item(i)->checkState() == Qt::Checked) {
+            selectedPorts.append(portList->item(i)->text());
+        }
+    }
+    return selectedPorts;
+}
+
+void PortSessionsWindow::openPort(const std::string &portName, BaudRate baudRate, DataBits dataBits, StopBits stopBits, Parity parity, FlowControl flowControl)
+{
+    using namespace ApplicationStrings;
+    auto serialPort = std::make_shared<SerialPort>(portName, baudRate, dataBits, stopBits, parity, flowControl);
+    serialPort->openPort();
+    serialPort->setRealtimeTimestamps(this->m_timestampMode == TimestampMode::Realtime);
+    unsigned portId{0};
+    try {
+        portId = this->m_serialReactor.addPort(serialPort);
+        if (!this->m_serialReactor.isRunning()) {
+            this->m_serialReactor.start();
+        }
+    } catch (std::exception &e) {
+        this->m_serialReactor.removePort(portId);
+        serialPort->closePort();
+        throw;
+    }
+    TerminalView *terminal{new TerminalView{this}};
+    terminal->setLineColor(LineKind::Received, QColor{RED_COLOR_STRING});
+    terminal->setLineColor(LineKind::Transmitted, QColor{BLUE_COLOR_STRING});
+    terminal->setScrollbackLimit(SCROLLBACK_LINE_LIMIT, SCROLLBACK_BYTE_LIMIT);
+    this->m_sessions.emplace(portId, PortSession{serialPort, terminal, "", ReadTimestamp{0, 0}, std::chrono::steady_clock::time_point{}, {}, false});
+    this->addTab(terminal, QString::fromStdString(portName));
+    this->updateWindowTitle();
+}
+
+bool PortSessionsWindow::isMonitoring(const std::string &portName) const
+{
+    for (const auto &it : this->m_sessions) {
+        if ( (it.second.serialPort->isOpen()) && (it.second.serialPort->portName() == portName) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PortSessionsWindow::setDisplayMode(DisplayMode displayMode, TimestampMode timestampMode)
+{
+    //Tabs show whole lines only, so the hex view falls back to escaping what is not printable
+    this->m_displayMode = (displayMode == DisplayMode::Hex ? DisplayMode::Escaped : displayMode);
+    this->m_timestampMode = timestampMode;
+    for (auto &it : this->m_sessions) {
+        it.second.serialPort->setRealtimeTimestamps(timestampMode == TimestampMode::Realtime);
+    }
+}
+
+void PortSessionsWindow::onReactorEvent()
+{
+    using namespace ApplicationStrings;
+    //Acknowledge before draining so an event pushed mid-drain raises a fresh notification instead of being stranded
+    this->m_serialReactor.acknowledgeNotification();
+    ReactorEvent event{};
+    bool isAnyLinePending{false};
+    while (this->m_serialReactor.tryPop(event)) {
+        auto foundSession = this->m_sessions.find(event.portId);
+        if (foundSession == this->m_sessions.end()) {
+            continue;
+        }
+        PortSession &session = foundSession->second;
+        if (event.errorString.empty()) {
+            this->appendChunk(session, event.chunk);
+            this->markUnseen(session);
+            isAnyLinePending |= !session.pendingLine.empty();
+            continue;
+        }
+        //The reactor has already let go of a failed port; its tab stays open so the scrollback can still be read
+        if (!session.pendingLine.empty()) {
+            this->appendLine(session);
+        }
+        session.pendingLines.push_back(TerminalLine{std::string{SERIAL_PORT_DISCONNECTED_STRING} + event.errorString, LineKind::Received});
+        session.serialPort->closePort();
+        this->setTabText(this->indexOf(session.terminal), QString{PORT_SESSION_DISCONNECTED_TAB_STRING}.arg(QString::fromStdString(session.serialPort->portName())));
+        this->markUnseen(session);
+    }
+    if (!this->m_frameTimer.isActive()) {
+        this->m_frameTimer.start();
+    }
+    if ( (isAnyLinePending) && (!this->m_partialLineTimer.isActive()) ) {
+        this->m_partialLineTimer.start();
+    }
+}
+
+void PortSessionsWindow::appendChunk(PortSession &session, const ReceivedChunk &chunk)
+{
+    const char *data{chunk.data.data()};
+    const size_t size{chunk.data.size()};
+    size_t position{0};
+    while (position < size) {
+        if (session.pendingLine.empty()) {
+            session.pendingLineTimestamp = chunk.timestamp;
+        }
+        auto lineFeed = static_cast<const char *>(memchr(data + position, '\n', size - position));
+        size_t segmentEnd{lineFeed ? static_cast<size_t>(lineFeed - data) + 1 : size};
+        session.pendingLine.append(data + position, segmentEnd - position);
+        if (lineFeed) {
+            this->appendLine(session);
+        }
+        position = segmentEnd;
+    }
+    session.lastReceiveTime = std::chrono::steady_clock::now();
+}
+
+void PortSessionsWindow::appendLine(PortSession &session)
+{
+    using namespace ApplicationStrings;
+    using namespace ApplicationUtilities;
+    std::string line{TERMINAL_RECEIVE_BASE_STRING};
+    ByteFormatter::appendTimestamp(session.pendingLineTimestamp, this->m_timestampMode, &line);
+    if (this->m_displayMode == DisplayMode::Escaped) {
+        ByteFormatter::appendEscaped(session.pendingLine.data(), session.pendingLine.length(), &line);
+    } else {
+        std::string stripped{stripLineEndings(session.pendingLine)};
+        size_t segmentStart{0};
+        size_t nulPosition{stripped.find('\0')};
+        while (nulPosition != std::string::npos) {
+            line.append(stripped, segmentStart, nulPosition - segmentStart);
+            line.append(NUL_DISPLAY_UTF8_STRING);
+            segmentStart = nulPosition + 1;
+            nulPosition = stripped.find('\0', segmentStart);
+        }
+        line.append(stripped, segmentStart, std::string::npos);
+    }
+    session.pendingLines.push_back(TerminalLine{std::move(line), LineKind::Received});
+    session.pendingLine.clear();
+}
+
+void PortSessionsWindow::markUnseen(PortSession &session)
+{
+    if ( (session.hasUnseenData) || (this->currentWidget() == session.terminal) ) {
+        return;
+    }
+    session.hasUnseenData = true;
+    this->tabBar()->setTabTextColor(this->indexOf(session.terminal), QColor{ApplicationStrings::RED_COLOR_STRING});
+}
+
+void PortSessionsWindow::onFrameTimeout()
+{
+    //One timer for every tab, so each busy tab gets a single append and repaint per frame
+    for (auto &it : this->m_sessions) {
+        if (it.second.pendingLines.empty()) {
+            continue;
+        }
+        it.second.terminal->appendLines(it.second.pendingLines);
+        it.second.pendingLines.clear();
+    }
+}
+
+void PortSessionsWindow::onPartialLineTimeout()
+{
+    //A prompt or a port that went quiet mid line still shows up, just not before PARTIAL_LINE_TIMEOUT
+    auto staleBefore = std::chrono::steady_clock::now() - std::chrono::milliseconds{PARTIAL_LINE_TIMEOUT};
+    bool isAnyLinePending{false};
+    bool isAnyLineFlushed{false};
+    for (auto &it : this->m_sessions) {
+        if (it.second.pendingLine.empty()) {
+            continue;
+        }
+        if (it.second.lastReceiveTime <= staleBefore) {
+            this->appendLine(it.second);
+            isAnyLineFlushed = true;
+        } else {
+            isAnyLinePending = true;
+        }
+    }
+    if ( (isAnyLineFlushed) && (!this->m_frameTimer.isActive()) ) {
+        this->m_frameTimer.start();
+    }
+    if (isAnyLinePending) {
+        this->m_partialLineTimer.start();
+    }
+}
+
+unsigned PortSessionsWindow::portIdAt(int index) const
+{
+    QWidget *terminal{this->widget(index)};
+    for (const auto &it : this->m_sessions) {
+        if (it.second.terminal == terminal) {
+            return it.first;
+        }
+    }
+    return 0;
+}
+
+void PortSessionsWindow::onTabCloseRequested(int index)
+{
+    this->closeSession(this->portIdAt(index));
+}
+
+void PortSessionsWindow::onCurrentChanged(int index)
+{
+    auto foundSession = this->m_sessions.find(this->portIdAt(index));
+    if ( (foundSession == this->m_sessions.end()) || (!foundSession->second.hasUnseenData) ) {
+        return;
+    }
+    foundSession->second.hasUnseenData = false;
+    this->tabBar()->setTabTextColor(index, this->palette().color(QPalette::WindowText));
+}
+
+void PortSessionsWindow::onStatisticsTimeout()
+{
+    using namespace ApplicationStrings;
+    auto now = std::chrono::steady_clock::now();
+    double elapsedSeconds{std::chrono::duration<double>(now - this->m_lastStatisticsTime).count()};
+    this->m_lastStatisticsTime = now;
+    std::vector<ReactorStatistics> statistics{this->m_serialReactor.statistics()};
+    this->m_lastBusySeconds.resize(statistics.size(), 0.0);
+    QStringList loads{};
+    QStringList details{};
+    for (const auto &it : statistics) {
+        double busySeconds{it.busySeconds - this->m_lastBusySeconds[it.threadIndex]};
+        this->m_lastBusySeconds[it.threadIndex] = it.busySeconds;
+        int load{elapsedSeconds > 0.0 ? static_cast<int>((busySeconds * 100.0) / elapsedSeconds) : 0};
+        loads.append(QString{REACTOR_LOAD_STRING}.arg(QString::number(it.portCount), QString::number(load)));
+        details.append(QString{REACTOR_STATISTICS_STRING}.arg(QString::number(it.threadIndex), QString::number(it.portCount), QString::number(it.wakeups),
+                                                               QString::number(it.chunksRead), QString::number(it.bytesRead)));
+    }
+    this->m_statisticsLabel->setText(loads.join("  "));
+    this->m_statisticsLabel->setToolTip(details.join("\n"));
+}
+
+void PortSessionsWindow::closeSession(unsigned portId)
+{
+    auto foundSession = this->m_sessions.find(portId);
+    if (foundSession == this->m_sessions.end()) {
+        return;
+    }
+    //Waits out a read the reactor may be in the middle of, so the port can be closed under it
+    this->m_serialReactor.removePort(portId);
+    if (foundSession->second.serialPort->isOpen()) {
+        foundSession->second.serialPort->closePort();
+    }
+    TerminalView *terminal{foundSession->second.terminal};
+    this->m_sessions.erase(foundSession);
+    this->removeTab(this->indexOf(terminal));
+    terminal->deleteLater();
+    this->updateWindowTitle();
+}
+
+void PortSessionsWindow::updateWindowTitle()
+{
+    this->setWindowTitle(QString{ApplicationStrings::PORT_SESSIONS_TITLE_STRING}.arg(QString::number(this->count())));
+}
+
+PortSessionsWindow::~PortSessionsWindow()
+{
+    //Joins the reactor before the signal it emits and the ports it reads go away
+    this->m_serialReactor.stop();
+    for (auto &it : this->m_sessions) {
+        if (it.second.serialPort->isOpen()) {
+            it.second.serialPort->closePort();
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef QSERIALTERMINAL_PORTSESSIONSWINDOW_H
+#define QSERIALTERMINAL_PORTSESSIONSWINDOW_H
+
+#include <QTabWidget>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QLabel>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+
+#include "SerialPort.h"
+#include "SerialReactor.h"
+#include "ByteFormatter.h"
+#include "TerminalView.h"
+
+class QWidget;
+
+/*
+ * Window that monitors many serial ports at once, one tab per port. The
+ * ports are shared out between the threads of one SerialReactor, sized
+ * to the number of ports on the machine, and a single frame timer flushes
+ * the lines of all tabs together, so a rack of consoles costs a thread
+ * per few dozen ports and one timer however many tabs are open. The load
+ * on each reactor thread is shown in the corner of the tab bar. Tabs that
+ * received something since they were last looked at are marked.
+ * Monitoring is receive only; use the main window to talk to a port
+ */
+class PortSessionsWindow : public QTabWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PortSessionsWindow(QWidget *parent = nullptr);
+    ~PortSessionsWindow() override;
+
+    PortSessionsWindow(const PortSessionsWindow &other) = delete;
+    PortSessionsWindow(PortSessionsWindow &&other) = delete;
+    PortSessionsWindow &operator=(const PortSessionsWindow &rhs) = delete;
+    PortSessionsWindow &operator=(PortSessionsWindow &&rhs) = delete;
+
+    void openPort(const std::string &portName, CppSerialPort::BaudRate baudRate, CppSerialPort::DataBits dataBits, CppSerialPort::StopBits stopBits,
+                  CppSerialPort::Parity parity, CppSerialPort::FlowControl flowControl);
+    bool isMonitoring(const std::string &portName) const;
+    void setDisplayMode(CppSerialPort::DisplayMode displayMode, CppSerialPort::TimestampMode timestampMode);
+
+    static QStringList selectPorts(QWidget *parent, const QStringList &portNames);
+
+    static const int FRAME_INTERVAL;
+    static const int PARTIAL_LINE_TIMEOUT;
+    static const size_t SCROLLBACK_LINE_LIMIT;
+    static const size_t SCROLLBACK_BYTE_LIMIT;
+    static const int STATISTICS_INTERVAL;
+
+signals:
+    void reactorEvent();
+
+private slots:
+    void onReactorEvent();
+    void onFrameTimeout();
+    void onPartialLineTimeout();
+    void onTabCloseRequested(int index);
+    void onCurrentChanged(int index);
+    void onStatisticsTimeout();
+
+private:
+    struct PortSession
+    {
+        std::shared_ptr<CppSerialPort::SerialPort> serialPort;
+        TerminalView *terminal;
+        std::string pendingLine;
+        CppSerialPort::ReadTimestamp pendingLineTimestamp;
+        std::chrono::steady_clock::time_point lastReceiveTime;
+        std::vector<TerminalLine> pendingLines;
+        bool hasUnseenData;
+    };
+
+    CppSerialPort::SerialReactor m_serialReactor;
+    std::unordered_map<unsigned, PortSession> m_sessions;
+    QTimer m_frameTimer;
+    QTimer m_partialLineTimer;
+    QTimer m_statisticsTimer;
+    QLabel *m_statisticsLabel;
+    //Busy time of each reactor thread at the last update, so the label shows the load since then
+    std::vector<double> m_lastBusySeconds;
+    std::chrono::steady_clock::time_point m_lastStatisticsTime;
+    CppSerialPort::DisplayMode m_displayMode;
+    CppSerialPort::TimestampMode m_timestampMode;
+
+    void appendChunk(PortSession &session, const CppSerialPort::ReceivedChunk &chunk);
+    void appendLine(PortSession &session);
+    void markUnseen(PortSession &session);
+    void closeSession(unsigned portId);
+    unsigned portIdAt(int index) const;
+    void updateWindowTitle();
+};
+
+#endif //QSERIALTERMINAL_PORTSESSIONSWINDOW_H
@@ -0,0 +1,190 @@
+/***********************************************************************
+*    RingBuffer.cpp:                                                   *
+*    RingBuffer, fixed capacity byte queue for received data           *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a RingBuffer class          *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "RingBuffer.h"
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace CppSerialPort {
+
+const size_t RingBuffer::DEFAULT_CAPACITY;
+const size_t RingBuffer::CACHE_LINE_SIZE;
+
+RingBuffer::RingBuffer(size_t capacity) :
+        m_allocation{nullptr},
+        m_storage{nullptr},
+        m_mask{0},
+        m_head{0},
+        m_tail{0}
+{
+    this->setCapacity(capacity);
+}
+
+size_t RingBuffer::roundUpToPowerOfTwo(size_t value)
+{
+    size_t returnValue{1};
+    while (returnValue < value) {
+        returnValue <<= 1;
+    }
+    return returnValue;
+}
+
+void RingBuffer::setCapacity(size_t capacity)
+{
+    if (capacity == 0) {
+        throw std::runtime_error("RingBuffer::setCapacity(size_t): invariant failure (capacity cannot be 0)");
+    }
+    size_t newCapacity{roundUpToPowerOfTwo(capacity)};
+    if (newCapacity < this->size()) {
+        throw std::runtime_error("RingBuffer::setCapacity(size_t): invariant failure (new capacity " + std::to_string(newCapacity) + " cannot hold the " + std::to_string(this->size()) + " bytes currently stored)");
+    }
+    //Over-allocate by one cache line so the usable storage can start on a line boundary
+    std::unique_ptr<char[]> newAllocation{new char[newCapacity + CACHE_LINE_SIZE]};
+    auto address = reinterpret_cast<uintptr_t>(newAllocation.get());
+    char *newStorage{newAllocation.get() + ((CACHE_LINE_SIZE - (address % CACHE_LINE_SIZE)) % CACHE_LINE_SIZE)};
+    size_t storedBytes{this->read(newStorage, this->size())};
+
+    this->m_allocation = std::move(newAllocation);
+    this->m_storage = newStorage;
+    this->m_mask = newCapacity - 1;
+    this->m_head = 0;
+    this->m_tail = storedBytes;
+}
+
+size_t RingBuffer::capacity() const
+{
+    return this->m_mask + 1;
+}
+
+size_t RingBuffer::size() const
+{
+    return this->m_tail - this->m_head;
+}
+
+size_t RingBuffer::freeSpace() const
+{
+    return this->capacity() - this->size();
+}
+
+bool RingBuffer::empty() const
+{
+    return this->m_head == this->m_tail;
+}
+
+bool RingBuffer::full() const
+{
+    return this->size() == this->capacity();
+}
+
+void RingBuffer::clear()
+{
+    this->m_head = 0;
+    this->m_tail = 0;
+}
+
+ByteSpan RingBuffer::firstReadableSpan() const
+{
+    size_t start{this->m_head & this->m_mask};
+    return ByteSpan{this->m_storage + start, std::min(this->size(), this->capacity() - start)};
+}
+
+ByteSpan RingBuffer::secondReadableSpan() const
+{
+    ByteSpan first{this->firstReadableSpan()};
+    return ByteSpan{this->m_storage, this->size() - first.size};
+}
+
+MutableByteSpan RingBuffer::firstWritableSpan()
+{
+    if (this->empty()) {
+        //Nothing stored, so rewind to hand out the whole buffer as one contiguous region
+        this->clear();
+    }
+    size_t start{this->m_tail & this->m_mask};
+    return MutableByteSpan{this->m_storage + start, std::min(this->freeSpace(), this->capacity() - start)};
+}
+
+void RingBuffer::commit(size_t numberOfBytes)
+{
+    if (numberOfBytes > this->freeSpace()) {
+        throw std::runtime_error("RingBuffer::commit(size_t): invariant failure (cannot commit " + std::to_string(numberOfBytes) + " bytes with only " + std::to_string(this->freeSpace()) + " bytes free)");
+    }
+    this->m_tail += numberOfBytes;
+}
+
+size_t RingBuffer::read(char *buffer, size_t maxBytes)
+{
+    size_t bytesToRead{std::min(maxBytes, this->size())};
+    if (bytesToRead == 0) {
+        return 0;
+    }
+    ByteSpan first{this->firstReadableSpan()};
+    size_t firstCount{std::min(bytesToRead, first.size)};
+    memcpy(buffer, first.data, firstCount);
+    if (firstCount < bytesToRead) {
+        memcpy(buffer + firstCount, this->m_storage, bytesToRead - firstCount);
+    }
+    this->m_head += bytesToRead;
+    return bytesToRead;
+}
+
+size_t RingBuffer::write(const char *bytes, size_t numberOfBytes)
+{
+    size_t bytesToWrite{std::min(numberOfBytes, this->freeSpace())};
+    size_t start{this->m_tail & this->m_mask};
+    size_t firstCount{std::min(bytesToWrite, this->capacity() - start)};
+    memcpy(this->m_storage + start, bytes, firstCount);
+    if (firstCount < bytesToWrite) {
+        memcpy(this->m_storage, bytes + firstCount, bytesToWrite - firstCount);
+    }
+    this->m_tail += bytesToWrite;
+    return bytesToWrite;
+}
+
+void RingBuffer::putBack(const char *bytes, size_t numberOfBytes)
+{
+    if (numberOfBytes > this->freeSpace()) {
+        throw std::runtime_error("RingBuffer::putBack(const char *, size_t): invariant failure (cannot put back " + std::to_string(numberOfBytes) + " bytes with only " + std::to_string(this->freeSpace()) + " bytes free)");
+    }
+    //Indices are free-running, so moving the head backwards wraps the same way moving the tail forwards does
+    this->m_head -= numberOfBytes;
+    size_t start{this->m_head & this->m_mask};
+    size_t firstCount{std::min(numberOfBytes, this->capacity() - start)};
+    memcpy(this->m_storage + start, bytes, firstCount);
+    if (firstCount < numberOfBytes) {
+        memcpy(this->m_storage, bytes + firstCount, numberOfBytes - firstCount);
+    }
+}
+
+void RingBuffer::consume(size_t numberOfBytes)
+{
+    this->m_head += std::min(numberOfBytes, this->size());
+}
+
+char RingBuffer::at(size_t index) const
+{
+    if (index >= this->size()) {
+        throw std::out_of_range("RingBuffer::at(size_t): index " + std::to_string(index) + " is out of range (size = " + std::to_string(this->size()) + ")");
+    }
+    return this->m_storage[(this->m_head + index) & this->m_mask];
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,86 @@
+/***********************************************************************
+*    RingBuffer.h:                                                     *
+*    RingBuffer, fixed capacity byte queue for received data           *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a RingBuffer class            *
+*    The capacity is always a power of two, and the storage is         *
+*    aligned to a cache line, so that wrapping is a single mask and    *
+*    consuming or putting back bytes never moves the stored data       *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_RINGBUFFER_H
+#define CPPSERIALPORT_RINGBUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+namespace CppSerialPort {
+
+struct ByteSpan
+{
+    const char *data;
+    size_t size;
+};
+
+struct MutableByteSpan
+{
+    char *data;
+    size_t size;
+};
+
+class RingBuffer
+{
+public:
+    explicit RingBuffer(size_t capacity = DEFAULT_CAPACITY);
+
+    RingBuffer(const RingBuffer &other) = delete;
+    RingBuffer(RingBuffer &&other) = delete;
+    RingBuffer &operator=(const RingBuffer &rhs) = delete;
+    RingBuffer &operator=(RingBuffer &&rhs) = delete;
+
+    size_t capacity() const;
+    size_t size() const;
+    size_t freeSpace() const;
+    bool empty() const;
+    bool full() const;
+
+    void setCapacity(size_t capacity);
+    void clear();
+
+    size_t read(char *buffer, size_t maxBytes);
+    size_t write(const char *bytes, size_t numberOfBytes);
+    void putBack(const char *bytes, size_t numberOfBytes);
+    void consume(size_t numberOfBytes);
+    char at(size_t index) const;
+
+    ByteSpan firstReadableSpan() const;
+    ByteSpan secondReadableSpan() const;
+    MutableByteSpan firstWritableSpan();
+    void commit(size_t numberOfBytes);
+
+    static const size_t constexpr DEFAULT_CAPACITY{4096};
+    static const size_t constexpr CACHE_LINE_SIZE{64};
+
+private:
+    std::unique_ptr<char[]> m_allocation;
+    char *m_storage;
+    size_t m_mask;
+    size_t m_head;
+    size_t m_tail;
+
+    static size_t roundUpToPowerOfTwo(size_t value);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_RINGBUFFER_H
@@ -0,0 +1,384 @@
+#include "ScriptRunner.h"
+#include "ByteSearch.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cctype>
+
+const size_t ScriptRunner::SEND_CHUNK_SIZE{16384};
+const size_t ScriptRunner::RECEIVE_WINDOW_SIZE{65536};
+const std::chrono::milliseconds ScriptRunner::DEFAULT_RESPONSE_TIMEOUT{5000};
+const std::chrono::milliseconds ScriptRunner::SEND_RETRY_INTERVAL{5};
+const std::chrono::milliseconds ScriptRunner::PROGRESS_INTERVAL{100};
+
+static bool parseMilliseconds(const std::string &str, std::chrono::milliseconds *out)
+{
+    if ( (str.empty()) || (str.length() > 9) ) {
+        return false;
+    }
+    long long milliseconds{0};
+    for (auto c : str) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+        milliseconds = (milliseconds * 10) + (c - '0');
+    }
+    *out = std::chrono::milliseconds{milliseconds};
+    return true;
+}
+
+ScriptRunner::ScriptRunner(SendFunction sendFunction, std::function<void()> scriptEventCallback) :
+    m_sendFunction{sendFunction},
+    m_scriptEventNotifier{scriptEventCallback},
+    m_scriptFile{},
+    m_filePath{""},
+    m_options{defaultOptions()},
+    m_waitRegex{},
+    m_scriptThread{},
+    m_isRunning{false},
+    m_mutex{},
+    m_condition{},
+    m_cancelRequested{false},
+    m_isWaitingForResponse{false},
+    m_receiveWindow{""},
+    m_progress{ScriptState::Idle, 0, 0, 0, 0, 0.0},
+    m_errorString{""},
+    m_startTime{},
+    m_lastNotification{}
+{
+    if (!this->m_sendFunction) {
+        throw std::runtime_error("ScriptRunner::ScriptRunner(SendFunction, std::function<void()>): invariant failure (sendFunction cannot be empty)");
+    }
+}
+
+ScriptOptions ScriptRunner::defaultOptions()
+{
+    return ScriptOptions{"\n", std::chrono::milliseconds{0}, "", "", DEFAULT_RESPONSE_TIMEOUT};
+}
+
+void ScriptRunner::start(const std::string &filePath, const ScriptOptions &options)
+{
+    if (this->m_isRunning) {
+        throw std::runtime_error("ScriptRunner::start(const std::string &, const ScriptOptions &): a script is already running (" + this->m_filePath + ")");
+    }
+    if (this->m_scriptThread.joinable()) {
+        this->m_scriptThread.join();
+    }
+    std::regex waitRegex{};
+    if (!options.waitForPattern.empty()) {
+        try {
+            waitRegex = std::regex{options.waitForPattern};
+        } catch (std::regex_error &e) {
+            throw std::runtime_error("ScriptRunner::start(const std::string &, const ScriptOptions &): invalid regular expression \"" + options.waitForPattern + "\" (" + e.what() + ")");
+        }
+    }
+    this->m_scriptFile.open(filePath);
+    this->m_scriptFile.adviseSequential();
+    this->m_filePath = filePath;
+    this->m_options = options;
+    this->m_waitRegex = std::move(waitRegex);
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_cancelRequested = false;
+        this->m_isWaitingForResponse = false;
+        this->m_receiveWindow.clear();
+        this->m_progress = ScriptProgress{ScriptState::Running, 0, this->m_scriptFile.size(), 0, 0, 0.0};
+        this->m_errorString = "";
+    }
+    this->m_startTime = std::chrono::steady_clock::now();
+    this->m_lastNotification = this->m_startTime;
+    this->m_scriptEventNotifier.acknowledge();
+    this->m_isRunning = true;
+    this->m_scriptThread = std::thread{&ScriptRunner::run, this};
+}
+
+void ScriptRunner::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_cancelRequested = true;
+    }
+    this->m_condition.notify_all();
+    if (this->m_scriptThread.joinable()) {
+        this->m_scriptThread.join();
+    }
+}
+
+bool ScriptRunner::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+void ScriptRunner::receive(const char *data, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        if (!this->m_isWaitingForResponse) {
+            return;
+        }
+        this->m_receiveWindow.append(data, size);
+        //Only the tail can still complete a match; anything that matched earlier already woke the script thread
+        if (this->m_receiveWindow.length() > RECEIVE_WINDOW_SIZE) {
+            this->m_receiveWindow.erase(0, this->m_receiveWindow.length() - RECEIVE_WINDOW_SIZE);
+        }
+    }
+    this->m_condition.notify_all();
+}
+
+ScriptProgress ScriptRunner::progress() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_progress;
+}
+
+std::string ScriptRunner::filePath() const
+{
+    return this->m_filePath;
+}
+
+std::string ScriptRunner::errorString() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_errorString;
+}
+
+void ScriptRunner::acknowledgeNotification()
+{
+    this->m_scriptEventNotifier.acknowledge();
+}
+
+void ScriptRunner::setErrorString(const std::string &errorString)
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    this->m_errorString = errorString;
+}
+
+void ScriptRunner::updateProgress(uint64_t bytesProcessed, uint64_t linesSent, uint64_t bytesSent, bool forceNotification)
+{
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress.bytesProcessed = bytesProcessed;
+        this->m_progress.linesSent = linesSent;
+        this->m_progress.bytesSent = bytesSent;
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(now - this->m_startTime).count();
+    }
+    //A 100k line file would otherwise flood the GUI thread with one event per line
+    if ( (forceNotification) || (now - this->m_lastNotification >= PROGRESS_INTERVAL) ) {
+        this->m_lastNotification = now;
+        this->m_scriptEventNotifier.notify();
+    }
+}
+
+void ScriptRunner::finish(ScriptState state)
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress.state = state;
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_startTime).count();
+        this->m_isWaitingForResponse = false;
+        this->m_receiveWindow.clear();
+    }
+    this->m_scriptFile.close();
+    this->m_isRunning = false;
+    this->m_scriptEventNotifier.notifyAlways();
+}
+
+bool ScriptRunner::sleepFor(std::chrono::milliseconds duration)
+{
+    std::unique_lock<std::mutex> lock{this->m_mutex};
+    return !this->m_condition.wait_for(lock, duration, [this]() { return this->m_cancelRequested; });
+}
+
+bool ScriptRunner::sendData(const std::string &data)
+{
+    //A refused send means the transmit queue is full, usually because flow control is holding the port off
+    while (!this->m_sendFunction(data)) {
+        if (!this->sleepFor(SEND_RETRY_INTERVAL)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScriptRunner::responseMatched() const
+{
+    if (!this->m_options.waitForPrompt.empty()) {
+        return CppSerialPort::ByteSearch::find(this->m_receiveWindow, this->m_options.waitForPrompt) != std::string::npos;
+    }
+    return std::regex_search(this->m_receiveWindow, this->m_waitRegex);
+}
+
+bool ScriptRunner::waitForResponse(uint64_t lineNumber)
+{
+    std::unique_lock<std::mutex> lock{this->m_mutex};
+    auto deadline = std::chrono::steady_clock::now() + this->m_options.responseTimeout;
+    bool matched{this->m_condition.wait_until(lock, deadline, [this]() { return (this->m_cancelRequested) || (this->responseMatched()); })};
+    this->m_isWaitingForResponse = false;
+    this->m_receiveWindow.clear();
+    if (this->m_cancelRequested) {
+        return false;
+    }
+    if (!matched) {
+        const std::string &expected{this->m_options.waitForPrompt.empty() ? this->m_options.waitForPattern : this->m_options.waitForPrompt};
+        this->m_errorString = "Line " + std::to_string(lineNumber) + ": no response matching \"" + expected + "\" within " + std::to_string(this->m_options.responseTimeout.count()) + " ms";
+        return false;
+    }
+    return true;
+}
+
+bool ScriptRunner::sendLineAndWait(const std::string &line, uint64_t lineNumber)
+{
+    bool waitsForResponse{(!this->m_options.waitForPrompt.empty()) || (!this->m_options.waitForPattern.empty())};
+    if (waitsForResponse) {
+        //Start listening before sending, a fast device can answer before send returns
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_receiveWindow.clear();
+        this->m_isWaitingForResponse = true;
+    }
+    if (!this->sendData(line)) {
+        return false;
+    }
+    if ( (waitsForResponse) && (!this->waitForResponse(lineNumber)) ) {
+        return false;
+    }
+    if ( (this->m_options.lineDelay.count() > 0) && (!this->sleepFor(this->m_options.lineDelay)) ) {
+        return false;
+    }
+    return true;
+}
+
+bool ScriptRunner::applyDirective(const char *begin, const char *end, uint64_t lineNumber)
+{
+    const char *nameEnd{static_cast<const char *>(memchr(begin, ' ', static_cast<size_t>(end - begin)))};
+    if (!nameEnd) {
+        nameEnd = end;
+    }
+    std::string name{begin, nameEnd};
+    std::string argument{nameEnd < end ? std::string{nameEnd + 1, end} : std::string{""}};
+    std::chrono::milliseconds milliseconds{0};
+    if (name == "prompt") {
+        this->m_options.waitForPrompt = argument;
+        this->m_options.waitForPattern = "";
+        return true;
+    } else if (name == "regex") {
+        try {
+            this->m_waitRegex = std::regex{argument};
+        } catch (std::regex_error &e) {
+            this->setErrorString("Line " + std::to_string(lineNumber) + ": invalid regular expression \"" + argument + "\" (" + e.what() + ")");
+            return false;
+        }
+        this->m_options.waitForPattern = argument;
+        this->m_options.waitForPrompt = "";
+        return true;
+    }
+    if (!parseMilliseconds(argument, &milliseconds)) {
+        this->setErrorString("Line " + std::to_string(lineNumber) + ": invalid directive \"@" + name + (argument.empty() ? "" : " " + argument) + "\"");
+        return false;
+    }
+    if (name == "delay") {
+        this->m_options.lineDelay = milliseconds;
+    } else if (name == "timeout") {
+        this->m_options.responseTimeout = milliseconds;
+    } else if (name == "sleep") {
+        return this->sleepFor(milliseconds);
+    } else {
+        this->setErrorString("Line " + std::to_string(lineNumber) + ": unknown directive \"@" + name + "\"");
+        return false;
+    }
+    return true;
+}
+
+void ScriptRunner::run()
+{
+    const char *fileBegin{this->m_scriptFile.data()};
+    const char *position{fileBegin};
+    const char *fileEnd{fileBegin + this->m_scriptFile.size()};
+    uint64_t lineNumber{0};
+    uint64_t linesSent{0};
+    uint64_t bytesSent{0};
+    std::string chunk{};
+    uint64_t chunkLines{0};
+    chunk.reserve(SEND_CHUNK_SIZE);
+
+    auto flushChunk = [&]() -> bool {
+        if (chunk.empty()) {
+            return true;
+        }
+        if (!this->sendData(chunk)) {
+            return false;
+        }
+        linesSent += chunkLines;
+        bytesSent += chunk.length();
+        chunk.clear();
+        chunkLines = 0;
+        this->updateProgress(static_cast<uint64_t>(position - fileBegin), linesSent, bytesSent, false);
+        return true;
+    };
+
+    bool completed{true};
+    while (position < fileEnd) {
+        const char *lineEnd{static_cast<const char *>(memchr(position, '\n', static_cast<size_t>(fileEnd - position)))};
+        const char *nextLine{lineEnd ? lineEnd + 1 : fileEnd};
+        const char *contentEnd{lineEnd ? lineEnd : fileEnd};
+        if ( (contentEnd > position) && (*(contentEnd - 1) == '\r') ) {
+            contentEnd--;
+        }
+        lineNumber++;
+        const char *contentBegin{position};
+        bool isEscaped{(contentEnd - contentBegin >= 2) && (contentBegin[0] == '@') && (contentBegin[1] == '@')};
+        if ( (contentEnd > contentBegin) && (*contentBegin == '@') && (!isEscaped) ) {
+            //Everything before the directive goes out under the options it was read with
+            if ( (!flushChunk()) || (!this->applyDirective(contentBegin + 1, contentEnd, lineNumber)) ) {
+                completed = false;
+                break;
+            }
+            position = nextLine;
+            continue;
+        }
+        if (isEscaped) {
+            contentBegin++;
+        }
+        bool isBatched{(this->m_options.lineDelay.count() == 0) && (this->m_options.waitForPrompt.empty()) && (this->m_options.waitForPattern.empty())};
+        if (isBatched) {
+            chunk.append(contentBegin, contentEnd);
+            chunk += this->m_options.lineEnding;
+            chunkLines++;
+            position = nextLine;
+            if ( (chunk.length() >= SEND_CHUNK_SIZE) && (!flushChunk()) ) {
+                completed = false;
+                break;
+            }
+            continue;
+        }
+        std::string line{contentBegin, contentEnd};
+        line += this->m_options.lineEnding;
+        if (!this->sendLineAndWait(line, lineNumber)) {
+            completed = false;
+            break;
+        }
+        position = nextLine;
+        linesSent++;
+        bytesSent += line.length();
+        this->updateProgress(static_cast<uint64_t>(position - fileBegin), linesSent, bytesSent, false);
+    }
+    if ( (completed) && (!flushChunk()) ) {
+        completed = false;
+    }
+    this->updateProgress(static_cast<uint64_t>(position - fileBegin), linesSent, bytesSent, false);
+    bool wasCancelled{false};
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        wasCancelled = this->m_cancelRequested;
+    }
+    if (completed) {
+        this->finish(ScriptState::Finished);
+    } else {
+        this->finish(wasCancelled ? ScriptState::Cancelled : ScriptState::Failed);
+    }
+}
+
+ScriptRunner::~ScriptRunner()
+{
+    this->stop();
+}
@@ -0,0 +1,130 @@
+#ifndef QSERIALTERMINAL_SCRIPTRUNNER_H
+#define QSERIALTERMINAL_SCRIPTRUNNER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <regex>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "EventNotifier.h"
+
+struct ScriptOptions
+{
+    std::string lineEnding;
+    std::chrono::milliseconds lineDelay;
+    std::string waitForPrompt;
+    std::string waitForPattern;
+    std::chrono::milliseconds responseTimeout;
+};
+
+enum class ScriptState
+{
+    Idle,
+    Running,
+    Finished,
+    Cancelled,
+    Failed
+};
+
+struct ScriptProgress
+{
+    ScriptState state;
+    uint64_t bytesProcessed;
+    uint64_t totalBytes;
+    uint64_t linesSent;
+    uint64_t bytesSent;
+    double elapsedSeconds;
+};
+
+/*
+ * Streams a command file to a device on its own thread. The file is
+ * memory mapped and walked line by line, so only the lines currently in
+ * flight are ever copied. Each line is sent with the configured line
+ * ending, then the runner optionally waits a fixed delay, for a literal
+ * prompt, or for a regular expression to match what the device sends
+ * back. With neither a delay nor a wait, lines are packed into large
+ * chunks so the transmit queue stays full.
+ *
+ * Lines starting with '@' are directives that change the options for
+ * the rest of the file:
+ *     @delay <ms>      pause after every line
+ *     @prompt <text>   wait for <text> after every line (empty turns it off)
+ *     @regex <pattern> wait for <pattern> (ECMAScript) to match after every line
+ *     @timeout <ms>    how long a prompt or regex wait may take
+ *     @sleep <ms>      pause once
+ *     @@...            send the line with one leading '@' removed
+ * Prompts and patterns are searched for in everything received since the
+ * line was sent, not line by line
+ */
+class ScriptRunner
+{
+public:
+    //Returns false when the data cannot be queued right now; it is retried until it is accepted or the script is stopped
+    using SendFunction = std::function<bool(const std::string &)>;
+
+    ScriptRunner(SendFunction sendFunction, std::function<void()> scriptEventCallback);
+    ~ScriptRunner();
+
+    ScriptRunner(const ScriptRunner &other) = delete;
+    ScriptRunner(ScriptRunner &&other) = delete;
+    ScriptRunner &operator=(const ScriptRunner &rhs) = delete;
+    ScriptRunner &operator=(ScriptRunner &&rhs) = delete;
+
+    void start(const std::string &filePath, const ScriptOptions &options);
+    void stop();
+    bool isRunning() const;
+
+    //Everything the device sends while a script runs has to be fed in here for prompt and regex waits to see it
+    void receive(const char *data, size_t size);
+
+    ScriptProgress progress() const;
+    std::string filePath() const;
+    std::string errorString() const;
+    void acknowledgeNotification();
+
+    static ScriptOptions defaultOptions();
+
+    static const size_t SEND_CHUNK_SIZE;
+    static const size_t RECEIVE_WINDOW_SIZE;
+    static const std::chrono::milliseconds DEFAULT_RESPONSE_TIMEOUT;
+    static const std::chrono::milliseconds SEND_RETRY_INTERVAL;
+    static const std::chrono::milliseconds PROGRESS_INTERVAL;
+
+private:
+    SendFunction m_sendFunction;
+    CppSerialPort::EventNotifier m_scriptEventNotifier;
+    MappedFile m_scriptFile;
+    std::string m_filePath;
+    ScriptOptions m_options;
+    std::regex m_waitRegex;
+    std::thread m_scriptThread;
+    std::atomic<bool> m_isRunning;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_cancelRequested;
+    bool m_isWaitingForResponse;
+    std::string m_receiveWindow;
+    ScriptProgress m_progress;
+    std::string m_errorString;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastNotification;
+
+    void run();
+    bool applyDirective(const char *begin, const char *end, uint64_t lineNumber);
+    bool sendData(const std::string &data);
+    bool sendLineAndWait(const std::string &line, uint64_t lineNumber);
+    bool waitForResponse(uint64_t lineNumber);
+    bool responseMatched() const;
+    bool sleepFor(std::chrono::milliseconds duration);
+    void updateProgress(uint64_t bytesProcessed, uint64_t linesSent, uint64_t bytesSent, bool forceNotification);
+    void setErrorString(const std::string &errorString);
+    void finish(ScriptState state);
+};
+
+#endif //QSERIALTERMINAL_SCRIPTRUNNER_H
@@ -0,0 +1,188 @@
+#include "SearchBar.h"
+#include "ApplicationStrings.h"
+
+#include <QHBoxLayout>
+#include <QKeyEvent>
+
+#include <algorithm>
+
+const int SearchBar::TYPING_DELAY{250};
+
+SearchBar::SearchBar(QWidget *parent) :
+    QWidget{parent},
+    m_patternEdit{new QLineEdit{this}},
+    m_regexCheckBox{new QCheckBox{ApplicationStrings::SEARCH_REGEX_STRING, this}},
+    m_matchCaseCheckBox{new QCheckBox{ApplicationStrings::SEARCH_MATCH_CASE_STRING, this}},
+    m_previousButton{new QPushButton{ApplicationStrings::SEARCH_PREVIOUS_STRING, this}},
+    m_nextButton{new QPushButton{ApplicationStrings::SEARCH_NEXT_STRING, this}},
+    m_statusLabel{new QLabel{this}},
+    m_typingTimer{new QTimer{}},
+    m_textSearch{[this]() { emit this->searchEvent(); }},
+    m_blockSource{nullptr},
+    m_lineFunction{nullptr},
+    m_hits{},
+    m_currentHit{0},
+    m_isSettled{true}
+{
+    QHBoxLayout *layout{new QHBoxLayout{this}};
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(this->m_patternEdit.get(), 1);
+    layout->addWidget(this->m_regexCheckBox.get());
+    layout->addWidget(this->m_matchCaseCheckBox.get());
+    layout->addWidget(this->m_previousButton.get());
+    layout->addWidget(this->m_nextButton.get());
+    layout->addWidget(this->m_statusLabel.get());
+    this->m_patternEdit->setPlaceholderText(ApplicationStrings::SEARCH_PLACEHOLDER_STRING);
+
+    this->m_typingTimer->setSingleShot(true);
+    this->m_typingTimer->setInterval(TYPING_DELAY);
+    connect(this->m_typingTimer.get(), &QTimer::timeout, this, &SearchBar::startSearch);
+    connect(this->m_patternEdit.get(), &QLineEdit::textEdited, this->m_typingTimer.get(), static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(this->m_regexCheckBox.get(), &QCheckBox::toggled, this, &SearchBar::startSearch);
+    connect(this->m_matchCaseCheckBox.get(), &QCheckBox::toggled, this, &SearchBar::startSearch);
+    connect(this->m_previousButton.get(), &QPushButton::clicked, this, &SearchBar::findPrevious);
+    connect(this->m_nextButton.get(), &QPushButton::clicked, this, &SearchBar::findNext);
+    //The workers raise the event, so it has to be queued over to the GUI thread
+    connect(this, &SearchBar::searchEvent, this, &SearchBar::onSearchEvent, Qt::QueuedConnection);
+}
+
+void SearchBar::setSource(BlockSource blockSource, LineFunction lineFunction)
+{
+    this->stopSearch();
+    this->m_blockSource = blockSource;
+    this->m_lineFunction = lineFunction;
+}
+
+void SearchBar::activate()
+{
+    this->show();
+    this->m_patternEdit->setFocus();
+    this->m_patternEdit->selectAll();
+}
+
+void SearchBar::dismiss()
+{
+    this->stopSearch();
+    this->hide();
+    emit this->dismissed();
+}
+
+void SearchBar::startSearch()
+{
+    this->stopSearch();
+    this->m_hits.clear();
+    this->m_currentHit = 0;
+    std::string pattern{this->m_patternEdit->text().toStdString()};
+    if ( (pattern.empty()) || (!this->m_blockSource) ) {
+        this->m_statusLabel->clear();
+        return;
+    }
+    TextSearch::BlockFunction blockFunction{nullptr};
+    size_t blockCount{this->m_blockSource(&blockFunction)};
+    try {
+        this->m_textSearch.start(SearchOptions{pattern, this->m_regexCheckBox->isChecked(), this->m_matchCaseCheckBox->isChecked()}, blockCount, blockFunction);
+    } catch (std::exception &e) {
+        this->m_statusLabel->setText(e.what());
+        return;
+    }
+    this->m_isSettled = false;
+    this->updateStatus();
+}
+
+void SearchBar::stopSearch()
+{
+    this->m_typingTimer->stop();
+    this->m_textSearch.stop();
+}
+
+void SearchBar::onSearchEvent()
+{
+    this->m_textSearch.acknowledgeNotification();
+    std::vector<SearchHit> hits{this->m_textSearch.takeHits()};
+    this->m_hits.insert(this->m_hits.end(), hits.begin(), hits.end());
+    SearchProgress progress{this->m_textSearch.progress()};
+    if ( (progress.state == SearchState::Running) || (this->m_isSettled) ) {
+        this->updateStatus();
+        return;
+    }
+    //The final event can trail an earlier one that already saw the search end
+    this->m_isSettled = true;
+    if (progress.state == SearchState::Failed) {
+        this->m_statusLabel->setText(QString::fromStdString(this->m_textSearch.errorString()));
+        return;
+    }
+    //Blocks finish in any order, so the hits are only put in line order once they are all in
+    std::sort(this->m_hits.begin(), this->m_hits.end(), [](const SearchHit &lhs, const SearchHit &rhs) { return lhs.lineNumber < rhs.lineNumber; });
+    if ( (progress.state == SearchState::Finished) && (!this->m_hits.empty()) ) {
+        this->showHit(0);
+    } else {
+        this->updateStatus();
+    }
+}
+
+void SearchBar::findNext()
+{
+    if ( (this->m_hits.empty()) || (!this->m_isSettled) ) {
+        return;
+    }
+    this->showHit((this->m_currentHit + 1) % this->m_hits.size());
+}
+
+void SearchBar::findPrevious()
+{
+    if ( (this->m_hits.empty()) || (!this->m_isSettled) ) {
+        return;
+    }
+    this->showHit((this->m_currentHit + this->m_hits.size() - 1) % this->m_hits.size());
+}
+
+void SearchBar::showHit(size_t hitIndex)
+{
+    using namespace ApplicationStrings;
+    this->m_currentHit = hitIndex;
+    if ( (this->m_lineFunction) && (!this->m_lineFunction(this->m_hits[hitIndex].lineNumber)) ) {
+        this->m_statusLabel->setText(QString{SEARCH_LINE_GONE_STRING}.arg(QString::number(hitIndex + 1), QString::number(this->m_hits.size())));
+        return;
+    }
+    this->updateStatus();
+}
+
+void SearchBar::updateStatus()
+{
+    using namespace ApplicationStrings;
+    SearchProgress progress{this->m_textSearch.progress()};
+    if (progress.state == SearchState::Running) {
+        int percentage{progress.blockCount > 0 ? static_cast<int>((progress.blocksSearched * 100) / progress.blockCount) : 0};
+        this->m_statusLabel->setText(QString{SEARCH_RUNNING_STRING}.arg(QString::number(percentage), QString::number(progress.hitCount)));
+    } else if (this->m_hits.empty()) {
+        this->m_statusLabel->setText(progress.state == SearchState::Finished ? SEARCH_NO_MATCHES_STRING : "");
+    } else {
+        this->m_statusLabel->setText(QString{progress.isTruncated ? SEARCH_TRUNCATED_RESULT_STRING : SEARCH_RESULT_STRING}.arg(QString::number(this->m_currentHit + 1), QString::number(this->m_hits.size())));
+    }
+}
+
+void SearchBar::keyPressEvent(QKeyEvent *event)
+{
+    if ( (event->key() == Qt::Key_Return) || (event->key() == Qt::Key_Enter) ) {
+        //Return straight after typing should not wait out the typing delay
+        if (this->m_typingTimer->isActive()) {
+            this->startSearch();
+        } else if (event->modifiers() & Qt::ShiftModifier) {
+            this->findPrevious();
+        } else {
+            this->findNext();
+        }
+        event->accept();
+    } else if (event->key() == Qt::Key_Escape) {
+        this->dismiss();
+        event->accept();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
+
+SearchBar::~SearchBar()
+{
+    //Joins the workers before the signal they emit goes away
+    this->m_textSearch.stop();
+}
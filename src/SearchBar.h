@@ -0,0 +1,88 @@
+#ifndef QSERIALTERMINAL_SEARCHBAR_H
+#define QSERIALTERMINAL_SEARCHBAR_H
+
+#include <QWidget>
+#include <QString>
+#include <QTimer>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QLabel>
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "TextSearch.h"
+
+class QKeyEvent;
+
+/*
+ * Find bar shared by the terminal and the capture viewer. The owner says
+ * where the text comes from with setSource(): a function that hands back
+ * the block count and the block function for a fresh search, and one that
+ * brings a matching line into view. Typing restarts the search after a
+ * short pause, Return and Shift+Return step through the matches and
+ * Escape hides the bar
+ */
+class SearchBar : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //Sets blockFunction up for a new search and returns the number of blocks it serves
+    using BlockSource = std::function<size_t(TextSearch::BlockFunction *blockFunction)>;
+    //Scrolls lineNumber into view, returning false if it is no longer available
+    using LineFunction = std::function<bool(uint64_t lineNumber)>;
+
+    explicit SearchBar(QWidget *parent = nullptr);
+    ~SearchBar() override;
+
+    SearchBar(const SearchBar &other) = delete;
+    SearchBar(SearchBar &&other) = delete;
+    SearchBar &operator=(const SearchBar &rhs) = delete;
+    SearchBar &operator=(SearchBar &&rhs) = delete;
+
+    void setSource(BlockSource blockSource, LineFunction lineFunction);
+
+signals:
+    void searchEvent();
+    void dismissed();
+
+public slots:
+    void activate();
+    void dismiss();
+    void startSearch();
+    void stopSearch();
+    void findNext();
+    void findPrevious();
+
+private slots:
+    void onSearchEvent();
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    std::unique_ptr<QLineEdit> m_patternEdit;
+    std::unique_ptr<QCheckBox> m_regexCheckBox;
+    std::unique_ptr<QCheckBox> m_matchCaseCheckBox;
+    std::unique_ptr<QPushButton> m_previousButton;
+    std::unique_ptr<QPushButton> m_nextButton;
+    std::unique_ptr<QLabel> m_statusLabel;
+    std::unique_ptr<QTimer> m_typingTimer;
+    TextSearch m_textSearch;
+    BlockSource m_blockSource;
+    LineFunction m_lineFunction;
+    std::vector<SearchHit> m_hits;
+    size_t m_currentHit;
+    bool m_isSettled;
+
+    void showHit(size_t hitIndex);
+    void updateStatus();
+
+    static const int TYPING_DELAY;
+};
+
+#endif //QSERIALTERMINAL_SEARCHBAR_H
@@ -25,6 +25,8 @@
 #include <future>
 #include <set>
 #include <climits>
+#include <mutex>
+#include <unordered_map>
 
 #if defined(_WIN32)
 #    include <Windows.h>
@@ -40,6 +42,10 @@
     #include <climits>
     #include <sys/file.h>
     #include <cerrno>
+    #include <poll.h>
+    #include <sys/uio.h>
+    #include <dirent.h>
+    #include <cstdlib>
 
 #endif
 
@@ -54,6 +60,7 @@ const StopBits SerialPort::DEFAULT_STOP_BITS{StopBits::StopOne};
 const Parity SerialPort::DEFAULT_PARITY{Parity::ParityNone};
 const BaudRate SerialPort::DEFAULT_BAUD_RATE{BaudRate::Baud9600};
 const FlowControl SerialPort::DEFAULT_FLOW_CONTROL{FlowControl::FlowOff};
+const size_t SerialPort::DEFAULT_RECEIVE_BUFFER_SIZE{65536};
 
 #if defined(_WIN32)
     const char *SerialPort::AVAILABLE_PORT_NAMES_BASE{R"(\\.\COM)"};
@@ -65,7 +72,134 @@ const std::vector<const char *> SerialPort::AVAILABLE_PORT_NAMES_BASE{"/dev/ttyS
                                                                       "/dev/cuau", "/dev/cuaU", "/dev/rfcomm"};
 #endif
 
-const std::vector<std::string> SerialPort::SERIAL_PORT_NAMES{SerialPort::generateSerialPortNames()};
+#if defined(__linux__)
+static const char *SYSFS_TTY_DIRECTORY{"/sys/class/tty"};
+static const char *DEVICE_DIRECTORY{"/dev"};
+static const char *SERIAL_BY_ID_DIRECTORY{"/dev/serial/by-id"};
+//serial_core keeps a tty for every UART slot it reserved, and reports the ones where no UART was found as type 0
+static const char *UNKNOWN_UART_TYPE{"0"};
+
+//What was read from sysfs for a port, along with the device node it was read for, so a replugged device is read again
+struct CachedSerialPortInfo
+{
+    SerialPortInfo info;
+    dev_t deviceNumber;
+    timespec nodeChangeTime;
+};
+
+static std::mutex serialPortInfoMutex;
+static std::unordered_map<std::string, CachedSerialPortInfo> serialPortInfoCache;
+
+static std::string readSysfsAttribute(const std::string &path)
+{
+    int fileDescriptor{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (fileDescriptor == -1) {
+        return "";
+    }
+    char buffer[256];
+    ssize_t bytesRead{read(fileDescriptor, buffer, sizeof(buffer))};
+    close(fileDescriptor);
+    if (bytesRead <= 0) {
+        return "";
+    }
+    std::string value{buffer, static_cast<size_t>(bytesRead)};
+    while ( (!value.empty()) && (isspace(static_cast<unsigned char>(value.back()))) ) {
+        value.pop_back();
+    }
+    return value;
+}
+
+static std::string resolvePath(const std::string &path)
+{
+    char resolvedPath[PATH_MAX];
+    if (realpath(path.c_str(), resolvedPath) == nullptr) {
+        return "";
+    }
+    return resolvedPath;
+}
+
+static std::string baseName(const std::string &path)
+{
+    auto foundPosition = path.rfind('/');
+    return (foundPosition == std::string::npos ? path : path.substr(foundPosition + 1));
+}
+
+//Maps each device node (/dev/ttyUSB0) to the /dev/serial/by-id link that names it
+static std::unordered_map<std::string, std::string> readSerialByIdLinks()
+{
+    std::unordered_map<std::string, std::string> returnMap{};
+    DIR *directory{opendir(SERIAL_BY_ID_DIRECTORY)};
+    if (directory == nullptr) {
+        return returnMap;
+    }
+    while (dirent *entry = readdir(directory)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string linkPath{std::string{SERIAL_BY_ID_DIRECTORY} + "/" + entry->d_name};
+        std::string targetPath{resolvePath(linkPath)};
+        if (!targetPath.empty()) {
+            returnMap.emplace(targetPath, linkPath);
+        }
+    }
+    closedir(directory);
+    return returnMap;
+}
+
+//Reads what sysfs knows about the tty called deviceName (ttyUSB0), returning false if there is no serial device behind it
+static bool readSerialPortInfo(const std::string &deviceName, const std::unordered_map<std::string, std::string> &byIdLinks, CachedSerialPortInfo *cachedInfo)
+{
+    std::string classPath{std::string{SYSFS_TTY_DIRECTORY} + "/" + deviceName};
+    //Virtual consoles, pseudo terminals and the like have no device behind them
+    std::string devicePath{resolvePath(classPath + "/device")};
+    if ( (devicePath.empty()) || (readSysfsAttribute(classPath + "/type") == UNKNOWN_UART_TYPE) ) {
+        return false;
+    }
+    SerialPortInfo &info = cachedInfo->info;
+    info = SerialPortInfo{};
+    info.portName = std::string{DEVICE_DIRECTORY} + "/" + deviceName;
+    struct stat nodeStatus{};
+    if ( (stat(info.portName.c_str(), &nodeStatus) != 0) || (!S_ISCHR(nodeStatus.st_mode)) ) {
+        return false;
+    }
+    cachedInfo->deviceNumber = nodeStatus.st_rdev;
+    cachedInfo->nodeChangeTime = nodeStatus.st_ctim;
+    info.driver = baseName(resolvePath(devicePath + "/driver"));
+    //The USB device is the nearest parent with a vendor id; the tty itself hangs off one of its interfaces
+    for (std::string path{devicePath}; path.find('/', 1) != std::string::npos; path.erase(path.rfind('/'))) {
+        std::string vendorId{readSysfsAttribute(path + "/idVendor")};
+        if (!vendorId.empty()) {
+            info.vendorId = vendorId;
+            info.productId = readSysfsAttribute(path + "/idProduct");
+            info.manufacturer = readSysfsAttribute(path + "/manufacturer");
+            info.product = readSysfsAttribute(path + "/product");
+            info.serialNumber = readSysfsAttribute(path + "/serial");
+            break;
+        }
+    }
+    auto foundLink = byIdLinks.find(info.portName);
+    if (foundLink != byIdLinks.end()) {
+        info.byIdPath = foundLink->second;
+    }
+    return true;
+}
+#endif //defined(__linux__)
+
+std::string SerialPortInfo::description() const
+{
+    //Most products already begin with the manufacturer ("FTDI" and "FTDI FT232R"), so it is only added when it says something new
+    std::string returnString{this->product};
+    if ( (!this->manufacturer.empty()) && (this->product.compare(0, this->manufacturer.length(), this->manufacturer) != 0) ) {
+        returnString = (returnString.empty() ? this->manufacturer : this->manufacturer + " " + returnString);
+    }
+    if ( (returnString.empty()) && (!this->vendorId.empty()) ) {
+        returnString = this->vendorId + ":" + this->productId;
+    }
+    if (!this->serialNumber.empty()) {
+        returnString += (returnString.empty() ? "SN=" : " SN=") + this->serialNumber;
+    }
+    return returnString;
+}
 
 SerialPort::SerialPort(const std::string &name) :
         SerialPort(name, DEFAULT_BAUD_RATE, DEFAULT_STOP_BITS, DEFAULT_DATA_BITS, DEFAULT_PARITY, DEFAULT_FLOW_CONTROL)
@@ -161,6 +295,8 @@ SerialPort::SerialPort(const std::string &name, BaudRate baudRate, StopBits stop
 }
 
 SerialPort::SerialPort(const std::string &name, BaudRate baudRate, StopBits stopBits, DataBits dataBits, Parity parity, FlowControl flowControl) :
+        m_readBuffer{DEFAULT_RECEIVE_BUFFER_SIZE},
+        m_readBufferTimestamp{0, 0},
         m_portName{name},
         m_portNumber{0},
         m_baudRate{baudRate},
@@ -168,13 +304,15 @@ SerialPort::SerialPort(const std::string &name, BaudRate baudRate, StopBits stop
         m_dataBits{dataBits},
         m_parity{parity},
         m_flowControl{flowControl},
-        m_isOpen{false}
+        m_isOpen{false},
+        m_recorder{nullptr}
 {
     std::pair<int, std::string> truePortNameAndNumber{getPortNameAndNumber(this->m_portName)};
     this->m_portNumber = truePortNameAndNumber.first;
     this->m_portName = truePortNameAndNumber.second;
 #if defined(_WIN32)
     this->m_serialPortHandle = INVALID_HANDLE_VALUE;
+    this->m_appliedReadTimeout = 0;
 #else
     this->m_fileStream = nullptr;
 #endif //defined(_WIN32)
@@ -247,23 +385,40 @@ void SerialPort::openPort()
     this->setStopBits(this->m_stopBits);
     this->setParity(this->m_parity);
     this->setFlowControl(this->m_flowControl);
-    this->setReadTimeout(this->readTimeout());
+    this->setReadTimeout(this->readTimeoutDuration());
 
-    this->enableDTR();
-    this->enableRTS();
+    //Pseudo terminals have no modem control lines, so only real ports get DTR and RTS raised
+    if (this->hasModemControlLines()) {
+        this->enableDTR();
+        this->enableRTS();
+    }
 }
 
-void SerialPort::setReadTimeout(int timeout)
+void SerialPort::setReadTimeout(std::chrono::microseconds timeout)
 {
     IByteStream::setReadTimeout(timeout);
     if (!this->isOpen()) {
         return;
     }
 #if defined(_WIN32)
+    this->applyCommTimeouts(static_cast<DWORD>(this->readTimeout()));
+#else
+    //Reads wait in select() and writes in poll(), so the descriptor itself never blocks and both timeouts are honoured
+    fcntl(this->getFileDescriptor(), F_SETFL, O_NONBLOCK);
+    if (this->readTimeoutDuration().count() != 0) {
+        this->m_portSettings.c_cc[VTIME] = static_cast<cc_t>(std::min(this->readTimeout() / 100, static_cast<int>(std::numeric_limits<cc_t>::max())));
+        tcsetattr(this->getFileDescriptor(), TCSANOW, &this->m_portSettings);
+    }
+#endif //defined(_WIN32)
+}
+
+#if defined(_WIN32)
+void SerialPort::applyCommTimeouts(DWORD readTimeout)
+{
     COMMTIMEOUTS commTimeouts{};
     commTimeouts.ReadIntervalTimeout         = MAXDWORD;
     commTimeouts.ReadTotalTimeoutMultiplier  = 0;
-    commTimeouts.ReadTotalTimeoutConstant    = static_cast<DWORD>(this->readTimeout());
+    commTimeouts.ReadTotalTimeoutConstant    = readTimeout;
     commTimeouts.WriteTotalTimeoutMultiplier = 0;
     commTimeouts.WriteTotalTimeoutConstant   = static_cast<DWORD>(this->writeTimeout());
 
@@ -272,17 +427,9 @@ void SerialPort::setReadTimeout(int timeout)
         this->closePort();
 		throw std::runtime_error("SetCommTimeouts(HANDLE, COMMTIMEOUTS*): Unable to set timeout settings for " + this->portName() + ": " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ")");
     }
-#else
-    if (this->readTimeout() == 0) {
-        fcntl(this->getFileDescriptor(), F_SETFL, O_NDELAY);
-    } else {
-        fcntl(this->getFileDescriptor(), F_SETFL, O_SYNC);
-        this->m_portSettings.c_cc[VTIME] = static_cast<cc_t>(this->readTimeout() / 100);
-        tcsetattr(this->getFileDescriptor(), TCSANOW, &this->m_portSettings);
-    }
-#endif //defined(_WIN32)
+    this->m_appliedReadTimeout = readTimeout;
 }
-
+#endif //defined(_WIN32)
 
 int SerialPort::getLastError() {
 #if defined(_WIN32)
@@ -311,24 +458,42 @@ std::string SerialPort::getErrorString(int errorCode) {
 	(void)conversionResult;
 	//wcstombs(errorString, wideErrorString, PATH_MAX);
 	LocalFree(wideErrorString);
+#elif defined(__GLIBC__) && defined(_GNU_SOURCE)
+    //The GNU strerror_r may return a static string and leave the buffer untouched
+    return std::string{strerror_r(errorCode, errorString, PATH_MAX)};
 #else
     strerror_r(errorCode, errorString, PATH_MAX);
 #endif //defined(_WIN32)
 	return std::string{ errorString };
 }
 
-char SerialPort::read()
+ssize_t SerialPort::readSome(char *buffer, size_t maxBytes, std::chrono::microseconds timeout)
 {
-#if defined(_WIN32)
+    if (maxBytes == 0) {
+        return 0;
+    }
     if (!this->m_readBuffer.empty()) {
-        char returnValue{this->m_readBuffer.front()};
-        this->m_readBuffer = this->m_readBuffer.substr(1);
-        return returnValue;
+        //Buffered bytes keep the timestamp of the read that brought them in
+        this->setLastReadTimestamp(this->m_readBufferTimestamp);
+        return static_cast<ssize_t>(this->m_readBuffer.read(buffer, maxBytes));
     }
+    if (maxBytes >= DIRECT_READ_THRESHOLD) {
+        return this->readFromPort(buffer, maxBytes, timeout);
+    }
+    //Small reads (read(), peek()) are staged through the receive buffer so each syscall still pulls a whole chunk
+    MutableByteSpan receiveSpan{this->m_readBuffer.firstWritableSpan()};
+    ssize_t bytesRead{this->readFromPort(receiveSpan.data, receiveSpan.size, timeout)};
+    if (bytesRead <= 0) {
+        return bytesRead;
+    }
+    this->m_readBuffer.commit(static_cast<size_t>(bytesRead));
+    this->m_readBufferTimestamp = this->lastReadTimestamp();
+    return static_cast<ssize_t>(this->m_readBuffer.read(buffer, maxBytes));
+}
 
-	static char readStuff[SERIAL_PORT_BUFFER_MAX];
-	memset(readStuff, '\0', SERIAL_PORT_BUFFER_MAX);
-
+ssize_t SerialPort::readFromPort(char *buffer, size_t maxBytes, std::chrono::microseconds timeout)
+{
+#if defined(_WIN32)
 	DWORD commErrors{};
 	COMSTAT commStatus{};
 	auto clearErrorsResult = ClearCommError(this->m_serialPortHandle, &commErrors, &commStatus);
@@ -337,99 +502,82 @@ char SerialPort::read()
 		std::cout << "ClearCommError(HANDLE, LPDWORD, LPCOMSTAT) error: " << toStdString(errorCode) << " (" << getErrorString(errorCode) << ")" << std::endl;
 	}
 
-    DWORD readBytes{0};
-	DWORD maxBytes{ commStatus.cbInQue };
-    bool firstByte{false};
-    if (commStatus.cbInQue == 0) {
-        maxBytes = 1;
-        firstByte = true;
+    //If nothing is queued, block (up to the read timeout) for the first byte, then pick up whatever followed it
+    bool firstByte{commStatus.cbInQue == 0};
+    //COMMTIMEOUTS only has millisecond resolution, so round up rather than turning a short wait into none
+    DWORD readTimeout{static_cast<DWORD>((timeout.count() + 999) / 1000)};
+    if ( (firstByte) && (readTimeout != this->m_appliedReadTimeout) ) {
+        this->applyCommTimeouts(readTimeout);
     }
-
-    auto readResult = ReadFile(this->m_serialPortHandle, readStuff, maxBytes, &readBytes, nullptr);
+    DWORD maxRead{firstByte ? 1 : static_cast<DWORD>(std::min(maxBytes, static_cast<size_t>(commStatus.cbInQue)))};
+    DWORD readBytes{0};
+    auto readResult = ReadFile(this->m_serialPortHandle, buffer, maxRead, &readBytes, nullptr);
     if (readResult == 0) {
 		const auto errorCode = getLastError();
 		std::cout << "ReadFile(HANDLE, LPVOID, DWORD, LPDWORD, LPDWORD) error: " << toStdString(errorCode) << " (" << getErrorString(errorCode) << ")" << std::endl;
-		return 0;
+		return -1;
 	}
-	if ( ( readBytes <= 0 ) || (readStuff[0] == '\0') ) {
-		return 0;
-    }
-    this->m_readBuffer += std::string{readStuff};
-    if (firstByte) {
+    if ( (firstByte) && (readBytes > 0) && (maxBytes > 1) ) {
         clearErrorsResult = ClearCommError(this->m_serialPortHandle, &commErrors, &commStatus);
         if ( (clearErrorsResult != 0) && (commStatus.cbInQue != 0) ) {
-            readResult = ReadFile(this->m_serialPortHandle, readStuff, commStatus.cbInQue, &readBytes, nullptr);
-            if ((readResult != 0) && (readBytes > 0)) {
-                this->m_readBuffer += readStuff;
+            DWORD moreBytes{0};
+            maxRead = static_cast<DWORD>(std::min(maxBytes - 1, static_cast<size_t>(commStatus.cbInQue)));
+            if (ReadFile(this->m_serialPortHandle, buffer + 1, maxRead, &moreBytes, nullptr) != 0) {
+                readBytes += moreBytes;
             }
         }
     }
-    char returnValue{this->m_readBuffer.front()};
-    this->m_readBuffer = this->m_readBuffer.substr(1);
-    return static_cast<int>(returnValue);
-#else
-    if (!this->m_readBuffer.empty()) {
-        char returnValue{this->m_readBuffer.front()};
-        this->m_readBuffer = this->m_readBuffer.substr(1);
-        return returnValue;
+    if (readBytes > 0) {
+        this->stampRead();
     }
-
+    auto recorder = std::atomic_load(&this->m_recorder);
+    if ( (recorder) && (readBytes > 0) ) {
+        recorder->record(RecordDirection::Received, buffer, static_cast<size_t>(readBytes));
+    }
+    return static_cast<ssize_t>(readBytes);
+#else
     // Initialize file descriptor sets
-    fd_set read_fds{0, 0, 0};
-    fd_set write_fds{0, 0, 0};
-    fd_set except_fds{0, 0, 0};
+    fd_set read_fds{};
     FD_ZERO(&read_fds);
-    FD_ZERO(&write_fds);
-    FD_ZERO(&except_fds);
     FD_SET(this->getFileDescriptor(), &read_fds);
 
-    struct timeval timeout{0, 0};
-    timeout.tv_sec = 0;
-    timeout.tv_usec = (this->readTimeout() * 1000);
-    static char readStuff[SERIAL_PORT_BUFFER_MAX];
-    memset(readStuff, '\0', SERIAL_PORT_BUFFER_MAX);
+    struct timeval selectTimeout{0, 0};
+    selectTimeout.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+    selectTimeout.tv_usec = static_cast<suseconds_t>(timeout.count() % 1000000);
 
     // Wait for input to become ready or until the time out; the first parameter is
     // 1 more than the largest file descriptor in any of the sets
-    if (select(this->getFileDescriptor() + 1, &read_fds, &write_fds, &except_fds, &timeout) == 1) {
-        int bytesAvailable{0};
-        ioctl(this->getFileDescriptor(), FIONREAD, &bytesAvailable);
-        auto returnedBytes = fread(readStuff, sizeof(char), static_cast<size_t>(bytesAvailable), this->m_fileStream);
-        //auto returnedBytes = fread(&readValue, sizeof(char), 1, this->m_fileStream);
-        if ((returnedBytes <= 0) || (readStuff[0] == '\0')) {
-            return 0;
-        }
-        this->m_readBuffer += std::string{readStuff};
-        char returnValue{this->m_readBuffer.front()};
-        this->m_readBuffer = this->m_readBuffer.substr(1);
-        return returnValue;
+    auto selectResult = select(this->getFileDescriptor() + 1, &read_fds, nullptr, nullptr, &selectTimeout);
+    if (selectResult == 0) {
+        return 0;
+    } else if (selectResult < 0) {
+        return (getLastError() == EINTR ? 0 : -1);
     }
-    return 0;
+    //Read straight into the caller's buffer, bypassing stdio buffering on m_fileStream
+    auto returnedBytes = ::read(this->getFileDescriptor(), buffer, maxBytes);
+    if (returnedBytes < 0) {
+        const auto errorCode = getLastError();
+        return ( ((errorCode == EAGAIN) || (errorCode == EINTR)) ? 0 : -1 );
+    }
+    if (returnedBytes > 0) {
+        this->stampRead();
+    }
+    auto recorder = std::atomic_load(&this->m_recorder);
+    if ( (recorder) && (returnedBytes > 0) ) {
+        recorder->record(RecordDirection::Received, buffer, static_cast<size_t>(returnedBytes));
+    }
+    return returnedBytes;
 #endif
 }
 
 ssize_t SerialPort::write(char c)
 {
-#if defined(_WIN32)
-    DWORD writtenBytes{0};
-	if (!WriteFile(this->m_serialPortHandle, &c, 1 , &writtenBytes, nullptr)) {
-        auto errorCode = getLastError();
-        (void)errorCode;
-        //TODO: Check if errorCode is IO_NOT_COMPLETED or whatever
-        return 0;
-    }
-    return static_cast<ssize_t>(writtenBytes);
-#else
-    auto writtenBytes = ::write(this->getFileDescriptor(), &c, 1);
-    if (writtenBytes != 0) {
-        return (getLastError() == EAGAIN ? 0 : writtenBytes);
-    }
-    return writtenBytes;
-#endif //defined(_WIN32)
+    return this->write(&c, 1);
 }
 
 ssize_t SerialPort::write(const char *bytes, size_t numberOfBytes) {
 #if defined(_WIN32)
+    //WriteTotalTimeoutConstant makes WriteFile give up after the write timeout on its own
 	DWORD writtenBytes{ 0 };
 	if (!WriteFile(this->m_serialPortHandle, bytes, numberOfBytes, &writtenBytes, nullptr)) {
 		auto errorCode = getLastError();
@@ -437,13 +585,109 @@ ssize_t SerialPort::write(const char *bytes, size_t numberOfBytes) {
 		//TODO: Check if errorCode is IO_NOT_COMPLETED or whatever
 		return 0;
 	}
+	auto recorder = std::atomic_load(&this->m_recorder);
+	if ( (recorder) && (writtenBytes > 0) ) {
+		recorder->record(RecordDirection::Transmitted, bytes, static_cast<size_t>(writtenBytes));
+	}
 	return static_cast<ssize_t>(writtenBytes);
 #else
-	auto writtenBytes = ::write(this->getFileDescriptor(), bytes, numberOfBytes);
-	if (writtenBytes != 0) {
-		return (getLastError() == EAGAIN ? 0 : writtenBytes);
-	}
-	return writtenBytes;
+    ByteSpan span{bytes, numberOfBytes};
+    return this->write(&span, 1);
+#endif //defined(_WIN32)
+}
+
+ssize_t SerialPort::write(const ByteSpan *spans, size_t spanCount)
+{
+#if defined(_WIN32)
+    return IByteStream::write(spans, spanCount);
+#else
+    //Keep going until everything is written or the write timeout runs out, so flow control never silently drops a tail
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{this->writeTimeout()};
+    size_t totalWritten{0};
+    size_t spanIndex{0};
+    size_t spanOffset{0};
+    pollfd pollDescriptor{this->getFileDescriptor(), POLLOUT, 0};
+    iovec vectors[WRITE_VECTOR_BATCH];
+    auto recorder = std::atomic_load(&this->m_recorder);
+    while (true) {
+        while ( (spanIndex < spanCount) && (spanOffset == spans[spanIndex].size) ) {
+            spanIndex++;
+            spanOffset = 0;
+        }
+        if (spanIndex == spanCount) {
+            break;
+        }
+        int vectorCount{0};
+        for (size_t i = spanIndex; (i < spanCount) && (vectorCount < static_cast<int>(WRITE_VECTOR_BATCH)); i++) {
+            size_t offset{i == spanIndex ? spanOffset : 0};
+            if (spans[i].size > offset) {
+                vectors[vectorCount++] = iovec{const_cast<char *>(spans[i].data + offset), spans[i].size - offset};
+            }
+        }
+        auto writtenBytes = ::writev(this->getFileDescriptor(), vectors, vectorCount);
+        if (writtenBytes > 0) {
+            if (recorder) {
+                recorder->record(RecordDirection::Transmitted, spans + spanIndex, spanCount - spanIndex, spanOffset, static_cast<size_t>(writtenBytes));
+            }
+            totalWritten += static_cast<size_t>(writtenBytes);
+            //Step over every span the kernel took, stopping part way into the last one
+            auto remainingBytes = static_cast<size_t>(writtenBytes);
+            while (remainingBytes > 0) {
+                size_t spanRemaining{spans[spanIndex].size - spanOffset};
+                if (remainingBytes < spanRemaining) {
+                    spanOffset += remainingBytes;
+                    remainingBytes = 0;
+                } else {
+                    remainingBytes -= spanRemaining;
+                    spanIndex++;
+                    spanOffset = 0;
+                }
+            }
+            continue;
+        }
+        const auto errorCode = getLastError();
+        if ( (writtenBytes < 0) && (errorCode != EAGAIN) && (errorCode != EINTR) ) {
+            return (totalWritten > 0 ? static_cast<ssize_t>(totalWritten) : -1);
+        }
+        auto remainingTime = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remainingTime.count() <= 0) {
+            break;
+        }
+        auto pollResult = poll(&pollDescriptor, 1, static_cast<int>(remainingTime.count()));
+        if ( (pollResult < 0) && (getLastError() != EINTR) ) {
+            return (totalWritten > 0 ? static_cast<ssize_t>(totalWritten) : -1);
+        } else if ( (pollResult > 0) && (pollDescriptor.revents & (POLLERR | POLLHUP | POLLNVAL)) ) {
+            return (totalWritten > 0 ? static_cast<ssize_t>(totalWritten) : -1);
+        }
+    }
+    return static_cast<ssize_t>(totalWritten);
+#endif //defined(_WIN32)
+}
+
+bool SerialPort::drainTx()
+{
+    if (!this->isOpen()) {
+        return false;
+    }
+#if defined(_WIN32)
+    return (FlushFileBuffers(this->m_serialPortHandle) != 0);
+#else
+    while (tcdrain(this->getFileDescriptor()) != 0) {
+        if (getLastError() != EINTR) {
+            return false;
+        }
+    }
+    return true;
+#endif //defined(_WIN32)
+}
+
+void SerialPort::setWriteTimeout(int timeout)
+{
+    IByteStream::setWriteTimeout(timeout);
+#if defined(_WIN32)
+    if (this->isOpen()) {
+        this->applyCommTimeouts(this->m_appliedReadTimeout);
+    }
 #endif //defined(_WIN32)
 }
 
@@ -457,7 +701,12 @@ void SerialPort::closePort()
     CloseHandle(this->m_serialPortHandle);
 #else
     this->m_portSettings = this->m_oldPortSettings;
-    this->applyPortSettings();
+    try {
+        this->applyPortSettings();
+    } catch (std::exception &e) {
+        //A device that has gone away cannot have its old settings restored, but the descriptor must still be released
+        (void)e;
+    }
     flock(this->getFileDescriptor(), LOCK_UN);
     fclose(this->m_fileStream);
 #endif
@@ -483,6 +732,23 @@ modem_status_t SerialPort::getModemStatus() const
     return status;
 }
 
+bool SerialPort::hasModemControlLines() const
+{
+#if defined(_WIN32)
+    return true;
+#else
+    modem_status_t status{0};
+    if (ioctl(this->getFileDescriptor(), TIOCMGET, &status) == -1) {
+        const auto errorCode = getLastError();
+        if ((errorCode == ENOTTY) || (errorCode == EINVAL)) {
+            return false;
+        }
+        throw std::runtime_error("ioctl(int, int, int): Unable to get modem settings for " + this->portName() + ": " + toStdString(errorCode) + " (" + getErrorString(errorCode) + ")");
+    }
+    return true;
+#endif //defined(_WIN32)
+}
+
 void SerialPort::enableDTR()
 {
     if (!this->isOpen()) {
@@ -634,7 +900,22 @@ bool SerialPort::isAvailableSerialPort(const std::string &name)
     copyName.erase(std::remove_if(copyName.begin(), copyName.end(), [](char c) { return ( (c == '.') || (c == '\\') ); }), copyName.end());
 	return (availablePorts.find(copyName) != availablePorts.end());
 #else
-	return (availablePorts.find(name) != availablePorts.end());
+	return ((availablePorts.find(name) != availablePorts.end()) || isCharacterDevice(name));
+#endif //defined(_WIN32)
+}
+
+bool SerialPort::isCharacterDevice(const std::string &name)
+{
+#if defined(_WIN32)
+    (void)name;
+    return false;
+#else
+    //Anything outside the well known names (a pseudo terminal, a udev symlink) is accepted if it is a tty device node
+    struct stat fileStatus{};
+    if (stat(name.c_str(), &fileStatus) != 0) {
+        return false;
+    }
+    return S_ISCHR(fileStatus.st_mode);
 #endif //defined(_WIN32)
 }
 
@@ -881,30 +1162,141 @@ std::unordered_set<std::string> SerialPort::availableSerialPorts()
         return returnSet;
     }
 #else
-    for (auto &it : SerialPort::SERIAL_PORT_NAMES) {
-        if (IByteStream::fileExists(std::string{it})) {
-            returnSet.emplace(it);
-        }
+    for (auto &it : SerialPort::availableSerialPortInfo()) {
+        returnSet.emplace(it.portName);
     }
     return returnSet;
 #endif
 }
 
-std::vector<std::string> SerialPort::generateSerialPortNames()
+std::vector<SerialPortInfo> SerialPort::availableSerialPortInfo()
 {
-    std::vector<std::string> returnSet;
+    std::vector<SerialPortInfo> returnVector{};
 #if defined(_WIN32)
-	for (int i = 0; i < UCHAR_MAX; i++) {
-		returnSet.push_back(AVAILABLE_PORT_NAMES_BASE + toStdString(i));
-	}
+    for (auto &it : SerialPort::availableSerialPorts()) {
+        SerialPortInfo info{};
+        info.portName = it;
+        returnVector.push_back(info);
+    }
 #else
-	for (auto &it : SerialPort::AVAILABLE_PORT_NAMES_BASE) {
-		for (int i = 0; i < UCHAR_MAX; i++) {
-			returnSet.push_back(it + toStdString(i));
-		}
-	}
+#if defined(__linux__)
+    //One pass over the ttys the kernel registered, instead of probing every name a port could have
+    DIR *directory{opendir(SYSFS_TTY_DIRECTORY)};
+    if (directory != nullptr) {
+        std::unordered_map<std::string, std::string> byIdLinks{readSerialByIdLinks()};
+        std::unordered_map<std::string, CachedSerialPortInfo> serialPortInfo{};
+        while (dirent *entry = readdir(directory)) {
+            std::string portName{std::string{DEVICE_DIRECTORY} + "/" + entry->d_name};
+            if (!SerialPort::isValidSerialPortName(portName)) {
+                continue;
+            }
+            CachedSerialPortInfo cachedInfo{};
+            if (readSerialPortInfo(entry->d_name, byIdLinks, &cachedInfo)) {
+                returnVector.push_back(cachedInfo.info);
+                serialPortInfo.emplace(portName, cachedInfo);
+            }
+        }
+        closedir(directory);
+        std::lock_guard<std::mutex> infoLock{serialPortInfoMutex};
+        serialPortInfoCache = std::move(serialPortInfo);
+        return returnVector;
+    }
+#endif //defined(__linux__)
+    //Without sysfs (another system, or /sys not mounted) every well known name is probed instead
+    for (auto &it : SerialPort::AVAILABLE_PORT_NAMES_BASE) {
+        for (int i = 0; i < UCHAR_MAX; i++) {
+            std::string portName{it + toStdString(i)};
+            if (IByteStream::fileExists(portName)) {
+                SerialPortInfo info{};
+                info.portName = portName;
+                returnVector.push_back(info);
+            }
+        }
+    }
+#endif //defined(_WIN32)
+    return returnVector;
+}
+
+bool SerialPort::findSerialPortInfo(const std::string &portName, SerialPortInfo *info)
+{
+#if defined(_WIN32)
+    if (!SerialPort::isValidSerialPortName(portName)) {
+        return false;
+    }
+    *info = SerialPortInfo{};
+    info->portName = portName;
+    return true;
+#else
+#if defined(__linux__)
+    if (access(SYSFS_TTY_DIRECTORY, F_OK) == 0) {
+        //A by-id link or any other alias is looked up under the node it points to
+        std::string devicePath{resolvePath(portName)};
+        struct stat nodeStatus{};
+        if ( (devicePath.empty()) || (stat(devicePath.c_str(), &nodeStatus) != 0) ) {
+            return false;
+        }
+        std::lock_guard<std::mutex> infoLock{serialPortInfoMutex};
+        auto foundPosition = serialPortInfoCache.find(devicePath);
+        if ( (foundPosition != serialPortInfoCache.end()) &&
+             (foundPosition->second.deviceNumber == nodeStatus.st_rdev) &&
+             (foundPosition->second.nodeChangeTime.tv_sec == nodeStatus.st_ctim.tv_sec) &&
+             (foundPosition->second.nodeChangeTime.tv_nsec == nodeStatus.st_ctim.tv_nsec) ) {
+            *info = foundPosition->second.info;
+            return true;
+        }
+        //Plugged in since the last scan, or replaced by another device under the same name
+        CachedSerialPortInfo cachedInfo{};
+        if ( (devicePath.compare(0, strlen(DEVICE_DIRECTORY) + 1, std::string{DEVICE_DIRECTORY} + "/") != 0) ||
+             (!readSerialPortInfo(baseName(devicePath), readSerialByIdLinks(), &cachedInfo)) ) {
+            serialPortInfoCache.erase(devicePath);
+            return false;
+        }
+        *info = cachedInfo.info;
+        serialPortInfoCache[devicePath] = cachedInfo;
+        return true;
+    }
+#endif //defined(__linux__)
+    //Without sysfs all that is known is that a well known port name exists
+    if ( (!SerialPort::isValidSerialPortName(portName)) || (!IByteStream::fileExists(portName)) ) {
+        return false;
+    }
+    *info = SerialPortInfo{};
+    info->portName = portName;
+    return true;
+#endif //defined(_WIN32)
+}
+
+int SerialPort::serialPortNumber(const std::string &serialPortName)
+{
+#if defined(_WIN32)
+    (void)serialPortName;
+    return -1;
+#else
+    //Parsed rather than looked up in a table of every possible name, so nothing has to be built before main()
+    int prefixIndex{0};
+    for (auto &it : SerialPort::AVAILABLE_PORT_NAMES_BASE) {
+        size_t prefixLength{strlen(it)};
+        size_t digitCount{serialPortName.length() - prefixLength};
+        //At most three digits with no leading zero, the same names the numbers were always handed out for
+        if ( (serialPortName.length() > prefixLength) && (digitCount <= 3) && (serialPortName.compare(0, prefixLength, it) == 0) &&
+             ( (digitCount == 1) || (serialPortName[prefixLength] != '0') ) ) {
+            int number{0};
+            bool isNumber{true};
+            for (size_t i = prefixLength; i < serialPortName.length(); i++) {
+                if (!isdigit(static_cast<unsigned char>(serialPortName[i]))) {
+                    isNumber = false;
+                    break;
+                }
+                number = (number * 10) + (serialPortName[i] - '0');
+            }
+            if ( (isNumber) && (number < UCHAR_MAX) ) {
+                return (prefixIndex * UCHAR_MAX) + number;
+            }
+        }
+        prefixIndex++;
+    }
+    return -1;
 #endif //defined(_WIN32)
-    return returnSet;
 }
 
 bool SerialPort::isValidSerialPortName(const std::string &serialPortName)
@@ -921,26 +1313,65 @@ bool SerialPort::isValidSerialPortName(const std::string &serialPortName)
 		return false;
 	}
 #else
-    for (auto &it : SerialPort::AVAILABLE_PORT_NAMES_BASE) {
-        for (int i = 0; i < UCHAR_MAX; i++) {
-            if (serialPortName == (it + toStdString(i))) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return (serialPortNumber(serialPortName) != -1);
 #endif
 }
 
-void SerialPort::putBack(char c)
+uint64_t SerialPort::characterDuration(unsigned bitsPerSecond, DataBits dataBits, Parity parity, StopBits stopBits)
+{
+    if (bitsPerSecond == 0) {
+        throw std::runtime_error("SerialPort::characterDuration(unsigned, DataBits, Parity, StopBits): invariant failure (bitsPerSecond cannot be 0)");
+    }
+    //Counted in half bits, so one and a half stop bits stays exact
+    uint64_t halfBits{2};
+    switch (dataBits) {
+        case DataBits::DataFive: halfBits += 10; break;
+        case DataBits::DataSix: halfBits += 12; break;
+        case DataBits::DataSeven: halfBits += 14; break;
+        case DataBits::DataEight: halfBits += 16; break;
+    }
+    if (parity != Parity::ParityNone) {
+        halfBits += 2;
+    }
+#if defined(_WIN32)
+    halfBits += (stopBits == StopBits::StopTwo ? 4 : (stopBits == StopBits::StopOneFive ? 3 : 2));
+#else
+    halfBits += (stopBits == StopBits::StopTwo ? 4 : 2);
+#endif //defined(_WIN32)
+    return (halfBits * 1000000000ull) / (2ull * bitsPerSecond);
+}
+
+void SerialPort::putBack(const char *bytes, size_t numberOfBytes)
 {
-    if (this->m_readBuffer.length() > 0) {
-        this->m_readBuffer.insert(this->m_readBuffer.begin(), static_cast<char>(c));
-    } else {
-#if !defined(_WIN32)
-        ungetc(c, this->m_fileStream);
-#endif //!defined(_WIN32)
+    //Bytes put back into an empty buffer came from the last read (readUntil reading straight from the port), not an earlier staged one
+    if (this->m_readBuffer.empty()) {
+        this->m_readBufferTimestamp = this->lastReadTimestamp();
     }
+    this->m_readBuffer.putBack(bytes, numberOfBytes);
+}
+
+void SerialPort::setReceiveBufferSize(size_t size)
+{
+    if (size < READ_CHUNK_SIZE) {
+        throw std::runtime_error("SerialPort::setReceiveBufferSize(size_t): invariant failure (receive buffer must hold at least one read chunk, " + toStdString(size) + " < " + toStdString(static_cast<size_t>(READ_CHUNK_SIZE)) + ")");
+    }
+    this->m_readBuffer.setCapacity(size);
+}
+
+void SerialPort::setRecorder(std::shared_ptr<SessionRecorder> recorder)
+{
+    //The reader and writer threads pick the recorder up on their next system call
+    std::atomic_store(&this->m_recorder, recorder);
+}
+
+std::shared_ptr<SessionRecorder> SerialPort::recorder() const
+{
+    return std::atomic_load(&this->m_recorder);
+}
+
+size_t SerialPort::receiveBufferSize() const
+{
+    return this->m_readBuffer.capacity();
 }
 
 std::pair<int, std::string> SerialPort::getPortNameAndNumber(const std::string &name)
@@ -959,25 +1390,28 @@ std::pair<int, std::string> SerialPort::getPortNameAndNumber(const std::string &
 	}
 #else
     std::string str{name};
-    auto iter = std::find(SERIAL_PORT_NAMES.cbegin(), SERIAL_PORT_NAMES.cend(), str);
-    if (iter != SERIAL_PORT_NAMES.cend()) {
-        return std::make_pair(static_cast<int>(std::distance(SERIAL_PORT_NAMES.begin(), iter)), str);
+    int portNumber{serialPortNumber(str)};
+    if (portNumber != -1) {
+        return std::make_pair(portNumber, str);
     }
     str = name;
     if (str.find("/dev/tty") == std::string::npos) {
         str = "/dev/tty" + str;
     }
-    iter = std::find(SERIAL_PORT_NAMES.cbegin(), SERIAL_PORT_NAMES.cend(), str);
-    if (iter != SERIAL_PORT_NAMES.cend()) {
-        return std::make_pair(static_cast<int>(std::distance(SERIAL_PORT_NAMES.begin(), iter)), str);
+    portNumber = serialPortNumber(str);
+    if (portNumber != -1) {
+        return std::make_pair(portNumber, str);
     }
     str = name;
     if (str.find("/dev/") == std::string::npos) {
         str = "/dev/" + str;
     }
-    iter = std::find(SERIAL_PORT_NAMES.cbegin(), SERIAL_PORT_NAMES.cend(), str);
-    if (iter != SERIAL_PORT_NAMES.cend()) {
-        return std::make_pair(static_cast<int>(std::distance(SERIAL_PORT_NAMES.begin(), iter)), str);
+    portNumber = serialPortNumber(str);
+    if (portNumber != -1) {
+        return std::make_pair(portNumber, str);
+    }
+    if ((name.find('/') == 0) && isCharacterDevice(name)) {
+        return std::make_pair(-1, name);
     }
 
     throw std::runtime_error("ERROR: " + name + " is an invalid serial port name");
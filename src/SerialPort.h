@@ -24,7 +24,10 @@
 #include <sstream>
 
 #include "IByteStream.h"
+#include "RingBuffer.h"
+#include "SessionRecorder.h"
 #include <unordered_set>
+#include <memory>
 
 
 namespace CppSerialPort {
@@ -130,6 +133,22 @@ enum class BaudRate {
 };
 #endif
 
+//What the system knows about a serial port. The USB fields are empty for ports that do not sit on a USB device
+struct SerialPortInfo
+{
+    std::string portName;
+    std::string driver;
+    std::string vendorId;
+    std::string productId;
+    std::string manufacturer;
+    std::string product;
+    std::string serialNumber;
+    std::string byIdPath;
+
+    //A label such as "FTDI FT232R USB UART SN=A50285BI", or an empty string when there is nothing to say about the port
+    std::string description() const;
+};
+
 class SerialPort : public IByteStream
 {
 public:
@@ -167,8 +186,11 @@ public:
 
 	void openPort() override;
     void closePort() override;
-    char read() override;
-    void setReadTimeout(int timeout) override;
+    using IByteStream::readSome;
+    using IByteStream::setReadTimeout;
+    ssize_t readSome(char *buffer, size_t maxBytes, std::chrono::microseconds timeout) override;
+    void setReadTimeout(std::chrono::microseconds timeout) override;
+    void setWriteTimeout(int timeout) override;
 
 public:
     std::string portName() const override;
@@ -185,6 +207,8 @@ public:
     void flushTx() override;
     ssize_t write(char c) override;
 	ssize_t write(const char *bytes, size_t numberOfBytes) override;
+    ssize_t write(const ByteSpan *spans, size_t spanCount) override;
+    bool drainTx();
 
     void setBaudRate(BaudRate baudRate);
     void setStopBits(StopBits stopBits);
@@ -198,6 +222,15 @@ public:
     Parity parity() const;
     FlowControl flowControl() const;
 
+    void setReceiveBufferSize(size_t size);
+    size_t receiveBufferSize() const;
+
+    //Every chunk that crosses the port from now on is also handed to the recorder; nullptr stops recording
+    void setRecorder(std::shared_ptr<SessionRecorder> recorder);
+    std::shared_ptr<SessionRecorder> recorder() const;
+
+    int getFileDescriptor() const;
+
 
     static const StopBits DEFAULT_STOP_BITS;
     static const Parity DEFAULT_PARITY;
@@ -206,13 +239,20 @@ public:
     static const FlowControl DEFAULT_FLOW_CONTROL;
     static const std::string DEFAULT_LINE_ENDING;
 
+    //How long one character takes on the wire (start bit, data, parity, stop bits) at bitsPerSecond, in nanoseconds
+    static uint64_t characterDuration(unsigned bitsPerSecond, DataBits dataBits, Parity parity, StopBits stopBits);
+
     static std::unordered_set<std::string> availableSerialPorts();
+    static std::vector<SerialPortInfo> availableSerialPortInfo();
+    static bool findSerialPortInfo(const std::string &portName, SerialPortInfo *info);
     static bool isValidSerialPortName(const std::string &serialPortName);
 
     static const long DEFAULT_RETRY_COUNT;
+    static const size_t DEFAULT_RECEIVE_BUFFER_SIZE;
 
 private:
-    std::string m_readBuffer;
+    RingBuffer m_readBuffer;
+    ReadTimestamp m_readBufferTimestamp;
     std::string m_portName;
     int m_portNumber;
     BaudRate m_baudRate;
@@ -221,18 +261,20 @@ private:
     Parity m_parity;
     FlowControl m_flowControl;
     bool m_isOpen;
+    std::shared_ptr<SessionRecorder> m_recorder;
 
     static const long constexpr SERIAL_PORT_BUFFER_MAX{4096};
     static const long constexpr SINGLE_MESSAGE_BUFFER_MAX{4096};
+    static const size_t constexpr DIRECT_READ_THRESHOLD{256};
+    static const size_t constexpr WRITE_VECTOR_BATCH{512};
 
     static bool isAvailableSerialPort(const std::string &name);
+    static bool isCharacterDevice(const std::string &name);
     static std::pair<int, std::string> getPortNameAndNumber(const std::string &name);
-    static std::vector<std::string> generateSerialPortNames();
+    static int serialPortNumber(const std::string &serialPortName);
 
-    static const std::vector<std::string> SERIAL_PORT_NAMES;
-    void putBack(char c) override;
-
-    int getFileDescriptor() const;
+    void putBack(const char *bytes, size_t numberOfBytes) override;
+    ssize_t readFromPort(char *buffer, size_t maxBytes, std::chrono::microseconds timeout);
 
 	static int getLastError();
 	static std::string getErrorString(int errorCode);
@@ -244,6 +286,8 @@ private:
     static const char *SERIAL_PORT_REGISTRY_PATH;
     HANDLE m_serialPortHandle;
     COMMCONFIG m_portSettings;
+    DWORD m_appliedReadTimeout;
+    void applyCommTimeouts(DWORD readTimeout);
 #else
 	FILE *m_fileStream;
 	static const std::vector<const char *> AVAILABLE_PORT_NAMES_BASE;
@@ -252,6 +296,7 @@ private:
     termios m_oldPortSettings;
 #endif
     void applyPortSettings();
+    bool hasModemControlLines() const;
         modem_status_t getModemStatus() const; };
 
 } //namespace CppSerialPort
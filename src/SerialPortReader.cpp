@@ -0,0 +1,245 @@
+/***********************************************************************
+*    SerialPortReader.cpp:                                             *
+*    SerialPortReader, background receive thread for a SerialPort      *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a SerialPortReader class    *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "SerialPortReader.h"
+
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#    include <unistd.h>
+#endif //!defined(_WIN32)
+
+namespace CppSerialPort {
+
+const size_t SerialPortReader::DEFAULT_QUEUE_CAPACITY{1024};
+
+SerialPortReader::SerialPortReader(std::shared_ptr<SerialPort> serialPort, std::function<void()> dataAvailableCallback) :
+    m_serialPort{serialPort},
+    m_dataAvailableNotifier{dataAvailableCallback},
+    m_receiveQueue{DEFAULT_QUEUE_CAPACITY},
+    m_readThread{},
+    m_isRunning{false},
+    m_hasError{false},
+    m_errorString{""}
+#if !defined(_WIN32)
+    ,m_epollFileDescriptor{-1},
+    m_shutdownEventFileDescriptor{-1}
+#endif //!defined(_WIN32)
+{
+    if (!this->m_serialPort) {
+        throw std::runtime_error("SerialPortReader::SerialPortReader(std::shared_ptr<SerialPort>, std::function<void()>): invariant failure (serialPort cannot be null)");
+    }
+}
+
+void SerialPortReader::start()
+{
+    if (this->m_isRunning) {
+        return;
+    }
+    //A thread that stopped on an error has still to be joined, and its event descriptors closed
+    this->stop();
+    if (!this->m_serialPort->isOpen()) {
+        throw std::runtime_error("SerialPortReader::start(): " + this->m_serialPort->portName() + " is not open");
+    }
+#if !defined(_WIN32)
+    this->m_epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (this->m_epollFileDescriptor == -1) {
+        const auto errorCode = errno;
+        throw std::runtime_error("epoll_create1(int): Unable to create epoll instance for " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    this->m_shutdownEventFileDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (this->m_shutdownEventFileDescriptor == -1) {
+        const auto errorCode = errno;
+        this->closeEventFileDescriptors();
+        throw std::runtime_error("eventfd(unsigned int, int): Unable to create shutdown event for " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    epoll_event portEvent{};
+    portEvent.events = EPOLLIN;
+    portEvent.data.fd = this->m_serialPort->getFileDescriptor();
+    epoll_event shutdownEvent{};
+    shutdownEvent.events = EPOLLIN;
+    shutdownEvent.data.fd = this->m_shutdownEventFileDescriptor;
+    if ( (epoll_ctl(this->m_epollFileDescriptor, EPOLL_CTL_ADD, portEvent.data.fd, &portEvent) == -1) ||
+         (epoll_ctl(this->m_epollFileDescriptor, EPOLL_CTL_ADD, shutdownEvent.data.fd, &shutdownEvent) == -1) ) {
+        const auto errorCode = errno;
+        this->closeEventFileDescriptors();
+        throw std::runtime_error("epoll_ctl(int, int, int, epoll_event *): Unable to watch " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+#endif //!defined(_WIN32)
+    this->m_hasError = false;
+    this->m_isRunning = true;
+    this->m_readThread = std::thread{&SerialPortReader::run, this};
+}
+
+void SerialPortReader::stop()
+{
+    if (!this->m_readThread.joinable()) {
+        return;
+    }
+    this->m_isRunning = false;
+#if !defined(_WIN32)
+    uint64_t wakeValue{1};
+    if (::write(this->m_shutdownEventFileDescriptor, &wakeValue, sizeof(wakeValue)) == -1) {
+        //The thread still checks m_isRunning after every wakeup, so it will exit on its next read
+    }
+#endif //!defined(_WIN32)
+    this->m_readThread.join();
+#if !defined(_WIN32)
+    this->closeEventFileDescriptors();
+#endif //!defined(_WIN32)
+}
+
+bool SerialPortReader::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+bool SerialPortReader::tryPop(ReceivedChunk &chunk)
+{
+    return this->m_receiveQueue.tryPop(chunk);
+}
+
+void SerialPortReader::acknowledgeNotification()
+{
+    this->m_dataAvailableNotifier.acknowledge();
+}
+
+bool SerialPortReader::hasError() const
+{
+    return this->m_hasError.load(std::memory_order_acquire);
+}
+
+std::string SerialPortReader::errorString() const
+{
+    if (!this->hasError()) {
+        return "";
+    }
+    return this->m_errorString;
+}
+
+void SerialPortReader::setError(const std::string &errorString)
+{
+    this->m_errorString = errorString;
+    this->m_hasError.store(true, std::memory_order_release);
+    this->m_isRunning = false;
+    this->m_dataAvailableNotifier.notify();
+}
+
+bool SerialPortReader::pushChunk(ReceivedChunk &&chunk)
+{
+    while (!this->m_receiveQueue.tryPush(std::move(chunk))) {
+        //The consumer is behind; let the kernel buffer the port rather than dropping data
+        if (!this->m_isRunning) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    this->m_dataAvailableNotifier.notify();
+    return true;
+}
+
+ssize_t SerialPortReader::readChunk(char *buffer, size_t bufferSize)
+{
+    ssize_t bytesRead{this->m_serialPort->readSome(buffer, bufferSize)};
+    if (bytesRead < 0) {
+        const auto errorCode = errno;
+        this->setError("Unable to read from " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+        return -1;
+    }
+    if ( (bytesRead > 0) && (!this->pushChunk(ReceivedChunk{std::string{buffer, static_cast<size_t>(bytesRead)}, this->m_serialPort->lastReadTimestamp()})) ) {
+        return -1;
+    }
+    return bytesRead;
+}
+
+#if defined(_WIN32)
+void SerialPortReader::run()
+{
+    char readBuffer[READ_BUFFER_SIZE];
+    while (this->m_isRunning) {
+        //No epoll here; readSome() blocks for at most the port's read timeout, which bounds stop() latency
+        if (this->readChunk(readBuffer, sizeof(readBuffer)) < 0) {
+            return;
+        }
+    }
+}
+
+void SerialPortReader::closeEventFileDescriptors()
+{
+
+}
+#else
+void SerialPortReader::run()
+{
+    char readBuffer[READ_BUFFER_SIZE];
+    epoll_event events[2];
+    while (this->m_isRunning) {
+        int eventCount{epoll_wait(this->m_epollFileDescriptor, events, 2, -1)};
+        if (eventCount == -1) {
+            const auto errorCode = errno;
+            if (errorCode == EINTR) {
+                continue;
+            }
+            this->setError("epoll_wait(int, epoll_event *, int, int): " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+            return;
+        }
+        for (int i = 0; i < eventCount; i++) {
+            if (events[i].data.fd == this->m_shutdownEventFileDescriptor) {
+                return;
+            }
+            if (events[i].events & EPOLLIN) {
+                //Level triggered: if more than one chunk is waiting, epoll_wait returns again immediately
+                ssize_t bytesRead{this->readChunk(readBuffer, sizeof(readBuffer))};
+                if (bytesRead < 0) {
+                    return;
+                } else if (bytesRead > 0) {
+                    continue;
+                }
+            }
+            //A hung up tty stays readable but only ever returns end of file
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                this->setError(this->m_serialPort->portName() + " was disconnected");
+                return;
+            }
+        }
+    }
+}
+
+void SerialPortReader::closeEventFileDescriptors()
+{
+    if (this->m_shutdownEventFileDescriptor != -1) {
+        close(this->m_shutdownEventFileDescriptor);
+        this->m_shutdownEventFileDescriptor = -1;
+    }
+    if (this->m_epollFileDescriptor != -1) {
+        close(this->m_epollFileDescriptor);
+        this->m_epollFileDescriptor = -1;
+    }
+}
+#endif //defined(_WIN32)
+
+SerialPortReader::~SerialPortReader()
+{
+    this->stop();
+}
+
+} //namespace CppSerialPort
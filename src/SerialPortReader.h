@@ -0,0 +1,92 @@
+/***********************************************************************
+*    SerialPortReader.h:                                               *
+*    SerialPortReader, background receive thread for a SerialPort      *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a SerialPortReader class      *
+*    One long-lived thread per open port sleeps in epoll_wait on the   *
+*    port and a shutdown eventfd, reads whole chunks when the port     *
+*    becomes readable and hands them to a single consumer through a    *
+*    lock-free queue. The consumer is told about new data through a   *
+*    callback that fires once per empty -> non-empty transition        *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_SERIALPORTREADER_H
+#define CPPSERIALPORT_SERIALPORTREADER_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#include "SerialPort.h"
+#include "SpscQueue.h"
+#include "EventNotifier.h"
+
+namespace CppSerialPort {
+
+struct ReceivedChunk
+{
+    std::string data;
+    //When the read that returned data completed; its last byte arrived then
+    ReadTimestamp timestamp;
+};
+
+class SerialPortReader
+{
+public:
+    SerialPortReader(std::shared_ptr<SerialPort> serialPort, std::function<void()> dataAvailableCallback);
+    ~SerialPortReader();
+
+    SerialPortReader(const SerialPortReader &other) = delete;
+    SerialPortReader(SerialPortReader &&other) = delete;
+    SerialPortReader &operator=(const SerialPortReader &rhs) = delete;
+    SerialPortReader &operator=(SerialPortReader &&rhs) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    bool tryPop(ReceivedChunk &chunk);
+    void acknowledgeNotification();
+
+    bool hasError() const;
+    std::string errorString() const;
+
+    static const size_t DEFAULT_QUEUE_CAPACITY;
+
+private:
+    std::shared_ptr<SerialPort> m_serialPort;
+    EventNotifier m_dataAvailableNotifier;
+    SpscQueue<ReceivedChunk> m_receiveQueue;
+    std::thread m_readThread;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_hasError;
+    std::string m_errorString;
+#if !defined(_WIN32)
+    int m_epollFileDescriptor;
+    int m_shutdownEventFileDescriptor;
+#endif //!defined(_WIN32)
+
+    static const size_t constexpr READ_BUFFER_SIZE{4096};
+
+    void run();
+    ssize_t readChunk(char *buffer, size_t bufferSize);
+    bool pushChunk(ReceivedChunk &&chunk);
+    void setError(const std::string &errorString);
+    void closeEventFileDescriptors();
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SERIALPORTREADER_H
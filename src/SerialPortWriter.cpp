@@ -0,0 +1,248 @@
+/***********************************************************************
+*    SerialPortWriter.cpp:                                             *
+*    SerialPortWriter, background transmit thread for a SerialPort     *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a SerialPortWriter class    *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "SerialPortWriter.h"
+
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace CppSerialPort {
+
+const size_t SerialPortWriter::DEFAULT_QUEUE_CAPACITY{65536};
+
+SerialPortWriter::SerialPortWriter(std::shared_ptr<SerialPort> serialPort, std::function<void()> transmitEventCallback, size_t capacity) :
+    m_serialPort{serialPort},
+    m_transmitEventNotifier{transmitEventCallback},
+    m_capacity{capacity},
+    m_queueMutex{},
+    m_queueCondition{},
+    m_transmitQueue{},
+    m_completions{},
+    m_queuedBytes{0},
+    m_nextSequenceNumber{1},
+    m_writeThread{},
+    m_isRunning{false},
+    m_hasFinished{false},
+    m_isStalled{false},
+    m_hasError{false},
+    m_errorString{""}
+{
+    if (!this->m_serialPort) {
+        throw std::runtime_error("SerialPortWriter::SerialPortWriter(std::shared_ptr<SerialPort>, std::function<void()>, size_t): invariant failure (serialPort cannot be null)");
+    }
+    if (this->m_capacity == 0) {
+        throw std::runtime_error("SerialPortWriter::SerialPortWriter(std::shared_ptr<SerialPort>, std::function<void()>, size_t): invariant failure (capacity cannot be 0)");
+    }
+}
+
+void SerialPortWriter::start()
+{
+    if (this->m_isRunning) {
+        return;
+    }
+    //A thread that stopped on an error has still to be joined
+    this->stop();
+    if (!this->m_serialPort->isOpen()) {
+        throw std::runtime_error("SerialPortWriter::start(): " + this->m_serialPort->portName() + " is not open");
+    }
+    this->m_hasError = false;
+    this->m_hasFinished = false;
+    this->m_isStalled = false;
+    this->m_isRunning = true;
+    this->m_writeThread = std::thread{&SerialPortWriter::run, this};
+}
+
+void SerialPortWriter::stop()
+{
+    if (!this->m_writeThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+        this->m_isRunning = false;
+    }
+    this->m_queueCondition.notify_all();
+    //tcdrain() only returns once the output is gone, so discard whatever flow control is still holding back
+    while (!this->m_hasFinished) {
+        this->m_serialPort->flushTx();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    this->m_writeThread.join();
+    std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+    this->m_transmitQueue.clear();
+    this->m_queuedBytes = 0;
+}
+
+bool SerialPortWriter::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+uint64_t SerialPortWriter::enqueue(const std::string &data)
+{
+    uint64_t sequenceNumber{0};
+    {
+        std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+        //A message bigger than the whole queue is still accepted once the queue is empty, otherwise it could never be sent
+        if ( (this->m_queuedBytes > 0) && (this->m_queuedBytes + data.length() > this->m_capacity) ) {
+            return 0;
+        }
+        sequenceNumber = this->m_nextSequenceNumber++;
+        this->m_transmitQueue.push_back(TransmitRequest{sequenceNumber, data, 0});
+        this->m_queuedBytes += data.length();
+    }
+    this->m_queueCondition.notify_one();
+    return sequenceNumber;
+}
+
+size_t SerialPortWriter::queuedBytes() const
+{
+    std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+    return this->m_queuedBytes;
+}
+
+size_t SerialPortWriter::capacity() const
+{
+    return this->m_capacity;
+}
+
+bool SerialPortWriter::isStalled() const
+{
+    return this->m_isStalled;
+}
+
+bool SerialPortWriter::tryPopCompletion(TransmitCompletion &completion)
+{
+    std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+    if (this->m_completions.empty()) {
+        return false;
+    }
+    completion = this->m_completions.front();
+    this->m_completions.pop_front();
+    return true;
+}
+
+void SerialPortWriter::acknowledgeNotification()
+{
+    this->m_transmitEventNotifier.acknowledge();
+}
+
+bool SerialPortWriter::hasError() const
+{
+    return this->m_hasError.load(std::memory_order_acquire);
+}
+
+std::string SerialPortWriter::errorString() const
+{
+    if (!this->hasError()) {
+        return "";
+    }
+    return this->m_errorString;
+}
+
+void SerialPortWriter::setStalled(bool stalled)
+{
+    if (this->m_isStalled.exchange(stalled) != stalled) {
+        this->m_transmitEventNotifier.notify();
+    }
+}
+
+void SerialPortWriter::setError(const std::string &errorString)
+{
+    this->m_errorString = errorString;
+    this->m_hasError.store(true, std::memory_order_release);
+    this->m_isRunning = false;
+    this->m_transmitEventNotifier.notify();
+}
+
+void SerialPortWriter::run()
+{
+    std::vector<TransmitCompletion> awaitingDrain{};
+    ByteSpan spans[WRITE_BATCH_SIZE];
+    while (this->m_isRunning) {
+        size_t spanCount{0};
+        {
+            std::unique_lock<std::mutex> queueLock{this->m_queueMutex};
+            if ( (this->m_transmitQueue.empty()) && (!awaitingDrain.empty()) ) {
+                queueLock.unlock();
+                //Everything queued is with the driver now; only report completion once it has left the UART
+                if (!this->m_serialPort->drainTx()) {
+                    if (this->m_isRunning) {
+                        const auto errorCode = errno;
+                        this->setError("Unable to drain " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+                    }
+                    break;
+                }
+                queueLock.lock();
+                this->m_completions.insert(this->m_completions.end(), awaitingDrain.begin(), awaitingDrain.end());
+                queueLock.unlock();
+                awaitingDrain.clear();
+                this->m_transmitEventNotifier.notify();
+                continue;
+            }
+            this->m_queueCondition.wait(queueLock, [this]() { return (!this->m_isRunning) || (!this->m_transmitQueue.empty()); });
+            if (!this->m_isRunning) {
+                break;
+            }
+            //Everything already queued goes out in one gather write. Only this thread pops, and push_back
+            //never moves existing deque elements, so the spans stay valid once the lock is released
+            for (auto it = this->m_transmitQueue.begin(); (it != this->m_transmitQueue.end()) && (spanCount < WRITE_BATCH_SIZE); ++it) {
+                spans[spanCount++] = ByteSpan{it->data.data() + it->bytesWritten, it->data.length() - it->bytesWritten};
+            }
+        }
+        size_t batchBytes{0};
+        for (size_t i = 0; i < spanCount; i++) {
+            batchBytes += spans[i].size;
+        }
+        ssize_t writtenBytes{this->m_serialPort->write(spans, spanCount)};
+        if (writtenBytes < 0) {
+            const auto errorCode = errno;
+            this->setError("Unable to write to " + this->m_serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> queueLock{this->m_queueMutex};
+            auto remainingBytes = static_cast<size_t>(writtenBytes);
+            this->m_queuedBytes -= remainingBytes;
+            while ( (remainingBytes > 0) || ((!this->m_transmitQueue.empty()) && (this->m_transmitQueue.front().bytesWritten == this->m_transmitQueue.front().data.length())) ) {
+                TransmitRequest &request = this->m_transmitQueue.front();
+                size_t taken{std::min(remainingBytes, request.data.length() - request.bytesWritten)};
+                request.bytesWritten += taken;
+                remainingBytes -= taken;
+                if (request.bytesWritten < request.data.length()) {
+                    break;
+                }
+                awaitingDrain.push_back(TransmitCompletion{request.sequenceNumber, request.data.length()});
+                this->m_transmitQueue.pop_front();
+            }
+        }
+        //write() only comes back short when the write timeout ran out, i.e. flow control is holding the transmitter off
+        this->setStalled(static_cast<size_t>(writtenBytes) < batchBytes);
+    }
+    this->m_hasFinished = true;
+}
+
+SerialPortWriter::~SerialPortWriter()
+{
+    this->stop();
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,109 @@
+/***********************************************************************
+*    SerialPortWriter.h:                                               *
+*    SerialPortWriter, background transmit thread for a SerialPort     *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a SerialPortWriter class      *
+*    Callers enqueue whole messages into a queue bounded by bytes; one *
+*    thread per open port writes them out, honouring the port's write *
+*    timeout, and reports a message as complete once tcdrain says it   *
+*    has left the UART. A full queue is refused instead of dropped,    *
+*    and a transmitter held off by flow control is reported as stalled *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_SERIALPORTWRITER_H
+#define CPPSERIALPORT_SERIALPORTWRITER_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <cstdint>
+
+#include "SerialPort.h"
+#include "EventNotifier.h"
+
+namespace CppSerialPort {
+
+struct TransmitCompletion
+{
+    uint64_t sequenceNumber;
+    size_t bytesWritten;
+};
+
+class SerialPortWriter
+{
+public:
+    SerialPortWriter(std::shared_ptr<SerialPort> serialPort, std::function<void()> transmitEventCallback, size_t capacity = DEFAULT_QUEUE_CAPACITY);
+    ~SerialPortWriter();
+
+    SerialPortWriter(const SerialPortWriter &other) = delete;
+    SerialPortWriter(SerialPortWriter &&other) = delete;
+    SerialPortWriter &operator=(const SerialPortWriter &rhs) = delete;
+    SerialPortWriter &operator=(SerialPortWriter &&rhs) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    //Returns the message's sequence number, or 0 if it does not fit in the queue right now
+    uint64_t enqueue(const std::string &data);
+    size_t queuedBytes() const;
+    size_t capacity() const;
+    bool isStalled() const;
+
+    bool tryPopCompletion(TransmitCompletion &completion);
+    void acknowledgeNotification();
+
+    bool hasError() const;
+    std::string errorString() const;
+
+    static const size_t DEFAULT_QUEUE_CAPACITY;
+
+private:
+    struct TransmitRequest
+    {
+        uint64_t sequenceNumber;
+        std::string data;
+        size_t bytesWritten;
+    };
+
+    std::shared_ptr<SerialPort> m_serialPort;
+    EventNotifier m_transmitEventNotifier;
+    size_t m_capacity;
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::deque<TransmitRequest> m_transmitQueue;
+    std::deque<TransmitCompletion> m_completions;
+    size_t m_queuedBytes;
+    uint64_t m_nextSequenceNumber;
+    std::thread m_writeThread;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_hasFinished;
+    std::atomic<bool> m_isStalled;
+    std::atomic<bool> m_hasError;
+    std::string m_errorString;
+
+    static const size_t constexpr WRITE_BATCH_SIZE{64};
+
+    void run();
+    void setStalled(bool stalled);
+    void setError(const std::string &errorString);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SERIALPORTWRITER_H
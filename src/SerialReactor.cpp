@@ -0,0 +1,517 @@
+/***********************************************************************
+*    SerialReactor.cpp:                                                *
+*    SerialReactor, one receive thread for many SerialPorts            *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a SerialReactor class       *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "SerialReactor.h"
+
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#    include <unistd.h>
+#endif //!defined(_WIN32)
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#endif //defined(__linux__)
+
+namespace CppSerialPort {
+
+const size_t SerialReactor::DEFAULT_QUEUE_CAPACITY{4096};
+const size_t SerialReactor::PORTS_PER_THREAD{32};
+
+//Port ids start at 1, so the shutdown event can never be mistaken for a port
+static const uint64_t SHUTDOWN_EVENT_ID{0};
+
+SerialReactor::Shard::Shard(unsigned shardIndex) :
+    index{shardIndex},
+    eventQueue{DEFAULT_QUEUE_CAPACITY},
+    thread{},
+    portsMutex{},
+    portReleased{},
+    ports{},
+    busyPortId{0},
+    cpu{-1},
+    wakeups{0},
+    chunksRead{0},
+    bytesRead{0},
+    busyNanoseconds{0}
+#if !defined(_WIN32)
+    ,epollFileDescriptor{-1},
+    shutdownEventFileDescriptor{-1}
+#endif //!defined(_WIN32)
+{
+
+}
+
+SerialReactor::SerialReactor(std::function<void()> eventCallback, unsigned threadCount) :
+    m_eventNotifier{eventCallback},
+    m_shards{},
+    m_isRunning{false},
+    m_hasError{false},
+    m_errorMutex{},
+    m_errorString{""},
+    m_portsMutex{},
+    m_portShards{},
+    m_nextPortId{1},
+    m_nextPopShard{0},
+    m_pinnedToCores{false}
+{
+    if (threadCount == 0) {
+        throw std::runtime_error("SerialReactor::SerialReactor(std::function<void()>, unsigned): invariant failure (threadCount cannot be 0)");
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        this->m_shards.emplace_back(new Shard{i});
+    }
+}
+
+unsigned SerialReactor::defaultThreadCount(size_t portCount)
+{
+    size_t hardwareThreads{std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1))};
+    size_t neededThreads{(portCount + PORTS_PER_THREAD - 1) / PORTS_PER_THREAD};
+    return static_cast<unsigned>(std::max(std::min(neededThreads, hardwareThreads), static_cast<size_t>(1)));
+}
+
+void SerialReactor::start()
+{
+    if (this->m_isRunning) {
+        return;
+    }
+    //Threads that stopped on an error have still to be joined
+    this->stop();
+#if !defined(_WIN32)
+    try {
+        for (auto &it : this->m_shards) {
+            this->openEventFileDescriptors(*it);
+        }
+    } catch (std::exception &e) {
+        for (auto &it : this->m_shards) {
+            this->closeEventFileDescriptors(*it);
+        }
+        throw;
+    }
+#endif //!defined(_WIN32)
+    std::vector<int> cores{this->m_pinnedToCores ? availableCores() : std::vector<int>{}};
+    for (auto &it : this->m_shards) {
+        it->cpu = (cores.empty() ? -1 : cores[it->index % cores.size()]);
+    }
+    {
+        std::lock_guard<std::mutex> errorLock{this->m_errorMutex};
+        this->m_errorString.clear();
+    }
+    this->m_hasError = false;
+    this->m_isRunning = true;
+    for (auto &it : this->m_shards) {
+        it->thread = std::thread{&SerialReactor::run, this, it.get()};
+        this->pinToCore(*it);
+    }
+}
+
+void SerialReactor::stop()
+{
+    this->m_isRunning = false;
+    for (auto &it : this->m_shards) {
+        if (!it->thread.joinable()) {
+            continue;
+        }
+#if !defined(_WIN32)
+        uint64_t wakeValue{1};
+        if (::write(it->shutdownEventFileDescriptor, &wakeValue, sizeof(wakeValue)) == -1) {
+            //The thread still checks m_isRunning after every wakeup, so it will exit on its next event
+        }
+#endif //!defined(_WIN32)
+        it->thread.join();
+#if !defined(_WIN32)
+        this->closeEventFileDescriptors(*it);
+#endif //!defined(_WIN32)
+    }
+}
+
+bool SerialReactor::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+unsigned SerialReactor::threadCount() const
+{
+    return static_cast<unsigned>(this->m_shards.size());
+}
+
+void SerialReactor::setPinnedToCores(bool pinnedToCores)
+{
+    this->m_pinnedToCores = pinnedToCores;
+}
+
+bool SerialReactor::isPinnedToCores() const
+{
+    return this->m_pinnedToCores;
+}
+
+std::vector<ReactorStatistics> SerialReactor::statistics() const
+{
+    std::vector<ReactorStatistics> statistics{};
+    for (const auto &it : this->m_shards) {
+        size_t portCount{0};
+        {
+            std::lock_guard<std::mutex> portsLock{it->portsMutex};
+            portCount = it->ports.size();
+        }
+        statistics.push_back(ReactorStatistics{it->index, it->cpu, portCount, it->wakeups.load(std::memory_order_relaxed), it->chunksRead.load(std::memory_order_relaxed),
+                                               it->bytesRead.load(std::memory_order_relaxed), static_cast<double>(it->busyNanoseconds.load(std::memory_order_relaxed)) / 1000000000.0});
+    }
+    return statistics;
+}
+
+unsigned SerialReactor::addPort(std::shared_ptr<SerialPort> serialPort)
+{
+    if (!serialPort) {
+        throw std::runtime_error("SerialReactor::addPort(std::shared_ptr<SerialPort>): invariant failure (serialPort cannot be null)");
+    }
+    if (!serialPort->isOpen()) {
+        throw std::runtime_error("SerialReactor::addPort(std::shared_ptr<SerialPort>): " + serialPort->portName() + " is not open");
+    }
+    std::lock_guard<std::mutex> portsLock{this->m_portsMutex};
+    //Ports are assumed to be equally busy, so the spread is by count
+    Shard *leastLoaded{nullptr};
+    size_t fewestPorts{0};
+    for (auto &it : this->m_shards) {
+        std::lock_guard<std::mutex> shardLock{it->portsMutex};
+        if ( (!leastLoaded) || (it->ports.size() < fewestPorts) ) {
+            leastLoaded = it.get();
+            fewestPorts = it->ports.size();
+        }
+    }
+    std::lock_guard<std::mutex> shardLock{leastLoaded->portsMutex};
+    unsigned portId{this->m_nextPortId++};
+#if !defined(_WIN32)
+    if (leastLoaded->epollFileDescriptor != -1) {
+        epoll_event portEvent{};
+        portEvent.events = EPOLLIN;
+        portEvent.data.u64 = portId;
+        if (epoll_ctl(leastLoaded->epollFileDescriptor, EPOLL_CTL_ADD, serialPort->getFileDescriptor(), &portEvent) == -1) {
+            const auto errorCode = errno;
+            throw std::runtime_error("epoll_ctl(int, int, int, epoll_event *): Unable to watch " + serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+        }
+    }
+#endif //!defined(_WIN32)
+    leastLoaded->ports.emplace(portId, serialPort);
+    this->m_portShards.emplace(portId, leastLoaded->index);
+    return portId;
+}
+
+void SerialReactor::removePort(unsigned portId)
+{
+    std::lock_guard<std::mutex> portsLock{this->m_portsMutex};
+    auto foundShard = this->m_portShards.find(portId);
+    if (foundShard == this->m_portShards.end()) {
+        return;
+    }
+    Shard &shard = *this->m_shards[foundShard->second];
+    this->m_portShards.erase(foundShard);
+    std::unique_lock<std::mutex> shardLock{shard.portsMutex};
+    auto foundPort = shard.ports.find(portId);
+    if (foundPort == shard.ports.end()) {
+        //Already dropped by its reactor after failing
+        return;
+    }
+#if !defined(_WIN32)
+    if (shard.epollFileDescriptor != -1) {
+        epoll_ctl(shard.epollFileDescriptor, EPOLL_CTL_DEL, foundPort->second->getFileDescriptor(), nullptr);
+    }
+#endif //!defined(_WIN32)
+    shard.ports.erase(foundPort);
+    //The thread may be halfway through a read of this port; the caller is about to close it
+    shard.portReleased.wait(shardLock, [&shard, portId]() { return shard.busyPortId != portId; });
+}
+
+size_t SerialReactor::portCount() const
+{
+    size_t portCount{0};
+    for (const auto &it : this->m_shards) {
+        std::lock_guard<std::mutex> shardLock{it->portsMutex};
+        portCount += it->ports.size();
+    }
+    return portCount;
+}
+
+bool SerialReactor::tryPop(ReactorEvent &event)
+{
+    //Events of one port stay in order, since a port only ever lives in one shard
+    const size_t shardCount{this->m_shards.size()};
+    for (size_t i = 0; i < shardCount; i++) {
+        size_t shardIndex{(this->m_nextPopShard + i) % shardCount};
+        if (this->m_shards[shardIndex]->eventQueue.tryPop(event)) {
+            this->m_nextPopShard = (shardIndex + 1) % shardCount;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SerialReactor::acknowledgeNotification()
+{
+    this->m_eventNotifier.acknowledge();
+}
+
+bool SerialReactor::hasError() const
+{
+    return this->m_hasError.load(std::memory_order_acquire);
+}
+
+std::string SerialReactor::errorString() const
+{
+    std::lock_guard<std::mutex> errorLock{this->m_errorMutex};
+    return this->m_errorString;
+}
+
+void SerialReactor::setError(const std::string &errorString)
+{
+    {
+        std::lock_guard<std::mutex> errorLock{this->m_errorMutex};
+        //The first failure is the one worth reporting
+        if (this->m_errorString.empty()) {
+            this->m_errorString = errorString;
+        }
+    }
+    this->m_hasError.store(true, std::memory_order_release);
+    this->m_isRunning = false;
+    this->m_eventNotifier.notify();
+}
+
+bool SerialReactor::pushEvent(Shard &shard, ReactorEvent &&event)
+{
+    while (!shard.eventQueue.tryPush(std::move(event))) {
+        //The consumer is behind; every port's kernel buffer takes up the slack rather than dropping data
+        if (!this->m_isRunning) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    this->m_eventNotifier.notify();
+    return true;
+}
+
+std::shared_ptr<SerialPort> SerialReactor::acquirePort(Shard &shard, unsigned portId)
+{
+    std::lock_guard<std::mutex> shardLock{shard.portsMutex};
+    auto foundPort = shard.ports.find(portId);
+    if (foundPort == shard.ports.end()) {
+        //Removed after epoll_wait reported it
+        return nullptr;
+    }
+    shard.busyPortId = portId;
+    return foundPort->second;
+}
+
+void SerialReactor::releasePort(Shard &shard)
+{
+    {
+        std::lock_guard<std::mutex> shardLock{shard.portsMutex};
+        shard.busyPortId = 0;
+    }
+    shard.portReleased.notify_all();
+}
+
+void SerialReactor::dropPort(Shard &shard, unsigned portId)
+{
+    std::lock_guard<std::mutex> shardLock{shard.portsMutex};
+    auto foundPort = shard.ports.find(portId);
+    if (foundPort == shard.ports.end()) {
+        return;
+    }
+#if !defined(_WIN32)
+    epoll_ctl(shard.epollFileDescriptor, EPOLL_CTL_DEL, foundPort->second->getFileDescriptor(), nullptr);
+#endif //!defined(_WIN32)
+    shard.ports.erase(foundPort);
+}
+
+bool SerialReactor::servicePort(Shard &shard, unsigned portId, bool isHungUp, char *buffer, size_t bufferSize)
+{
+    std::shared_ptr<SerialPort> serialPort{this->acquirePort(shard, portId)};
+    if (!serialPort) {
+        return false;
+    }
+    //One chunk per wakeup, so a flooding port cannot starve the others; anything left keeps it readable
+    ssize_t bytesRead{serialPort->readSome(buffer, bufferSize, std::chrono::microseconds::zero())};
+    const auto errorCode = errno;
+    ReadTimestamp timestamp{serialPort->lastReadTimestamp()};
+    std::string errorString{""};
+    if (bytesRead < 0) {
+        errorString = "Unable to read from " + serialPort->portName() + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")";
+    } else if ( (bytesRead == 0) && (isHungUp) ) {
+        //A hung up tty stays readable but only ever returns end of file
+        errorString = serialPort->portName() + " was disconnected";
+    }
+    if (!errorString.empty()) {
+        this->dropPort(shard, portId);
+    }
+    this->releasePort(shard);
+    if (bytesRead > 0) {
+        shard.chunksRead.fetch_add(1, std::memory_order_relaxed);
+        shard.bytesRead.fetch_add(static_cast<uint64_t>(bytesRead), std::memory_order_relaxed);
+        return this->pushEvent(shard, ReactorEvent{portId, ReceivedChunk{std::string{buffer, static_cast<size_t>(bytesRead)}, timestamp}, ""});
+    } else if (!errorString.empty()) {
+        return this->pushEvent(shard, ReactorEvent{portId, ReceivedChunk{"", ReadTimestamp{0, 0}}, errorString});
+    }
+    return false;
+}
+
+std::vector<int> SerialReactor::availableCores()
+{
+    std::vector<int> cores{};
+#if defined(__linux__)
+    //Only the cores this process may use, so taskset and cgroup limits are respected
+    cpu_set_t allowedCores;
+    CPU_ZERO(&allowedCores);
+    if (sched_getaffinity(0, sizeof(allowedCores), &allowedCores) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowedCores)) {
+                cores.push_back(cpu);
+            }
+        }
+    }
+#endif //defined(__linux__)
+    return cores;
+}
+
+void SerialReactor::pinToCore(Shard &shard)
+{
+#if defined(__linux__)
+    if (shard.cpu < 0) {
+        return;
+    }
+    cpu_set_t core;
+    CPU_ZERO(&core);
+    CPU_SET(shard.cpu, &core);
+    //Set from here rather than by the thread itself, so cpu is only ever written by the controlling thread
+    if (pthread_setaffinity_np(shard.thread.native_handle(), sizeof(core), &core) != 0) {
+        //Not fatal; the thread just stays wherever the scheduler puts it
+        shard.cpu = -1;
+    }
+#else
+    //Pinning is only implemented for Linux
+    shard.cpu = -1;
+#endif //defined(__linux__)
+}
+
+#if defined(_WIN32)
+void SerialReactor::run(Shard *shard)
+{
+    char readBuffer[READ_BUFFER_SIZE];
+    std::vector<unsigned> portIds{};
+    while (this->m_isRunning) {
+        //No epoll here, so every port is polled without waiting and the thread naps whenever a pass finds nothing
+        portIds.clear();
+        {
+            std::lock_guard<std::mutex> shardLock{shard->portsMutex};
+            for (const auto &it : shard->ports) {
+                portIds.push_back(it.first);
+            }
+        }
+        auto passStart = std::chrono::steady_clock::now();
+        bool anythingRead{false};
+        for (auto portId : portIds) {
+            anythingRead |= this->servicePort(*shard, portId, false, readBuffer, sizeof(readBuffer));
+        }
+        if (!anythingRead) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        shard->wakeups.fetch_add(1, std::memory_order_relaxed);
+        shard->busyNanoseconds.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - passStart).count()), std::memory_order_relaxed);
+    }
+}
+#else
+void SerialReactor::run(Shard *shard)
+{
+    char readBuffer[READ_BUFFER_SIZE];
+    epoll_event events[MAX_EVENTS];
+    while (this->m_isRunning) {
+        int eventCount{epoll_wait(shard->epollFileDescriptor, events, MAX_EVENTS, -1)};
+        if (eventCount == -1) {
+            const auto errorCode = errno;
+            if (errorCode == EINTR) {
+                continue;
+            }
+            this->setError("epoll_wait(int, epoll_event *, int, int): " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+            return;
+        }
+        auto wakeTime = std::chrono::steady_clock::now();
+        shard->wakeups.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < eventCount; i++) {
+            if (events[i].data.u64 == SHUTDOWN_EVENT_ID) {
+                return;
+            }
+            bool isHungUp{(events[i].events & (EPOLLERR | EPOLLHUP)) != 0};
+            this->servicePort(*shard, static_cast<unsigned>(events[i].data.u64), isHungUp, readBuffer, sizeof(readBuffer));
+        }
+        shard->busyNanoseconds.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wakeTime).count()), std::memory_order_relaxed);
+    }
+}
+
+void SerialReactor::openEventFileDescriptors(Shard &shard)
+{
+    shard.epollFileDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (shard.epollFileDescriptor == -1) {
+        const auto errorCode = errno;
+        throw std::runtime_error("epoll_create1(int): Unable to create epoll instance: " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    shard.shutdownEventFileDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (shard.shutdownEventFileDescriptor == -1) {
+        const auto errorCode = errno;
+        throw std::runtime_error("eventfd(unsigned int, int): Unable to create shutdown event: " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    epoll_event shutdownEvent{};
+    shutdownEvent.events = EPOLLIN;
+    shutdownEvent.data.u64 = SHUTDOWN_EVENT_ID;
+    if (epoll_ctl(shard.epollFileDescriptor, EPOLL_CTL_ADD, shard.shutdownEventFileDescriptor, &shutdownEvent) == -1) {
+        const auto errorCode = errno;
+        throw std::runtime_error("epoll_ctl(int, int, int, epoll_event *): Unable to watch shutdown event: " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    //Ports added before start() are only now given to epoll
+    std::lock_guard<std::mutex> shardLock{shard.portsMutex};
+    for (const auto &it : shard.ports) {
+        epoll_event portEvent{};
+        portEvent.events = EPOLLIN;
+        portEvent.data.u64 = it.first;
+        epoll_ctl(shard.epollFileDescriptor, EPOLL_CTL_ADD, it.second->getFileDescriptor(), &portEvent);
+    }
+}
+
+void SerialReactor::closeEventFileDescriptors(Shard &shard)
+{
+    if (shard.shutdownEventFileDescriptor != -1) {
+        close(shard.shutdownEventFileDescriptor);
+        shard.shutdownEventFileDescriptor = -1;
+    }
+    if (shard.epollFileDescriptor != -1) {
+        close(shard.epollFileDescriptor);
+        shard.epollFileDescriptor = -1;
+    }
+}
+#endif //defined(_WIN32)
+
+SerialReactor::~SerialReactor()
+{
+    this->stop();
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,166 @@
+/***********************************************************************
+*    SerialReactor.h:                                                  *
+*    SerialReactor, one receive thread for many SerialPorts            *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a SerialReactor class         *
+*    Ports are sharded across one or more reactor threads, each going  *
+*    to the thread with the fewest. Every thread sleeps in epoll_wait  *
+*    on its own ports (plus a shutdown eventfd), reads one chunk from  *
+*    each port that is readable and hands it, tagged with the port's   *
+*    id, to a single consumer through its own lock-free queue. The     *
+*    threads can be pinned to cores, and each keeps load statistics so *
+*    an uneven spread shows up. Ports can be added and removed while   *
+*    the threads run. A port that fails or hangs up is dropped by its  *
+*    reactor and reported once through the same queue                  *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_SERIALREACTOR_H
+#define CPPSERIALPORT_SERIALREACTOR_H
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "SerialPort.h"
+#include "SerialPortReader.h"
+#include "SpscQueue.h"
+#include "EventNotifier.h"
+
+namespace CppSerialPort {
+
+struct ReactorEvent
+{
+    unsigned portId;
+    ReceivedChunk chunk;
+    //Empty unless the port failed or hung up, in which case the reactor has already let go of it
+    std::string errorString;
+};
+
+struct ReactorStatistics
+{
+    unsigned threadIndex;
+    //The core the thread is pinned to, or -1 when it may run anywhere
+    int cpu;
+    size_t portCount;
+    uint64_t wakeups;
+    uint64_t chunksRead;
+    uint64_t bytesRead;
+    //Time spent reading and queueing rather than waiting for the ports
+    double busySeconds;
+};
+
+class SerialReactor
+{
+public:
+    explicit SerialReactor(std::function<void()> eventCallback, unsigned threadCount = 1);
+    ~SerialReactor();
+
+    SerialReactor(const SerialReactor &other) = delete;
+    SerialReactor(SerialReactor &&other) = delete;
+    SerialReactor &operator=(const SerialReactor &rhs) = delete;
+    SerialReactor &operator=(SerialReactor &&rhs) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const;
+    unsigned threadCount() const;
+    //Takes effect at the next start(); each thread gets its own core out of those the process may run on
+    void setPinnedToCores(bool pinnedToCores);
+    bool isPinnedToCores() const;
+    std::vector<ReactorStatistics> statistics() const;
+
+    //The port must already be open; the id it is given tags everything read from it
+    unsigned addPort(std::shared_ptr<SerialPort> serialPort);
+    //Once this returns the reactor thread is not touching the port, so it can be closed
+    void removePort(unsigned portId);
+    size_t portCount() const;
+
+    bool tryPop(ReactorEvent &event);
+    void acknowledgeNotification();
+
+    bool hasError() const;
+    std::string errorString() const;
+
+    //One thread per PORTS_PER_THREAD ports, but never more threads than the machine has
+    static unsigned defaultThreadCount(size_t portCount);
+
+    static const size_t DEFAULT_QUEUE_CAPACITY;
+    static const size_t PORTS_PER_THREAD;
+
+private:
+    struct Shard
+    {
+        explicit Shard(unsigned shardIndex);
+
+        unsigned index;
+        SpscQueue<ReactorEvent> eventQueue;
+        std::thread thread;
+        mutable std::mutex portsMutex;
+        std::condition_variable portReleased;
+        std::unordered_map<unsigned, std::shared_ptr<SerialPort>> ports;
+        //The port this shard's thread is reading right now, 0 for none
+        unsigned busyPortId;
+        int cpu;
+        std::atomic<uint64_t> wakeups;
+        std::atomic<uint64_t> chunksRead;
+        std::atomic<uint64_t> bytesRead;
+        std::atomic<uint64_t> busyNanoseconds;
+#if !defined(_WIN32)
+        int epollFileDescriptor;
+        int shutdownEventFileDescriptor;
+#endif //!defined(_WIN32)
+    };
+
+    EventNotifier m_eventNotifier;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_hasError;
+    mutable std::mutex m_errorMutex;
+    std::string m_errorString;
+    //Guards the id counter and which shard each port went to; taken before a shard's own mutex, never after
+    mutable std::mutex m_portsMutex;
+    std::unordered_map<unsigned, size_t> m_portShards;
+    unsigned m_nextPortId;
+    //Where the next tryPop() starts looking, so one busy shard cannot starve the others of the consumer
+    size_t m_nextPopShard;
+    bool m_pinnedToCores;
+
+    static const size_t constexpr READ_BUFFER_SIZE{4096};
+    static const int constexpr MAX_EVENTS{64};
+
+    void run(Shard *shard);
+    bool servicePort(Shard &shard, unsigned portId, bool isHungUp, char *buffer, size_t bufferSize);
+    std::shared_ptr<SerialPort> acquirePort(Shard &shard, unsigned portId);
+    void releasePort(Shard &shard);
+    void dropPort(Shard &shard, unsigned portId);
+    bool pushEvent(Shard &shard, ReactorEvent &&event);
+    void setError(const std::string &errorString);
+    void pinToCore(Shard &shard);
+#if !defined(_WIN32)
+    void openEventFileDescriptors(Shard &shard);
+    void closeEventFileDescriptors(Shard &shard);
+#endif //!defined(_WIN32)
+
+    static std::vector<int> availableCores();
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SERIALREACTOR_H
@@ -0,0 +1,294 @@
+/***********************************************************************
+*    SessionRecorder.cpp:                                              *
+*    SessionRecorder, binary capture of everything sent and received   *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a SessionRecorder class     *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "SessionRecorder.h"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__linux__)
+#    include <fcntl.h>
+#endif //defined(__linux__)
+
+namespace CppSerialPort {
+
+const char SessionRecorder::FILE_MAGIC[8]{'Q', 'S', 'T', 'C', 'A', 'P', '0', '1'};
+const size_t SessionRecorder::FLUSH_THRESHOLD{1024 * 1024};
+const size_t SessionRecorder::MAXIMUM_PENDING_BYTES{64 * 1024 * 1024};
+const std::chrono::milliseconds SessionRecorder::FLUSH_INTERVAL{1000};
+
+SessionRecorder::SessionRecorder() :
+    m_filePath{""},
+    m_file{nullptr},
+    m_activeBuffer{},
+    m_writeBuffer{},
+    m_bufferMutex{},
+    m_bufferCondition{},
+    m_writeThread{},
+    m_isRecording{false},
+    m_startTime{},
+    m_fileOffset{0},
+    m_previousBlockOffset{0},
+    m_previousBlockSize{0},
+    m_recordedBytes{0},
+    m_droppedRecords{0},
+    m_hasError{false},
+    m_errorString{""}
+{
+
+}
+
+void SessionRecorder::start(const std::string &filePath)
+{
+    if (this->m_writeThread.joinable()) {
+        throw std::runtime_error("SessionRecorder::start(const std::string &): already recording to " + this->m_filePath);
+    }
+    this->m_file = std::fopen(filePath.c_str(), "wb");
+    if (!this->m_file) {
+        const auto errorCode = errno;
+        throw std::runtime_error("SessionRecorder::start(const std::string &): Unable to open " + filePath + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+    //The writer thread already hands over whole blocks, so stdio buffering would only add a copy
+    std::setvbuf(this->m_file, nullptr, _IONBF, 0);
+
+    auto wallClockStart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+    char fileHeader[FILE_HEADER_SIZE];
+    memcpy(fileHeader, FILE_MAGIC, sizeof(FILE_MAGIC));
+    encodeLittleEndian(fileHeader + sizeof(FILE_MAGIC), static_cast<uint64_t>(wallClockStart.count()), 8);
+    if (std::fwrite(fileHeader, 1, sizeof(fileHeader), this->m_file) != sizeof(fileHeader)) {
+        const auto errorCode = errno;
+        std::fclose(this->m_file);
+        this->m_file = nullptr;
+        throw std::runtime_error("SessionRecorder::start(const std::string &): Unable to write to " + filePath + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+    }
+
+    this->m_filePath = filePath;
+    this->m_activeBuffer.clear();
+    this->m_activeBuffer.reserve(FLUSH_THRESHOLD * 2);
+    this->m_writeBuffer.clear();
+    this->m_writeBuffer.reserve(FLUSH_THRESHOLD * 2);
+    this->m_startTime = std::chrono::steady_clock::now();
+    this->m_fileOffset = FILE_HEADER_SIZE;
+    this->m_previousBlockOffset = 0;
+    this->m_previousBlockSize = 0;
+    this->m_recordedBytes = 0;
+    this->m_droppedRecords = 0;
+    this->m_hasError = false;
+    this->m_isRecording = true;
+    this->m_writeThread = std::thread{&SessionRecorder::run, this};
+}
+
+void SessionRecorder::stop()
+{
+    if (!this->m_writeThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> bufferLock{this->m_bufferMutex};
+        this->m_isRecording = false;
+    }
+    this->m_bufferCondition.notify_one();
+    this->m_writeThread.join();
+    std::fclose(this->m_file);
+    this->m_file = nullptr;
+}
+
+bool SessionRecorder::isRecording() const
+{
+    return this->m_isRecording;
+}
+
+std::string SessionRecorder::filePath() const
+{
+    return this->m_filePath;
+}
+
+char *SessionRecorder::reserveRecord(RecordDirection direction, size_t size)
+{
+    if (!this->m_isRecording) {
+        return nullptr;
+    }
+    if ( (size > MAXIMUM_RECORD_SIZE) || (this->m_activeBuffer.size() + RECORD_HEADER_SIZE + size > MAXIMUM_PENDING_BYTES) ) {
+        this->m_droppedRecords++;
+        return nullptr;
+    }
+    //Taken under the buffer lock, so timestamps never go backwards through the file
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->m_startTime);
+    size_t recordOffset{this->m_activeBuffer.size()};
+    this->m_activeBuffer.resize(recordOffset + RECORD_HEADER_SIZE + size);
+    char *recordHeader{this->m_activeBuffer.data() + recordOffset};
+    uint32_t sizeAndDirection{static_cast<uint32_t>(size) | (direction == RecordDirection::Transmitted ? 0x80000000u : 0u)};
+    encodeLittleEndian(recordHeader, static_cast<uint64_t>(timestamp.count()), 8);
+    encodeLittleEndian(recordHeader + 8, sizeAndDirection, 4);
+    this->m_recordedBytes += size;
+    return recordHeader + RECORD_HEADER_SIZE;
+}
+
+void SessionRecorder::record(RecordDirection direction, const char *data, size_t size)
+{
+    ByteSpan span{data, size};
+    this->record(direction, &span, 1, 0, size);
+}
+
+void SessionRecorder::record(RecordDirection direction, const ByteSpan *spans, size_t spanCount, size_t firstSpanOffset, size_t size)
+{
+    if ( (size == 0) || (!this->m_isRecording) ) {
+        return;
+    }
+    bool isFlushDue{false};
+    {
+        std::lock_guard<std::mutex> bufferLock{this->m_bufferMutex};
+        char *payload{this->reserveRecord(direction, size)};
+        if (!payload) {
+            return;
+        }
+        size_t remainingBytes{size};
+        for (size_t i = 0; (i < spanCount) && (remainingBytes > 0); i++) {
+            size_t offset{i == 0 ? firstSpanOffset : 0};
+            size_t taken{std::min(spans[i].size - offset, remainingBytes)};
+            memcpy(payload, spans[i].data + offset, taken);
+            payload += taken;
+            remainingBytes -= taken;
+        }
+        isFlushDue = (this->m_activeBuffer.size() >= FLUSH_THRESHOLD);
+    }
+    if (isFlushDue) {
+        this->m_bufferCondition.notify_one();
+    }
+}
+
+uint64_t SessionRecorder::recordedBytes() const
+{
+    return this->m_recordedBytes;
+}
+
+uint64_t SessionRecorder::droppedRecords() const
+{
+    return this->m_droppedRecords;
+}
+
+bool SessionRecorder::hasError() const
+{
+    return this->m_hasError.load(std::memory_order_acquire);
+}
+
+std::string SessionRecorder::errorString() const
+{
+    if (!this->hasError()) {
+        return "";
+    }
+    return this->m_errorString;
+}
+
+void SessionRecorder::setError(const std::string &errorString)
+{
+    this->m_errorString = errorString;
+    this->m_hasError.store(true, std::memory_order_release);
+}
+
+void SessionRecorder::run()
+{
+    std::unique_lock<std::mutex> bufferLock{this->m_bufferMutex};
+    while (true) {
+        //A slow link still reaches the disk at least once per FLUSH_INTERVAL
+        this->m_bufferCondition.wait_for(bufferLock, FLUSH_INTERVAL, [this]() {
+            return (!this->m_isRecording) || (this->m_activeBuffer.size() >= FLUSH_THRESHOLD);
+        });
+        bool isStopping{!this->m_isRecording};
+        if (!this->m_activeBuffer.empty()) {
+            //Recording carries on into the other buffer while this one is written out
+            std::swap(this->m_activeBuffer, this->m_writeBuffer);
+            bufferLock.unlock();
+            if (!this->m_hasError) {
+                this->writeBuffer(this->m_writeBuffer);
+            }
+            this->m_writeBuffer.clear();
+            bufferLock.lock();
+        }
+        if ( (isStopping) && (this->m_activeBuffer.empty()) ) {
+            return;
+        }
+    }
+}
+
+bool SessionRecorder::writeBuffer(const std::vector<char> &buffer)
+{
+    if (std::fwrite(buffer.data(), 1, buffer.size(), this->m_file) != buffer.size()) {
+        const auto errorCode = errno;
+        this->setError("Unable to write to " + this->m_filePath + ": " + std::to_string(errorCode) + " (" + strerror(errorCode) + ")");
+        return false;
+    }
+#if defined(__linux__)
+    //A day long capture would otherwise fill the page cache with data nobody reads back. Start writeback of
+    //this block now, and drop the previous one, whose writeback was started a whole block ago
+    int fileDescriptor{fileno(this->m_file)};
+    sync_file_range(fileDescriptor, static_cast<off64_t>(this->m_fileOffset), static_cast<off64_t>(buffer.size()), SYNC_FILE_RANGE_WRITE);
+    if (this->m_previousBlockSize > 0) {
+        posix_fadvise(fileDescriptor, static_cast<off_t>(this->m_previousBlockOffset), static_cast<off_t>(this->m_previousBlockSize), POSIX_FADV_DONTNEED);
+    }
+#endif //defined(__linux__)
+    this->m_previousBlockOffset = this->m_fileOffset;
+    this->m_previousBlockSize = buffer.size();
+    this->m_fileOffset += buffer.size();
+    return true;
+}
+
+bool SessionRecorder::decodeFileHeader(const char *data, size_t size, uint64_t *startTime)
+{
+    if ( (size < FILE_HEADER_SIZE) || (memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) ) {
+        return false;
+    }
+    *startTime = decodeLittleEndian(data + sizeof(FILE_MAGIC), 8);
+    return true;
+}
+
+bool SessionRecorder::decodeRecordHeader(const char *data, size_t size, CaptureRecordHeader *header)
+{
+    if (size < RECORD_HEADER_SIZE) {
+        return false;
+    }
+    auto sizeAndDirection = static_cast<uint32_t>(decodeLittleEndian(data + 8, 4));
+    header->timestamp = decodeLittleEndian(data, 8);
+    header->size = (sizeAndDirection & 0x7FFFFFFFu);
+    header->direction = ((sizeAndDirection & 0x80000000u) ? RecordDirection::Transmitted : RecordDirection::Received);
+    return true;
+}
+
+void SessionRecorder::encodeLittleEndian(char *destination, uint64_t value, size_t byteCount)
+{
+    for (size_t i = 0; i < byteCount; i++) {
+        destination[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint64_t SessionRecorder::decodeLittleEndian(const char *data, size_t byteCount)
+{
+    uint64_t value{0};
+    for (size_t i = 0; i < byteCount; i++) {
+        value |= (static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i));
+    }
+    return value;
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    this->stop();
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,133 @@
+/***********************************************************************
+*    SessionRecorder.h:                                                *
+*    SessionRecorder, binary capture of everything sent and received   *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a SessionRecorder class       *
+*    Every chunk read from or written to a port is appended to a       *
+*    capture file as one record: a monotonic timestamp, a direction,   *
+*    a length and the payload. Callers only copy the record into an    *
+*    in-memory buffer; a dedicated thread swaps that buffer with a     *
+*    second one and writes it out in large blocks, so recording never  *
+*    waits on the disk. If the disk falls so far behind that the       *
+*    pending data would exceed MAXIMUM_PENDING_BYTES, records are      *
+*    dropped and counted rather than stalling the port                 *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_SESSIONRECORDER_H
+#define CPPSERIALPORT_SESSIONRECORDER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+#include "RingBuffer.h"
+
+namespace CppSerialPort {
+
+enum class RecordDirection : uint8_t
+{
+    Received,
+    Transmitted
+};
+
+/*
+ * Capture file layout, all integers little endian:
+ *   file header:   8 byte magic "QSTCAP01", uint64 wall clock start time
+ *                  in nanoseconds since the Unix epoch
+ *   record header: uint64 nanoseconds since the start time (monotonic),
+ *                  uint32 payload length with the direction in bit 31
+ *   payload:       the bytes exactly as they crossed the port
+ */
+struct CaptureRecordHeader
+{
+    uint64_t timestamp;
+    uint32_t size;
+    RecordDirection direction;
+};
+
+class SessionRecorder
+{
+public:
+    SessionRecorder();
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder &other) = delete;
+    SessionRecorder(SessionRecorder &&other) = delete;
+    SessionRecorder &operator=(const SessionRecorder &rhs) = delete;
+    SessionRecorder &operator=(SessionRecorder &&rhs) = delete;
+
+    //Creates (or truncates) the capture file and starts the writer thread
+    void start(const std::string &filePath);
+    //Writes out everything recorded so far and closes the file
+    void stop();
+    bool isRecording() const;
+    std::string filePath() const;
+
+    //Safe to call from any thread; only ever copies into memory
+    void record(RecordDirection direction, const char *data, size_t size);
+    //Records size bytes of the spans as a single chunk, starting firstSpanOffset bytes into the first one
+    void record(RecordDirection direction, const ByteSpan *spans, size_t spanCount, size_t firstSpanOffset, size_t size);
+
+    uint64_t recordedBytes() const;
+    uint64_t droppedRecords() const;
+    bool hasError() const;
+    std::string errorString() const;
+
+    static bool decodeFileHeader(const char *data, size_t size, uint64_t *startTime);
+    //Returns false if fewer than RECORD_HEADER_SIZE bytes are available
+    static bool decodeRecordHeader(const char *data, size_t size, CaptureRecordHeader *header);
+    static void encodeLittleEndian(char *destination, uint64_t value, size_t byteCount);
+    static uint64_t decodeLittleEndian(const char *data, size_t byteCount);
+
+    static const char FILE_MAGIC[8];
+    static const size_t constexpr FILE_HEADER_SIZE{16};
+    static const size_t constexpr RECORD_HEADER_SIZE{12};
+    static const size_t constexpr MAXIMUM_RECORD_SIZE{0x7FFFFFFF};
+    static const size_t FLUSH_THRESHOLD;
+    static const size_t MAXIMUM_PENDING_BYTES;
+    static const std::chrono::milliseconds FLUSH_INTERVAL;
+
+private:
+    std::string m_filePath;
+    std::FILE *m_file;
+    std::vector<char> m_activeBuffer;
+    std::vector<char> m_writeBuffer;
+    mutable std::mutex m_bufferMutex;
+    std::condition_variable m_bufferCondition;
+    std::thread m_writeThread;
+    std::atomic<bool> m_isRecording;
+    std::chrono::steady_clock::time_point m_startTime;
+    uint64_t m_fileOffset;
+    uint64_t m_previousBlockOffset;
+    size_t m_previousBlockSize;
+    std::atomic<uint64_t> m_recordedBytes;
+    std::atomic<uint64_t> m_droppedRecords;
+    std::atomic<bool> m_hasError;
+    std::string m_errorString;
+
+    //Returns where the payload goes, or nullptr if the record was dropped; the buffer mutex must be held
+    char *reserveRecord(RecordDirection direction, size_t size);
+    void run();
+    bool writeBuffer(const std::vector<char> &buffer);
+    void setError(const std::string &errorString);
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SESSIONRECORDER_H
@@ -0,0 +1,237 @@
+#include "SessionReplayer.h"
+#include "SessionRecorder.h"
+
+#include <stdexcept>
+
+using namespace CppSerialPort;
+
+const size_t SessionReplayer::REPLAY_CHUNK_SIZE{65536};
+const std::chrono::milliseconds SessionReplayer::REPLAY_RETRY_INTERVAL{1};
+const std::chrono::milliseconds SessionReplayer::PROGRESS_INTERVAL{100};
+
+SessionReplayer::SessionReplayer(ReplayFunction replayFunction, std::function<void()> replayEventCallback) :
+    m_replayFunction{replayFunction},
+    m_replayEventNotifier{replayEventCallback},
+    m_captureFile{},
+    m_filePath{""},
+    m_options{defaultOptions()},
+    m_replayThread{},
+    m_isRunning{false},
+    m_cancelRequested{false},
+    m_mutex{},
+    m_condition{},
+    m_progress{ReplayState::Idle, 0, 0, 0, 0, 0.0},
+    m_errorString{""},
+    m_startTime{},
+    m_lastNotification{}
+{
+    if (!this->m_replayFunction) {
+        throw std::runtime_error("SessionReplayer::SessionReplayer(ReplayFunction, std::function<void()>): invariant failure (replayFunction cannot be empty)");
+    }
+}
+
+ReplayOptions SessionReplayer::defaultOptions()
+{
+    return ReplayOptions{ReplayMode::Timed, 1.0};
+}
+
+void SessionReplayer::start(const std::string &filePath, const ReplayOptions &options)
+{
+    if (this->m_isRunning) {
+        throw std::runtime_error("SessionReplayer::start(const std::string &, const ReplayOptions &): a replay is already running (" + this->m_filePath + ")");
+    }
+    if (this->m_replayThread.joinable()) {
+        this->m_replayThread.join();
+    }
+    if ( (options.mode == ReplayMode::Timed) && (!(options.speedFactor > 0.0)) ) {
+        throw std::runtime_error("SessionReplayer::start(const std::string &, const ReplayOptions &): invalid speed factor " + std::to_string(options.speedFactor));
+    }
+    this->m_captureFile.open(filePath);
+    uint64_t recordingStartTime{0};
+    if (!SessionRecorder::decodeFileHeader(this->m_captureFile.data(), this->m_captureFile.size(), &recordingStartTime)) {
+        this->m_captureFile.close();
+        throw std::runtime_error("SessionReplayer::start(const std::string &, const ReplayOptions &): " + filePath + " is not a session capture");
+    }
+    this->m_captureFile.adviseSequential();
+    this->m_filePath = filePath;
+    this->m_options = options;
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_cancelRequested = false;
+        this->m_progress = ReplayProgress{ReplayState::Running, 0, 0, 0, this->m_captureFile.size(), 0.0};
+        this->m_errorString = "";
+    }
+    this->m_startTime = std::chrono::steady_clock::now();
+    this->m_lastNotification = this->m_startTime;
+    this->m_replayEventNotifier.acknowledge();
+    this->m_isRunning = true;
+    this->m_replayThread = std::thread{&SessionReplayer::run, this};
+}
+
+void SessionReplayer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_cancelRequested = true;
+    }
+    this->m_condition.notify_all();
+    if (this->m_replayThread.joinable()) {
+        this->m_replayThread.join();
+    }
+}
+
+bool SessionReplayer::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+ReplayProgress SessionReplayer::progress() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_progress;
+}
+
+std::string SessionReplayer::filePath() const
+{
+    return this->m_filePath;
+}
+
+std::string SessionReplayer::errorString() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_errorString;
+}
+
+void SessionReplayer::acknowledgeNotification()
+{
+    this->m_replayEventNotifier.acknowledge();
+}
+
+void SessionReplayer::setErrorString(const std::string &errorString)
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    this->m_errorString = errorString;
+}
+
+void SessionReplayer::updateProgress(uint64_t recordsReplayed, uint64_t bytesReplayed, uint64_t bytesProcessed, bool forceNotification)
+{
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress.recordsReplayed = recordsReplayed;
+        this->m_progress.bytesReplayed = bytesReplayed;
+        this->m_progress.bytesProcessed = bytesProcessed;
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(now - this->m_startTime).count();
+    }
+    if ( (forceNotification) || (now - this->m_lastNotification >= PROGRESS_INTERVAL) ) {
+        this->m_lastNotification = now;
+        this->m_replayEventNotifier.notify();
+    }
+}
+
+void SessionReplayer::finish(ReplayState state)
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress.state = state;
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_startTime).count();
+    }
+    this->m_captureFile.close();
+    this->m_isRunning = false;
+    this->m_replayEventNotifier.notifyAlways();
+}
+
+bool SessionReplayer::sleepUntil(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock{this->m_mutex};
+    return !this->m_condition.wait_until(lock, deadline, [this]() { return this->m_cancelRequested.load(); });
+}
+
+bool SessionReplayer::replayData(const char *data, size_t size)
+{
+    while (!this->m_replayFunction(data, size)) {
+        if (!this->sleepUntil(std::chrono::steady_clock::now() + REPLAY_RETRY_INTERVAL)) {
+            return false;
+        }
+    }
+    return !this->m_cancelRequested;
+}
+
+void SessionReplayer::run()
+{
+    const char *captureData{this->m_captureFile.data()};
+    const size_t captureSize{this->m_captureFile.size()};
+    const bool isTimed{this->m_options.mode == ReplayMode::Timed};
+    size_t offset{SessionRecorder::FILE_HEADER_SIZE};
+    uint64_t recordsReplayed{0};
+    uint64_t bytesReplayed{0};
+    bool hasFirstTimestamp{false};
+    uint64_t firstTimestamp{0};
+    std::string chunk{};
+    if (!isTimed) {
+        chunk.reserve(REPLAY_CHUNK_SIZE);
+    }
+
+    try {
+        while (offset < captureSize) {
+            CaptureRecordHeader header{};
+            if ( (!SessionRecorder::decodeRecordHeader(captureData + offset, captureSize - offset, &header)) ||
+                 (header.size > captureSize - offset - SessionRecorder::RECORD_HEADER_SIZE) ) {
+                break;
+            }
+            const char *payload{captureData + offset + SessionRecorder::RECORD_HEADER_SIZE};
+            offset += SessionRecorder::RECORD_HEADER_SIZE + header.size;
+            if (header.direction != RecordDirection::Received) {
+                continue;
+            }
+            if (isTimed) {
+                if (!hasFirstTimestamp) {
+                    firstTimestamp = header.timestamp;
+                    hasFirstTimestamp = true;
+                }
+                //Scheduled against the start rather than the previous chunk, so a slow consumer catches up instead of drifting
+                std::chrono::duration<double, std::nano> recordedOffset{static_cast<double>(header.timestamp - firstTimestamp) / this->m_options.speedFactor};
+                if ( (!this->sleepUntil(this->m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(recordedOffset))) ||
+                     (!this->replayData(payload, header.size)) ) {
+                    this->finish(ReplayState::Cancelled);
+                    return;
+                }
+            } else {
+                if ( (!chunk.empty()) && (chunk.length() + header.size > REPLAY_CHUNK_SIZE) ) {
+                    if (!this->replayData(chunk.data(), chunk.length())) {
+                        this->finish(ReplayState::Cancelled);
+                        return;
+                    }
+                    chunk.clear();
+                }
+                if (header.size >= REPLAY_CHUNK_SIZE) {
+                    if (!this->replayData(payload, header.size)) {
+                        this->finish(ReplayState::Cancelled);
+                        return;
+                    }
+                } else {
+                    chunk.append(payload, header.size);
+                }
+            }
+            recordsReplayed++;
+            bytesReplayed += header.size;
+            this->updateProgress(recordsReplayed, bytesReplayed, offset, false);
+        }
+        if ( (!chunk.empty()) && (!this->replayData(chunk.data(), chunk.length())) ) {
+            this->finish(ReplayState::Cancelled);
+            return;
+        }
+    } catch (std::exception &e) {
+        this->setErrorString(e.what());
+        this->updateProgress(recordsReplayed, bytesReplayed, offset, false);
+        this->finish(ReplayState::Failed);
+        return;
+    }
+    this->updateProgress(recordsReplayed, bytesReplayed, offset, false);
+    this->finish(ReplayState::Finished);
+}
+
+SessionReplayer::~SessionReplayer()
+{
+    this->stop();
+}
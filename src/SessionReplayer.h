@@ -0,0 +1,114 @@
+#ifndef QSERIALTERMINAL_SESSIONREPLAYER_H
+#define QSERIALTERMINAL_SESSIONREPLAYER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "EventNotifier.h"
+
+enum class ReplayMode
+{
+    Timed,
+    MaximumSpeed
+};
+
+struct ReplayOptions
+{
+    ReplayMode mode;
+    //Only used in Timed mode; 2.0 replays twice as fast as the traffic was recorded
+    double speedFactor;
+};
+
+enum class ReplayState
+{
+    Idle,
+    Running,
+    Finished,
+    Cancelled,
+    Failed
+};
+
+struct ReplayProgress
+{
+    ReplayState state;
+    uint64_t recordsReplayed;
+    uint64_t bytesReplayed;
+    uint64_t bytesProcessed;
+    uint64_t totalBytes;
+    double elapsedSeconds;
+};
+
+/*
+ * Plays the received side of a SessionRecorder capture back on its own
+ * thread. The capture is memory mapped and walked record by record, and
+ * each payload is handed to the replay function: the GUI queues it for
+ * the same line splitting and rendering as live traffic, the command line
+ * writes it to stdout or out of a port. Timed mode reproduces the original
+ * gaps between chunks (optionally sped up); MaximumSpeed packs consecutive
+ * chunks into REPLAY_CHUNK_SIZE blocks and sends them as fast as the
+ * consumer accepts them, which makes the achieved rate a measure of the
+ * consumer. A capture cut short by a crash replays up to its last whole
+ * record
+ */
+class SessionReplayer
+{
+public:
+    //Returns false when the data cannot be accepted right now; it is retried until it is accepted or the replay is stopped.
+    //Throwing fails the replay with the exception's message
+    using ReplayFunction = std::function<bool(const char *, size_t)>;
+
+    SessionReplayer(ReplayFunction replayFunction, std::function<void()> replayEventCallback);
+    ~SessionReplayer();
+
+    SessionReplayer(const SessionReplayer &other) = delete;
+    SessionReplayer(SessionReplayer &&other) = delete;
+    SessionReplayer &operator=(const SessionReplayer &rhs) = delete;
+    SessionReplayer &operator=(SessionReplayer &&rhs) = delete;
+
+    void start(const std::string &filePath, const ReplayOptions &options);
+    void stop();
+    bool isRunning() const;
+
+    ReplayProgress progress() const;
+    std::string filePath() const;
+    std::string errorString() const;
+    void acknowledgeNotification();
+
+    static ReplayOptions defaultOptions();
+
+    static const size_t REPLAY_CHUNK_SIZE;
+    static const std::chrono::milliseconds REPLAY_RETRY_INTERVAL;
+    static const std::chrono::milliseconds PROGRESS_INTERVAL;
+
+private:
+    ReplayFunction m_replayFunction;
+    CppSerialPort::EventNotifier m_replayEventNotifier;
+    MappedFile m_captureFile;
+    std::string m_filePath;
+    ReplayOptions m_options;
+    std::thread m_replayThread;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_cancelRequested;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    ReplayProgress m_progress;
+    std::string m_errorString;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastNotification;
+
+    void run();
+    bool replayData(const char *data, size_t size);
+    bool sleepUntil(std::chrono::steady_clock::time_point deadline);
+    void updateProgress(uint64_t recordsReplayed, uint64_t bytesReplayed, uint64_t bytesProcessed, bool forceNotification);
+    void setErrorString(const std::string &errorString);
+    void finish(ReplayState state);
+};
+
+#endif //QSERIALTERMINAL_SESSIONREPLAYER_H
@@ -0,0 +1,114 @@
+/***********************************************************************
+*    SpscQueue.h:                                                      *
+*    SpscQueue, lock-free single producer/single consumer queue        *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of an SpscQueue template class   *
+*    Exactly one thread may push and exactly one (other) thread may    *
+*    pop. The producer and consumer indices are padded out to separate *
+*    cache lines so the two threads do not false-share                 *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_SPSCQUEUE_H
+#define CPPSERIALPORT_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace CppSerialPort {
+
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) :
+        m_capacity{roundUpToPowerOfTwo(capacity)},
+        m_mask{m_capacity - 1},
+        m_slots{new T[m_capacity]},
+        m_head{},
+        m_tail{}
+    {
+        if (capacity == 0) {
+            throw std::runtime_error("SpscQueue::SpscQueue(size_t): invariant failure (capacity cannot be 0)");
+        }
+    }
+
+    SpscQueue(const SpscQueue &other) = delete;
+    SpscQueue(SpscQueue &&other) = delete;
+    SpscQueue &operator=(const SpscQueue &rhs) = delete;
+    SpscQueue &operator=(SpscQueue &&rhs) = delete;
+
+    //Producer side only
+    bool tryPush(T &&value)
+    {
+        size_t tail{this->m_tail.value.load(std::memory_order_relaxed)};
+        if (tail - this->m_head.value.load(std::memory_order_acquire) == this->m_capacity) {
+            return false;
+        }
+        this->m_slots[tail & this->m_mask] = std::move(value);
+        this->m_tail.value.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Consumer side only
+    bool tryPop(T &value)
+    {
+        size_t head{this->m_head.value.load(std::memory_order_relaxed)};
+        if (head == this->m_tail.value.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(this->m_slots[head & this->m_mask]);
+        this->m_head.value.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return this->m_head.value.load(std::memory_order_acquire) == this->m_tail.value.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return this->m_capacity;
+    }
+
+private:
+    static const size_t constexpr CACHE_LINE_SIZE{64};
+
+    struct PaddedIndex
+    {
+        std::atomic<size_t> value{0};
+        char padding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+    PaddedIndex m_head;
+    PaddedIndex m_tail;
+
+    static size_t roundUpToPowerOfTwo(size_t value)
+    {
+        size_t returnValue{1};
+        while (returnValue < value) {
+            returnValue <<= 1;
+        }
+        return returnValue;
+    }
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_SPSCQUEUE_H
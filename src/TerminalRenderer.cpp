@@ -0,0 +1,55 @@
+#include "TerminalRenderer.h"
+
+#include <utility>
+
+const int TerminalRenderer::DEFAULT_FLUSH_INTERVAL{16};
+
+TerminalRenderer::TerminalRenderer(TerminalView *terminal, int flushInterval, QObject *parent) :
+    QObject{parent},
+    m_terminal{terminal},
+    m_flushTimer{},
+    m_pendingLines{}
+{
+    this->m_flushTimer.setSingleShot(true);
+    this->m_flushTimer.setInterval(flushInterval);
+    connect(&this->m_flushTimer, &QTimer::timeout, this, &TerminalRenderer::flush);
+}
+
+void TerminalRenderer::appendLine(std::string text, LineKind kind)
+{
+    this->m_pendingLines.push_back(TerminalLine{std::move(text), kind});
+    //Only the first line of a frame arms the timer, so a steady stream still flushes once per interval
+    if (!this->m_flushTimer.isActive()) {
+        this->m_flushTimer.start();
+    }
+}
+
+void TerminalRenderer::clear()
+{
+    this->m_flushTimer.stop();
+    this->m_pendingLines.clear();
+    this->m_terminal->clear();
+}
+
+void TerminalRenderer::setFlushInterval(int flushInterval)
+{
+    this->m_flushTimer.setInterval(flushInterval);
+}
+
+int TerminalRenderer::flushInterval() const
+{
+    return this->m_flushTimer.interval();
+}
+
+void TerminalRenderer::flush()
+{
+    this->m_flushTimer.stop();
+    if (this->m_pendingLines.empty()) {
+        return;
+    }
+    //One append means one scroll bar update and one repaint for the whole batch
+    this->m_terminal->appendLines(this->m_pendingLines);
+    int linesCoalesced{static_cast<int>(this->m_pendingLines.size())};
+    this->m_pendingLines.clear();
+    emit flushed(linesCoalesced);
+}
@@ -0,0 +1,40 @@
+#ifndef QSERIALTERMINAL_TERMINALRENDERER_H
+#define QSERIALTERMINAL_TERMINALRENDERER_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <vector>
+#include <string>
+
+#include "TerminalView.h"
+
+class TerminalRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TerminalRenderer(TerminalView *terminal, int flushInterval = DEFAULT_FLUSH_INTERVAL, QObject *parent = nullptr);
+
+    void appendLine(std::string text, LineKind kind);
+    void clear();
+
+    void setFlushInterval(int flushInterval);
+    int flushInterval() const;
+
+    static const int DEFAULT_FLUSH_INTERVAL;
+
+signals:
+    void flushed(int linesCoalesced);
+
+public slots:
+    void flush();
+
+private:
+    TerminalView *m_terminal;
+    QTimer m_flushTimer;
+    std::vector<TerminalLine> m_pendingLines;
+};
+
+#endif //QSERIALTERMINAL_TERMINALRENDERER_H
@@ -0,0 +1,263 @@
+#include "TerminalView.h"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QScrollBar>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QMouseEvent>
+#include <QKeyEvent>
+#include <QKeySequence>
+#include <QFontMetrics>
+
+#include <algorithm>
+#include <climits>
+
+static const int TEXT_MARGIN{4};
+
+TerminalView::TerminalView(QWidget *parent) :
+    QAbstractScrollArea{parent},
+    m_lineStore{},
+    m_receivedColor{Qt::red},
+    m_transmittedColor{Qt::blue},
+    m_longestLineWidth{0},
+    m_hasSelection{false},
+    m_selectionAnchor{0},
+    m_selectionEnd{0}
+{
+    this->setFocusPolicy(Qt::ClickFocus);
+    this->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    this->updateScrollBars();
+}
+
+const LineStore &TerminalView::lineStore() const
+{
+    return this->m_lineStore;
+}
+
+bool TerminalView::scrollToLine(uint64_t lineNumber)
+{
+    uint64_t firstLineNumber{this->m_lineStore.firstLineNumber()};
+    if ( (lineNumber < firstLineNumber) || (lineNumber - firstLineNumber >= this->m_lineStore.lineCount()) ) {
+        return false;
+    }
+    //Selecting the line is what highlights it, and leaves it ready to copy
+    this->m_selectionAnchor = lineNumber;
+    this->m_selectionEnd = lineNumber;
+    this->m_hasSelection = true;
+    int index{static_cast<int>(std::min(lineNumber - firstLineNumber, static_cast<uint64_t>(INT_MAX)))};
+    this->verticalScrollBar()->setValue(std::max(0, index - (this->visibleRowCount() / 2)));
+    this->viewport()->update();
+    return true;
+}
+
+void TerminalView::setLineColor(LineKind kind, const QColor &color)
+{
+    if (kind == LineKind::Received) {
+        this->m_receivedColor = color;
+    } else {
+        this->m_transmittedColor = color;
+    }
+    this->viewport()->update();
+}
+
+void TerminalView::setScrollbackLimit(size_t maxLines, size_t maxBytes)
+{
+    this->m_lineStore.setScrollbackLimit(maxLines, maxBytes);
+    this->updateScrollBars();
+    this->viewport()->update();
+}
+
+void TerminalView::setSpillFile(const std::string &filePath)
+{
+    this->m_lineStore.setSpillFile(filePath);
+}
+
+int TerminalView::lineHeight() const
+{
+    return std::max(1, this->fontMetrics().lineSpacing());
+}
+
+int TerminalView::visibleRowCount() const
+{
+    return std::max(1, this->viewport()->height() / this->lineHeight());
+}
+
+uint64_t TerminalView::lineNumberAt(int y) const
+{
+    int row{std::max(0, y) / this->lineHeight()};
+    size_t index{static_cast<size_t>(this->verticalScrollBar()->value() + row)};
+    if (index >= this->m_lineStore.lineCount()) {
+        index = this->m_lineStore.lineCount() - 1;
+    }
+    return this->m_lineStore.firstLineNumber() + index;
+}
+
+void TerminalView::updateScrollBars()
+{
+    int rows{this->visibleRowCount()};
+    int lineCount{static_cast<int>(std::min(this->m_lineStore.lineCount(), static_cast<size_t>(INT_MAX)))};
+    this->verticalScrollBar()->setPageStep(rows);
+    this->verticalScrollBar()->setRange(0, std::max(0, lineCount - rows));
+    this->horizontalScrollBar()->setPageStep(this->viewport()->width());
+    this->horizontalScrollBar()->setRange(0, std::max(0, this->m_longestLineWidth + (2 * TEXT_MARGIN) - this->viewport()->width()));
+}
+
+void TerminalView::appendLines(const std::vector<TerminalLine> &lines)
+{
+    if (lines.empty()) {
+        return;
+    }
+    QScrollBar *scrollBar{this->verticalScrollBar()};
+    bool followOutput{scrollBar->value() == scrollBar->maximum()};
+    int previousValue{scrollBar->value()};
+    uint64_t previousFirstLine{this->m_lineStore.firstLineNumber()};
+
+    const TerminalLine *longestLine{&lines.front()};
+    for (const auto &it : lines) {
+        this->m_lineStore.append(it.text.data(), it.text.size(), it.kind);
+        if (it.text.size() > longestLine->text.size()) {
+            longestLine = &it;
+        }
+    }
+    //Only the line with the most bytes is measured, saving a QString per line. With the fixed pitch terminal font
+    //that is also the widest line unless other lines hold multibyte characters
+    QFontMetrics metrics{this->font()};
+    QString longestText{QString::fromUtf8(longestLine->text.data(), static_cast<int>(longestLine->text.size()))};
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    this->m_longestLineWidth = std::max(this->m_longestLineWidth, metrics.horizontalAdvance(longestText));
+#else
+    this->m_longestLineWidth = std::max(this->m_longestLineWidth, metrics.width(longestText));
+#endif
+    this->updateScrollBars();
+
+    if (followOutput) {
+        scrollBar->setValue(scrollBar->maximum());
+    } else {
+        //Keep the same text on screen when old segments were dropped from the top
+        int droppedLines{static_cast<int>(this->m_lineStore.firstLineNumber() - previousFirstLine)};
+        scrollBar->setValue(std::max(0, previousValue - droppedLines));
+    }
+    this->viewport()->update();
+}
+
+void TerminalView::clear()
+{
+    this->m_lineStore.clear();
+    this->m_longestLineWidth = 0;
+    this->m_hasSelection = false;
+    this->updateScrollBars();
+    this->viewport()->update();
+}
+
+void TerminalView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter{this->viewport()};
+    painter.setFont(this->font());
+
+    const int height{this->lineHeight()};
+    const int ascent{this->fontMetrics().ascent()};
+    const int xOffset{TEXT_MARGIN - this->horizontalScrollBar()->value()};
+    const int rowsToPaint{(this->viewport()->height() / height) + 1};
+    const size_t firstIndex{static_cast<size_t>(this->verticalScrollBar()->value())};
+    const uint64_t firstLineNumber{this->m_lineStore.firstLineNumber()};
+    const uint64_t selectionStart{std::min(this->m_selectionAnchor, this->m_selectionEnd)};
+    const uint64_t selectionEnd{std::max(this->m_selectionAnchor, this->m_selectionEnd)};
+
+    for (int row = 0; row < rowsToPaint; row++) {
+        size_t index{firstIndex + static_cast<size_t>(row)};
+        if (index >= this->m_lineStore.lineCount()) {
+            break;
+        }
+        LineReference line{this->m_lineStore.line(index)};
+        int y{row * height};
+        uint64_t lineNumber{firstLineNumber + index};
+        if ( (this->m_hasSelection) && (lineNumber >= selectionStart) && (lineNumber <= selectionEnd) ) {
+            painter.fillRect(0, y, this->viewport()->width(), height, this->palette().highlight());
+        }
+        painter.setPen(line.kind == LineKind::Received ? this->m_receivedColor : this->m_transmittedColor);
+        painter.drawText(xOffset, y + ascent, QString::fromUtf8(line.data, static_cast<int>(line.size)));
+    }
+}
+
+void TerminalView::resizeEvent(QResizeEvent *event)
+{
+    QScrollBar *scrollBar{this->verticalScrollBar()};
+    bool followOutput{scrollBar->value() == scrollBar->maximum()};
+    QAbstractScrollArea::resizeEvent(event);
+    this->updateScrollBars();
+    if (followOutput) {
+        scrollBar->setValue(scrollBar->maximum());
+    }
+}
+
+void TerminalView::mousePressEvent(QMouseEvent *event)
+{
+    if ( (event->button() != Qt::LeftButton) || (this->m_lineStore.lineCount() == 0) ) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    this->m_selectionAnchor = this->lineNumberAt(event->pos().y());
+    this->m_selectionEnd = this->m_selectionAnchor;
+    this->m_hasSelection = true;
+    this->viewport()->update();
+}
+
+void TerminalView::mouseMoveEvent(QMouseEvent *event)
+{
+    if ( (!(event->buttons() & Qt::LeftButton)) || (!this->m_hasSelection) || (this->m_lineStore.lineCount() == 0) ) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+    if (event->pos().y() < 0) {
+        this->verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    } else if (event->pos().y() > this->viewport()->height()) {
+        this->verticalScrollBar()->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    }
+    this->m_selectionEnd = this->lineNumberAt(std::min(event->pos().y(), this->viewport()->height() - 1));
+    this->viewport()->update();
+}
+
+void TerminalView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->matches(QKeySequence::Copy)) {
+        this->copySelection();
+    } else if (event->matches(QKeySequence::SelectAll)) {
+        this->selectAll();
+    } else {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void TerminalView::selectAll()
+{
+    if (this->m_lineStore.lineCount() == 0) {
+        return;
+    }
+    this->m_selectionAnchor = this->m_lineStore.firstLineNumber();
+    this->m_selectionEnd = this->m_selectionAnchor + this->m_lineStore.lineCount() - 1;
+    this->m_hasSelection = true;
+    this->viewport()->update();
+}
+
+void TerminalView::copySelection()
+{
+    if ( (!this->m_hasSelection) || (this->m_lineStore.lineCount() == 0) ) {
+        return;
+    }
+    //Lines that have since been trimmed from the scrollback are simply skipped
+    uint64_t firstLineNumber{this->m_lineStore.firstLineNumber()};
+    uint64_t selectionStart{std::max(std::min(this->m_selectionAnchor, this->m_selectionEnd), firstLineNumber)};
+    uint64_t selectionEnd{std::max(this->m_selectionAnchor, this->m_selectionEnd)};
+    QString copiedText{""};
+    for (uint64_t lineNumber = selectionStart; lineNumber <= selectionEnd; lineNumber++) {
+        LineReference line{this->m_lineStore.line(static_cast<size_t>(lineNumber - firstLineNumber))};
+        if (lineNumber != selectionStart) {
+            copiedText += '\n';
+        }
+        copiedText += QString::fromUtf8(line.data, static_cast<int>(line.size));
+    }
+    QApplication::clipboard()->setText(copiedText);
+}
@@ -0,0 +1,74 @@
+#ifndef QSERIALTERMINAL_TERMINALVIEW_H
+#define QSERIALTERMINAL_TERMINALVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QString>
+#include <QColor>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "LineStore.h"
+
+class QPaintEvent;
+class QResizeEvent;
+class QMouseEvent;
+class QKeyEvent;
+
+//UTF-8, so a line goes into the LineStore without a round trip through QString
+struct TerminalLine
+{
+    std::string text;
+    LineKind kind;
+};
+
+/*
+ * Read-only log view over a LineStore. Only the rows inside the viewport
+ * are converted and painted, so the cost of scrolling or appending does
+ * not depend on how much scrollback is retained
+ */
+class TerminalView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit TerminalView(QWidget *parent = nullptr);
+
+    void appendLines(const std::vector<TerminalLine> &lines);
+    void clear();
+
+    void setLineColor(LineKind kind, const QColor &color);
+    void setScrollbackLimit(size_t maxLines, size_t maxBytes);
+    void setSpillFile(const std::string &filePath);
+
+    const LineStore &lineStore() const;
+    bool scrollToLine(uint64_t lineNumber);
+
+public slots:
+    void copySelection();
+    void selectAll();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    LineStore m_lineStore;
+    QColor m_receivedColor;
+    QColor m_transmittedColor;
+    int m_longestLineWidth;
+    bool m_hasSelection;
+    uint64_t m_selectionAnchor;
+    uint64_t m_selectionEnd;
+
+    int visibleRowCount() const;
+    int lineHeight() const;
+    uint64_t lineNumberAt(int y) const;
+    void updateScrollBars();
+};
+
+#endif //QSERIALTERMINAL_TERMINALVIEW_H
@@ -0,0 +1,367 @@
+#include "TextSearch.h"
+#include "ByteSearch.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+using namespace CppSerialPort;
+
+const uint64_t TextSearch::MAXIMUM_HITS{1000000};
+const std::chrono::milliseconds TextSearch::PROGRESS_INTERVAL{100};
+
+static const size_t CANCEL_CHECK_INTERVAL{4096};
+
+TextSearch::TextSearch(std::function<void()> searchEventCallback) :
+    m_searchEventNotifier{searchEventCallback},
+    m_blockFunction{},
+    m_options{"", false, true},
+    m_literal{""},
+    m_expression{},
+    m_hasExpression{false},
+    m_workers{},
+    m_nextBlock{0},
+    m_activeWorkers{0},
+    m_isRunning{false},
+    m_cancelRequested{false},
+    m_mutex{},
+    m_progress{SearchState::Idle, 0, 0, 0, 0, false, 0.0},
+    m_pendingHits{},
+    m_errorString{""},
+    m_startTime{},
+    m_lastNotification{}
+{
+
+}
+
+size_t TextSearch::workerCount(size_t blockCount)
+{
+    size_t hardwareThreads{std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1))};
+    return std::max(std::min(hardwareThreads, blockCount), static_cast<size_t>(1));
+}
+
+std::string TextSearch::requiredLiteral(const std::string &pattern)
+{
+    //Any run could sit in a branch the match does not take
+    if (pattern.find('|') != std::string::npos) {
+        return "";
+    }
+    std::string longestRun{""};
+    std::string currentRun{""};
+    bool lastAtomWasLiteral{false};
+    auto endRun = [&longestRun, &currentRun, &lastAtomWasLiteral]() {
+        if (currentRun.length() > longestRun.length()) {
+            longestRun = currentRun;
+        }
+        currentRun.clear();
+        lastAtomWasLiteral = false;
+    };
+    for (size_t i = 0; i < pattern.length(); i++) {
+        char c{pattern[i]};
+        if (c == '\\') {
+            if (++i >= pattern.length()) {
+                return "";
+            }
+            char escaped{pattern[i]};
+            if (!isalnum(static_cast<unsigned char>(escaped))) {
+                currentRun += escaped;
+                lastAtomWasLiteral = true;
+                continue;
+            }
+            //Character classes, anchors, back references and escape codes; skip over the digits the last two take
+            endRun();
+            size_t digitsToSkip{escaped == 'x' ? 2u : (escaped == 'u' ? 4u : (escaped == 'c' ? 1u : 0u))};
+            i += std::min(digitsToSkip, pattern.length() - i - 1);
+            while ( (isdigit(static_cast<unsigned char>(escaped))) && (i + 1 < pattern.length()) && (isdigit(static_cast<unsigned char>(pattern[i + 1]))) ) {
+                i++;
+            }
+        } else if ( (c == '*') || (c == '?') || (c == '{') ) {
+            //The atom before may occur zero times, so it cannot be part of a required run
+            if (lastAtomWasLiteral) {
+                currentRun.pop_back();
+            }
+            endRun();
+            if (c == '{') {
+                i = std::min(pattern.find('}', i), pattern.length());
+            }
+        } else if (c == '+') {
+            endRun();
+        } else if (c == '[') {
+            endRun();
+            //A ] straight after [ or [^ is a literal member of the class
+            size_t classEnd{i + 1};
+            if ( (classEnd < pattern.length()) && (pattern[classEnd] == '^') ) {
+                classEnd++;
+            }
+            if ( (classEnd < pattern.length()) && (pattern[classEnd] == ']') ) {
+                classEnd++;
+            }
+            while ( (classEnd < pattern.length()) && (pattern[classEnd] != ']') ) {
+                classEnd += (pattern[classEnd] == '\\' ? 2 : 1);
+            }
+            i = std::min(classEnd, pattern.length());
+        } else if (c == '(') {
+            //Groups can be quantified as a whole, so nothing inside them is relied on
+            endRun();
+            size_t depth{1};
+            while ( (depth > 0) && (++i < pattern.length()) ) {
+                if (pattern[i] == '\\') {
+                    i++;
+                } else if (pattern[i] == '(') {
+                    depth++;
+                } else if (pattern[i] == ')') {
+                    depth--;
+                }
+            }
+        } else if ( (c == '.') || (c == '^') || (c == '$') || (c == ')') || (c == ']') || (c == '}') ) {
+            endRun();
+        } else {
+            currentRun += c;
+            lastAtomWasLiteral = true;
+        }
+    }
+    endRun();
+    return longestRun;
+}
+
+void TextSearch::foldCase(const char *data, size_t size, std::string *folded)
+{
+    folded->resize(size);
+    char *destination{&(*folded)[0]};
+    for (size_t i = 0; i < size; i++) {
+        char c{data[i]};
+        destination[i] = ( (c >= 'A') && (c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c );
+    }
+}
+
+void TextSearch::start(const SearchOptions &options, size_t blockCount, BlockFunction blockFunction)
+{
+    if (this->m_isRunning) {
+        throw std::runtime_error("TextSearch::start(const SearchOptions &, size_t, BlockFunction): a search is already running");
+    }
+    this->stop();
+    if (options.pattern.empty()) {
+        throw std::runtime_error("TextSearch::start(const SearchOptions &, size_t, BlockFunction): the search pattern is empty");
+    }
+    if (options.isRegex) {
+        auto flags = std::regex::ECMAScript | std::regex::optimize | (options.isCaseSensitive ? std::regex::flag_type{} : std::regex::icase);
+        try {
+            this->m_expression = std::regex{options.pattern, flags};
+        } catch (std::regex_error &e) {
+            throw std::runtime_error("TextSearch::start(const SearchOptions &, size_t, BlockFunction): invalid regular expression \"" + options.pattern + "\" (" + e.what() + ")");
+        }
+    }
+    this->m_options = options;
+    this->m_hasExpression = options.isRegex;
+    this->m_literal = (options.isRegex ? requiredLiteral(options.pattern) : options.pattern);
+    if (!options.isCaseSensitive) {
+        std::string foldedLiteral{};
+        foldCase(this->m_literal.data(), this->m_literal.length(), &foldedLiteral);
+        this->m_literal = foldedLiteral;
+    }
+    this->m_blockFunction = blockFunction;
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        this->m_progress = SearchProgress{SearchState::Running, 0, blockCount, 0, 0, false, 0.0};
+        this->m_pendingHits.clear();
+        this->m_errorString = "";
+    }
+    this->m_startTime = std::chrono::steady_clock::now();
+    //So the first hits are handed over straight away
+    this->m_lastNotification = this->m_startTime - PROGRESS_INTERVAL;
+    this->m_nextBlock = 0;
+    this->m_cancelRequested = false;
+    this->m_searchEventNotifier.acknowledge();
+    size_t workers{workerCount(blockCount)};
+    this->m_activeWorkers = workers;
+    this->m_isRunning = true;
+    for (size_t i = 0; i < workers; i++) {
+        this->m_workers.emplace_back(&TextSearch::run, this);
+    }
+}
+
+void TextSearch::stop()
+{
+    this->m_cancelRequested = true;
+    for (auto &it : this->m_workers) {
+        if (it.joinable()) {
+            it.join();
+        }
+    }
+    this->m_workers.clear();
+}
+
+bool TextSearch::isRunning() const
+{
+    return this->m_isRunning;
+}
+
+SearchProgress TextSearch::progress() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    SearchProgress progress{this->m_progress};
+    if (progress.state == SearchState::Running) {
+        progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_startTime).count();
+    }
+    return progress;
+}
+
+std::vector<SearchHit> TextSearch::takeHits()
+{
+    std::vector<SearchHit> hits{};
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    std::swap(hits, this->m_pendingHits);
+    return hits;
+}
+
+std::string TextSearch::errorString() const
+{
+    std::lock_guard<std::mutex> lock{this->m_mutex};
+    return this->m_errorString;
+}
+
+void TextSearch::acknowledgeNotification()
+{
+    this->m_searchEventNotifier.acknowledge();
+}
+
+void TextSearch::fail(const std::string &errorString)
+{
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        if (this->m_errorString.empty()) {
+            this->m_errorString = errorString;
+        }
+    }
+    this->m_cancelRequested = true;
+}
+
+void TextSearch::addHits(std::vector<SearchHit> *hits, uint64_t bytesSearched)
+{
+    bool isNotificationDue{false};
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        if (this->m_progress.hitCount + hits->size() > MAXIMUM_HITS) {
+            hits->resize(static_cast<size_t>(MAXIMUM_HITS - this->m_progress.hitCount));
+            this->m_progress.isTruncated = true;
+            this->m_cancelRequested = true;
+        }
+        this->m_pendingHits.insert(this->m_pendingHits.end(), hits->begin(), hits->end());
+        this->m_progress.hitCount += hits->size();
+        this->m_progress.blocksSearched++;
+        this->m_progress.bytesSearched += bytesSearched;
+        auto now = std::chrono::steady_clock::now();
+        if (now - this->m_lastNotification >= PROGRESS_INTERVAL) {
+            this->m_lastNotification = now;
+            isNotificationDue = true;
+        }
+    }
+    hits->clear();
+    if (isNotificationDue) {
+        this->m_searchEventNotifier.notify();
+    }
+}
+
+void TextSearch::searchBlock(const SearchBlock &block, const std::regex *expression, std::string *foldedBytes, std::vector<SearchHit> *hits) const
+{
+    if (block.lineCount == 0) {
+        return;
+    }
+    const size_t blockSize{block.lineEnds[block.lineCount - 1]};
+    const uint32_t *lineEnds{block.lineEnds};
+    std::cmatch match{};
+    auto addHit = [&block, hits](size_t lineIndex, size_t matchOffset, size_t matchLength) {
+        hits->push_back(SearchHit{block.firstLineNumber + lineIndex, static_cast<uint32_t>(matchOffset), static_cast<uint32_t>(matchLength)});
+    };
+
+    if (this->m_literal.empty()) {
+        //Nothing to prefilter on, every line goes through the regular expression
+        for (size_t i = 0; i < block.lineCount; i++) {
+            if ( ((i % CANCEL_CHECK_INTERVAL) == 0) && (this->m_cancelRequested) ) {
+                return;
+            }
+            size_t lineStart{i == 0 ? 0 : lineEnds[i - 1]};
+            if (std::regex_search(block.data + lineStart, block.data + lineEnds[i], match, *expression)) {
+                addHit(i, static_cast<size_t>(match.position(0)), static_cast<size_t>(match.length(0)));
+            }
+        }
+        return;
+    }
+
+    const char *haystack{block.data};
+    if (!this->m_options.isCaseSensitive) {
+        foldCase(block.data, blockSize, foldedBytes);
+        haystack = foldedBytes->data();
+    }
+    size_t searchFrom{0};
+    size_t candidateCount{0};
+    while (searchFrom < blockSize) {
+        if ( ((++candidateCount % CANCEL_CHECK_INTERVAL) == 0) && (this->m_cancelRequested) ) {
+            return;
+        }
+        const char *candidate{ByteSearch::find(haystack + searchFrom, haystack + blockSize, this->m_literal.data(), this->m_literal.length())};
+        if (!candidate) {
+            return;
+        }
+        size_t candidateOffset{static_cast<size_t>(candidate - haystack)};
+        size_t lineIndex{static_cast<size_t>(std::upper_bound(lineEnds, lineEnds + block.lineCount, candidateOffset) - lineEnds)};
+        size_t lineStart{lineIndex == 0 ? 0 : lineEnds[lineIndex - 1]};
+        size_t lineEnd{lineEnds[lineIndex]};
+        //Lines are packed without separators, so a candidate running into the next line is not a match (nor is anything later on this line)
+        if (candidateOffset + this->m_literal.length() <= lineEnd) {
+            if (!expression) {
+                addHit(lineIndex, candidateOffset - lineStart, this->m_literal.length());
+            } else if (std::regex_search(block.data + lineStart, block.data + lineEnd, match, *expression)) {
+                addHit(lineIndex, static_cast<size_t>(match.position(0)), static_cast<size_t>(match.length(0)));
+            }
+        }
+        searchFrom = lineEnd;
+    }
+}
+
+void TextSearch::run()
+{
+    //Each worker matches with its own copy of the expression
+    std::regex expression{this->m_expression};
+    const size_t blockCount{this->m_progress.blockCount};
+    std::string scratchBytes{};
+    std::vector<uint32_t> scratchLineEnds{};
+    std::string foldedBytes{};
+    std::vector<SearchHit> hits{};
+    try {
+        while (!this->m_cancelRequested) {
+            size_t blockIndex{this->m_nextBlock++};
+            if (blockIndex >= blockCount) {
+                break;
+            }
+            SearchBlock block{0, nullptr, nullptr, 0};
+            this->m_blockFunction(blockIndex, &scratchBytes, &scratchLineEnds, &block);
+            this->searchBlock(block, (this->m_hasExpression ? &expression : nullptr), &foldedBytes, &hits);
+            this->addHits(&hits, (block.lineCount == 0 ? 0 : block.lineEnds[block.lineCount - 1]));
+        }
+    } catch (std::exception &e) {
+        this->fail(e.what());
+    }
+    if (--this->m_activeWorkers > 0) {
+        return;
+    }
+    //The last worker out reports how the search ended
+    {
+        std::lock_guard<std::mutex> lock{this->m_mutex};
+        if (!this->m_errorString.empty()) {
+            this->m_progress.state = SearchState::Failed;
+        } else if ( (this->m_cancelRequested) && (!this->m_progress.isTruncated) ) {
+            this->m_progress.state = SearchState::Cancelled;
+        } else {
+            this->m_progress.state = SearchState::Finished;
+        }
+        this->m_progress.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->m_startTime).count();
+    }
+    this->m_isRunning = false;
+    this->m_searchEventNotifier.notifyAlways();
+}
+
+TextSearch::~TextSearch()
+{
+    this->stop();
+}
@@ -0,0 +1,133 @@
+#ifndef QSERIALTERMINAL_TEXTSEARCH_H
+#define QSERIALTERMINAL_TEXTSEARCH_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <regex>
+#include <cstdint>
+
+#include "EventNotifier.h"
+
+struct SearchOptions
+{
+    std::string pattern;
+    bool isRegex;
+    bool isCaseSensitive;
+};
+
+enum class SearchState
+{
+    Idle,
+    Running,
+    Finished,
+    Cancelled,
+    Failed
+};
+
+//The first match on a line; lines with several matches are reported once
+struct SearchHit
+{
+    uint64_t lineNumber;
+    uint32_t matchOffset;
+    uint32_t matchLength;
+};
+
+struct SearchProgress
+{
+    SearchState state;
+    size_t blocksSearched;
+    size_t blockCount;
+    uint64_t bytesSearched;
+    uint64_t hitCount;
+    //Set when MAXIMUM_HITS was reached and the rest of the data was skipped
+    bool isTruncated;
+    double elapsedSeconds;
+};
+
+//A run of consecutive lines packed back to back like a LineSegment; line i ends at lineEnds[i]
+struct SearchBlock
+{
+    uint64_t firstLineNumber;
+    const char *data;
+    const uint32_t *lineEnds;
+    size_t lineCount;
+};
+
+/*
+ * Line search over data that is already split into blocks of packed lines,
+ * such as the scrollback's LineSegments or a CaptureIndex's line blocks.
+ * Each search starts one worker per core, and the workers take blocks off
+ * a shared counter until none are left. A block is first scanned for a
+ * literal with ByteSearch (the SSE2/AVX2 search the port reader uses): the
+ * whole pattern for a plain search, or the longest run of literal
+ * characters every match must contain for a regular expression. Only lines
+ * holding a candidate are handed to std::regex, so a rare pattern costs
+ * little more than a memory scan. Hits are collected as blocks complete
+ * and handed over with takeHits(), in block completion order
+ */
+class TextSearch
+{
+public:
+    //Fills in the block with index blockIndex. Sources that already keep their lines packed point straight into
+    //them; others assemble the block in the scratch buffers, which belong to the calling worker
+    using BlockFunction = std::function<void(size_t blockIndex, std::string *scratchBytes, std::vector<uint32_t> *scratchLineEnds, SearchBlock *block)>;
+
+    explicit TextSearch(std::function<void()> searchEventCallback);
+    ~TextSearch();
+
+    TextSearch(const TextSearch &other) = delete;
+    TextSearch(TextSearch &&other) = delete;
+    TextSearch &operator=(const TextSearch &rhs) = delete;
+    TextSearch &operator=(TextSearch &&rhs) = delete;
+
+    //Throws if the pattern is empty or is not a valid regular expression
+    void start(const SearchOptions &options, size_t blockCount, BlockFunction blockFunction);
+    void stop();
+    bool isRunning() const;
+
+    SearchProgress progress() const;
+    //Hits found since the last call
+    std::vector<SearchHit> takeHits();
+    std::string errorString() const;
+    void acknowledgeNotification();
+
+    //The longest string every match of pattern contains, or "" if none can be worked out
+    static std::string requiredLiteral(const std::string &pattern);
+    static size_t workerCount(size_t blockCount);
+
+    static const uint64_t MAXIMUM_HITS;
+    static const std::chrono::milliseconds PROGRESS_INTERVAL;
+
+private:
+    CppSerialPort::EventNotifier m_searchEventNotifier;
+    BlockFunction m_blockFunction;
+    SearchOptions m_options;
+    std::string m_literal;
+    std::regex m_expression;
+    bool m_hasExpression;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_nextBlock;
+    std::atomic<size_t> m_activeWorkers;
+    std::atomic<bool> m_isRunning;
+    std::atomic<bool> m_cancelRequested;
+    mutable std::mutex m_mutex;
+    SearchProgress m_progress;
+    std::vector<SearchHit> m_pendingHits;
+    std::string m_errorString;
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_lastNotification;
+
+    void run();
+    void searchBlock(const SearchBlock &block, const std::regex *expression, std::string *foldedBytes, std::vector<SearchHit> *hits) const;
+    void addHits(std::vector<SearchHit> *hits, uint64_t bytesSearched);
+    void fail(const std::string &errorString);
+
+    static void foldCase(const char *data, size_t size, std::string *folded);
+};
+
+#endif //QSERIALTERMINAL_TEXTSEARCH_H
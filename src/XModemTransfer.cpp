@@ -0,0 +1,397 @@
+/***********************************************************************
+*    XModemTransfer.cpp:                                               *
+*    XModemTransfer, XMODEM/XMODEM-1K/YMODEM batch file transfers      *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a XModemTransfer class      *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "XModemTransfer.h"
+#include "Crc.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+namespace CppSerialPort {
+
+namespace {
+
+const char START_OF_HEADER{0x01};
+const char START_OF_TEXT{0x02};
+const char END_OF_TRANSMISSION{0x04};
+const char ACKNOWLEDGE{0x06};
+const char NEGATIVE_ACKNOWLEDGE{0x15};
+const char CANCEL{0x18};
+const char PADDING{0x1A};
+const char REQUEST_CRC{'C'};
+
+} //namespace
+
+const std::chrono::milliseconds XModemTransfer::START_TIMEOUT{60000};
+const std::chrono::milliseconds XModemTransfer::BLOCK_TIMEOUT{10000};
+const std::chrono::milliseconds XModemTransfer::CHARACTER_TIMEOUT{1000};
+const std::chrono::milliseconds XModemTransfer::START_REQUEST_INTERVAL{3000};
+const int XModemTransfer::MAXIMUM_RETRIES{10};
+
+XModemTransfer::XModemTransfer(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback) :
+    FileTransfer{byteStream, progressCallback},
+    m_protocol{protocol},
+    m_useCrc{true}
+{
+    if (protocol == TransferProtocol::ZModem) {
+        throw std::runtime_error("XModemTransfer::XModemTransfer(TransferProtocol, std::shared_ptr<IByteStream>, std::function<void()>): invariant failure (protocol cannot be ZMODEM)");
+    }
+}
+
+TransferProtocol XModemTransfer::protocol() const
+{
+    return this->m_protocol;
+}
+
+void XModemTransfer::throwTransferError(const std::string &context, const std::string &message)
+{
+    this->sendCancelSequence();
+    throw std::runtime_error(context + ": " + message);
+}
+
+bool XModemTransfer::isCancelledByPeer(int c)
+{
+    //A lone CAN can be line noise, two in a row cannot
+    return (c == CANCEL) && (this->readByte(CHARACTER_TIMEOUT) == CANCEL);
+}
+
+void XModemTransfer::waitForReceiverStart()
+{
+    auto deadline = std::chrono::steady_clock::now() + START_TIMEOUT;
+    while (std::chrono::steady_clock::now() < deadline) {
+        this->throwIfCancelled("XModemTransfer::waitForReceiverStart()");
+        int c{this->readByte(CHARACTER_TIMEOUT)};
+        if (c == REQUEST_CRC) {
+            this->m_useCrc = true;
+            return;
+        } else if (c == NEGATIVE_ACKNOWLEDGE) {
+            this->m_useCrc = false;
+            return;
+        } else if (this->isCancelledByPeer(c)) {
+            throw std::runtime_error("XModemTransfer::waitForReceiverStart(): transfer cancelled by receiver");
+        }
+    }
+    this->throwTransferError("XModemTransfer::waitForReceiverStart()", "receiver never asked for data");
+}
+
+void XModemTransfer::sendBlock(uint8_t blockNumber, const char *data, size_t dataSize, size_t blockSize)
+{
+    char frame[3 + LONG_BLOCK_SIZE + 2];
+    frame[0] = (blockSize == LONG_BLOCK_SIZE ? START_OF_TEXT : START_OF_HEADER);
+    frame[1] = static_cast<char>(blockNumber);
+    frame[2] = static_cast<char>(~blockNumber);
+    memcpy(frame + 3, data, dataSize);
+    memset(frame + 3 + dataSize, PADDING, blockSize - dataSize);
+    size_t frameSize{3 + blockSize};
+    if (this->m_useCrc) {
+        uint16_t crc{Crc16::compute(frame + 3, blockSize)};
+        frame[frameSize++] = static_cast<char>(crc >> 8);
+        frame[frameSize++] = static_cast<char>(crc & 0xFF);
+    } else {
+        uint8_t checksum{0};
+        for (size_t i = 0; i < blockSize; i++) {
+            checksum = static_cast<uint8_t>(checksum + static_cast<uint8_t>(frame[3 + i]));
+        }
+        frame[frameSize++] = static_cast<char>(checksum);
+    }
+
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; attempt++) {
+        this->throwIfCancelled("XModemTransfer::sendBlock(uint8_t, const char *, size_t, size_t)");
+        this->writeBytes(frame, frameSize);
+        auto deadline = std::chrono::steady_clock::now() + BLOCK_TIMEOUT;
+        int c{FileTransfer::READ_TIMED_OUT};
+        //Anything other than ACK, NAK or CAN is line noise (or a receiver still sending its start request)
+        do {
+            c = this->readByte(CHARACTER_TIMEOUT);
+            if ( (c == ACKNOWLEDGE) || (c == NEGATIVE_ACKNOWLEDGE) ) {
+                break;
+            } else if (this->isCancelledByPeer(c)) {
+                throw std::runtime_error("XModemTransfer::sendBlock(uint8_t, const char *, size_t, size_t): transfer cancelled by receiver");
+            }
+            this->throwIfCancelled("XModemTransfer::sendBlock(uint8_t, const char *, size_t, size_t)");
+        } while (std::chrono::steady_clock::now() < deadline);
+        if (c == ACKNOWLEDGE) {
+            return;
+        }
+        this->countError();
+    }
+    this->throwTransferError("XModemTransfer::sendBlock(uint8_t, const char *, size_t, size_t)", "block " + std::to_string(blockNumber) + " was not acknowledged after " + std::to_string(MAXIMUM_RETRIES) + " attempts");
+}
+
+void XModemTransfer::sendFileData(std::ifstream &inputFile, uint64_t fileSize)
+{
+    //1K blocks only go out in CRC mode, and a short tail goes out in 128 byte blocks to save padding
+    bool allowLongBlocks{(this->m_protocol != TransferProtocol::XModem) && (this->m_useCrc)};
+    char data[LONG_BLOCK_SIZE];
+    uint64_t bytesSent{0};
+    uint8_t blockNumber{1};
+    while (bytesSent < fileSize) {
+        uint64_t remainingBytes{fileSize - bytesSent};
+        size_t blockSize{( (allowLongBlocks) && (remainingBytes > SHORT_BLOCK_SIZE * 7) ) ? LONG_BLOCK_SIZE : SHORT_BLOCK_SIZE};
+        auto dataSize = static_cast<size_t>(std::min<uint64_t>(blockSize, remainingBytes));
+        if (!inputFile.read(data, static_cast<std::streamsize>(dataSize))) {
+            this->throwTransferError("XModemTransfer::sendFileData(std::ifstream &, uint64_t)", "could not read from the input file");
+        }
+        this->sendBlock(blockNumber++, data, dataSize, blockSize);
+        bytesSent += dataSize;
+        this->addFileBytes(dataSize);
+    }
+}
+
+void XModemTransfer::sendEndOfTransmission()
+{
+    //YMODEM receivers NAK the first EOT to make sure it was not line noise
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; attempt++) {
+        this->throwIfCancelled("XModemTransfer::sendEndOfTransmission()");
+        this->writeByte(END_OF_TRANSMISSION);
+        int c{this->readByte(BLOCK_TIMEOUT)};
+        if (c == ACKNOWLEDGE) {
+            return;
+        } else if (this->isCancelledByPeer(c)) {
+            throw std::runtime_error("XModemTransfer::sendEndOfTransmission(): transfer cancelled by receiver");
+        }
+    }
+    this->throwTransferError("XModemTransfer::sendEndOfTransmission()", "end of transmission was not acknowledged");
+}
+
+void XModemTransfer::sendHeaderBlock(const std::string &fileName, uint64_t fileSize)
+{
+    //Name, NUL, then the decimal size; an empty name ends the batch
+    std::string header{fileName};
+    if (!fileName.empty()) {
+        header += '\0';
+        header += std::to_string(fileSize);
+    }
+    header += '\0';
+    if (header.length() > LONG_BLOCK_SIZE) {
+        this->throwTransferError("XModemTransfer::sendHeaderBlock(const std::string &, uint64_t)", "file name \"" + fileName + "\" is too long");
+    }
+    size_t blockSize{header.length() > SHORT_BLOCK_SIZE ? LONG_BLOCK_SIZE : SHORT_BLOCK_SIZE};
+    std::string block(blockSize, '\0');
+    block.replace(0, header.length(), header);
+    //Block 0 is zero padded rather than 0x1A padded, so it is sent as a full block
+    this->sendBlock(0, block.data(), block.length(), blockSize);
+}
+
+void XModemTransfer::sendFiles(const std::vector<std::string> &filePaths)
+{
+    if (filePaths.empty()) {
+        throw std::runtime_error("XModemTransfer::sendFiles(const std::vector<std::string> &): no files to send");
+    }
+    if ( (this->m_protocol != TransferProtocol::YModem) && (filePaths.size() > 1) ) {
+        throw std::runtime_error("XModemTransfer::sendFiles(const std::vector<std::string> &): " + protocolName(this->m_protocol) + " can only send one file at a time");
+    }
+    this->beginTransfer();
+    for (const auto &filePath : filePaths) {
+        std::ifstream inputFile{filePath, std::ios::binary};
+        if (!inputFile.is_open()) {
+            this->throwTransferError("XModemTransfer::sendFiles(const std::vector<std::string> &)", "could not open \"" + filePath + "\"");
+        }
+        uint64_t size{fileSize(filePath)};
+        this->beginFile(baseName(filePath), size);
+        this->waitForReceiverStart();
+        if (this->m_protocol == TransferProtocol::YModem) {
+            if (!this->m_useCrc) {
+                this->throwTransferError("XModemTransfer::sendFiles(const std::vector<std::string> &)", "YMODEM receiver asked for checksum mode");
+            }
+            this->sendHeaderBlock(baseName(filePath), size);
+            this->waitForReceiverStart();
+        }
+        this->sendFileData(inputFile, size);
+        this->sendEndOfTransmission();
+        this->finishFile();
+    }
+    if (this->m_protocol == TransferProtocol::YModem) {
+        this->waitForReceiverStart();
+        this->sendHeaderBlock("", 0);
+    }
+}
+
+bool XModemTransfer::readBlockBody(size_t blockSize, uint8_t *blockNumber, char *data)
+{
+    int number{this->readByte(CHARACTER_TIMEOUT)};
+    int complement{this->readByte(CHARACTER_TIMEOUT)};
+    if ( (number == FileTransfer::READ_TIMED_OUT) || (complement == FileTransfer::READ_TIMED_OUT) ) {
+        return false;
+    }
+    for (size_t i = 0; i < blockSize; i++) {
+        int c{this->readByte(CHARACTER_TIMEOUT)};
+        if (c == FileTransfer::READ_TIMED_OUT) {
+            return false;
+        }
+        data[i] = static_cast<char>(c);
+    }
+    bool isValid{false};
+    if (this->m_useCrc) {
+        int high{this->readByte(CHARACTER_TIMEOUT)};
+        int low{this->readByte(CHARACTER_TIMEOUT)};
+        isValid = (high != FileTransfer::READ_TIMED_OUT) && (low != FileTransfer::READ_TIMED_OUT) &&
+                  (Crc16::compute(data, blockSize) == static_cast<uint16_t>((high << 8) | low));
+    } else {
+        int checksum{this->readByte(CHARACTER_TIMEOUT)};
+        uint8_t expected{0};
+        for (size_t i = 0; i < blockSize; i++) {
+            expected = static_cast<uint8_t>(expected + static_cast<uint8_t>(data[i]));
+        }
+        isValid = (checksum == expected);
+    }
+    *blockNumber = static_cast<uint8_t>(number);
+    return (isValid) && ((number ^ complement) == 0xFF);
+}
+
+void XModemTransfer::receiveFileData(std::ofstream &outputFile, uint64_t fileSize, bool isSizeKnown)
+{
+    char data[LONG_BLOCK_SIZE];
+    uint8_t expectedBlock{1};
+    uint64_t bytesWritten{0};
+    int errorCount{0};
+    int startRequests{0};
+    bool hasStarted{false};
+    this->writeByte(this->m_useCrc ? REQUEST_CRC : NEGATIVE_ACKNOWLEDGE);
+    while (true) {
+        this->throwIfCancelled("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool)");
+        int c{this->readByte(hasStarted ? BLOCK_TIMEOUT : START_REQUEST_INTERVAL)};
+        if (c == FileTransfer::READ_TIMED_OUT) {
+            if (++errorCount > MAXIMUM_RETRIES) {
+                this->throwTransferError("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool)", "sender stopped responding");
+            }
+            this->countError();
+            if (!hasStarted) {
+                //Plain XMODEM senders that only know checksums never answer 'C'
+                if ( (this->m_protocol != TransferProtocol::YModem) && (++startRequests == 3) ) {
+                    this->m_useCrc = false;
+                }
+                this->writeByte(this->m_useCrc ? REQUEST_CRC : NEGATIVE_ACKNOWLEDGE);
+            } else {
+                this->writeByte(NEGATIVE_ACKNOWLEDGE);
+            }
+            continue;
+        }
+        if (c == END_OF_TRANSMISSION) {
+            this->writeByte(ACKNOWLEDGE);
+            return;
+        } else if (this->isCancelledByPeer(c)) {
+            throw std::runtime_error("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool): transfer cancelled by sender");
+        } else if ( (c != START_OF_HEADER) && (c != START_OF_TEXT) ) {
+            continue;
+        }
+        size_t blockSize{c == START_OF_TEXT ? LONG_BLOCK_SIZE : SHORT_BLOCK_SIZE};
+        uint8_t blockNumber{0};
+        if (!this->readBlockBody(blockSize, &blockNumber, data)) {
+            //Let the rest of a damaged block drain away, so its bytes are not mistaken for the retransmission
+            this->discardInput(CHARACTER_TIMEOUT / 4);
+            this->countError();
+            if (++errorCount > MAXIMUM_RETRIES) {
+                this->throwTransferError("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool)", "too many damaged blocks");
+            }
+            this->writeByte(NEGATIVE_ACKNOWLEDGE);
+            continue;
+        }
+        hasStarted = true;
+        errorCount = 0;
+        if (blockNumber == expectedBlock) {
+            auto dataSize = static_cast<size_t>(isSizeKnown ? std::min<uint64_t>(blockSize, fileSize - bytesWritten) : blockSize);
+            if (!outputFile.write(data, static_cast<std::streamsize>(dataSize))) {
+                this->throwTransferError("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool)", "could not write to the output file");
+            }
+            bytesWritten += dataSize;
+            expectedBlock++;
+            this->addFileBytes(dataSize);
+        } else if (blockNumber != static_cast<uint8_t>(expectedBlock - 1)) {
+            this->throwTransferError("XModemTransfer::receiveFileData(std::ofstream &, uint64_t, bool)", "lost block synchronisation (expected block " + std::to_string(expectedBlock) + ", got " + std::to_string(blockNumber) + ")");
+        }
+        //A repeat of the previous block means our ACK was lost, so it is acknowledged again and otherwise ignored
+        this->writeByte(ACKNOWLEDGE);
+    }
+}
+
+bool XModemTransfer::receiveHeaderBlock(std::string *fileName, uint64_t *fileSize)
+{
+    char data[LONG_BLOCK_SIZE];
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES * 2; attempt++) {
+        this->throwIfCancelled("XModemTransfer::receiveHeaderBlock(std::string *, uint64_t *)");
+        this->writeByte(REQUEST_CRC);
+        int c{this->readByte(START_REQUEST_INTERVAL)};
+        if (this->isCancelledByPeer(c)) {
+            throw std::runtime_error("XModemTransfer::receiveHeaderBlock(std::string *, uint64_t *): transfer cancelled by sender");
+        } else if (c == END_OF_TRANSMISSION) {
+            //The previous file's EOT again, our ACK got lost
+            this->writeByte(ACKNOWLEDGE);
+            continue;
+        } else if ( (c != START_OF_HEADER) && (c != START_OF_TEXT) ) {
+            continue;
+        }
+        size_t blockSize{c == START_OF_TEXT ? LONG_BLOCK_SIZE : SHORT_BLOCK_SIZE};
+        uint8_t blockNumber{0};
+        if ( (!this->readBlockBody(blockSize, &blockNumber, data)) || (blockNumber != 0) ) {
+            this->discardInput(CHARACTER_TIMEOUT / 4);
+            this->countError();
+            this->writeByte(NEGATIVE_ACKNOWLEDGE);
+            continue;
+        }
+        this->writeByte(ACKNOWLEDGE);
+        size_t nameLength{strnlen(data, blockSize)};
+        *fileName = std::string{data, nameLength};
+        *fileSize = 0;
+        if (nameLength + 1 < blockSize) {
+            *fileSize = std::strtoull(data + nameLength + 1, nullptr, 10);
+        }
+        return !fileName->empty();
+    }
+    this->throwTransferError("XModemTransfer::receiveHeaderBlock(std::string *, uint64_t *)", "sender never sent a file header");
+    return false;
+}
+
+std::vector<std::string> XModemTransfer::receiveFiles(const std::string &destination)
+{
+    std::vector<std::string> receivedFiles{};
+    this->beginTransfer();
+    this->m_useCrc = true;
+    if (this->m_protocol != TransferProtocol::YModem) {
+        std::ofstream outputFile{destination, std::ios::binary | std::ios::trunc};
+        if (!outputFile.is_open()) {
+            this->throwTransferError("XModemTransfer::receiveFiles(const std::string &)", "could not open \"" + destination + "\" for writing");
+        }
+        this->beginFile(baseName(destination), 0);
+        this->receiveFileData(outputFile, 0, false);
+        this->finishFile();
+        receivedFiles.push_back(destination);
+        return receivedFiles;
+    }
+    std::string fileName{""};
+    uint64_t size{0};
+    while (this->receiveHeaderBlock(&fileName, &size)) {
+        std::string safeName{""};
+        std::string filePath{""};
+        if (!receivedFilePath(fileName, destination, &safeName, &filePath)) {
+            this->throwTransferError("XModemTransfer::receiveFiles(const std::string &)", "sender offered an invalid file name \"" + fileName + "\"");
+        }
+        std::ofstream outputFile{filePath, std::ios::binary | std::ios::trunc};
+        if (!outputFile.is_open()) {
+            this->throwTransferError("XModemTransfer::receiveFiles(const std::string &)", "could not open \"" + filePath + "\" for writing");
+        }
+        this->beginFile(safeName, size);
+        this->receiveFileData(outputFile, size, true);
+        this->finishFile();
+        receivedFiles.push_back(filePath);
+    }
+    return receivedFiles;
+}
+
+} //namespace CppSerialPort
@@ -0,0 +1,76 @@
+/***********************************************************************
+*    XModemTransfer.h:                                                 *
+*    XModemTransfer, XMODEM/XMODEM-1K/YMODEM batch file transfers      *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a XModemTransfer class        *
+*    Sends and receives XMODEM (128 byte blocks, CRC-16 with checksum  *
+*    fallback), XMODEM-1K and YMODEM batch (block 0 carries the name   *
+*    and size, so received files are truncated to their real length). *
+*    Plain XMODEM keeps the final block's 0x1A padding                 *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_XMODEMTRANSFER_H
+#define CPPSERIALPORT_XMODEMTRANSFER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+#include "FileTransfer.h"
+
+namespace CppSerialPort {
+
+class XModemTransfer : public FileTransfer
+{
+public:
+    XModemTransfer(TransferProtocol protocol, std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback = nullptr);
+    ~XModemTransfer() override = default;
+
+    void sendFiles(const std::vector<std::string> &filePaths) override;
+    std::vector<std::string> receiveFiles(const std::string &destination) override;
+    TransferProtocol protocol() const override;
+
+    static const std::chrono::milliseconds START_TIMEOUT;
+    static const std::chrono::milliseconds BLOCK_TIMEOUT;
+    static const std::chrono::milliseconds CHARACTER_TIMEOUT;
+    static const std::chrono::milliseconds START_REQUEST_INTERVAL;
+    static const int MAXIMUM_RETRIES;
+
+private:
+    TransferProtocol m_protocol;
+    bool m_useCrc;
+
+    void waitForReceiverStart();
+    void sendBlock(uint8_t blockNumber, const char *data, size_t dataSize, size_t blockSize);
+    void sendFileData(std::ifstream &inputFile, uint64_t fileSize);
+    void sendEndOfTransmission();
+    void sendHeaderBlock(const std::string &fileName, uint64_t fileSize);
+
+    //Returns false once the sender ends the batch (YMODEM block 0 with an empty name)
+    bool receiveHeaderBlock(std::string *fileName, uint64_t *fileSize);
+    void receiveFileData(std::ofstream &outputFile, uint64_t fileSize, bool isSizeKnown);
+    //Reads the rest of a block after its SOH/STX; returns false on a timeout or a bad CRC
+    bool readBlockBody(size_t blockSize, uint8_t *blockNumber, char *data);
+    bool isCancelledByPeer(int c);
+    void throwTransferError(const std::string &context, const std::string &message);
+
+    static const size_t constexpr SHORT_BLOCK_SIZE{128};
+    static const size_t constexpr LONG_BLOCK_SIZE{1024};
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_XMODEMTRANSFER_H
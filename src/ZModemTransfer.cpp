@@ -0,0 +1,880 @@
+/***********************************************************************
+*    ZModemTransfer.cpp:                                               *
+*    ZModemTransfer, ZMODEM batch file transfers                       *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the implementation of a ZModemTransfer class      *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#include "ZModemTransfer.h"
+#include "Crc.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+namespace CppSerialPort {
+
+namespace {
+
+const char ZPAD{'*'};
+const char ZDLE{0x18};
+const char ZBIN{'A'};
+const char ZHEX{'B'};
+const char ZBIN32{'C'};
+const char XON{0x11};
+
+const int ZRQINIT{0};
+const int ZRINIT{1};
+const int ZSINIT{2};
+const int ZACK{3};
+const int ZFILE{4};
+const int ZSKIP{5};
+const int ZNAK{6};
+const int ZABORT{7};
+const int ZFIN{8};
+const int ZRPOS{9};
+const int ZDATA{10};
+const int ZEOF{11};
+const int ZFERR{12};
+const int ZCRC{13};
+const int ZCHALLENGE{14};
+const int ZCOMMAND{18};
+
+const int ZCRCE{'h'};
+const int ZCRCG{'i'};
+const int ZCRCQ{'j'};
+const int ZCRCW{'k'};
+const int ZRUB0{'l'};
+const int ZRUB1{'m'};
+
+//Header byte offsets: positions are little endian from ZP0, flags are counted down from ZF0
+const int ZP0{0};
+const int ZP1{1};
+const int ZF0{3};
+
+const uint8_t CANFDX{0x01};
+const uint8_t CANOVIO{0x02};
+const uint8_t CANFC32{0x20};
+const uint8_t ESCCTL{0x40};
+const uint8_t ZCBIN{1};
+
+const std::chrono::milliseconds LINE_END_TIMEOUT{100};
+
+bool isFlowControl(int c)
+{
+    return (c == 0x11) || (c == 0x13) || (c == 0x91) || (c == 0x93);
+}
+
+bool needsEscape(uint8_t c, uint8_t previous, bool escapeControlCharacters)
+{
+    switch (c) {
+        case 0x10: case 0x11: case 0x13: case 0x18:
+        case 0x90: case 0x91: case 0x93: case 0x98:
+            return true;
+        case 0x0d: case 0x8d:
+            //"@<CR>" is a command to some telnet and modem software
+            return (escapeControlCharacters) || ((previous & 0x7f) == '@');
+        default:
+            return (escapeControlCharacters) && ((c & 0x60) == 0);
+    }
+}
+
+int hexValue(int c)
+{
+    if ( (c >= '0') && (c <= '9') ) {
+        return c - '0';
+    } else if ( (c >= 'a') && (c <= 'f') ) {
+        return c - 'a' + 10;
+    } else if ( (c >= 'A') && (c <= 'F') ) {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+} //namespace
+
+const size_t ZModemTransfer::DEFAULT_WINDOW_SIZE{32768};
+const size_t ZModemTransfer::SUBPACKET_SIZE{1024};
+const size_t ZModemTransfer::MAXIMUM_SUBPACKET_SIZE{8192};
+const std::chrono::milliseconds ZModemTransfer::HEADER_TIMEOUT{10000};
+const std::chrono::milliseconds ZModemTransfer::CHARACTER_TIMEOUT{5000};
+const int ZModemTransfer::MAXIMUM_RETRIES{10};
+const int ZModemTransfer::FRAME_ERROR{-2};
+const int ZModemTransfer::PEER_CANCELLED{-3};
+const int ZModemTransfer::FRAME_END_FLAG{0x100};
+const size_t ZModemTransfer::GARBAGE_LIMIT{1048576};
+
+ZModemTransfer::ZModemTransfer(std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback) :
+    FileTransfer{byteStream, progressCallback},
+    m_windowSize{DEFAULT_WINDOW_SIZE},
+    m_useCrc32{false},
+    m_escapeControlCharacters{false},
+    m_receiverBufferSize{0},
+    m_receivingCrc32{false},
+    m_lastSentByte{0},
+    m_frame{},
+    m_dataBuffer(MAXIMUM_SUBPACKET_SIZE)
+{
+
+}
+
+TransferProtocol ZModemTransfer::protocol() const
+{
+    return TransferProtocol::ZModem;
+}
+
+void ZModemTransfer::setWindowSize(size_t windowSize)
+{
+    this->m_windowSize = windowSize;
+}
+
+size_t ZModemTransfer::windowSize() const
+{
+    return this->m_windowSize;
+}
+
+ZModemTransfer::Header ZModemTransfer::makeHeader(int type, uint32_t position)
+{
+    Header header{type, {0, 0, 0, 0}};
+    for (int i = 0; i < 4; i++) {
+        header.data[i] = static_cast<uint8_t>(position >> (8 * i));
+    }
+    return header;
+}
+
+uint32_t ZModemTransfer::headerPosition(const Header &header)
+{
+    uint32_t position{0};
+    for (int i = 3; i >= 0; i--) {
+        position = (position << 8) | header.data[i];
+    }
+    return position;
+}
+
+void ZModemTransfer::throwTransferError(const std::string &context, const std::string &message)
+{
+    this->sendCancelSequence();
+    throw std::runtime_error(context + ": " + message);
+}
+
+void ZModemTransfer::throwIfPeerCancelled(int result, const std::string &context)
+{
+    if (result == PEER_CANCELLED) {
+        throw std::runtime_error(context + ": transfer cancelled by the other end");
+    }
+}
+
+void ZModemTransfer::appendEscaped(uint8_t c)
+{
+    if (needsEscape(c, this->m_lastSentByte, this->m_escapeControlCharacters)) {
+        c ^= 0x40;
+        this->m_frame += ZDLE;
+    }
+    this->m_frame += static_cast<char>(c);
+    this->m_lastSentByte = c;
+}
+
+void ZModemTransfer::appendEscaped(const char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        this->appendEscaped(static_cast<uint8_t>(data[i]));
+    }
+}
+
+void ZModemTransfer::appendHexHeader(const Header &header)
+{
+    static const char hexDigits[]{"0123456789abcdef"};
+    uint8_t bytes[7]{static_cast<uint8_t>(header.type), header.data[0], header.data[1], header.data[2], header.data[3], 0, 0};
+    uint16_t crc{Crc16::compute(bytes, 5)};
+    bytes[5] = static_cast<uint8_t>(crc >> 8);
+    bytes[6] = static_cast<uint8_t>(crc);
+    this->m_frame += ZPAD;
+    this->m_frame += ZPAD;
+    this->m_frame += ZDLE;
+    this->m_frame += ZHEX;
+    for (auto byte : bytes) {
+        this->m_frame += hexDigits[byte >> 4];
+        this->m_frame += hexDigits[byte & 0x0f];
+    }
+    this->m_frame += '\r';
+    this->m_frame += static_cast<char>(0x8a);
+    //The XON restarts a sender that took line noise for an XOFF; it is left off where the session may be over
+    if ( (header.type != ZFIN) && (header.type != ZACK) ) {
+        this->m_frame += XON;
+    }
+    this->m_lastSentByte = 0;
+}
+
+void ZModemTransfer::appendBinaryHeader(const Header &header)
+{
+    uint8_t bytes[5]{static_cast<uint8_t>(header.type), header.data[0], header.data[1], header.data[2], header.data[3]};
+    this->m_frame += ZPAD;
+    this->m_frame += ZDLE;
+    this->m_frame += (this->m_useCrc32 ? ZBIN32 : ZBIN);
+    this->m_lastSentByte = 0;
+    for (auto byte : bytes) {
+        this->appendEscaped(byte);
+    }
+    if (this->m_useCrc32) {
+        uint32_t crc{Crc32::compute(bytes, sizeof(bytes))};
+        for (int i = 0; i < 4; i++) {
+            this->appendEscaped(static_cast<uint8_t>(crc >> (8 * i)));
+        }
+    } else {
+        uint16_t crc{Crc16::compute(bytes, sizeof(bytes))};
+        this->appendEscaped(static_cast<uint8_t>(crc >> 8));
+        this->appendEscaped(static_cast<uint8_t>(crc));
+    }
+}
+
+void ZModemTransfer::appendDataSubpacket(const char *data, size_t size, int frameEnd)
+{
+    this->appendEscaped(data, size);
+    this->m_frame += ZDLE;
+    this->m_frame += static_cast<char>(frameEnd);
+    this->m_lastSentByte = static_cast<uint8_t>(frameEnd);
+    //The CRC covers the frame end as well, so a damaged ZCRCG cannot pass for a ZCRCE
+    uint8_t frameEndByte{static_cast<uint8_t>(frameEnd)};
+    if (this->m_useCrc32) {
+        uint32_t crc{Crc32::update(Crc32::update(0, data, size), &frameEndByte, 1)};
+        for (int i = 0; i < 4; i++) {
+            this->appendEscaped(static_cast<uint8_t>(crc >> (8 * i)));
+        }
+    } else {
+        uint16_t crc{Crc16::update(Crc16::update(0, data, size), frameEndByte)};
+        this->appendEscaped(static_cast<uint8_t>(crc >> 8));
+        this->appendEscaped(static_cast<uint8_t>(crc));
+    }
+    if (frameEnd == ZCRCW) {
+        this->m_frame += XON;
+        this->m_lastSentByte = XON;
+    }
+}
+
+void ZModemTransfer::flushFrame()
+{
+    this->writeBytes(this->m_frame.data(), this->m_frame.size());
+    this->m_frame.clear();
+}
+
+void ZModemTransfer::sendHeader(const Header &header)
+{
+    this->appendHexHeader(header);
+    this->flushFrame();
+}
+
+int ZModemTransfer::readEscaped(std::chrono::milliseconds timeout)
+{
+    int c{0};
+    do {
+        c = this->readByte(timeout);
+    } while (isFlowControl(c));
+    if (c != ZDLE) {
+        return c;
+    }
+    int cancelCount{1};
+    while (true) {
+        c = this->readByte(timeout);
+        if (c == READ_TIMED_OUT) {
+            return READ_TIMED_OUT;
+        } else if (isFlowControl(c)) {
+            continue;
+        } else if (c != ZDLE) {
+            break;
+        } else if (++cancelCount >= 5) {
+            return PEER_CANCELLED;
+        }
+    }
+    switch (c) {
+        case ZCRCE: case ZCRCG: case ZCRCQ: case ZCRCW:
+            return FRAME_END_FLAG | c;
+        case ZRUB0:
+            return 0x7f;
+        case ZRUB1:
+            return 0xff;
+        default:
+            return ((c & 0x60) == 0x40 ? c ^ 0x40 : FRAME_ERROR);
+    }
+}
+
+int ZModemTransfer::readHexByte()
+{
+    int high{this->readByte(CHARACTER_TIMEOUT)};
+    int low{this->readByte(CHARACTER_TIMEOUT)};
+    if ( (high == READ_TIMED_OUT) || (low == READ_TIMED_OUT) ) {
+        return READ_TIMED_OUT;
+    }
+    high = hexValue(high & 0x7f);
+    low = hexValue(low & 0x7f);
+    return ( (high < 0) || (low < 0) ? FRAME_ERROR : (high << 4) | low );
+}
+
+int ZModemTransfer::readHexHeader(Header *header)
+{
+    uint8_t bytes[7];
+    for (auto &byte : bytes) {
+        int value{this->readHexByte()};
+        if (value < 0) {
+            return value;
+        }
+        byte = static_cast<uint8_t>(value);
+    }
+    if (Crc16::compute(bytes, 5) != static_cast<uint16_t>((bytes[5] << 8) | bytes[6])) {
+        return FRAME_ERROR;
+    }
+    //Swallow the CR LF (often with the high bit set) so it is not counted as garbage before the next header
+    for (int i = 0; i < 2; i++) {
+        int c{this->peekByte(LINE_END_TIMEOUT)};
+        if ( ((c & 0x7f) != '\r') && ((c & 0x7f) != '\n') ) {
+            break;
+        }
+        this->readByte(LINE_END_TIMEOUT);
+    }
+    header->type = bytes[0];
+    std::memcpy(header->data, bytes + 1, 4);
+    this->m_receivingCrc32 = false;
+    return header->type;
+}
+
+int ZModemTransfer::readBinaryHeader(Header *header, bool isCrc32)
+{
+    uint8_t bytes[9];
+    size_t byteCount{isCrc32 ? 9u : 7u};
+    for (size_t i = 0; i < byteCount; i++) {
+        int c{this->readEscaped(CHARACTER_TIMEOUT)};
+        if (c < 0) {
+            return c;
+        } else if (c & FRAME_END_FLAG) {
+            return FRAME_ERROR;
+        }
+        bytes[i] = static_cast<uint8_t>(c);
+    }
+    if (isCrc32) {
+        uint32_t crc{static_cast<uint32_t>(bytes[5]) | (static_cast<uint32_t>(bytes[6]) << 8) | (static_cast<uint32_t>(bytes[7]) << 16) | (static_cast<uint32_t>(bytes[8]) << 24)};
+        if (Crc32::compute(bytes, 5) != crc) {
+            return FRAME_ERROR;
+        }
+    } else if (Crc16::compute(bytes, 5) != static_cast<uint16_t>((bytes[5] << 8) | bytes[6])) {
+        return FRAME_ERROR;
+    }
+    header->type = bytes[0];
+    std::memcpy(header->data, bytes + 1, 4);
+    //The data subpackets that follow use the same CRC as their header
+    this->m_receivingCrc32 = isCrc32;
+    return header->type;
+}
+
+int ZModemTransfer::readHeader(Header *header, std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    size_t garbageCount{0};
+    int cancelCount{0};
+    while (true) {
+        auto remainingTime = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remainingTime.count() <= 0) {
+            return READ_TIMED_OUT;
+        }
+        int c{this->readByte(remainingTime)};
+        if (c == READ_TIMED_OUT) {
+            return READ_TIMED_OUT;
+        } else if (c == ZDLE) {
+            if (++cancelCount >= 5) {
+                return PEER_CANCELLED;
+            }
+            continue;
+        }
+        cancelCount = 0;
+        if ((c & 0x7f) == ZPAD) {
+            do {
+                c = this->readByte(CHARACTER_TIMEOUT);
+            } while ((c & 0x7f) == ZPAD);
+            if (c == ZDLE) {
+                switch (this->readByte(CHARACTER_TIMEOUT) & 0x7f) {
+                    case ZHEX:
+                        return this->readHexHeader(header);
+                    case ZBIN:
+                        return this->readBinaryHeader(header, false);
+                    case ZBIN32:
+                        return this->readBinaryHeader(header, true);
+                    default:
+                        break;
+                }
+            }
+        }
+        if (++garbageCount > GARBAGE_LIMIT) {
+            return FRAME_ERROR;
+        }
+    }
+}
+
+int ZModemTransfer::readDataSubpacket(size_t *dataSize)
+{
+    size_t size{0};
+    while (true) {
+        int c{this->readEscaped(CHARACTER_TIMEOUT)};
+        if (c < 0) {
+            return c;
+        } else if (c & FRAME_END_FLAG) {
+            int frameEnd{c & 0xff};
+            uint8_t frameEndByte{static_cast<uint8_t>(frameEnd)};
+            uint8_t crcBytes[4];
+            size_t crcSize{this->m_receivingCrc32 ? 4u : 2u};
+            for (size_t i = 0; i < crcSize; i++) {
+                c = this->readEscaped(CHARACTER_TIMEOUT);
+                if (c < 0) {
+                    return c;
+                } else if (c & FRAME_END_FLAG) {
+                    return FRAME_ERROR;
+                }
+                crcBytes[i] = static_cast<uint8_t>(c);
+            }
+            bool isValid{false};
+            if (this->m_receivingCrc32) {
+                uint32_t crc{Crc32::update(Crc32::update(0, this->m_dataBuffer.data(), size), &frameEndByte, 1)};
+                isValid = (crc == (static_cast<uint32_t>(crcBytes[0]) | (static_cast<uint32_t>(crcBytes[1]) << 8) | (static_cast<uint32_t>(crcBytes[2]) << 16) | (static_cast<uint32_t>(crcBytes[3]) << 24)));
+            } else {
+                uint16_t crc{Crc16::update(Crc16::update(0, this->m_dataBuffer.data(), size), frameEndByte)};
+                isValid = (crc == static_cast<uint16_t>((crcBytes[0] << 8) | crcBytes[1]));
+            }
+            *dataSize = size;
+            return (isValid ? frameEnd : FRAME_ERROR);
+        } else if (size >= this->m_dataBuffer.size()) {
+            return FRAME_ERROR;
+        }
+        this->m_dataBuffer[size++] = static_cast<char>(c);
+    }
+}
+
+void ZModemTransfer::waitForReceiverInit()
+{
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; ) {
+        this->throwIfCancelled("ZModemTransfer::waitForReceiverInit()");
+        Header header{};
+        int type{this->readHeader(&header, HEADER_TIMEOUT)};
+        this->throwIfPeerCancelled(type, "ZModemTransfer::waitForReceiverInit()");
+        if (type == ZRINIT) {
+            uint8_t flags{header.data[ZF0]};
+            this->m_useCrc32 = ((flags & CANFC32) != 0);
+            this->m_escapeControlCharacters = ((flags & ESCCTL) != 0);
+            this->m_receiverBufferSize = static_cast<size_t>(header.data[ZP0]) | (static_cast<size_t>(header.data[ZP1]) << 8);
+            //A receiver that cannot read the line while writing to disk has to acknowledge every subpacket
+            if ( ((flags & CANOVIO) == 0) || ((flags & CANFDX) == 0) ) {
+                this->m_receiverBufferSize = (this->m_receiverBufferSize == 0 ? SUBPACKET_SIZE : std::min(this->m_receiverBufferSize, SUBPACKET_SIZE));
+            }
+            return;
+        } else if (type == ZCHALLENGE) {
+            this->sendHeader(makeHeader(ZACK, headerPosition(header)));
+            continue;
+        }
+        attempt++;
+        this->countError();
+        this->sendHeader(makeHeader(ZRQINIT));
+    }
+    this->throwTransferError("ZModemTransfer::waitForReceiverInit()", "receiver never answered");
+}
+
+bool ZModemTransfer::negotiateFile(const std::string &fileInfo, std::ifstream &inputFile, uint64_t *position)
+{
+    Header fileHeader{makeHeader(ZFILE)};
+    fileHeader.data[ZF0] = ZCBIN;
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; attempt++) {
+        this->throwIfCancelled("ZModemTransfer::negotiateFile(const std::string &, std::ifstream &, uint64_t *)");
+        this->appendBinaryHeader(fileHeader);
+        this->appendDataSubpacket(fileInfo.data(), fileInfo.size(), ZCRCW);
+        this->flushFrame();
+        while (true) {
+            Header header{};
+            int type{this->readHeader(&header, HEADER_TIMEOUT)};
+            this->throwIfPeerCancelled(type, "ZModemTransfer::negotiateFile(const std::string &, std::ifstream &, uint64_t *)");
+            if (type == ZRPOS) {
+                *position = headerPosition(header);
+                return true;
+            } else if (type == ZSKIP) {
+                return false;
+            } else if (type == ZCRC) {
+                //The receiver already has a file by this name and wants to know whether it is the same one
+                uint32_t length{headerPosition(header)};
+                uint32_t crc{0};
+                inputFile.clear();
+                inputFile.seekg(0);
+                for (uint64_t checked = 0; (length == 0) || (checked < length); ) {
+                    size_t chunkSize{length == 0 ? this->m_dataBuffer.size() : static_cast<size_t>(std::min<uint64_t>(length - checked, this->m_dataBuffer.size()))};
+                    inputFile.read(this->m_dataBuffer.data(), static_cast<std::streamsize>(chunkSize));
+                    size_t bytesRead{static_cast<size_t>(inputFile.gcount())};
+                    if (bytesRead == 0) {
+                        break;
+                    }
+                    crc = Crc32::update(crc, this->m_dataBuffer.data(), bytesRead);
+                    checked += bytesRead;
+                }
+                this->appendBinaryHeader(makeHeader(ZCRC, crc));
+                this->flushFrame();
+                continue;
+            } else if ( (type == ZABORT) || (type == ZFERR) ) {
+                this->throwTransferError("ZModemTransfer::negotiateFile(const std::string &, std::ifstream &, uint64_t *)", "receiver refused the file");
+            } else if (type == ZRINIT) {
+                //Sent before our ZFILE arrived (the receiver answers ZRQINIT again); resending now would only duplicate it
+                continue;
+            }
+            //Anything else (a timeout, a ZNAK, a damaged header) means send it again
+            this->countError();
+            break;
+        }
+    }
+    this->throwTransferError("ZModemTransfer::negotiateFile(const std::string &, std::ifstream &, uint64_t *)", "receiver never accepted the file header");
+    return false;
+}
+
+ZModemTransfer::SendResult ZModemTransfer::streamFileData(std::ifstream &inputFile, uint64_t fileSize, uint64_t *position)
+{
+    uint64_t acknowledgedPosition{*position};
+    size_t queryInterval{this->m_windowSize / 4};
+    size_t bytesSinceQuery{0};
+    size_t bytesSinceHeader{0};
+    int timeoutCount{0};
+    bool needsHeader{true};
+    bool needsSeek{true};
+    while (true) {
+        this->throwIfCancelled("ZModemTransfer::streamFileData(std::ifstream &, uint64_t, uint64_t *)");
+        if (needsSeek) {
+            inputFile.clear();
+            inputFile.seekg(static_cast<std::streamoff>(*position));
+            this->setFilePosition(*position);
+            needsSeek = false;
+        }
+        if (needsHeader) {
+            this->appendBinaryHeader(makeHeader(ZDATA, static_cast<uint32_t>(*position)));
+            bytesSinceQuery = 0;
+            bytesSinceHeader = 0;
+            needsHeader = false;
+        }
+        inputFile.read(this->m_dataBuffer.data(), static_cast<std::streamsize>(SUBPACKET_SIZE));
+        size_t bytesRead{static_cast<size_t>(inputFile.gcount())};
+        if ( (bytesRead == 0) && (inputFile.bad()) ) {
+            this->throwTransferError("ZModemTransfer::streamFileData(std::ifstream &, uint64_t, uint64_t *)", "could not read from the input file");
+        }
+        bool isEndOfFile{(bytesRead < SUBPACKET_SIZE) || (*position + bytesRead >= fileSize)};
+        bytesSinceQuery += bytesRead;
+        bytesSinceHeader += bytesRead;
+        int frameEnd{ZCRCG};
+        if (isEndOfFile) {
+            frameEnd = ZCRCE;
+        } else if ( (this->m_receiverBufferSize != 0) && (bytesSinceHeader + SUBPACKET_SIZE > this->m_receiverBufferSize) ) {
+            frameEnd = ZCRCW;
+        } else if ( (queryInterval != 0) && (bytesSinceQuery >= queryInterval) ) {
+            frameEnd = ZCRCQ;
+            bytesSinceQuery = 0;
+        }
+        this->appendDataSubpacket(this->m_dataBuffer.data(), bytesRead, frameEnd);
+        this->flushFrame();
+        *position += bytesRead;
+        this->addFileBytes(bytesRead);
+        if (isEndOfFile) {
+            //A ZRPOS still on its way is picked up while waiting for the answer to ZEOF
+            return SendResult::Completed;
+        }
+        needsHeader = (frameEnd == ZCRCW);
+
+        //Poll the reverse channel without stopping, unless the window is full or a ZCRCW needs its ACK
+        while (true) {
+            bool isWindowFull{(this->m_windowSize != 0) && (*position - acknowledgedPosition >= this->m_windowSize)};
+            bool isAwaitingAcknowledge{(frameEnd == ZCRCW) && (acknowledgedPosition < *position)};
+            if ( (!isWindowFull) && (!isAwaitingAcknowledge) ) {
+                if (!this->hasPendingInput()) {
+                    break;
+                }
+                int c{this->peekByte(std::chrono::milliseconds{0})};
+                if ( ((c & 0x7f) != ZPAD) && (c != ZDLE) ) {
+                    this->readByte(std::chrono::milliseconds{0});
+                    continue;
+                }
+            }
+            Header header{};
+            int type{this->readHeader(&header, HEADER_TIMEOUT)};
+            this->throwIfPeerCancelled(type, "ZModemTransfer::streamFileData(std::ifstream &, uint64_t, uint64_t *)");
+            if (type == ZACK) {
+                acknowledgedPosition = std::max<uint64_t>(acknowledgedPosition, headerPosition(header));
+                timeoutCount = 0;
+                continue;
+            } else if (type == ZSKIP) {
+                return SendResult::Skipped;
+            }
+            this->countError();
+            if (type == ZRPOS) {
+                *position = headerPosition(header);
+            } else if ( (type == READ_TIMED_OUT) && (isWindowFull || isAwaitingAcknowledge) ) {
+                //The query or its answer was lost; start again from the last position known to have arrived
+                if (++timeoutCount >= MAXIMUM_RETRIES) {
+                    this->throwTransferError("ZModemTransfer::streamFileData(std::ifstream &, uint64_t, uint64_t *)", "receiver stopped acknowledging data");
+                }
+                *position = acknowledgedPosition;
+            } else {
+                continue;
+            }
+            acknowledgedPosition = *position;
+            needsHeader = true;
+            needsSeek = true;
+            break;
+        }
+    }
+}
+
+bool ZModemTransfer::sendEndOfFile(uint64_t fileSize, uint64_t *position)
+{
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; attempt++) {
+        this->throwIfCancelled("ZModemTransfer::sendEndOfFile(uint64_t, uint64_t *)");
+        this->appendBinaryHeader(makeHeader(ZEOF, static_cast<uint32_t>(fileSize)));
+        this->flushFrame();
+        while (true) {
+            Header header{};
+            int type{this->readHeader(&header, HEADER_TIMEOUT)};
+            this->throwIfPeerCancelled(type, "ZModemTransfer::sendEndOfFile(uint64_t, uint64_t *)");
+            if ( (type == ZRINIT) || (type == ZSKIP) ) {
+                return true;
+            } else if (type == ZRPOS) {
+                this->countError();
+                *position = headerPosition(header);
+                return false;
+            } else if (type == ZACK) {
+                //Late answers to the last ZCRCQ queries
+                continue;
+            }
+            this->countError();
+            break;
+        }
+    }
+    this->throwTransferError("ZModemTransfer::sendEndOfFile(uint64_t, uint64_t *)", "end of file was not acknowledged");
+    return false;
+}
+
+void ZModemTransfer::sendFile(const std::string &filePath, uint64_t fileSize, size_t filesLeft, uint64_t bytesLeft)
+{
+    std::ifstream inputFile{filePath, std::ios::binary};
+    if (!inputFile.is_open()) {
+        this->throwTransferError("ZModemTransfer::sendFile(const std::string &, uint64_t, size_t, uint64_t)", "could not open \"" + filePath + "\"");
+    }
+    std::string fileName{baseName(filePath)};
+    //name NUL length modification-time mode serial files-left bytes-left NUL; a zero time and mode mean "unknown"
+    std::string fileInfo{fileName};
+    fileInfo += '\0';
+    fileInfo += std::to_string(fileSize) + " 0 0 0 " + std::to_string(filesLeft) + " " + std::to_string(bytesLeft);
+    fileInfo += '\0';
+    this->beginFile(fileName, fileSize);
+
+    uint64_t position{0};
+    if (!this->negotiateFile(fileInfo, inputFile, &position)) {
+        return;
+    }
+    while (true) {
+        if (this->streamFileData(inputFile, fileSize, &position) == SendResult::Skipped) {
+            return;
+        }
+        if (this->sendEndOfFile(fileSize, &position)) {
+            break;
+        }
+    }
+    this->finishFile();
+}
+
+void ZModemTransfer::finishSession()
+{
+    for (int attempt = 0; attempt < MAXIMUM_RETRIES; attempt++) {
+        this->sendHeader(makeHeader(ZFIN));
+        Header header{};
+        int type{this->readHeader(&header, HEADER_TIMEOUT)};
+        this->throwIfPeerCancelled(type, "ZModemTransfer::finishSession()");
+        if (type == ZFIN) {
+            //"Over and out"
+            this->writeBytes("OO", 2);
+            return;
+        }
+    }
+    this->throwTransferError("ZModemTransfer::finishSession()", "receiver never confirmed the end of the session");
+}
+
+void ZModemTransfer::sendFiles(const std::vector<std::string> &filePaths)
+{
+    this->beginTransfer();
+    std::vector<uint64_t> fileSizes{};
+    uint64_t bytesLeft{0};
+    for (auto &filePath : filePaths) {
+        fileSizes.push_back(fileSize(filePath));
+        bytesLeft += fileSizes.back();
+    }
+    //Starts a receiver if the other end is sitting at a shell; a receiver that is already running ignores it
+    this->writeBytes("rz\r", 3);
+    this->sendHeader(makeHeader(ZRQINIT));
+    this->waitForReceiverInit();
+    for (size_t i = 0; i < filePaths.size(); i++) {
+        this->sendFile(filePaths[i], fileSizes[i], filePaths.size() - i, bytesLeft);
+        bytesLeft -= fileSizes[i];
+    }
+    this->finishSession();
+}
+
+void ZModemTransfer::sendReceiverInit()
+{
+    //A buffer size of zero asks the sender to stream for as long as it likes
+    Header header{makeHeader(ZRINIT)};
+    header.data[ZF0] = CANFDX | CANOVIO | CANFC32;
+    this->sendHeader(header);
+}
+
+void ZModemTransfer::receiveFileData(std::ofstream &outputFile)
+{
+    uint64_t position{0};
+    int errorCount{0};
+    while (true) {
+        this->throwIfCancelled("ZModemTransfer::receiveFileData(std::ofstream &)");
+        Header header{};
+        int type{this->readHeader(&header, HEADER_TIMEOUT)};
+        this->throwIfPeerCancelled(type, "ZModemTransfer::receiveFileData(std::ofstream &)");
+        if ( (type == ZDATA) && (headerPosition(header) == static_cast<uint32_t>(position)) ) {
+            while (true) {
+                this->throwIfCancelled("ZModemTransfer::receiveFileData(std::ofstream &)");
+                size_t dataSize{0};
+                int frameEnd{this->readDataSubpacket(&dataSize)};
+                this->throwIfPeerCancelled(frameEnd, "ZModemTransfer::receiveFileData(std::ofstream &)");
+                if (frameEnd < 0) {
+                    //Everything up to the next header is useless now; the sender rewinds when it sees this
+                    this->countError();
+                    if (++errorCount > MAXIMUM_RETRIES) {
+                        this->throwTransferError("ZModemTransfer::receiveFileData(std::ofstream &)", "too many damaged subpackets");
+                    }
+                    this->sendHeader(makeHeader(ZRPOS, static_cast<uint32_t>(position)));
+                    break;
+                }
+                outputFile.write(this->m_dataBuffer.data(), static_cast<std::streamsize>(dataSize));
+                if (!outputFile) {
+                    this->throwTransferError("ZModemTransfer::receiveFileData(std::ofstream &)", "could not write to the output file");
+                }
+                position += dataSize;
+                this->addFileBytes(dataSize);
+                errorCount = 0;
+                if ( (frameEnd == ZCRCQ) || (frameEnd == ZCRCW) ) {
+                    this->sendHeader(makeHeader(ZACK, static_cast<uint32_t>(position)));
+                }
+                if ( (frameEnd == ZCRCE) || (frameEnd == ZCRCW) ) {
+                    break;
+                }
+            }
+            continue;
+        } else if (type == ZEOF) {
+            if (headerPosition(header) == static_cast<uint32_t>(position)) {
+                return;
+            }
+            //An old ZEOF overtaken by our ZRPOS; the data is on its way again
+            this->countError();
+            continue;
+        } else if (type == ZDATA) {
+            //Data from before the last ZRPOS took effect; wait for the sender to catch up
+            this->countError();
+            continue;
+        } else if (type == ZFILE) {
+            //The sender never saw our ZRPOS
+            size_t dataSize{0};
+            this->readDataSubpacket(&dataSize);
+        } else if (type == ZFIN) {
+            this->throwTransferError("ZModemTransfer::receiveFileData(std::ofstream &)", "sender ended the session in the middle of a file");
+        } else {
+            this->countError();
+            if (++errorCount > MAXIMUM_RETRIES) {
+                this->throwTransferError("ZModemTransfer::receiveFileData(std::ofstream &)", "sender stopped responding");
+            }
+        }
+        this->sendHeader(makeHeader(ZRPOS, static_cast<uint32_t>(position)));
+    }
+}
+
+bool ZModemTransfer::receiveFile(const std::string &destination, std::string *filePath)
+{
+    size_t infoSize{0};
+    int frameEnd{this->readDataSubpacket(&infoSize)};
+    this->throwIfPeerCancelled(frameEnd, "ZModemTransfer::receiveFile(const std::string &, std::string *)");
+    if (frameEnd < 0) {
+        this->countError();
+        this->sendHeader(makeHeader(ZNAK));
+        return false;
+    }
+    const char *fileInfo{this->m_dataBuffer.data()};
+    size_t nameLength{strnlen(fileInfo, infoSize)};
+    std::string fileName{fileInfo, nameLength};
+    uint64_t size{0};
+    if (nameLength + 1 < infoSize) {
+        std::string sizeField{fileInfo + nameLength + 1, strnlen(fileInfo + nameLength + 1, infoSize - nameLength - 1)};
+        size = std::strtoull(sizeField.c_str(), nullptr, 10);
+    }
+
+    std::string safeName{""};
+    if (!receivedFilePath(fileName, destination, &safeName, filePath)) {
+        this->countError();
+        this->sendHeader(makeHeader(ZSKIP));
+        return false;
+    }
+    std::ofstream outputFile{*filePath, std::ios::binary | std::ios::trunc};
+    if (!outputFile.is_open()) {
+        this->throwTransferError("ZModemTransfer::receiveFile(const std::string &, std::string *)", "could not open \"" + *filePath + "\" for writing");
+    }
+    this->beginFile(safeName, size);
+    this->sendHeader(makeHeader(ZRPOS, 0));
+    this->receiveFileData(outputFile);
+    outputFile.close();
+    if (outputFile.fail()) {
+        this->throwTransferError("ZModemTransfer::receiveFile(const std::string &, std::string *)", "could not write to \"" + *filePath + "\"");
+    }
+    this->finishFile();
+    return true;
+}
+
+std::vector<std::string> ZModemTransfer::receiveFiles(const std::string &destination)
+{
+    std::vector<std::string> receivedFiles{};
+    this->beginTransfer();
+    this->sendReceiverInit();
+    int errorCount{0};
+    while (true) {
+        this->throwIfCancelled("ZModemTransfer::receiveFiles(const std::string &)");
+        Header header{};
+        int type{this->readHeader(&header, HEADER_TIMEOUT)};
+        this->throwIfPeerCancelled(type, "ZModemTransfer::receiveFiles(const std::string &)");
+        if (type == ZFILE) {
+            std::string filePath{""};
+            if (this->receiveFile(destination, &filePath)) {
+                receivedFiles.push_back(filePath);
+                this->sendReceiverInit();
+            }
+            errorCount = 0;
+        } else if (type == ZFIN) {
+            this->sendHeader(makeHeader(ZFIN));
+            //The sender's "OO" is a courtesy; do not wait long for it
+            for (int i = 0; (i < 2) && (this->readByte(LINE_END_TIMEOUT) == 'O'); i++) { }
+            return receivedFiles;
+        } else if (type == ZSINIT) {
+            size_t dataSize{0};
+            this->sendHeader(makeHeader(this->readDataSubpacket(&dataSize) < 0 ? ZNAK : ZACK));
+        } else if (type == ZCOMMAND) {
+            this->throwTransferError("ZModemTransfer::receiveFiles(const std::string &)", "sender asked to run a command, which is not supported");
+        } else if (type == ZRQINIT) {
+            this->sendReceiverInit();
+        } else {
+            this->countError();
+            if (++errorCount >= MAXIMUM_RETRIES) {
+                this->throwTransferError("ZModemTransfer::receiveFiles(const std::string &)", "sender never started");
+            }
+            this->sendReceiverInit();
+        }
+    }
+}
+
+} //namespace CppSerialPort
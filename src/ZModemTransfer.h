@@ -0,0 +1,126 @@
+/***********************************************************************
+*    ZModemTransfer.h:                                                 *
+*    ZModemTransfer, ZMODEM batch file transfers                       *
+*    Copyright (c) 2017 Tyler Lewis                                    *
+************************************************************************
+*    This is a header file for CppSerialPort:                          *
+*    https://github.com/tlewiscpp/CppSerialPort                        *
+*    This file may be distributed with the CppSerialPort library,      *
+*    but may also be distributed as a standalone file                  *
+*    The source code is released under the GNU LGPL                    *
+*    This file holds the declarations of a ZModemTransfer class        *
+*    The sender streams data subpackets without waiting for each one  *
+*    to be acknowledged. Every quarter window it asks for an ACK       *
+*    (ZCRCQ), and it only stops to wait once a whole window is         *
+*    unacknowledged, so a full duplex line stays busy. A receiver that *
+*    reports a bad subpacket sends ZRPOS and the sender rewinds to it. *
+*    CRC-32 is used whenever the receiver offers it. The receiver side *
+*    asks for full streaming and accepts CRC-16 and CRC-32 frames      *
+*                                                                      *
+*    You should have received a copy of the GNU Lesser General         *
+*    Public license along with CppSerialPort                           *
+*    If not, see <http://www.gnu.org/licenses/>                        *
+***********************************************************************/
+
+#ifndef CPPSERIALPORT_ZMODEMTRANSFER_H
+#define CPPSERIALPORT_ZMODEMTRANSFER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+#include "FileTransfer.h"
+
+namespace CppSerialPort {
+
+class ZModemTransfer : public FileTransfer
+{
+public:
+    explicit ZModemTransfer(std::shared_ptr<IByteStream> byteStream, std::function<void()> progressCallback = nullptr);
+    ~ZModemTransfer() override = default;
+
+    void sendFiles(const std::vector<std::string> &filePaths) override;
+    //The destination is a directory; names offered by the sender are reduced to their last path component
+    std::vector<std::string> receiveFiles(const std::string &destination) override;
+    TransferProtocol protocol() const override;
+
+    //How many bytes may be sent without an acknowledgement; 0 streams without ever waiting
+    void setWindowSize(size_t windowSize);
+    size_t windowSize() const;
+
+    static const size_t DEFAULT_WINDOW_SIZE;
+    static const size_t SUBPACKET_SIZE;
+    static const size_t MAXIMUM_SUBPACKET_SIZE;
+    static const std::chrono::milliseconds HEADER_TIMEOUT;
+    static const std::chrono::milliseconds CHARACTER_TIMEOUT;
+    static const int MAXIMUM_RETRIES;
+
+private:
+    struct Header
+    {
+        int type;
+        uint8_t data[4];
+    };
+
+    enum class SendResult
+    {
+        Completed,
+        Skipped
+    };
+
+    size_t m_windowSize;
+    bool m_useCrc32;
+    bool m_escapeControlCharacters;
+    size_t m_receiverBufferSize;
+    bool m_receivingCrc32;
+    uint8_t m_lastSentByte;
+    std::string m_frame;
+    std::vector<char> m_dataBuffer;
+
+    static Header makeHeader(int type, uint32_t position = 0);
+    static uint32_t headerPosition(const Header &header);
+
+    //Frames are assembled in m_frame and written with a single flushFrame()
+    void appendEscaped(uint8_t c);
+    void appendEscaped(const char *data, size_t size);
+    void appendHexHeader(const Header &header);
+    void appendBinaryHeader(const Header &header);
+    void appendDataSubpacket(const char *data, size_t size, int frameEnd);
+    void flushFrame();
+    void sendHeader(const Header &header);
+
+    //These return a non-negative value on success, or READ_TIMED_OUT, FRAME_ERROR or PEER_CANCELLED
+    int readEscaped(std::chrono::milliseconds timeout);
+    int readHexByte();
+    int readHexHeader(Header *header);
+    int readBinaryHeader(Header *header, bool isCrc32);
+    int readHeader(Header *header, std::chrono::milliseconds timeout);
+    //Returns the frame end (ZCRCE, ZCRCG, ZCRCQ or ZCRCW), with the data left in m_dataBuffer
+    int readDataSubpacket(size_t *dataSize);
+    void throwIfPeerCancelled(int result, const std::string &context);
+    void throwTransferError(const std::string &context, const std::string &message);
+
+    void waitForReceiverInit();
+    void sendFile(const std::string &filePath, uint64_t fileSize, size_t filesLeft, uint64_t bytesLeft);
+    bool negotiateFile(const std::string &fileInfo, std::ifstream &inputFile, uint64_t *position);
+    SendResult streamFileData(std::ifstream &inputFile, uint64_t fileSize, uint64_t *position);
+    //Returns false when the receiver asked for data again from *position
+    bool sendEndOfFile(uint64_t fileSize, uint64_t *position);
+    void finishSession();
+
+    void sendReceiverInit();
+    bool receiveFile(const std::string &destination, std::string *filePath);
+    void receiveFileData(std::ofstream &outputFile);
+
+    static const int FRAME_ERROR;
+    static const int PEER_CANCELLED;
+    static const int FRAME_END_FLAG;
+    static const size_t GARBAGE_LIMIT;
+};
+
+} //namespace CppSerialPort
+
+#endif //CPPSERIALPORT_ZMODEMTRANSFER_H